@@ -73,15 +73,30 @@
    network has to be inactive. If the network is inactive for this duaration,
    the MCU will suspend the network stack. Now, the MCU will not need to service
    the network timers which allows it to stay longer in sleep/deepsleep.
+   The network suspend scheduler adapts the window to the gaps measured between
+   packets of a traffic burst, and uses this value as the upper limit.
 */
 #define NETWORK_INACTIVE_WINDOW_MS        (200)
 
+/* Lower limit of the adaptive inactivity window in milliseconds. */
+#define NETWORK_INACTIVE_WINDOW_MIN_MS    (30)
+
+/*
+ * Minimum delay between the network stack resuming and the next attempt to
+ * suspend it. This is a safe delay which helps in preventing the race
+ * conditions that might occur when activating and de-activating the offload.
+ */
+#define NETWORK_SUSPEND_GUARD_MS          (20)
+
 /*
- * Delay between subsequent calls to suspending the network stack.
- * This is a safe delay which helps in preventing the race conditions
- * that might occur when activating and de-activating the offload.
+ * If the network stack resumes within NETWORK_SUSPEND_BOUNCE_MS of being
+ * suspended, the delay before the next suspend starts at
+ * NETWORK_SUSPEND_DELAY_MS and doubles on every further bounce, up to
+ * NETWORK_SUSPEND_DELAY_MAX_MS.
  */
+#define NETWORK_SUSPEND_BOUNCE_MS         (1000)
 #define NETWORK_SUSPEND_DELAY_MS          (100)
+#define NETWORK_SUSPEND_DELAY_MAX_MS      (3200)
 
 /*
  * Enable(1) or Disable(0) the Host TCP Keepalive via ENABLE_HOST_TCP_KEEPALIVE.
@@ -89,6 +104,224 @@
  */
 #define ENABLE_HOST_TCP_KEEPALIVE         (0)
 
+/*
+ * Enable(1) or Disable(0) the coalescing of the Host TCP Keepalive. When enabled,
+ * the lwIP keepalive timer of each socket is replaced by one shared timer. The
+ * probe deadlines of all the sockets are rounded up to a grid of
+ * HOST_TCP_KEEPALIVE_TICK_MS, and the probes due at a grid point are sent in one
+ * burst. Only used when ENABLE_HOST_TCP_KEEPALIVE is enabled.
+ */
+#define HOST_TCP_KEEPALIVE_COALESCED      (1)
+#define HOST_TCP_KEEPALIVE_TICK_MS        (5000)
+
+/*
+ * Enable(1) or Disable(0) the fast rejoin after a Wi-Fi link loss. When enabled,
+ * the BSSID/channel of the AP, the DHCP lease, and the ARP entries of the TCP
+ * Keepalive servers are cached, and used to rejoin the AP and re-arm the offload
+ * without a full scan and DHCP exchange. It is disabled by default.
+ */
+#define ENABLE_WIFI_FAST_REJOIN           (0)
+
+/*
+ * Enable(1) or Disable(0) the candidate AP list. When enabled, the APs of
+ * WIFI_SSID and of WIFI_AP_CANDIDATE_NETWORKS are looked for by a background
+ * scan every WIFI_AP_SCAN_PERIOD_MS, started at a host wake while the link is
+ * up, and the WIFI_AP_CANDIDATE_MAX strongest are kept. When the fast rejoin to
+ * the last AP fails, the candidates are joined directly by BSSID, strongest
+ * first, before a full scan. Only used when ENABLE_WIFI_FAST_REJOIN is enabled.
+ * It is disabled by default.
+ */
+#define ENABLE_WIFI_AP_CANDIDATES         (0)
+#define WIFI_AP_CANDIDATE_MAX             (6)
+#define WIFI_AP_SCAN_PERIOD_MS            (600000)
+
+/*
+ * Networks whose APs are candidates in addition to the ones of WIFI_SSID, as
+ * {SSID, password, security}, each followed by a comma.
+ */
+/* #define WIFI_AP_CANDIDATE_NETWORKS     { "WIFI_SSID_2", "WIFI_PASSWORD_2", CY_WCM_SECURITY_WPA2_AES_PSK }, */
+
+/*
+ * Enable(1) or Disable(0) the warm boot. When enabled, the runtime TCP Keepalive
+ * configuration, the keepalive parameters of each connection, the validated port
+ * table, and the fast rejoin state are saved in a flash row whenever they change.
+ * After a software or watchdog reset they are restored from it, so the AP is
+ * joined directly and the offload is armed without parsing the configuration
+ * again. The time asleep after the last wake before the reset is not known,
+ * so the cached address is only reused with WARM_BOOT_LEASE_MARGIN_MS of its
+ * reuse time left. Programming the device erases the saved state. Each save
+ * erases and writes the row, so it adds flash wear. It is disabled by default.
+ */
+#define ENABLE_WARM_BOOT                  (0)
+#define WARM_BOOT_LEASE_MARGIN_MS         (600000)
+
+/*
+ * Enable(1) or Disable(0) TLS on the TCP Keepalive connections. When enabled,
+ * a TLS handshake runs over each connection once it is up, and the server
+ * certificate is verified against TKO_TLS_ROOT_CA_CERTIFICATE and
+ * TKO_TLS_SERVER_NAME. The session of each server is cached in RAM, and
+ * offered on the next handshake for at most TKO_TLS_SESSION_LIFETIME_MS, so
+ * that a reconnect takes an abbreviated handshake. Each TLS read waits at most
+ * TKO_TLS_RECV_TIMEOUT_MS for a record. It is disabled by default.
+ */
+#define ENABLE_TKO_TLS                    (0)
+#define TKO_TLS_SERVER_NAME               "tko-server.local"
+#define TKO_TLS_ROOT_CA_CERTIFICATE       "-----BEGIN CERTIFICATE-----\n"                                    \
+                                          "Paste the CA certificate of the TCP server here\n"               \
+                                          "-----END CERTIFICATE-----\n"
+#define TKO_TLS_HANDSHAKE_TIMEOUT_MS      (10000)
+#define TKO_TLS_RECV_TIMEOUT_MS           (100)
+#define TKO_TLS_SESSION_LIFETIME_MS       (7200000)
+
+/*
+ * Enable(1) or Disable(0) the packet filters of the TCP Keepalive servers. When
+ * enabled, WLAN packet filters are built from the TCP Keepalive port table and
+ * enabled while the network stack is suspended. Only the TCP segments from the
+ * remote IP address and port of a valid port, the ARP packets of the gateway,
+ * and the IPv6 neighbor solicitations then wake the host; the firmware drops
+ * the rest. The filters are disabled again while the host is awake.
+ */
+#define ENABLE_TKO_PACKET_FILTER          (0)
+
+/*
+ * Enable(1) or Disable(0) the WLAN power policy. When enabled, the power save
+ * mode and the listen interval of the radio follow the network stack: the
+ * WLAN_POWER_ACTIVE_* settings while the host is awake, for a low latency, and
+ * the WLAN_POWER_SUSPEND_* settings while the stack is suspended and all the
+ * sockets are offloaded. The power save modes are WLAN_POWER_SAVE_OFF, PM1
+ * (the radio sleeps after each frame) and PM2 (the radio sleeps after
+ * *_SLEEP_DELAY_MS without traffic, a multiple of 10), as defined in
+ * wlan_power_policy.h. The listen intervals are in DTIM periods; beacons in
+ * between are skipped. It is disabled by default.
+ */
+#define ENABLE_WLAN_POWER_POLICY          (0)
+#define WLAN_POWER_ACTIVE_SAVE            (WLAN_POWER_SAVE_PM2)
+#define WLAN_POWER_ACTIVE_SLEEP_DELAY_MS  (50)
+#define WLAN_POWER_ACTIVE_LISTEN_DTIM     (1)
+#define WLAN_POWER_SUSPEND_SAVE           (WLAN_POWER_SAVE_PM1)
+#define WLAN_POWER_SUSPEND_SLEEP_DELAY_MS (200)
+#define WLAN_POWER_SUSPEND_LISTEN_DTIM    (3)
+
+/*
+ * Enable(1) or Disable(0) the batched uplink queue. When enabled, the messages
+ * given to tko_uplink_send() are queued in a buffer of TKO_UPLINK_BUFFER_SIZE
+ * bytes per socket, and sent as one write per socket in the next awake window
+ * of the host, or at the earliest deadline of the queued messages. A queue of
+ * TKO_UPLINK_FLUSH_THRESHOLD bytes or more is sent right away. When a deadline
+ * passes while the connection is down, the flush is retried every
+ * TKO_UPLINK_RETRY_DELAY_MS.
+ */
+#define ENABLE_TKO_UPLINK_QUEUE           (0)
+#define TKO_UPLINK_BUFFER_SIZE            (1024)
+#define TKO_UPLINK_FLUSH_THRESHOLD        (768)
+#define TKO_UPLINK_RETRY_DELAY_MS         (5000)
+
+#if ENABLE_TKO_TLS && !defined(TCP_SOCKET_CONNECT_TASK_STACK_SIZE)
+/* The TLS handshake runs in the worker task of each socket connection */
+#define TCP_SOCKET_CONNECT_TASK_STACK_SIZE (4096)
+#endif
+
+/*
+ * Maximum time to wait for an IPv6 address from the stateless address
+ * autoconfiguration (SLAAC) after the join, and the polling period. Used by the
+ * IPv6-only build (make IPV6_ONLY=1), and when a TCP Keepalive server has an
+ * IPv6 address.
+ */
+#define IPV6_SLAAC_TIMEOUT_MS             (10000)
+#define IPV6_SLAAC_POLL_MS                (50)
+
+/*
+ * Retry scheduling of the Wi-Fi join and of the TCP socket connections.
+ * After a failed attempt the delay starts at the base delay and doubles up to
+ * the maximum delay; a random half of it is taken so that many devices don't
+ * retry in lock-step. Retries stop after the maximum number of attempts or
+ * when the attempts have kept the device awake for the budget (0: no limit).
+ * The first Wi-Fi join is delayed by a random part of the initial jitter.
+ * A rejoin after a link loss that failed, with its own join retries, is
+ * retried without limit on the WIFI_REJOIN delays.
+ */
+#define WIFI_JOIN_INITIAL_JITTER_MS       (2000)
+#define WIFI_JOIN_RETRY_BASE_DELAY_MS     (1000)
+#define WIFI_JOIN_RETRY_MAX_DELAY_MS      (30000)
+#define WIFI_JOIN_RETRY_BUDGET_MS         (60000)
+
+#define WIFI_REJOIN_RETRY_BASE_DELAY_MS   (10000)
+#define WIFI_REJOIN_RETRY_MAX_DELAY_MS    (600000)
+
+#define TCP_SOCKET_RETRY_BASE_DELAY_MS    (2000)
+#define TCP_SOCKET_RETRY_MAX_DELAY_MS     (60000)
+#define TCP_SOCKET_RETRY_MAX_ATTEMPTS     (8)
+#define TCP_SOCKET_RETRY_BUDGET_MS        (0)
+
+/*
+ * Buffered logging. APP_INFO and ERR_INFO only add a record to a buffer of
+ * APP_LOG_BUFFER_SIZE bytes (a power of two); a low priority task formats and
+ * prints it. Errors and a half full buffer are printed right away, the other
+ * logs when the system is awake anyway, or after APP_LOG_FLUSH_INTERVAL_MS.
+ * The level of the logs built in is set by the LOG_LEVEL option of the Makefile.
+ */
+#define APP_LOG_BUFFER_SIZE               (2048)
+#define APP_LOG_FLUSH_INTERVAL_MS         (1000)
+
+/*
+ * Interval of the health check of the TCP Keepalive connections, in addition
+ * to the checks made when the offload reports a lost connection.
+ */
+#define TKO_HEALTH_CHECK_INTERVAL_MS      (60000)
+
+/*
+ * Enable(1) or Disable(0) the learning of the keepalive interval of each network
+ * path (AP and server). When enabled, the interval of each connection is doubled
+ * from the configured one each time the connection held for
+ * TKO_PROBE_CONFIRM_INTERVALS of it, up to TKO_PROBE_INTERVAL_MAX_S. A connection
+ * lost after the interval elapsed means that a NAT or firewall on the path timed
+ * out, and the search continues halfway to the last interval that held. Once
+ * the two are TKO_PROBE_RESOLUTION_S apart, the interval that held, less
+ * TKO_PROBE_MARGIN_PERCENT, is used and saved in flash for the path. The checks
+ * are made by the health monitor. It is disabled by default.
+ */
+#define ENABLE_TKO_INTERVAL_PROBE         (0)
+#define TKO_PROBE_INTERVAL_MIN_S          (20)
+#define TKO_PROBE_INTERVAL_MAX_S          (1800)
+#define TKO_PROBE_CONFIRM_INTERVALS       (3)
+#define TKO_PROBE_RESOLUTION_S            (30)
+#define TKO_PROBE_MARGIN_PERCENT          (20)
+
+/*
+ * Enable(1) or Disable(0) the TCP Keepalive session manager, which serves up to
+ * TKO_SESSION_MAX connections with the MAX_TKO firmware offload slots. The most
+ * recently active sessions are kept in the firmware slots; the others are kept
+ * alive by the host, with the probes of all of them sent in one burst per
+ * TKO_SESSION_KEEPALIVE_WINDOW_MS. A host kept session takes the slot of the
+ * least recently active offloaded session once it has been active more recently
+ * by TKO_SESSION_PROMOTE_HYSTERESIS_MS, and it is reconnected if nothing is
+ * received from the server for TKO_SESSION_HOST_TIMEOUT_MS.
+ */
+#define ENABLE_TKO_SESSION_MANAGER        (0)
+#define TKO_SESSION_MAX                   (8)
+#define TKO_SESSION_KEEPALIVE_WINDOW_MS   (20000)
+#define TKO_SESSION_PROMOTE_HYSTERESIS_MS (60000)
+#define TKO_SESSION_HOST_TIMEOUT_MS       (120000)
+
+/*
+ * Enable(1) or Disable(0) the metrics endpoint. A metrics request frame received
+ * on the TCP Keepalive connection TKO_METRICS_SOCKET_INDEX is answered, in the
+ * same awake window, with a frame of the suspend, connection, heap, lwIP pool
+ * and wake counters (see tko_metrics.h). The data received on that connection
+ * is read by the endpoint and is not passed to the data handler. Each read
+ * waits at most TKO_METRICS_RECV_TIMEOUT_MS, or TKO_TLS_RECV_TIMEOUT_MS over
+ * TLS. It is disabled by default.
+ */
+#define ENABLE_TKO_METRICS                (0)
+#define TKO_METRICS_SOCKET_INDEX          (0)
+#define TKO_METRICS_RECV_TIMEOUT_MS       (20)
+
+/*
+ * Connections opened by the session manager in addition to the ones configured
+ * in the TCP Keepalive offload settings, as {local port, remote port, remote IP}.
+ */
+/* #define TKO_SESSION_EXTRA_SERVERS      { {3353, 50007, "192.168.1.10"}, {3354, 50008, "192.168.1.10"} } */
+
 #endif /* APP_CONFIG_H_ */
 
 
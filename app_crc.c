@@ -0,0 +1,113 @@
+/******************************************************************************
+* File Name:   app_crc.c
+*
+* Description: CRCs of the records kept in flash and of the binary frames.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include "app_crc.h"
+
+/********************************************************************************
+ * Function Name: app_crc32
+ ********************************************************************************
+ * Summary:
+ *  Computes the CRC-32 (IEEE 802.3) of a buffer.
+ *
+ * Parameters:
+ *  data: Buffer to compute the CRC of.
+ *  length: Length of the buffer in bytes.
+ *
+ * Return:
+ *  uint32_t: CRC-32 of the buffer.
+ *
+ *******************************************************************************/
+uint32_t app_crc32(const void *data, size_t length)
+{
+    const uint8_t *byte = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    int bit;
+
+    while (length--)
+    {
+        crc ^= *byte++;
+
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+
+    return ~crc;
+}
+
+/********************************************************************************
+ * Function Name: app_crc16
+ ********************************************************************************
+ * Summary:
+ *  Computes the CRC-16/CCITT-FALSE of a buffer. Start with 0xFFFF, or with the
+ *  CRC of the previous buffer to cover several buffers.
+ *
+ * Parameters:
+ *  crc: Initial value or the CRC of the previous buffer.
+ *  data: Buffer to compute the CRC over.
+ *  length: Number of bytes in the buffer.
+ *
+ * Return:
+ *  uint16_t: CRC of the buffer.
+ *
+ *******************************************************************************/
+uint16_t app_crc16(uint16_t crc, const void *data, size_t length)
+{
+    const uint8_t *byte = (const uint8_t *)data;
+    uint8_t bit;
+
+    while (length--)
+    {
+        crc ^= (uint16_t)(*byte++) << 8;
+
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+
+/* [] END OF FILE */
+
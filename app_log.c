@@ -0,0 +1,803 @@
+/******************************************************************************
+* File Name:   app_log.c
+*
+* Description: This file buffers the APP_INFO and ERR_INFO logs of the
+*              application and prints them from a low priority task.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+#include "app_config.h"
+#include "app_log.h"
+
+/* Serializes the writes to the debug UART, created by app_log_init() */
+static SemaphoreHandle_t log_output_lock = NULL;
+
+/********************************************************************************
+ * Function Name: app_log_lock
+ ********************************************************************************
+ * Summary:
+ *  Takes the lock of the debug UART output, so that the log lines and the
+ *  binary frames written by debug_uart_write_frame() do not interleave. It has
+ *  no effect before app_log_init(), before the scheduler is started, and in an
+ *  interrupt.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void app_log_lock(void)
+{
+    if ((NULL == log_output_lock) || (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) ||
+        xPortIsInsideInterrupt())
+    {
+        return;
+    }
+
+    (void)xSemaphoreTake(log_output_lock, portMAX_DELAY);
+}
+
+/********************************************************************************
+ * Function Name: app_log_unlock
+ ********************************************************************************
+ * Summary:
+ *  Gives back the lock taken by app_log_lock().
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void app_log_unlock(void)
+{
+    if ((NULL == log_output_lock) || (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) ||
+        xPortIsInsideInterrupt())
+    {
+        return;
+    }
+
+    (void)xSemaphoreGive(log_output_lock);
+}
+
+#if !defined(APP_LOG_SYNCHRONOUS)
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#if ((APP_LOG_BUFFER_SIZE & (APP_LOG_BUFFER_SIZE - 1)) != 0)
+#error "APP_LOG_BUFFER_SIZE must be a power of two"
+#endif
+
+#define APP_LOG_BUFFER_MASK                      (APP_LOG_BUFFER_SIZE - 1)
+
+/* Longest conversion specification printed from a record, such as "%-36s" */
+#define APP_LOG_MAX_SPEC_LENGTH                  (16)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Argument taken by a conversion specification of the format */
+typedef enum
+{
+    APP_LOG_ARG_NONE = 0,           /* "%%" */
+    APP_LOG_ARG_INT,
+    APP_LOG_ARG_LONG,
+    APP_LOG_ARG_LLONG,
+    APP_LOG_ARG_SIZE,
+    APP_LOG_ARG_PTR,
+    APP_LOG_ARG_DOUBLE,
+    APP_LOG_ARG_STRING,             /* Copied into the record */
+    APP_LOG_ARG_UNSUPPORTED         /* "*" width or precision, ends the record */
+} app_log_arg_t;
+
+/* Start of each record in the log buffer. The values of the arguments follow
+ * in the order of the format, unaligned.
+ */
+typedef struct
+{
+    uint8_t length;                 /* Of the whole record. Must be first. */
+    uint8_t level;
+    uint8_t arguments;              /* Number of arguments captured */
+    uint8_t reserved;
+    const char *format;             /* String literal of the call site */
+} app_log_header_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static uint8_t log_buffer[APP_LOG_BUFFER_SIZE];
+
+/* Free running offsets. A record is added or removed as a whole under a short
+ * critical section, by any task or interrupt.
+ */
+static uint32_t log_head = 0;
+static uint32_t log_tail = 0;
+
+/* Records lost because the buffer was full */
+static uint32_t log_dropped = 0;
+
+static TaskHandle_t log_task = NULL;
+
+/********************************************************************************
+ * Function Name: app_log_parse_spec
+ ********************************************************************************
+ * Summary:
+ *  Parses the printf conversion specification at the start of the string.
+ *
+ * Parameters:
+ *  spec: Points to the '%' of the specification.
+ *  type: Returns the type of the argument taken by the specification.
+ *
+ * Return:
+ *  size_t: Length of the specification, in characters.
+ *
+ *******************************************************************************/
+static size_t app_log_parse_spec(const char *spec, app_log_arg_t *type)
+{
+    const char *p = spec + 1;
+    int longs = 0;
+    bool size = false;
+
+    if ('%' == *p)
+    {
+        *type = APP_LOG_ARG_NONE;
+        return 2;
+    }
+
+    /* Flags, field width and precision */
+    while (('\0' != *p) && (NULL != strchr("-+ #0123456789.", *p)))
+    {
+        p++;
+    }
+
+    /* Length modifier */
+    while (('\0' != *p) && (NULL != strchr("hlzjt", *p)))
+    {
+        if ('l' == *p)
+        {
+            longs++;
+        }
+        else if ('j' == *p)
+        {
+            longs = 2;
+        }
+        else if ('h' != *p)
+        {
+            size = true;
+        }
+        p++;
+    }
+
+    switch (*p)
+    {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+            *type = size ? APP_LOG_ARG_SIZE :
+                    (longs >= 2) ? APP_LOG_ARG_LLONG :
+                    (1 == longs) ? APP_LOG_ARG_LONG : APP_LOG_ARG_INT;
+            break;
+
+        case 'p':
+            *type = APP_LOG_ARG_PTR;
+            break;
+
+        case 's':
+            *type = APP_LOG_ARG_STRING;
+            break;
+
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            *type = APP_LOG_ARG_DOUBLE;
+            break;
+
+        default:
+            *type = APP_LOG_ARG_UNSUPPORTED;
+            return (size_t)(p - spec);
+    }
+
+    return (size_t)(p + 1 - spec);
+}
+
+/********************************************************************************
+ * Function Name: app_log_pack
+ ********************************************************************************
+ * Summary:
+ *  Appends the value of an argument to a record.
+ *
+ * Parameters:
+ *  record: Record being built.
+ *  offset: Offset of the value in the record. Advanced past the value.
+ *  value: Value to append.
+ *  size: Size of the value, in bytes.
+ *
+ * Return:
+ *  bool: Returns true if the value fits in the record.
+ *
+ *******************************************************************************/
+static bool app_log_pack(uint8_t *record, size_t *offset, const void *value, size_t size)
+{
+    if ((APP_LOG_MAX_RECORD_SIZE - *offset) < size)
+    {
+        return false;
+    }
+
+    memcpy(&record[*offset], value, size);
+    *offset += size;
+
+    return true;
+}
+
+/********************************************************************************
+ * Function Name: app_log_notify
+ ********************************************************************************
+ * Summary:
+ *  Wakes up the log task, from a task or from an interrupt.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void app_log_notify(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if ((NULL == log_task) || (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState()))
+    {
+        return;
+    }
+
+    if (xPortIsInsideInterrupt())
+    {
+        vTaskNotifyGiveFromISR(log_task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        (void)xTaskNotifyGive(log_task);
+    }
+}
+
+/********************************************************************************
+ * Function Name: app_log_write
+ ********************************************************************************
+ * Summary:
+ *  Adds a record to the log buffer. The format is not expanded: the record
+ *  holds the format pointer and the values of the arguments. Strings are
+ *  copied, as they may not outlive the call.
+ *
+ *  The log task is woken up when an error is logged or the buffer is half
+ *  full. It prints the other records when nothing else runs, or when the
+ *  network stack resumes.
+ *
+ * Parameters:
+ *  level: APP_LOG_LEVEL_ERROR or APP_LOG_LEVEL_INFO.
+ *  format: printf format string. Must be a string literal.
+ *  args: Arguments of the format.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void app_log_write(uint8_t level, const char *format, va_list args)
+{
+    uint8_t record[APP_LOG_MAX_RECORD_SIZE];
+    app_log_header_t header;
+    const char *p = format;
+    const char *string;
+    size_t offset = sizeof(header);
+    size_t length;
+    size_t index;
+    app_log_arg_t type;
+    UBaseType_t mask;
+    bool packed = true;
+    bool notify = false;
+
+    header.level = level;
+    header.arguments = 0;
+    header.reserved = 0;
+    header.format = format;
+
+    while (packed && (NULL != (p = strchr(p, '%'))))
+    {
+        p += app_log_parse_spec(p, &type);
+
+        switch (type)
+        {
+            case APP_LOG_ARG_NONE:
+                continue;
+
+            case APP_LOG_ARG_INT:
+            {
+                int value = va_arg(args, int);
+                packed = app_log_pack(record, &offset, &value, sizeof(value));
+                break;
+            }
+
+            case APP_LOG_ARG_LONG:
+            {
+                long value = va_arg(args, long);
+                packed = app_log_pack(record, &offset, &value, sizeof(value));
+                break;
+            }
+
+            case APP_LOG_ARG_LLONG:
+            {
+                long long value = va_arg(args, long long);
+                packed = app_log_pack(record, &offset, &value, sizeof(value));
+                break;
+            }
+
+            case APP_LOG_ARG_SIZE:
+            {
+                size_t value = va_arg(args, size_t);
+                packed = app_log_pack(record, &offset, &value, sizeof(value));
+                break;
+            }
+
+            case APP_LOG_ARG_PTR:
+            {
+                void *value = va_arg(args, void *);
+                packed = app_log_pack(record, &offset, &value, sizeof(value));
+                break;
+            }
+
+            case APP_LOG_ARG_DOUBLE:
+            {
+                double value = va_arg(args, double);
+                packed = app_log_pack(record, &offset, &value, sizeof(value));
+                break;
+            }
+
+            case APP_LOG_ARG_STRING:
+                string = va_arg(args, const char *);
+                string = (NULL != string) ? string : "(null)";
+                packed = (offset < APP_LOG_MAX_RECORD_SIZE);
+
+                if (packed)
+                {
+                    /* Truncated to the space left in the record */
+                    length = strnlen(string, APP_LOG_MAX_RECORD_SIZE - offset - 1);
+                    memcpy(&record[offset], string, length);
+                    record[offset + length] = '\0';
+                    offset += length + 1;
+                }
+                break;
+
+            default:
+                packed = false;
+                break;
+        }
+
+        if (packed)
+        {
+            header.arguments++;
+        }
+    }
+
+    header.length = (uint8_t)offset;
+    memcpy(record, &header, sizeof(header));
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+
+    if ((APP_LOG_BUFFER_SIZE - (log_head - log_tail)) < offset)
+    {
+        log_dropped++;
+        notify = true;
+    }
+    else
+    {
+        for (index = 0; index < offset; index++)
+        {
+            log_buffer[(log_head + index) & APP_LOG_BUFFER_MASK] = record[index];
+        }
+
+        log_head += offset;
+        notify = (APP_LOG_LEVEL_ERROR == level) || ((log_head - log_tail) > (APP_LOG_BUFFER_SIZE / 2));
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    if (notify)
+    {
+        app_log_notify();
+    }
+}
+
+/********************************************************************************
+ * Function Name: app_log_read
+ ********************************************************************************
+ * Summary:
+ *  Removes the oldest record from the log buffer.
+ *
+ * Parameters:
+ *  record: Returns the record. APP_LOG_MAX_RECORD_SIZE bytes.
+ *
+ * Return:
+ *  bool: Returns false if the log buffer is empty.
+ *
+ *******************************************************************************/
+static bool app_log_read(uint8_t *record)
+{
+    UBaseType_t mask;
+    size_t length;
+    size_t index;
+    bool found = false;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+
+    if (log_head != log_tail)
+    {
+        length = log_buffer[log_tail & APP_LOG_BUFFER_MASK];
+
+        for (index = 0; index < length; index++)
+        {
+            record[index] = log_buffer[(log_tail + index) & APP_LOG_BUFFER_MASK];
+        }
+
+        log_tail += length;
+        found = true;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    return found;
+}
+
+/********************************************************************************
+ * Function Name: app_log_print
+ ********************************************************************************
+ * Summary:
+ *  Prints a record, expanding its format with the captured arguments.
+ *
+ * Parameters:
+ *  record: Record read from the log buffer.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void app_log_print(const uint8_t *record)
+{
+    app_log_header_t header;
+    char spec[APP_LOG_MAX_SPEC_LENGTH];
+    const char *p;
+    const char *next;
+    size_t offset = sizeof(header);
+    size_t length;
+    uint8_t argument = 0;
+    app_log_arg_t type;
+
+    memcpy(&header, record, sizeof(header));
+    printf((APP_LOG_LEVEL_ERROR == header.level) ? "Error: " : "Info: ");
+
+    p = header.format;
+
+    while (NULL != (next = strchr(p, '%')))
+    {
+        (void)fwrite(p, 1, (size_t)(next - p), stdout);
+        length = app_log_parse_spec(next, &type);
+        p = next + length;
+
+        if (APP_LOG_ARG_NONE == type)
+        {
+            (void)putchar('%');
+            continue;
+        }
+
+        if ((argument >= header.arguments) || (length >= sizeof(spec)))
+        {
+            /* Not captured: print the specification as is */
+            (void)fwrite(next, 1, length, stdout);
+            continue;
+        }
+
+        memcpy(spec, next, length);
+        spec[length] = '\0';
+        argument++;
+
+        switch (type)
+        {
+            case APP_LOG_ARG_INT:
+            {
+                int value;
+                memcpy(&value, &record[offset], sizeof(value));
+                offset += sizeof(value);
+                printf(spec, value);
+                break;
+            }
+
+            case APP_LOG_ARG_LONG:
+            {
+                long value;
+                memcpy(&value, &record[offset], sizeof(value));
+                offset += sizeof(value);
+                printf(spec, value);
+                break;
+            }
+
+            case APP_LOG_ARG_LLONG:
+            {
+                long long value;
+                memcpy(&value, &record[offset], sizeof(value));
+                offset += sizeof(value);
+                printf(spec, value);
+                break;
+            }
+
+            case APP_LOG_ARG_SIZE:
+            {
+                size_t value;
+                memcpy(&value, &record[offset], sizeof(value));
+                offset += sizeof(value);
+                printf(spec, value);
+                break;
+            }
+
+            case APP_LOG_ARG_PTR:
+            {
+                void *value;
+                memcpy(&value, &record[offset], sizeof(value));
+                offset += sizeof(value);
+                printf(spec, value);
+                break;
+            }
+
+            case APP_LOG_ARG_DOUBLE:
+            {
+                double value;
+                memcpy(&value, &record[offset], sizeof(value));
+                offset += sizeof(value);
+                printf(spec, value);
+                break;
+            }
+
+            case APP_LOG_ARG_STRING:
+                printf(spec, (const char *)&record[offset]);
+                offset += strlen((const char *)&record[offset]) + 1;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    printf("%s", p);
+}
+
+/********************************************************************************
+ * Function Name: app_log_task
+ ********************************************************************************
+ * Summary:
+ *  Prints the buffered logs. Woken up by the errors, a half full buffer and
+ *  app_log_kick(). Pending logs are also printed after
+ *  APP_LOG_FLUSH_INTERVAL_MS.
+ *
+ * Parameters:
+ *  arg: Unused.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void app_log_task(void *arg)
+{
+    (void)arg;
+
+    while (true)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, (log_head != log_tail) ?
+                               pdMS_TO_TICKS(APP_LOG_FLUSH_INTERVAL_MS) : portMAX_DELAY);
+        app_log_flush();
+    }
+}
+
+/********************************************************************************
+ * Function Name: app_log_init
+ ********************************************************************************
+ * Summary:
+ *  Creates the lock of the debug UART output and starts the task that prints
+ *  the buffered logs. The logs written before are kept in the buffer.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the log task is started.
+ *
+ *******************************************************************************/
+cy_rslt_t app_log_init(void)
+{
+    log_output_lock = xSemaphoreCreateMutex();
+
+    if ((NULL == log_output_lock) ||
+        (pdPASS != xTaskCreate(app_log_task, "AppLog", APP_LOG_TASK_STACK_SIZE,
+                              NULL, APP_LOG_TASK_PRIORITY, &log_task)))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: app_log_info
+ ********************************************************************************
+ * Summary:
+ *  Logs an information message. Called through APP_INFO().
+ *
+ * Parameters:
+ *  format: printf format string. Must be a string literal.
+ *  ...: Arguments of the format.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void app_log_info(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    app_log_write(APP_LOG_LEVEL_INFO, format, args);
+    va_end(args);
+}
+
+/********************************************************************************
+ * Function Name: app_log_error
+ ********************************************************************************
+ * Summary:
+ *  Logs an error message. Called through ERR_INFO().
+ *
+ * Parameters:
+ *  format: printf format string. Must be a string literal.
+ *  ...: Arguments of the format.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void app_log_error(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    app_log_write(APP_LOG_LEVEL_ERROR, format, args);
+    va_end(args);
+}
+
+/********************************************************************************
+ * Function Name: app_log_kick
+ ********************************************************************************
+ * Summary:
+ *  Prints the buffered logs now. Called when the system is awake anyway, for
+ *  example when the network stack resumes.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void app_log_kick(void)
+{
+    if (log_head != log_tail)
+    {
+        app_log_notify();
+    }
+}
+
+/********************************************************************************
+ * Function Name: app_log_flush
+ ********************************************************************************
+ * Summary:
+ *  Prints all the buffered logs from the calling context, for example before
+ *  an assert or a direct printf. The output lock is held while the logs are
+ *  printed.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void app_log_flush(void)
+{
+    uint8_t record[APP_LOG_MAX_RECORD_SIZE];
+    UBaseType_t mask;
+    uint32_t dropped;
+
+    app_log_lock();
+
+    while (app_log_read(record))
+    {
+        app_log_print(record);
+    }
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    dropped = log_dropped;
+    log_dropped = 0;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    if (0 != dropped)
+    {
+        printf("Error: %lu log messages dropped\n", (unsigned long)dropped);
+    }
+
+    (void)fflush(stdout);
+
+    app_log_unlock();
+}
+
+#else
+
+/* The APP_INFO and ERR_INFO macros print the logs directly, under the lock */
+cy_rslt_t app_log_init(void)
+{
+    log_output_lock = xSemaphoreCreateMutex();
+
+    return (NULL != log_output_lock) ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
+}
+
+void app_log_kick(void)
+{
+}
+
+void app_log_flush(void)
+{
+}
+
+#endif /* APP_LOG_SYNCHRONOUS */
+
+
+/* [] END OF FILE */
+
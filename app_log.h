@@ -0,0 +1,115 @@
+/******************************************************************************
+* File Name:   app_log.h
+*
+* Description: This file is the public interface of app_log.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef APP_LOG_H
+#define APP_LOG_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Log levels. Messages above APP_LOG_LEVEL are removed at compile time. */
+#define APP_LOG_LEVEL_NONE                       (0)
+#define APP_LOG_LEVEL_ERROR                      (1)
+#define APP_LOG_LEVEL_INFO                       (2)
+
+/* Set by the LOG_LEVEL option of the Makefile */
+#ifndef APP_LOG_LEVEL
+#define APP_LOG_LEVEL                            APP_LOG_LEVEL_INFO
+#endif
+
+/* Stack size and priority of the task that prints the buffered logs. It runs
+ * at the idle priority, so the logs are printed only when no other task is
+ * ready.
+ */
+#ifndef APP_LOG_TASK_STACK_SIZE
+#define APP_LOG_TASK_STACK_SIZE                  (1024)
+#endif
+#define APP_LOG_TASK_PRIORITY                    (0)
+
+/* Largest record in the log buffer. Longer string arguments are truncated. */
+#define APP_LOG_MAX_RECORD_SIZE                  (128)
+
+/* APP_INFO(("format", args)) and ERR_INFO(("format", args)). The disabled
+ * levels still type check their arguments but generate no code.
+ */
+#if (APP_LOG_LEVEL >= APP_LOG_LEVEL_INFO)
+#if defined(APP_LOG_SYNCHRONOUS)
+#define APP_INFO(x)                              do { app_log_lock(); printf("Info: "); printf x; \
+                                                      (void)fflush(stdout); app_log_unlock(); } while(0);
+#else
+#define APP_INFO(x)                              do { app_log_info x; } while(0);
+#endif
+#else
+#define APP_INFO(x)                              do { if (0) { printf x; } } while(0);
+#endif
+
+#if (APP_LOG_LEVEL >= APP_LOG_LEVEL_ERROR)
+#if defined(APP_LOG_SYNCHRONOUS)
+#define ERR_INFO(x)                              do { app_log_lock(); printf("Error: "); printf x; \
+                                                      (void)fflush(stdout); app_log_unlock(); } while(0);
+#else
+#define ERR_INFO(x)                              do { app_log_error x; } while(0);
+#endif
+#else
+#define ERR_INFO(x)                              do { if (0) { printf x; } } while(0);
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t app_log_init(void);
+void app_log_info(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void app_log_error(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void app_log_kick(void);
+void app_log_flush(void);
+void app_log_lock(void);
+void app_log_unlock(void);
+
+#endif /* APP_LOG_H */
+
+
+/* [] END OF FILE */
+
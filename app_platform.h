@@ -0,0 +1,90 @@
+/******************************************************************************
+* File Name:   app_platform.h
+*
+* Description: Time, delay and device identity hooks used by the control
+*              logic. The defaults map to FreeRTOS and the PSoC 6 system
+*              library; an off-target build defines the hooks beforehand to
+*              run the logic on simulated time.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef APP_PLATFORM_H
+#define APP_PLATFORM_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Each hook can be predefined, for example with -include on the compiler
+ * command line, to replace the board implementation. A replacement must keep
+ * the semantics: APP_PLATFORM_NOW_MS() is a free-running millisecond counter
+ * that wraps at 2^32, and APP_PLATFORM_SLEEP_MS() advances it by the delay.
+ */
+#if !defined(APP_PLATFORM_NOW_MS) || !defined(APP_PLATFORM_SLEEP_MS)
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+/*
+ * Milliseconds of a tick count, or of the difference of two. Like the tick
+ * count, the result wraps at 2^32, so longer times must be converted in 64 bits.
+ */
+#ifndef TICKS_TO_MS
+#include <FreeRTOS.h>
+#define TICKS_TO_MS(ticks)                ((uint32_t)(ticks) * portTICK_PERIOD_MS)
+#endif
+
+#ifndef APP_PLATFORM_NOW_MS
+#define APP_PLATFORM_NOW_MS()             TICKS_TO_MS(xTaskGetTickCount())
+#endif
+
+#ifndef APP_PLATFORM_SLEEP_MS
+#define APP_PLATFORM_SLEEP_MS(ms)         vTaskDelay(pdMS_TO_TICKS(ms))
+#endif
+
+#ifndef APP_PLATFORM_DEVICE_ID
+#include "cy_syslib.h"
+#define APP_PLATFORM_DEVICE_ID()          Cy_SysLib_GetUniqueId()
+#endif
+
+#endif /* APP_PLATFORM_H */
+
+
+/* [] END OF FILE */
+
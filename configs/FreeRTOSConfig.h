@@ -61,6 +61,21 @@
  */
 #include "cycfg_system.h"
 
+/* Per-target footprint profile written from the output of the footprint
+ * profiling build, selected with make FOOTPRINT_PROFILE_FILE=<file>. Its
+ * values take precedence over the defaults below.
+ */
+#if defined(APP_FOOTPRINT_PROFILE_FILE)
+#include APP_FOOTPRINT_PROFILE_FILE
+#endif
+
+/* Task topology selected with make TASK_TOPOLOGY_FILE=<file>. Its priorities
+ * take precedence over the defaults of each task.
+ */
+#if defined(APP_TASK_TOPOLOGY_FILE)
+#include APP_TASK_TOPOLOGY_FILE
+#endif
+
 #define configUSE_PREEMPTION                    1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
 #define configCPU_CLOCK_HZ                      SystemCoreClock
@@ -83,7 +98,15 @@
 /* Memory allocation related definitions. */
 #define configSUPPORT_STATIC_ALLOCATION         1
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
+#if defined(APP_STATIC_ALLOCATION)
+/* Fixed arena of heap_4 for the task stacks, queues (lwIP mailboxes) and
+ * semaphores: a base for the system tasks plus one connect task stack and the
+ * netconn mailboxes for each TCP connection.
+ */
+#define configTOTAL_HEAP_SIZE                   ((32 * 1024) + (APP_STATIC_CONNECTIONS) * (4 * 1024 + 512))
+#else
 #define configTOTAL_HEAP_SIZE                   10240
+#endif
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
@@ -93,8 +116,46 @@
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      1
 
-/* Run time and task stats gathering related definitions. */
+/* Run time and task stats gathering related definitions. The sleep statistics
+ * build counts the run time on a free running LP timer, and traces the task
+ * switches and timers that end a sleep early (see sleep_stats.c).
+ */
+#if defined(APP_SLEEP_STATS)
+extern void sleep_stats_counter_init( void );
+extern uint32_t sleep_stats_counter_read( void );
+extern void sleep_stats_task_switched_in( void );
+extern void sleep_stats_timer_expired( void *xTimer );
+#define configGENERATE_RUN_TIME_STATS           1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() sleep_stats_counter_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()        sleep_stats_counter_read()
+#define traceTIMER_EXPIRED( pxTimer )           sleep_stats_timer_expired( pxTimer )
+#else
 #define configGENERATE_RUN_TIME_STATS           0
+#endif
+
+/* The trace build records the task switches, the interrupts that signal a
+ * task and the tickless idle periods into a RAM buffer (see trace_events.c).
+ * The FromISR hooks take variable arguments, as their parameters differ
+ * between kernel versions.
+ */
+#if defined(APP_TRACE_EVENTS)
+extern void trace_events_task_switched_in( void );
+extern void trace_events_isr( void );
+extern void trace_events_sleep( _Bool begin );
+#define traceQUEUE_SEND_FROM_ISR( ... )         trace_events_isr()
+#define traceTASK_NOTIFY_FROM_ISR( ... )        trace_events_isr()
+#define traceTASK_NOTIFY_GIVE_FROM_ISR( ... )   trace_events_isr()
+#define traceLOW_POWER_IDLE_BEGIN()             trace_events_sleep( 1 )
+#define traceLOW_POWER_IDLE_END()               trace_events_sleep( 0 )
+#endif
+
+#if defined(APP_SLEEP_STATS) && defined(APP_TRACE_EVENTS)
+#define traceTASK_SWITCHED_IN()                 do { sleep_stats_task_switched_in(); trace_events_task_switched_in(); } while( 0 )
+#elif defined(APP_SLEEP_STATS)
+#define traceTASK_SWITCHED_IN()                 sleep_stats_task_switched_in()
+#elif defined(APP_TRACE_EVENTS)
+#define traceTASK_SWITCHED_IN()                 trace_events_task_switched_in()
+#endif
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
@@ -104,9 +165,13 @@
 
 /* Software timer related definitions. */
 #define configUSE_TIMERS                        1
+#ifndef configTIMER_TASK_PRIORITY
 #define configTIMER_TASK_PRIORITY               2
+#endif
 #define configTIMER_QUEUE_LENGTH                10
+#ifndef configTIMER_TASK_STACK_DEPTH
 #define configTIMER_TASK_STACK_DEPTH            ( configMINIMAL_STACK_SIZE * 2 )
+#endif
 
 /*
 Interrupt nesting behavior configuration.
@@ -164,7 +229,11 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
+#if defined(APP_FOOTPRINT_PROFILE)
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#else
 #define INCLUDE_uxTaskGetStackHighWaterMark     0
+#endif
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
@@ -195,7 +264,11 @@ standard names - or at least those used in the unmodified vector table. */
 #define HEAP_ALLOCATION_TYPE5                   (5)     /* heap_5.c*/
 #define NO_HEAP_ALLOCATION                      (0)
 
+#if defined(APP_STATIC_ALLOCATION)
+#define configHEAP_ALLOCATION_SCHEME            (HEAP_ALLOCATION_TYPE4)
+#else
 #define configHEAP_ALLOCATION_SCHEME            (HEAP_ALLOCATION_TYPE3)
+#endif
 
 /* Check if the ModusToolbox Device Configurator Power personality parameter
  * "System Idle Power Mode" is set to either "CPU Sleep" or "System Deep Sleep".
@@ -212,7 +285,13 @@ standard names - or at least those used in the unmodified vector table. */
  * https://github.com/cypresssemiconductorco/lpa
  */
 extern void vApplicationSleep( uint32_t xExpectedIdleTime );
+#if defined(APP_SLEEP_STATS)
+/* Records the power mode reached and its residency, see sleep_stats.c */
+extern void sleep_stats_sleep( uint32_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xIdleTime ) sleep_stats_sleep( xIdleTime )
+#else
 #define portSUPPRESS_TICKS_AND_SLEEP( xIdleTime ) vApplicationSleep( xIdleTime )
+#endif
 #define configUSE_TICKLESS_IDLE                 2
 
 #else
@@ -33,6 +33,23 @@
 
 #include <whd_types.h>
 
+//
+// Per-target footprint profile written from the output of the footprint
+// profiling build, selected with make FOOTPRINT_PROFILE_FILE=<file>. Its
+// values take precedence over the defaults below.
+//
+#if defined(APP_FOOTPRINT_PROFILE_FILE)
+#include APP_FOOTPRINT_PROFILE_FILE
+#endif
+
+//
+// Task topology selected with make TASK_TOPOLOGY_FILE=<file>, see
+// FreeRTOSConfig.h.
+//
+#if defined(APP_TASK_TOPOLOGY_FILE)
+#include APP_TASK_TOPOLOGY_FILE
+#endif
+
 #define MEM_ALIGNMENT                   (4)
 
 #define LWIP_RAW                        (1)
@@ -58,6 +75,12 @@
 //
 #define LWIP_IPV6                       (1)
 
+//
+// Take a routable IPv6 address from the router advertisements (SLAAC).
+// It is turned on for the STA interface by wifi_ipv6_address_wait().
+//
+#define LWIP_IPV6_AUTOCONFIG            (1)
+
 #define ETHARP_SUPPORT_STATIC_ENTRIES   (1)
 
 //
@@ -68,11 +91,21 @@
 #define LWIP_UDP                        (1)
 #define LWIP_IGMP                       (1)
 
+#if defined(APP_STATIC_ALLOCATION)
+//
+// Static allocation build (make STATIC_ALLOCATION=1): the memory blocks come
+// from the LWIP heap, a fixed arena of MEM_SIZE bytes, and the pools below are
+// sized from the number of TCP connections APP_STATIC_CONNECTIONS.
+//
+#define MEM_LIBC_MALLOC                 (0)
+#define MEM_SIZE                        ((APP_STATIC_CONNECTIONS) * (TCP_SND_BUF) + (4 * 1024))
+#else
 //
 // Use malloc to allocate any memory blocks instead of the
 // malloc that is part of LWIP
 //
 #define MEM_LIBC_MALLOC                 (1)
+#endif
 
 //
 // The standard library does not provide errno, use the one
@@ -146,7 +179,13 @@
  * TCP_SND_BUF: TCP sender buffer space (bytes).
  * To achieve good performance, this should be at least 2 * TCP_MSS.
  */
+#ifndef TCP_SND_BUF
+#if defined(APP_STATIC_ALLOCATION)
+#define TCP_SND_BUF                     (2 * TCP_MSS)
+#else
 #define TCP_SND_BUF                     (4 * TCP_MSS)
+#endif
+#endif
 
 /**
  * TCP_SND_QUEUELEN: TCP sender buffer space (pbufs). This must be at least
@@ -172,8 +211,12 @@
 #define LWIP_NETCONN                    (1)
 #define DEFAULT_TCP_RECVMBOX_SIZE       (12)
 #define TCPIP_MBOX_SIZE                 (16)
+#ifndef TCPIP_THREAD_STACKSIZE
 #define TCPIP_THREAD_STACKSIZE          (4*1024)
+#endif
+#ifndef TCPIP_THREAD_PRIO
 #define TCPIP_THREAD_PRIO               (4)
+#endif
 #define DEFAULT_RAW_RECVMBOX_SIZE       (12)
 #define DEFAULT_UDP_RECVMBOX_SIZE       (12)
 #define DEFAULT_ACCEPTMBOX_SIZE         (8)
@@ -189,7 +232,13 @@
  * MEMP_NUM_TCP_PCB: the number of simultaneously active TCP connections.
  * (requires the LWIP_TCP option)
  */
+#ifndef MEMP_NUM_TCP_PCB
+#if defined(APP_STATIC_ALLOCATION)
+#define MEMP_NUM_TCP_PCB                ((APP_STATIC_CONNECTIONS) + 1)
+#else
 #define MEMP_NUM_TCP_PCB                8
+#endif
+#endif
 
 /**
  * MEMP_NUM_TCP_PCB_LISTEN: the number of listening TCP connections.
@@ -201,33 +250,55 @@
  * MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP segments.
  * (requires the LWIP_TCP option)
  */
+#ifndef MEMP_NUM_TCP_SEG
+#if defined(APP_STATIC_ALLOCATION)
+#define MEMP_NUM_TCP_SEG                ((TCP_SND_QUEUELEN) + 2 * (APP_STATIC_CONNECTIONS))
+#else
 #define MEMP_NUM_TCP_SEG                27
+#endif
+#endif
 
 /**
  * MEMP_NUM_SYS_TIMEOUT: the number of simultaneously active timeouts.
  */
+#ifndef MEMP_NUM_SYS_TIMEOUT
 #define MEMP_NUM_SYS_TIMEOUT            12
+#endif
 
 /**
  * PBUF_POOL_SIZE: the number of buffers in the pbuf pool.
  */
+#ifndef PBUF_POOL_SIZE
 #define PBUF_POOL_SIZE                  24
+#endif
 
 /**
  * MEMP_NUM_NETBUF: the number of struct netbufs.
  * (only needed if you use the sequential API, like api_lib.c)
  */
+#ifndef MEMP_NUM_NETBUF
+#if defined(APP_STATIC_ALLOCATION)
+#define MEMP_NUM_NETBUF                 (2 * (APP_STATIC_CONNECTIONS))
+#else
 #define MEMP_NUM_NETBUF                 8
+#endif
+#endif
 
 /**
  * MEMP_NUM_NETCONN: the number of struct netconns.
  * (only needed if you use the sequential API, like api_lib.c)
  */
+#ifndef MEMP_NUM_NETCONN
+#if defined(APP_STATIC_ALLOCATION)
+#define MEMP_NUM_NETCONN                ((APP_STATIC_CONNECTIONS) + 2)
+#else
 #define MEMP_NUM_NETCONN                16
+#endif
+#endif
 
 
-/* Turn off LWIP_STATS in Release build */
-#ifdef DEBUG
+/* Turn off LWIP_STATS in Release build, except for the footprint profiling build */
+#if defined(DEBUG) || defined(APP_FOOTPRINT_PROFILE)
 #define LWIP_STATS 1
 #else
 #define LWIP_STATS 0
@@ -0,0 +1,79 @@
+/******************************************************************************
+* File Name:   task_topology_resume_first.h
+*
+* Description: Task topology that puts the suspend/resume path of the network
+*              stack ahead of the application tasks. Select it with make
+*              TASK_TOPOLOGY_FILE=task_topology_resume_first.h.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TASK_TOPOLOGY_RESUME_FIRST_H
+#define TASK_TOPOLOGY_RESUME_FIRST_H
+
+/* Printed at startup, to tell the resume latency of each topology apart */
+#define TASK_TOPOLOGY_NAME                       "resume first"
+
+/* Suspend/resume path. A packet that wakes the host is handled by the WHD
+ * thread, then by tcpip_thread, and the stack is resumed by the network idle
+ * task (NetAct) waiting in wait_net_suspend(). NetAct runs right below
+ * tcpip_thread, which it still waits on, so that no application task delays
+ * the resume. The WHD thread and the WCM worker keep the priorities set by
+ * their libraries.
+ */
+#define TCPIP_THREAD_PRIO                        (4)
+#define NETWORK_ACTIVITY_TASK_PRIORITY           (3)
+
+/* Link recovery. It never runs alongside a suspend. */
+#define WIFI_REJOIN_TASK_PRIORITY                (3)
+
+/* Work done once the stack is resumed: the debug commands in the timer
+ * service task, the wake handling and the socket bring-up.
+ */
+#define configTIMER_TASK_PRIORITY                (2)
+#define WAKE_DISPATCHER_TASK_PRIORITY            (2)
+#define TCP_SOCKET_CONNECT_TASK_PRIORITY         (2)
+
+/* Background work that can wait for the awake window to go quiet */
+#define TKO_UPLINK_TASK_PRIORITY                 (1)
+#define TKO_HEALTH_TASK_PRIORITY                 (1)
+#define TKO_SESSION_TASK_PRIORITY                (1)
+
+#endif /* TASK_TOPOLOGY_RESUME_FIRST_H */
+
+
+/* [] END OF FILE */
+
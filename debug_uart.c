@@ -0,0 +1,277 @@
+/******************************************************************************
+* File Name:   debug_uart.c
+*
+* Description: This file dispatches single byte commands received on the
+*              retarget-io UART and writes binary frames to it.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include "cyhal.h"
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+#include "app_crc.h"
+#include "app_log.h"
+#include "debug_uart.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    uint8_t command;
+    debug_uart_command_handler_t handler;
+} debug_uart_command_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static debug_uart_command_t command_table[DEBUG_UART_MAX_COMMANDS];
+static uint32_t command_count = 0;
+
+/********************************************************************************
+ * Function Name: debug_uart_run_command
+ ********************************************************************************
+ * Summary:
+ *  Runs the handler registered for a command byte. Deferred from the UART
+ *  interrupt to the RTOS daemon task through xTimerPendFunctionCallFromISR().
+ *
+ * Parameters:
+ *  handler: Handler to run, passed as the first pended function parameter.
+ *  unused: Not used.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void debug_uart_run_command(void *handler, uint32_t unused)
+{
+    (void)unused;
+
+    ((debug_uart_command_t *)handler)->handler();
+}
+
+/********************************************************************************
+ * Function Name: debug_uart_event_cb
+ ********************************************************************************
+ * Summary:
+ *  UART receive interrupt callback. Looks up the received byte in the command
+ *  table and defers the matching handler to the RTOS daemon task.
+ *
+ * Parameters:
+ *  arg: Not used.
+ *  event: UART event that triggered the callback.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void debug_uart_event_cb(void *arg, cyhal_uart_event_t event)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    uint8_t value;
+    uint32_t index;
+
+    (void)arg;
+
+    if (0 == (event & CYHAL_UART_IRQ_RX_NOT_EMPTY))
+    {
+        return;
+    }
+
+    while (CY_RSLT_SUCCESS == cyhal_uart_getc(&cy_retarget_io_uart_obj, &value, 1))
+    {
+        for (index = 0; index < command_count; index++)
+        {
+            if (command_table[index].command == value)
+            {
+                xTimerPendFunctionCallFromISR(debug_uart_run_command, &command_table[index],
+                                              0, &higher_priority_task_woken);
+                break;
+            }
+        }
+
+        if (0 == cyhal_uart_readable(&cy_retarget_io_uart_obj))
+        {
+            break;
+        }
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/********************************************************************************
+ * Function Name: debug_uart_init
+ ********************************************************************************
+ * Summary:
+ *  Enables the receive interrupt of the retarget-io UART. Must be called after
+ *  cy_retarget_io_init().
+ *
+ *  Note: The UART does not operate in deep-sleep power mode. Commands are only
+ *  received while the MCU is awake.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS. The HAL UART callback APIs do not report errors.
+ *
+ *******************************************************************************/
+cy_rslt_t debug_uart_init(void)
+{
+    cyhal_uart_register_callback(&cy_retarget_io_uart_obj, debug_uart_event_cb, NULL);
+    cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY,
+                            DEBUG_UART_RX_INTERRUPT_PRIORITY, true);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: debug_uart_register_command
+ ********************************************************************************
+ * Summary:
+ *  Registers a handler for a single byte command received on the debug UART.
+ *  Commands must be registered before the scheduler starts or from a single
+ *  task, as the table is not protected.
+ *
+ * Parameters:
+ *  command: Command byte.
+ *  handler: Function to run in the RTOS daemon task when the byte is received.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the command was registered, CY_RSLT_TYPE_ERROR
+ *  if the command table is full.
+ *
+ *******************************************************************************/
+cy_rslt_t debug_uart_register_command(uint8_t command, debug_uart_command_handler_t handler)
+{
+    if (command_count >= DEBUG_UART_MAX_COMMANDS)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    command_table[command_count].command = command;
+    command_table[command_count].handler = handler;
+    command_count++;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: debug_uart_write_all
+ ********************************************************************************
+ * Summary:
+ *  Writes all the bytes on the debug UART. cyhal_uart_write() only copies
+ *  what fits in the TX FIFO, so the rest is written byte by byte with the
+ *  blocking cyhal_uart_putc().
+ *
+ * Parameters:
+ *  data: Bytes to write.
+ *  length: Number of bytes to write.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void debug_uart_write_all(const uint8_t *data, size_t length)
+{
+    size_t size = length;
+
+    if (CY_RSLT_SUCCESS != cyhal_uart_write(&cy_retarget_io_uart_obj, (void *)data, &size))
+    {
+        size = 0;
+    }
+
+    for (; size < length; size++)
+    {
+        if (CY_RSLT_SUCCESS != cyhal_uart_putc(&cy_retarget_io_uart_obj, data[size]))
+        {
+            break;
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: debug_uart_write_frame
+ ********************************************************************************
+ * Summary:
+ *  Writes a binary frame on the debug UART. The frame format is:
+ *  sync (0xA5 0x5A), type (1 byte), length (2 bytes, little-endian), payload,
+ *  and the CRC-16/CCITT-FALSE of type, length and payload (2 bytes,
+ *  little-endian). The whole frame is written under the log output lock, so
+ *  that no log line is printed in the middle of it.
+ *
+ * Parameters:
+ *  type: Frame type identifying the payload layout.
+ *  payload: Payload of the frame.
+ *  length: Number of bytes in the payload.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void debug_uart_write_frame(uint8_t type, const void *payload, uint16_t length)
+{
+    uint8_t header[DEBUG_UART_FRAME_HEADER_SIZE] = { DEBUG_UART_FRAME_SYNC_0, DEBUG_UART_FRAME_SYNC_1, type,
+                                                     (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+    uint8_t trailer[2];
+    uint16_t crc;
+
+    crc = app_crc16(0xFFFF, &header[2], sizeof(header) - 2);
+    crc = app_crc16(crc, payload, length);
+    trailer[0] = (uint8_t)(crc & 0xFF);
+    trailer[1] = (uint8_t)(crc >> 8);
+
+    app_log_lock();
+
+    /* Text already handed to stdio goes out before the frame */
+    (void)fflush(stdout);
+
+    debug_uart_write_all(header, sizeof(header));
+    debug_uart_write_all((const uint8_t *)payload, length);
+    debug_uart_write_all(trailer, sizeof(trailer));
+
+    app_log_unlock();
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,86 @@
+/******************************************************************************
+* File Name:   debug_uart.h
+*
+* Description: This file is the public interface of debug_uart.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef DEBUG_UART_H
+#define DEBUG_UART_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Maximum number of single byte commands that can be registered */
+#define DEBUG_UART_MAX_COMMANDS                  (16)
+
+/* Start of every binary frame. Never produced by the text logs. The frames
+ * sent on a TCP connection, such as the metrics, use the same format.
+ */
+#define DEBUG_UART_FRAME_SYNC_0                  (0xA5)
+#define DEBUG_UART_FRAME_SYNC_1                  (0x5A)
+
+/* Bytes of a frame besides the payload: sync, type, length and CRC */
+#define DEBUG_UART_FRAME_HEADER_SIZE             (5)
+#define DEBUG_UART_FRAME_OVERHEAD                (DEBUG_UART_FRAME_HEADER_SIZE + 2)
+
+/* Interrupt priority of the debug UART receive event */
+#define DEBUG_UART_RX_INTERRUPT_PRIORITY         (7)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Handler for a command byte. Runs in the RTOS daemon (timer) task. */
+typedef void (*debug_uart_command_handler_t)(void);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t debug_uart_init(void);
+cy_rslt_t debug_uart_register_command(uint8_t command, debug_uart_command_handler_t handler);
+void debug_uart_write_frame(uint8_t type, const void *payload, uint16_t length);
+
+#endif /* DEBUG_UART_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,285 @@
+/******************************************************************************
+* File Name:   footprint_profile.c
+*
+* Description: This file implements the footprint profiling build (make
+*              FOOTPRINT_PROFILE=1). It records the high-water marks of the
+*              lwIP pools and of the task stacks, and prints from them a
+*              profile of pool and stack sizes for the target, in the form of
+*              a header file that can be selected with make
+*              FOOTPRINT_PROFILE_FILE=<file>.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#if defined(APP_FOOTPRINT_PROFILE)
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "lwip/opt.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "debug_uart.h"
+#include "footprint_profile.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_health.h"
+#include "tko_session_manager.h"
+#include "tko_uplink.h"
+#include "wake_dispatcher.h"
+#include "wifi_fast_rejoin.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* lwIP pool and the option that sets its size */
+typedef struct
+{
+    memp_t pool;
+    const char *option;
+    uint32_t configured;
+} footprint_pool_t;
+
+/* Task and the option that sets its stack size, in units of unit bytes */
+typedef struct
+{
+    const char *task;
+    const char *option;
+    uint32_t configured;
+    uint32_t unit;
+} footprint_stack_t;
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define FOOTPRINT_ARRAY_SIZE(array)       (sizeof(array) / sizeof((array)[0]))
+#define FOOTPRINT_WITH_MARGIN(value)      ((value) + ((value) * FOOTPRINT_PROFILE_MARGIN_PERCENT + 99) / 100)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const footprint_pool_t footprint_pools[] =
+{
+    { MEMP_TCP_PCB,         "MEMP_NUM_TCP_PCB",         MEMP_NUM_TCP_PCB },
+    { MEMP_TCP_PCB_LISTEN,  "MEMP_NUM_TCP_PCB_LISTEN",  MEMP_NUM_TCP_PCB_LISTEN },
+    { MEMP_TCP_SEG,         "MEMP_NUM_TCP_SEG",         MEMP_NUM_TCP_SEG },
+    { MEMP_UDP_PCB,         "MEMP_NUM_UDP_PCB",         MEMP_NUM_UDP_PCB },
+    { MEMP_NETBUF,          "MEMP_NUM_NETBUF",          MEMP_NUM_NETBUF },
+    { MEMP_NETCONN,         "MEMP_NUM_NETCONN",         MEMP_NUM_NETCONN },
+    { MEMP_SYS_TIMEOUT,     "MEMP_NUM_SYS_TIMEOUT",     MEMP_NUM_SYS_TIMEOUT },
+    { MEMP_PBUF_POOL,       "PBUF_POOL_SIZE",           PBUF_POOL_SIZE },
+};
+
+/* The lwIP port takes the stack size of its thread in bytes */
+static const footprint_stack_t footprint_stacks[] =
+{
+    { "tcpip_thread", "TCPIP_THREAD_STACKSIZE",             TCPIP_THREAD_STACKSIZE,             sizeof(StackType_t) },
+    { "Tmr Svc",      "configTIMER_TASK_STACK_DEPTH",       configTIMER_TASK_STACK_DEPTH,       1 },
+    { "NetAct",       "NETWORK_ACTIVITY_TASK_STACK_SIZE",   NETWORK_ACTIVITY_TASK_STACK_SIZE,   1 },
+    { "SockConn",     "TCP_SOCKET_CONNECT_TASK_STACK_SIZE", TCP_SOCKET_CONNECT_TASK_STACK_SIZE, 1 },
+    { "TkoHealth",    "TKO_HEALTH_TASK_STACK_SIZE",         TKO_HEALTH_TASK_STACK_SIZE,         1 },
+    { "WiFiRejoin",   "WIFI_REJOIN_TASK_STACK_SIZE",        WIFI_REJOIN_TASK_STACK_SIZE,        1 },
+    { "TkoSess",      "TKO_SESSION_TASK_STACK_SIZE",        TKO_SESSION_TASK_STACK_SIZE,        1 },
+    { "WakeDisp",     "WAKE_DISPATCHER_TASK_STACK_SIZE",    WAKE_DISPATCHER_TASK_STACK_SIZE,    1 },
+    { "AppLog",       "APP_LOG_TASK_STACK_SIZE",            APP_LOG_TASK_STACK_SIZE,            1 },
+    { "Uplink",       "TKO_UPLINK_TASK_STACK_SIZE",         TKO_UPLINK_TASK_STACK_SIZE,         1 },
+};
+
+/* Lowest free stack seen for each entry of footprint_stacks, in words */
+static uint32_t stack_min_free[FOOTPRINT_ARRAY_SIZE(footprint_stacks)];
+
+static TaskStatus_t task_status[FOOTPRINT_PROFILE_MAX_TASKS];
+
+/********************************************************************************
+ * Function Name: footprint_profile_record
+ ********************************************************************************
+ * Summary:
+ *  Records the free stack of a task, if it is one of the profiled tasks.
+ *
+ * Parameters:
+ *  name: Name of the task.
+ *  free_words: Stack high-water mark of the task, in words.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void footprint_profile_record(const char *name, uint32_t free_words)
+{
+    uint32_t index;
+
+    for (index = 0; index < FOOTPRINT_ARRAY_SIZE(footprint_stacks); index++)
+    {
+        if ((0 == strcmp(name, footprint_stacks[index].task)) && (free_words < stack_min_free[index]))
+        {
+            stack_min_free[index] = free_words;
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: footprint_profile_init
+ ********************************************************************************
+ * Summary:
+ *  Registers the debug UART command that prints the footprint profile.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void footprint_profile_init(void)
+{
+    uint32_t index;
+
+    for (index = 0; index < FOOTPRINT_ARRAY_SIZE(footprint_stacks); index++)
+    {
+        stack_min_free[index] = UINT32_MAX;
+    }
+
+    debug_uart_register_command(FOOTPRINT_PROFILE_COMMAND, footprint_profile_dump);
+}
+
+/********************************************************************************
+ * Function Name: footprint_profile_task_exit
+ ********************************************************************************
+ * Summary:
+ *  Records the stack high-water mark of the calling task. It is called by the
+ *  tasks that delete themselves, before they do so.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void footprint_profile_task_exit(void)
+{
+    taskENTER_CRITICAL();
+    footprint_profile_record(pcTaskGetName(NULL), (uint32_t)uxTaskGetStackHighWaterMark(NULL));
+    taskEXIT_CRITICAL();
+}
+
+/********************************************************************************
+ * Function Name: footprint_profile_dump
+ ********************************************************************************
+ * Summary:
+ *  Samples the stacks of the running tasks, and prints the footprint profile:
+ *  the high-water mark of each pool and stack plus a margin. The lines are
+ *  printed without the log prefix so that they can be saved as a header file.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void footprint_profile_dump(void)
+{
+    UBaseType_t task_count;
+    uint32_t used;
+    uint32_t index;
+
+    task_count = uxTaskGetSystemState(task_status, FOOTPRINT_PROFILE_MAX_TASKS, NULL);
+
+    taskENTER_CRITICAL();
+    for (index = 0; index < task_count; index++)
+    {
+        footprint_profile_record(task_status[index].pcTaskName, (uint32_t)task_status[index].usStackHighWaterMark);
+    }
+    taskEXIT_CRITICAL();
+
+    /* Keep the profile in one piece on the terminal */
+    app_log_flush();
+
+    printf("/* Footprint profile for %s */\n", APP_FOOTPRINT_TARGET);
+    printf("#ifndef FOOTPRINT_PROFILE_VALUES_H\n#define FOOTPRINT_PROFILE_VALUES_H\n\n");
+
+    for (index = 0; index < FOOTPRINT_ARRAY_SIZE(footprint_pools); index++)
+    {
+        used = lwip_stats.memp[footprint_pools[index].pool]->max;
+
+        printf("#define %-36s (%"PRIu32")    /* peak %"PRIu32" of %"PRIu32" */\n",
+               footprint_pools[index].option, FOOTPRINT_WITH_MARGIN(used) > 0 ? FOOTPRINT_WITH_MARGIN(used) : 1,
+               used, footprint_pools[index].configured);
+    }
+
+    printf("\n");
+
+    for (index = 0; index < FOOTPRINT_ARRAY_SIZE(footprint_stacks); index++)
+    {
+        if (UINT32_MAX == stack_min_free[index])
+        {
+            printf("/* %s: task %s did not run */\n", footprint_stacks[index].option, footprint_stacks[index].task);
+            continue;
+        }
+
+        used = footprint_stacks[index].configured / footprint_stacks[index].unit - stack_min_free[index];
+
+        /* Rounded up to 8 words */
+        printf("#define %-36s (%"PRIu32")    /* used %"PRIu32" of %"PRIu32" */\n",
+               footprint_stacks[index].option,
+               ((FOOTPRINT_WITH_MARGIN(used) + 7) & ~7u) * footprint_stacks[index].unit,
+               used * footprint_stacks[index].unit, footprint_stacks[index].configured);
+    }
+
+    printf("\n#endif\n");
+}
+
+#endif /* APP_FOOTPRINT_PROFILE */
+
+
+/* [] END OF FILE */
+
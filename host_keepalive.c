@@ -0,0 +1,363 @@
+/******************************************************************************
+* File Name:   host_keepalive.c
+*
+* Description: This file implements the coalesced host TCP keepalive. The
+*              lwIP keepalive of every TCP Keepalive socket is replaced by
+*              one shared lwIP timeout, set to the next point of a fixed grid
+*              at which a probe is due. All the probes due at that point are
+*              sent in one burst, so the MCU wakes once for all the sockets
+*              instead of once per socket.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/timeouts.h"
+#include "lwip/stats.h"
+#include "lwip/priv/tcp_priv.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "debug_uart.h"
+#include "host_keepalive.h"
+#include "tcp_keepalive_offload.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    bool adopted;
+    uint8_t probes_sent;
+    uint32_t rx_tmr;        /* PCB timer value at the last segment received */
+    uint32_t last_rx;       /* sys_now() at the last segment received */
+    uint32_t last_probe;    /* sys_now() at the last probe sent */
+} host_keepalive_socket_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Accessed in the lwIP core context only */
+static host_keepalive_socket_t keepalive_socket[MAX_TKO];
+static bool tick_scheduled = false;
+
+/* Number of shared timeouts expired, and probes sent by them */
+static uint32_t tick_count = 0;
+static uint32_t probe_count = 0;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void host_keepalive_tick(void *arg);
+
+/********************************************************************************
+ * Function Name: host_keepalive_next_due
+ ********************************************************************************
+ * Summary:
+ *  Returns the time left before the next probe is due on a socket, following the
+ *  keepalive idle time, interval and count of its PCB.
+ *
+ * Parameters:
+ *  socket: Keepalive state of the socket.
+ *  pcb: PCB of the socket.
+ *  now: Current sys_now() value.
+ *
+ * Return:
+ *  uint32_t: Time in milliseconds, 0 if a probe is due now.
+ *
+ *******************************************************************************/
+static uint32_t host_keepalive_next_due(const host_keepalive_socket_t *socket,
+                                        const struct tcp_pcb *pcb, uint32_t now)
+{
+    uint32_t elapsed;
+    uint32_t period;
+
+    if (0 == socket->probes_sent)
+    {
+        elapsed = now - socket->last_rx;
+        period = pcb->keep_idle;
+    }
+    else
+    {
+        elapsed = now - socket->last_probe;
+        period = pcb->keep_intvl;
+    }
+
+    return (elapsed >= period) ? 0 : (period - elapsed);
+}
+
+/********************************************************************************
+ * Function Name: host_keepalive_schedule
+ ********************************************************************************
+ * Summary:
+ *  Sets the shared timeout to the first point of the HOST_TCP_KEEPALIVE_TICK_MS
+ *  grid at which a probe is due. As every socket is rounded up to the same grid,
+ *  the deadlines of different sockets fall on the same wake-up. Must be called
+ *  in the lwIP core context.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void host_keepalive_schedule(void)
+{
+    struct tcp_pcb *pcb;
+    uint32_t now = sys_now();
+    uint32_t next = UINT32_MAX;
+    uint32_t due;
+    int index;
+
+    if (tick_scheduled)
+    {
+        sys_untimeout(host_keepalive_tick, NULL);
+        tick_scheduled = false;
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (!keepalive_socket[index].adopted)
+        {
+            continue;
+        }
+
+        pcb = tcp_socket_get_pcb(index);
+
+        if ((NULL == pcb) || (ESTABLISHED != pcb->state))
+        {
+            continue;
+        }
+
+        due = host_keepalive_next_due(&keepalive_socket[index], pcb, now);
+
+        if (due < next)
+        {
+            next = due;
+        }
+    }
+
+    if (UINT32_MAX == next)
+    {
+        return;
+    }
+
+    /* Round the deadline up to the next grid point */
+    next = ((now + next + HOST_TCP_KEEPALIVE_TICK_MS - 1) / HOST_TCP_KEEPALIVE_TICK_MS) * HOST_TCP_KEEPALIVE_TICK_MS;
+
+    sys_timeout((next > now) ? (next - now) : HOST_TCP_KEEPALIVE_TICK_MS, host_keepalive_tick, NULL);
+    tick_scheduled = true;
+}
+
+/********************************************************************************
+ * Function Name: host_keepalive_tick
+ ********************************************************************************
+ * Summary:
+ *  Shared keepalive timeout. Sends a probe on every socket that has one due, and
+ *  aborts the connections that have not answered keep_cnt probes, as the lwIP
+ *  keepalive would. It runs in the lwIP core context.
+ *
+ * Parameters:
+ *  arg: Unused.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void host_keepalive_tick(void *arg)
+{
+    host_keepalive_socket_t *socket;
+    struct tcp_pcb *pcb;
+    uint32_t now = sys_now();
+    int index;
+
+    (void)arg;
+
+    tick_scheduled = false;
+    tick_count++;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        socket = &keepalive_socket[index];
+
+        if (!socket->adopted)
+        {
+            continue;
+        }
+
+        pcb = tcp_socket_get_pcb(index);
+
+        if ((NULL == pcb) || (ESTABLISHED != pcb->state))
+        {
+            continue;
+        }
+
+        /* lwIP restarts the PCB timer on every segment received */
+        if (pcb->tmr != socket->rx_tmr)
+        {
+            socket->rx_tmr = pcb->tmr;
+            socket->last_rx = now;
+            socket->probes_sent = 0;
+        }
+
+        /* Grid points can lag the deadline by up to one tick */
+        if (host_keepalive_next_due(socket, pcb, now) > 0)
+        {
+            continue;
+        }
+
+        if (socket->probes_sent >= pcb->keep_cnt)
+        {
+            ERR_INFO(("Socket[%d]: No answer to %d keepalive probes, aborting.\n", index, socket->probes_sent));
+            socket->adopted = false;
+            tcp_abort(pcb);
+            continue;
+        }
+
+        tcp_keepalive(pcb);
+        socket->probes_sent++;
+        socket->last_probe = now;
+        probe_count++;
+    }
+
+    host_keepalive_schedule();
+}
+
+/********************************************************************************
+ * Function Name: host_keepalive_adopt
+ ********************************************************************************
+ * Summary:
+ *  Moves a newly connected socket from the lwIP keepalive to the coalesced
+ *  host keepalive. The keepalive idle time, interval and count set on the
+ *  socket are still used.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void host_keepalive_adopt(int index)
+{
+    static bool command_registered = false;
+    struct tcp_pcb *pcb;
+
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return;
+    }
+
+    /* Sockets are connected in parallel; the core lock serializes them */
+    LOCK_TCPIP_CORE();
+
+    if (!command_registered)
+    {
+        debug_uart_register_command(HOST_KEEPALIVE_REPORT_COMMAND, host_keepalive_report);
+        command_registered = true;
+    }
+
+    pcb = tcp_socket_get_pcb(index);
+
+    if (NULL != pcb)
+    {
+        ip_reset_option(pcb, SOF_KEEPALIVE);
+
+        memset(&keepalive_socket[index], 0, sizeof(keepalive_socket[index]));
+        keepalive_socket[index].adopted = true;
+        keepalive_socket[index].rx_tmr = pcb->tmr;
+        keepalive_socket[index].last_rx = sys_now();
+
+        host_keepalive_schedule();
+    }
+
+    UNLOCK_TCPIP_CORE();
+}
+
+/********************************************************************************
+ * Function Name: host_keepalive_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the number of shared keepalive wake-ups, the probes sent by them, and
+ *  the lwIP timeout slots (MEMP_NUM_SYS_TIMEOUT) in use. It is run by the debug
+ *  UART command HOST_KEEPALIVE_REPORT_COMMAND.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void host_keepalive_report(void)
+{
+    uint32_t ticks;
+    uint32_t probes;
+
+    LOCK_TCPIP_CORE();
+    ticks = tick_count;
+    probes = probe_count;
+    UNLOCK_TCPIP_CORE();
+
+    APP_INFO(("Host keepalive: %"PRIu32" wake-ups, %"PRIu32" probes\n", ticks, probes));
+
+#if MEMP_STATS
+    APP_INFO(("System timeouts: %d used, %d max, %d available\n",
+              (int)lwip_stats.memp[MEMP_SYS_TIMEOUT]->used,
+              (int)lwip_stats.memp[MEMP_SYS_TIMEOUT]->max,
+              (int)lwip_stats.memp[MEMP_SYS_TIMEOUT]->avail));
+#else
+    APP_INFO(("System timeout usage needs MEMP_STATS (LWIP_STATS in a Debug build)\n"));
+#endif
+}
+
+
+/* [] END OF FILE */
+
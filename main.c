@@ -63,12 +63,35 @@
  */
 #include "tcp_keepalive_offload.h"
 
+/* Command and binary frame interface on the debug UART */
+#include "debug_uart.h"
+
+/* Offload descriptors resolved once at startup */
+#include "offload_registry.h"
+
+/* Rejoins the AP and re-arms the offload after a link loss */
+#include "wifi_fast_rejoin.h"
+#include "wifi_ap_candidates.h"
+#include "tko_session_manager.h"
+#include "static_allocation.h"
+#include "footprint_profile.h"
+#include "tko_health.h"
+#include "tko_interval_probe.h"
+#include "sleep_stats.h"
+#include "trace_events.h"
+#include "warm_boot.h"
+#include "tko_tls.h"
+#include "tko_packet_filter.h"
+#include "tko_uplink.h"
+#include "wlan_power_policy.h"
+
 /*******************************************************************************
 * Macros
 ********************************************************************************/
-/* Configure task stack size and priority */
-#define NETWORK_ACTIVITY_TASK_STACK_SIZE            (256)
-#define NETWORK_ACTIVITY_TASK_PRIORITY              (1)
+/* Set by the file selected with make TASK_TOPOLOGY_FILE=<file> */
+#ifndef TASK_TOPOLOGY_NAME
+#define TASK_TOPOLOGY_NAME                "default"
+#endif
 
 /*******************************************************************************
 * Global Variables
@@ -110,16 +133,39 @@ int main(void)
     cy_retarget_io_init(CYBSP_DEBUG_UART_TX, CYBSP_DEBUG_UART_RX,
                                         CY_RETARGET_IO_BAUDRATE);
 
+    /* Accept runtime commands, such as statistics dumps, on the debug UART */
+    debug_uart_init();
+
+#if defined(APP_FOOTPRINT_PROFILE)
+    /* Record the pool and stack high-water marks for the footprint profile */
+    footprint_profile_init();
+#endif
+
+#if defined(APP_SLEEP_STATS)
+    /* Count the sleep entries and the early wakes of the idle task */
+    sleep_stats_init();
+#endif
+
+#if defined(APP_TRACE_EVENTS)
+    /* Record the scheduling around the offload transitions */
+    trace_events_init();
+#endif
+
+    /* Print the logs from a low priority task */
+    CHECK_RESULT(app_log_init());
+
     /* \x1b[2J\x1b[;H - ANSI ESC sequence to clear screen */
     APP_INFO(("\x1b[2J\x1b[;H"));
     APP_INFO(("============================================\n"));
     APP_INFO(("AnyCloud Example: WLAN TCP Keepalive Offload\n"));
     APP_INFO(("============================================\n\n"));
+    APP_INFO(("Task topology: %s\n", TASK_TOPOLOGY_NAME));
 
     /* Start the FreeRTOS scheduler */
     vTaskStartScheduler();
 
     /* Should never get here */
+    app_log_flush();
     CY_ASSERT(0);
 }
 
@@ -145,13 +191,44 @@ void vApplicationDaemonTaskStartupHook()
     BaseType_t xReturned;
     cy_rslt_t  result;
 
+#if ENABLE_WARM_BOOT
+    /*
+     * After a software or watchdog reset, take the validated port table, the
+     * runtime configuration, and the join state saved by the previous boot.
+     */
+    (void)warm_boot_restore();
+#endif
+
+    /*
+     * Resolve the offload descriptors and validate the TCP Keepalive
+     * configuration once, before it is used by the connection paths.
+     */
+    offload_registry_init();
+
     /*
-     * Connect to Wi-Fi Access Point.
+     * Connect to Wi-Fi Access Point. On a warm boot the AP is joined directly
+     * with the saved state, if it is still valid.
      */
-    result = wifi_connect();
+#if ENABLE_WARM_BOOT
+    if (warm_boot_is_warm())
+    {
+        result = wifi_fast_rejoin_join();
+    }
+    else
+#endif
+    {
+        result = wifi_connect();
+    }
 
     PRINT_AND_ASSERT(result, "Wi-Fi connection failed.\n");
 
+#if ENABLE_TKO_TLS
+    /* Set up the TLS client that secures each connection once it is up */
+    result = tko_tls_init();
+
+    PRINT_AND_ASSERT(result, "TLS initialization failed.\n");
+#endif
+
     /*
      * Establish TCP socket connection with the configured TCP server.
      * Ensure the remote TCP server has already started before running this application.
@@ -161,15 +238,96 @@ void vApplicationDaemonTaskStartupHook()
     if (CY_RSLT_SUCCESS != result)
     {
         ERR_INFO(("One or more TCP socket connections failed.\n"));
-        /*
-         * Wait for few seconds to let the user notice about the socket
-         * connection failure before the network stats start to print
-         * on the serial terminal that would cause the user to miss seeing
-         * the error message.
-         */
-        vTaskDelay(pdMS_TO_TICKS(TCP_SOCKET_ERROR_DELAY_MS));
     }
 
+#if ENABLE_WARM_BOOT
+    /* Set the keepalive parameters changed at runtime by the previous boot again */
+    warm_boot_apply_overrides();
+
+    /* Let lwIP learn the ARP entries restored by the warm boot join again */
+    wifi_fast_rejoin_arp_release();
+#endif
+
+#if ENABLE_TKO_INTERVAL_PROBE
+    /* Learn the keepalive interval of each path from the health checks */
+    (void)tko_probe_init();
+#endif
+
+    /*
+     * Monitor the connections from now on. The ones that failed above, and any
+     * lost later, are reconnected one by one with an exponential back-off.
+     */
+    result = tko_health_init();
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Failed to start the TCP Keepalive health monitor.\n"));
+    }
+
+#if ENABLE_TKO_SESSION_MANAGER
+    /*
+     * Hand the connected offload slots over to the session manager, and open
+     * the sessions that do not fit in the firmware slots.
+     */
+    result = tko_session_manager_init();
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Failed to start the TCP Keepalive session manager.\n"));
+    }
+#endif
+
+#if ENABLE_WIFI_FAST_REJOIN
+    /*
+     * Cache the AP, DHCP lease, and ARP state now that the connections are up,
+     * and start watching for link loss.
+     */
+    result = wifi_fast_rejoin_init();
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Failed to start the Wi-Fi fast rejoin.\n"));
+    }
+#endif
+
+#if ENABLE_WIFI_AP_CANDIDATES
+    /* Scan for the other APs of the configured networks at the host wakes */
+    (void)wifi_ap_candidates_init();
+#endif
+
+#if ENABLE_WARM_BOOT
+    /* Save the state of this boot for the next warm boot */
+    (void)warm_boot_save();
+#endif
+
+#if ENABLE_TKO_PACKET_FILTER
+    /* Filter the traffic of the TCP Keepalive servers at each suspend */
+    (void)tko_pf_init();
+#endif
+
+#if ENABLE_WLAN_POWER_POLICY
+    /* Switch the WLAN power save settings with the suspend state from now on */
+    if (CY_RSLT_SUCCESS != wlan_power_policy_init())
+    {
+        ERR_INFO(("The WLAN firmware refused the power save settings.\n"));
+    }
+#endif
+
+#if ENABLE_TKO_UPLINK_QUEUE
+    /* Queue the application data until the host is awake anyway */
+    result = tko_uplink_init();
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Failed to start the uplink queue.\n"));
+    }
+#endif
+
+#if defined(APP_STATIC_ALLOCATION)
+    /* Report the use of the fixed arenas once all the connections are up */
+    static_allocation_report();
+#endif
+
     /*
      * Suspend/Resume network stack.
      * This task will cause PSoC 6 MCU to go into deep-sleep power mode. The PSoC 6 MCU
@@ -186,6 +344,7 @@ void vApplicationDaemonTaskStartupHook()
     if (pdPASS != xReturned)
     {
         APP_INFO(("Failed to create low power task.\n"));
+        app_log_flush();
         CY_ASSERT(0);
     }
 }
@@ -0,0 +1,372 @@
+/******************************************************************************
+* File Name:   network_suspend_scheduler.c
+*
+* Description: This file decides when the network stack is suspended. It
+*              reacts to EMAC activity and offload enable/disable
+*              notifications instead of polling, and adapts the inactivity
+*              window to the measured traffic pattern.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+
+/* LPA header file */
+#include "network_activity_handler.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "network_suspend_scheduler.h"
+#include "network_suspend_stats.h"
+
+#if defined(APP_TRACE_EVENTS)
+#include "trace_events.h"
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Gaps longer than this are treated as the end of a traffic burst */
+#define BURST_GAP_MAX_MS                  (NETWORK_INACTIVE_WINDOW_MS)
+
+/* Weight of a new sample in the moving average of the intra-burst gap (1/8) */
+#define GAP_AVERAGE_SHIFT                 (3)
+
+/* Inactivity window as a multiple of the average intra-burst gap */
+#define WINDOW_GAP_MULTIPLIER             (2)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static TaskHandle_t scheduler_task = NULL;
+
+/* Updated from the EMAC activity callback */
+static volatile TickType_t last_activity_tick = 0;
+static volatile bool waiting_for_idle = false;
+
+/* Moving average of the gap between packets of the same burst */
+static uint32_t average_gap_ms = NETWORK_INACTIVE_WINDOW_MS / WINDOW_GAP_MULTIPLIER;
+
+/* Hold-off before the next suspend; grows when the stack keeps bouncing */
+static uint32_t holdoff_ms = NETWORK_SUSPEND_GUARD_MS;
+
+/* True while the offload is enabled and the network stack is suspended */
+static volatile bool offload_enabled = false;
+
+/* Set when the wake is known to need no further network activity */
+static volatile bool expedite_pending = false;
+
+/********************************************************************************
+ * Function Name: network_activity_cb
+ ********************************************************************************
+ * Summary:
+ *  Called by the LPA network activity handler for every Tx/Rx packet on the EMAC
+ *  interface. Updates the intra-burst gap average and wakes the scheduler only
+ *  if it is waiting for the network to become idle.
+ *
+ * Parameters:
+ *  is_tx: true for transmitted packets, false for received packets.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void network_activity_cb(bool is_tx)
+{
+    TickType_t now = xTaskGetTickCount();
+    uint32_t gap_ms = (uint32_t)((now - last_activity_tick) * portTICK_PERIOD_MS);
+
+    (void)is_tx;
+
+    last_activity_tick = now;
+    net_suspend_stats_activity();
+
+    if ((gap_ms > 0) && (gap_ms < BURST_GAP_MAX_MS))
+    {
+        average_gap_ms = (uint32_t)((int32_t)average_gap_ms +
+                                    (((int32_t)gap_ms - (int32_t)average_gap_ms) >> GAP_AVERAGE_SHIFT));
+    }
+
+    if (waiting_for_idle && (NULL != scheduler_task))
+    {
+        xTaskNotifyGive(scheduler_task);
+    }
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_init
+ ********************************************************************************
+ * Summary:
+ *  Registers for the EMAC activity notifications of the LPA middleware.
+ *
+ * Parameters:
+ *  idle_task: Handle of the task that suspends the network stack.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_scheduler_init(TaskHandle_t idle_task)
+{
+    scheduler_task = idle_task;
+    last_activity_tick = xTaskGetTickCount();
+
+    cy_network_activity_register_cb(network_activity_cb);
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_wait_for_idle
+ ********************************************************************************
+ * Summary:
+ *  Blocks until no EMAC activity has been seen for the current hold-off, and
+ *  returns the inactivity interval and window to use for the next suspend. The
+ *  calling task sleeps on a task notification, so the MCU is free to enter
+ *  deep-sleep while it waits and wakes only when a packet extends the hold-off.
+ *  After net_suspend_scheduler_expedite(), the guard delay and the shortest
+ *  window are used instead.
+ *
+ * Parameters:
+ *  params: Filled in with the parameters for wait_net_suspend().
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_scheduler_wait_for_idle(net_suspend_params_t *params)
+{
+    TickType_t idle_ticks;
+    TickType_t holdoff_ticks;
+    uint32_t window_ms;
+
+    waiting_for_idle = true;
+
+    for (;;)
+    {
+        holdoff_ticks = pdMS_TO_TICKS(expedite_pending ? NETWORK_SUSPEND_GUARD_MS : holdoff_ms);
+        idle_ticks = xTaskGetTickCount() - last_activity_tick;
+
+        if (idle_ticks >= holdoff_ticks)
+        {
+            break;
+        }
+
+        (void)ulTaskNotifyTake(pdTRUE, holdoff_ticks - idle_ticks);
+    }
+
+    waiting_for_idle = false;
+
+    window_ms = net_suspend_scheduler_window_ms(average_gap_ms, expedite_pending);
+    expedite_pending = false;
+
+    params->inactive_window_ms = window_ms;
+    params->inactive_interval_ms = window_ms + (NETWORK_INACTIVE_INTERVAL_MS - NETWORK_INACTIVE_WINDOW_MS);
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_suspend_done
+ ********************************************************************************
+ * Summary:
+ *  Informs the scheduler that wait_net_suspend() has returned. If the network
+ *  stack was resumed shortly after it was suspended, the hold-off before the
+ *  next suspend is doubled to stop the stack from bouncing in and out of
+ *  suspend. Otherwise the hold-off decays back to NETWORK_SUSPEND_GUARD_MS.
+ *
+ * Parameters:
+ *  status: Return value of wait_net_suspend().
+ *  suspend_start: Tick count at which wait_net_suspend() was called.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_scheduler_suspend_done(int32_t status, TickType_t suspend_start)
+{
+    uint32_t elapsed_ms = (uint32_t)((xTaskGetTickCount() - suspend_start) * portTICK_PERIOD_MS);
+
+    net_suspend_scheduler_offload_event(false);
+
+    holdoff_ms = net_suspend_scheduler_next_holdoff_ms(holdoff_ms, status, elapsed_ms);
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_window_ms
+ ********************************************************************************
+ * Summary:
+ *  Sizes the inactivity window of the next suspend to cover the gaps seen
+ *  inside a burst, and no more, within the configured limits.
+ *
+ * Parameters:
+ *  average_gap_ms: Running average of the intra-burst packet gap.
+ *  expedite: true to use the shortest window regardless of the gap.
+ *
+ * Return:
+ *  uint32_t: Inactivity window in milliseconds.
+ *
+ *******************************************************************************/
+uint32_t net_suspend_scheduler_window_ms(uint32_t average_gap_ms, bool expedite)
+{
+    uint32_t window_ms = average_gap_ms * WINDOW_GAP_MULTIPLIER;
+
+    if ((window_ms < NETWORK_INACTIVE_WINDOW_MIN_MS) || expedite)
+    {
+        window_ms = NETWORK_INACTIVE_WINDOW_MIN_MS;
+    }
+    else if (window_ms > NETWORK_INACTIVE_WINDOW_MS)
+    {
+        window_ms = NETWORK_INACTIVE_WINDOW_MS;
+    }
+
+    return window_ms;
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_next_holdoff_ms
+ ********************************************************************************
+ * Summary:
+ *  Returns the hold-off before the next suspend: doubled up to the maximum if
+ *  the stack bounced out of a successful suspend, reset to the guard delay
+ *  after a suspend that lasted, and unchanged if the suspend failed.
+ *
+ * Parameters:
+ *  holdoff_ms: Current hold-off.
+ *  status: Return value of wait_net_suspend().
+ *  elapsed_ms: Time spent in wait_net_suspend().
+ *
+ * Return:
+ *  uint32_t: Hold-off in milliseconds.
+ *
+ *******************************************************************************/
+uint32_t net_suspend_scheduler_next_holdoff_ms(uint32_t holdoff_ms, int32_t status, uint32_t elapsed_ms)
+{
+    if ((ST_SUCCESS == status) && (elapsed_ms < NETWORK_SUSPEND_BOUNCE_MS))
+    {
+        holdoff_ms = (holdoff_ms < NETWORK_SUSPEND_DELAY_MS) ? NETWORK_SUSPEND_DELAY_MS : (holdoff_ms * 2);
+
+        if (holdoff_ms > NETWORK_SUSPEND_DELAY_MAX_MS)
+        {
+            holdoff_ms = NETWORK_SUSPEND_DELAY_MAX_MS;
+        }
+    }
+    else if (ST_SUCCESS == status)
+    {
+        holdoff_ms = NETWORK_SUSPEND_GUARD_MS;
+    }
+
+    return holdoff_ms;
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_offload_event
+ ********************************************************************************
+ * Summary:
+ *  Records an offload enable (network stack suspended) or disable (network
+ *  stack resumed) edge. A disable edge counts as network activity so that the
+ *  hold-off restarts from the moment the stack resumed.
+ *
+ * Parameters:
+ *  enabled: true when the offload was enabled, false when it was disabled.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_scheduler_offload_event(bool enabled)
+{
+    if (offload_enabled && !enabled)
+    {
+        last_activity_tick = xTaskGetTickCount();
+    }
+
+#if defined(APP_TRACE_EVENTS)
+    if (offload_enabled != enabled)
+    {
+        trace_events_record(enabled ? TRACE_EVENT_OFFLOAD_ENABLED : TRACE_EVENT_OFFLOAD_DISABLED, 0);
+    }
+#endif
+
+    offload_enabled = enabled;
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_is_offloaded
+ ********************************************************************************
+ * Summary:
+ *  Tells whether the network stack is handed to the offload, that is, whether
+ *  wait_net_suspend() is in progress.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool: true if the offload is enabled, false otherwise.
+ *
+ *******************************************************************************/
+bool net_suspend_scheduler_is_offloaded(void)
+{
+    return offload_enabled;
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_scheduler_expedite
+ ********************************************************************************
+ * Summary:
+ *  Requests that the network stack be suspended again as soon as possible,
+ *  because the current wake needs no further network activity. The next
+ *  suspend uses the guard delay and the shortest inactivity window, and the
+ *  hold-off of the bounce detection is reset.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_scheduler_expedite(void)
+{
+    holdoff_ms = NETWORK_SUSPEND_GUARD_MS;
+    expedite_pending = true;
+
+    if (waiting_for_idle && (NULL != scheduler_task))
+    {
+        xTaskNotifyGive(scheduler_task);
+    }
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,83 @@
+/******************************************************************************
+* File Name:   network_suspend_scheduler.h
+*
+* Description: This file is the public interface of
+*              network_suspend_scheduler.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef NETWORK_SUSPEND_SCHEDULER_H
+#define NETWORK_SUSPEND_SCHEDULER_H
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Parameters for the next wait_net_suspend() call */
+typedef struct
+{
+    uint32_t inactive_interval_ms;
+    uint32_t inactive_window_ms;
+} net_suspend_params_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void net_suspend_scheduler_init(TaskHandle_t idle_task);
+void net_suspend_scheduler_wait_for_idle(net_suspend_params_t *params);
+void net_suspend_scheduler_suspend_done(int32_t status, TickType_t suspend_start);
+void net_suspend_scheduler_offload_event(bool enabled);
+bool net_suspend_scheduler_is_offloaded(void);
+void net_suspend_scheduler_expedite(void);
+
+/* Decision functions of the scheduler. They keep no state and call no RTOS or
+ * middleware API, so that they can also be built and exercised off-target.
+ */
+uint32_t net_suspend_scheduler_window_ms(uint32_t average_gap_ms, bool expedite);
+uint32_t net_suspend_scheduler_next_holdoff_ms(uint32_t holdoff_ms, int32_t status, uint32_t elapsed_ms);
+
+#endif /* NETWORK_SUSPEND_SCHEDULER_H */
+
+
+/* [] END OF FILE */
+
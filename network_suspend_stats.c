@@ -0,0 +1,251 @@
+/******************************************************************************
+* File Name:   network_suspend_stats.c
+*
+* Description: This file keeps counters and timestamps for each phase of the
+*              network suspend/resume path and dumps them as a binary frame
+*              on the debug UART.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "cyhal.h"
+
+/* LPA header file */
+#include "network_activity_handler.h"
+
+#include "app_platform.h"
+#include "debug_uart.h"
+#include "network_suspend_stats.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Written only by the network idle task, read under a critical section */
+static net_suspend_stats_t stats;
+
+/* Timestamps of the suspend in progress */
+static TickType_t suspend_begin_tick;
+static TickType_t suspend_end_tick;
+static TickType_t activity_tick;
+static uint32_t activity_cycles;
+static volatile bool activity_pending = false;
+static volatile bool suspend_in_progress = false;
+
+/********************************************************************************
+ * Function Name: net_suspend_stats_init
+ ********************************************************************************
+ * Summary:
+ *  Resets the statistics, enables the DWT cycle counter used for the resume
+ *  latency, and registers the dump command on the debug UART.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_stats_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.version = NET_SUSPEND_STATS_VERSION;
+    suspend_end_tick = xTaskGetTickCount();
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    debug_uart_register_command(NET_SUSPEND_STATS_DUMP_COMMAND, net_suspend_stats_dump);
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_stats_suspend_begin
+ ********************************************************************************
+ * Summary:
+ *  Marks the call to wait_net_suspend(). The time since the previous call
+ *  returned is accounted as awake time.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_stats_suspend_begin(void)
+{
+    suspend_begin_tick = xTaskGetTickCount();
+    stats.awake_ms += TICKS_TO_MS(suspend_begin_tick - suspend_end_tick);
+    stats.suspend_calls++;
+
+    activity_pending = false;
+    suspend_in_progress = true;
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_stats_activity
+ ********************************************************************************
+ * Summary:
+ *  Called for each EMAC activity notification. Only records the latest
+ *  activity while a suspend is in progress, so the cost outside of that is a
+ *  single flag check.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_stats_activity(void)
+{
+    if (suspend_in_progress)
+    {
+        activity_tick = xTaskGetTickCount();
+        activity_cycles = DWT->CYCCNT;
+        activity_pending = true;
+    }
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_stats_suspend_end
+ ********************************************************************************
+ * Summary:
+ *  Marks the return of wait_net_suspend() and accounts the elapsed time.
+ *
+ *  On a successful suspend, the network stack is taken to be suspended once the
+ *  inactivity window has elapsed after the call, and to be resumed by the last
+ *  EMAC activity seen before the return. The time before that is accounted as
+ *  waiting for inactivity and the rest as suspended. The resume latency is the
+ *  time from that activity to the return. On a failed suspend, the whole time
+ *  is accounted as waiting for inactivity.
+ *
+ * Parameters:
+ *  status: Return value of wait_net_suspend().
+ *  inactive_window_ms: Inactivity window passed to wait_net_suspend().
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_stats_suspend_end(int32_t status, uint32_t inactive_window_ms)
+{
+    uint32_t now_cycles = DWT->CYCCNT;
+    uint32_t elapsed_ms;
+    uint32_t waiting_ms;
+    uint32_t latency_us;
+
+    suspend_in_progress = false;
+    suspend_end_tick = xTaskGetTickCount();
+    elapsed_ms = TICKS_TO_MS(suspend_end_tick - suspend_begin_tick);
+
+    stats.status_count[((status >= 0) && (status < NET_SUSPEND_STATS_MAX_STATUS)) ?
+                       status : (NET_SUSPEND_STATS_MAX_STATUS - 1)]++;
+
+    if ((ST_SUCCESS != status) || !activity_pending)
+    {
+        stats.waiting_ms += elapsed_ms;
+        return;
+    }
+
+    waiting_ms = TICKS_TO_MS(activity_tick - suspend_begin_tick);
+    waiting_ms = (waiting_ms < inactive_window_ms) ? waiting_ms : inactive_window_ms;
+
+    stats.waiting_ms += waiting_ms;
+    stats.suspended_ms += TICKS_TO_MS(activity_tick - suspend_begin_tick) - waiting_ms;
+    stats.awake_ms += TICKS_TO_MS(suspend_end_tick - activity_tick);
+
+    latency_us = (now_cycles - activity_cycles) / (SystemCoreClock / 1000000u);
+    stats.resume_latency_last_us = latency_us;
+    stats.resume_latency_total_us += latency_us;
+    stats.resume_count++;
+
+    if (latency_us > stats.resume_latency_max_us)
+    {
+        stats.resume_latency_max_us = latency_us;
+    }
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_stats_get
+ ********************************************************************************
+ * Summary:
+ *  Takes a consistent snapshot of the statistics.
+ *
+ * Parameters:
+ *  snapshot: Filled in with the current statistics.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_stats_get(net_suspend_stats_t *snapshot)
+{
+    taskENTER_CRITICAL();
+    *snapshot = stats;
+    taskEXIT_CRITICAL();
+
+    snapshot->uptime_ms = TICKS_TO_MS(xTaskGetTickCount());
+}
+
+/********************************************************************************
+ * Function Name: net_suspend_stats_dump
+ ********************************************************************************
+ * Summary:
+ *  Writes the statistics as a binary frame of type NET_SUSPEND_STATS_FRAME_TYPE
+ *  on the debug UART.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void net_suspend_stats_dump(void)
+{
+    net_suspend_stats_t snapshot;
+
+    net_suspend_stats_get(&snapshot);
+    debug_uart_write_frame(NET_SUSPEND_STATS_FRAME_TYPE, &snapshot, sizeof(snapshot));
+}
+
+
+/* [] END OF FILE */
+
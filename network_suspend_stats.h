@@ -0,0 +1,106 @@
+/******************************************************************************
+* File Name:   network_suspend_stats.h
+*
+* Description: This file is the public interface of network_suspend_stats.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef NETWORK_SUSPEND_STATS_H
+#define NETWORK_SUSPEND_STATS_H
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Debug UART command byte that dumps the statistics */
+#define NET_SUSPEND_STATS_DUMP_COMMAND           ('s')
+
+/* Debug UART frame type and layout version of the statistics dump */
+#define NET_SUSPEND_STATS_FRAME_TYPE             (0x01)
+#define NET_SUSPEND_STATS_VERSION                (1)
+
+/* wait_net_suspend() return codes counted individually. Larger codes share
+ * the last slot.
+ */
+#define NET_SUSPEND_STATS_MAX_STATUS             (8)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Layout of the statistics dump. All fields are little-endian. */
+typedef struct __attribute__((packed))
+{
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t uptime_ms;
+
+    /* wait_net_suspend() calls and their outcome, by return code */
+    uint32_t suspend_calls;
+    uint32_t status_count[NET_SUSPEND_STATS_MAX_STATUS];
+
+    /* Time spent awake between suspends, waiting for inactivity, and suspended */
+    uint64_t awake_ms;
+    uint64_t waiting_ms;
+    uint64_t suspended_ms;
+
+    /* EMAC activity to the lwIP stack running again, in microseconds */
+    uint32_t resume_latency_last_us;
+    uint32_t resume_latency_max_us;
+    uint64_t resume_latency_total_us;
+    uint32_t resume_count;
+} net_suspend_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void net_suspend_stats_init(void);
+void net_suspend_stats_suspend_begin(void);
+void net_suspend_stats_activity(void);
+void net_suspend_stats_suspend_end(int32_t status, uint32_t inactive_window_ms);
+void net_suspend_stats_get(net_suspend_stats_t *stats);
+void net_suspend_stats_dump(void);
+
+#endif /* NETWORK_SUSPEND_STATS_H */
+
+
+/* [] END OF FILE */
+
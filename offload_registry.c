@@ -0,0 +1,487 @@
+/******************************************************************************
+* File Name:   offload_registry.c
+*
+* Description: This file resolves the configurator-generated offload
+*              descriptors once at startup and provides constant-time lookup
+*              by offload type, along with the pre-validated TCP Keepalive
+*              port entries.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <string.h>
+
+/* lwIP header files */
+#include "lwip/ip_addr.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "tcp_keepalive_offload.h"
+#include "offload_registry.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Descriptor name of each offload type, indexed by offload_type_t */
+static const char *const offload_names[OFFLOAD_TYPE_MAX] =
+{
+    [OFFLOAD_TYPE_ARP]           = OFFLOAD_NAME_ARP,
+    [OFFLOAD_TYPE_PACKET_FILTER] = OFFLOAD_NAME_PACKET_FILTER,
+    [OFFLOAD_TYPE_TKO]           = OFFLOAD_NAME_TKO,
+};
+
+/* Resolved descriptor of each offload type, NULL if not configured */
+static const ol_desc_t *offload_descriptors[OFFLOAD_TYPE_MAX];
+
+/* Bit n is set if TCP Keepalive port n has a usable configuration */
+static uint32_t tko_valid_ports = 0;
+static uint32_t tko_valid_port_count = 0;
+
+/* Remote address of each valid port, parsed once, and the IPv6 ones */
+static ip_addr_t tko_remote_addr[MAX_TKO];
+static uint32_t tko_ipv6_ports = 0;
+
+/* Incremented each time a port is set or released after the validation */
+static uint32_t tko_port_generation = 0;
+
+static bool registry_ready = false;
+
+/* Set when the port table was restored instead of validated */
+static bool tko_ports_restored = false;
+
+/********************************************************************************
+ * Function Name: offload_registry_init
+ ********************************************************************************
+ * Summary:
+ *  Walks the offload list defined by the configurator once, records the
+ *  descriptor of each known offload type, and validates the TCP Keepalive port
+ *  table. The remote IP address of each port is parsed as IPv4 or IPv6 here,
+ *  and ports with a malformed address are skipped. In the IPv6-only build the
+ *  IPv4 ports are skipped too. The validation is skipped if the port table was
+ *  restored with offload_registry_tko_restore(). Calling it again has no effect.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the TCP Keepalive offload is configured,
+ *  CY_RSLT_TYPE_ERROR otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t offload_registry_init(void)
+{
+    const ol_desc_t *offloads_list;
+    const cy_tko_ol_cfg_t *tko_cfg;
+    const cy_tko_ol_connect_t *port;
+    int type;
+    int index;
+
+    if (registry_ready)
+    {
+        return (NULL != offload_descriptors[OFFLOAD_TYPE_TKO]) ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
+    }
+
+    /* Take offload configuration defined by the configurator */
+    for (offloads_list = (const ol_desc_t *)get_default_ol_list();
+         offloads_list && offloads_list->name;
+         offloads_list++)
+    {
+        for (type = 0; type < OFFLOAD_TYPE_MAX; type++)
+        {
+            if ((NULL == offload_descriptors[type]) &&
+                (0 == strcmp(offloads_list->name, offload_names[type])))
+            {
+                offload_descriptors[type] = offloads_list;
+                break;
+            }
+        }
+    }
+
+    /* Validate the TCP Keepalive port table once */
+    if (!tko_ports_restored &&
+        (NULL != offload_descriptors[OFFLOAD_TYPE_TKO]) &&
+        (NULL != offload_descriptors[OFFLOAD_TYPE_TKO]->cfg))
+    {
+        tko_cfg = (const cy_tko_ol_cfg_t *)offload_descriptors[OFFLOAD_TYPE_TKO]->cfg;
+
+        for (index = 0; index < MAX_TKO; index++)
+        {
+            port = &tko_cfg->ports[index];
+
+            if ((0 == port->remote_port) || (0 == port->local_port) ||
+                ('\0' == port->remote_ip[0]) || (0 == strcmp(port->remote_ip, NULL_IP_ADDRESS)))
+            {
+                continue;
+            }
+
+            if (!ipaddr_aton(port->remote_ip, &tko_remote_addr[index]) || ip_addr_isany(&tko_remote_addr[index]))
+            {
+                ERR_INFO(("Socket[%d]: Invalid remote IP address %s, skipped\n", index, port->remote_ip));
+                continue;
+            }
+
+#if defined(APP_IPV6_ONLY)
+            if (!IP_IS_V6(&tko_remote_addr[index]))
+            {
+                ERR_INFO(("Socket[%d]: %s is not an IPv6 address, skipped in the IPv6-only build\n",
+                          index, port->remote_ip));
+                continue;
+            }
+#endif
+
+            if (IP_IS_V6(&tko_remote_addr[index]))
+            {
+                tko_ipv6_ports |= (1u << index);
+            }
+
+            tko_valid_ports |= (1u << index);
+            tko_valid_port_count++;
+        }
+    }
+
+    registry_ready = true;
+
+    if (NULL == offload_descriptors[OFFLOAD_TYPE_TKO])
+    {
+        ERR_INFO(("Unable to find %s offloads configuration\n", OFFLOAD_NAME_TKO));
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_restore
+ ********************************************************************************
+ * Summary:
+ *  Sets the valid TCP Keepalive ports and their parsed remote addresses, such
+ *  as the ones saved by the previous boot, so that offload_registry_init() does
+ *  not parse and validate the port table again. Call it before
+ *  offload_registry_init(); it has no effect afterwards.
+ *
+ * Parameters:
+ *  valid_ports: Bit n is set if port n is valid.
+ *  remote_addr: Remote address of each port, MAX_TKO entries.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void offload_registry_tko_restore(uint32_t valid_ports, const ip_addr_t *remote_addr)
+{
+    int index;
+
+    if (registry_ready)
+    {
+        return;
+    }
+
+    tko_valid_ports = 0;
+    tko_valid_port_count = 0;
+    tko_ipv6_ports = 0;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (0 == (valid_ports & (1u << index)))
+        {
+            continue;
+        }
+
+        ip_addr_copy(tko_remote_addr[index], remote_addr[index]);
+
+        if (IP_IS_V6(&tko_remote_addr[index]))
+        {
+            tko_ipv6_ports |= (1u << index);
+        }
+
+        tko_valid_ports |= (1u << index);
+        tko_valid_port_count++;
+    }
+
+    tko_ports_restored = true;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_get
+ ********************************************************************************
+ * Summary:
+ *  Returns the descriptor of the given offload type.
+ *
+ * Parameters:
+ *  type: Offload type.
+ *
+ * Return:
+ *  const ol_desc_t *: Offload descriptor, or NULL if the offload is not
+ *  configured.
+ *
+ *******************************************************************************/
+const ol_desc_t *offload_registry_get(offload_type_t type)
+{
+    if (!registry_ready)
+    {
+        offload_registry_init();
+    }
+
+    return ((unsigned)type < OFFLOAD_TYPE_MAX) ? offload_descriptors[type] : NULL;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_find
+ ********************************************************************************
+ * Summary:
+ *  Returns the descriptor with the given name. Only the offload types known to
+ *  the registry can be found.
+ *
+ * Parameters:
+ *  name: Offload descriptor name, such as OFFLOAD_NAME_TKO.
+ *
+ * Return:
+ *  const ol_desc_t *: Offload descriptor, or NULL if it is not configured.
+ *
+ *******************************************************************************/
+const ol_desc_t *offload_registry_find(const char *name)
+{
+    int type;
+
+    for (type = 0; type < OFFLOAD_TYPE_MAX; type++)
+    {
+        if (0 == strcmp(name, offload_names[type]))
+        {
+            return offload_registry_get((offload_type_t)type);
+        }
+    }
+
+    return NULL;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_port_valid
+ ********************************************************************************
+ * Summary:
+ *  Tells whether a TCP Keepalive port entry has a non-zero local and remote
+ *  port and a well-formed remote IP address, as validated when the registry
+ *  was built.
+ *
+ * Parameters:
+ *  index: Index of the port in the TCP Keepalive port table.
+ *
+ * Return:
+ *  bool: true if the port entry can be connected, false otherwise.
+ *
+ *******************************************************************************/
+bool offload_registry_tko_port_valid(int index)
+{
+    if (!registry_ready)
+    {
+        offload_registry_init();
+    }
+
+    return (index >= 0) && (index < MAX_TKO) && (0 != (tko_valid_ports & (1u << index)));
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_port_count
+ ********************************************************************************
+ * Summary:
+ *  Returns the number of valid TCP Keepalive port entries.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Number of valid port entries.
+ *
+ *******************************************************************************/
+uint32_t offload_registry_tko_port_count(void)
+{
+    if (!registry_ready)
+    {
+        offload_registry_init();
+    }
+
+    return tko_valid_port_count;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_remote_addr
+ ********************************************************************************
+ * Summary:
+ *  Returns the remote IP address of a TCP Keepalive port, as parsed when the
+ *  registry was built. Use IP_IS_V6() to tell the IP version.
+ *
+ * Parameters:
+ *  index: Index of the port in the TCP Keepalive port table.
+ *
+ * Return:
+ *  const ip_addr_t *: Remote IP address, or NULL if the port is not valid.
+ *
+ *******************************************************************************/
+const ip_addr_t *offload_registry_tko_remote_addr(int index)
+{
+    return offload_registry_tko_port_valid(index) ? &tko_remote_addr[index] : NULL;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_port_set
+ ********************************************************************************
+ * Summary:
+ *  Validates a new entry of the TCP Keepalive port table, such as one written
+ *  by the session manager when it moves a session into a firmware slot, and
+ *  records its remote address. The port is marked not valid if the entry is
+ *  not usable.
+ *
+ * Parameters:
+ *  index: Index of the port in the TCP Keepalive port table.
+ *  port: New entry of the port.
+ *
+ * Return:
+ *  bool: true if the entry is valid, false otherwise.
+ *
+ *******************************************************************************/
+bool offload_registry_tko_port_set(int index, const cy_tko_ol_connect_t *port)
+{
+    ip_addr_t addr;
+    bool valid;
+
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return false;
+    }
+
+    offload_registry_tko_port_release(index);
+
+    valid = (0 != port->remote_port) && (0 != port->local_port) && ('\0' != port->remote_ip[0]) &&
+            ipaddr_aton(port->remote_ip, &addr) && !ip_addr_isany(&addr);
+
+#if defined(APP_IPV6_ONLY)
+    valid = valid && IP_IS_V6(&addr);
+#endif
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    ip_addr_copy(tko_remote_addr[index], addr);
+
+    if (IP_IS_V6(&addr))
+    {
+        tko_ipv6_ports |= (1u << index);
+    }
+
+    tko_valid_ports |= (1u << index);
+    tko_valid_port_count++;
+    tko_port_generation++;
+
+    return true;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_port_release
+ ********************************************************************************
+ * Summary:
+ *  Marks a TCP Keepalive port as not valid, such as when the session manager
+ *  closes the session of a firmware slot, so that it is neither connected nor
+ *  filtered until it is set again.
+ *
+ * Parameters:
+ *  index: Index of the port in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void offload_registry_tko_port_release(int index)
+{
+    if (!offload_registry_tko_port_valid(index))
+    {
+        return;
+    }
+
+    tko_valid_ports &= ~(1u << index);
+    tko_ipv6_ports &= ~(1u << index);
+    tko_valid_port_count--;
+    tko_port_generation++;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_generation
+ ********************************************************************************
+ * Summary:
+ *  Returns a counter that changes each time a TCP Keepalive port is set or
+ *  released, so that the state derived from the port table, such as the
+ *  packet filters, can be rebuilt when the table changes.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Generation of the TCP Keepalive port table.
+ *
+ *******************************************************************************/
+uint32_t offload_registry_tko_generation(void)
+{
+    return tko_port_generation;
+}
+
+/********************************************************************************
+ * Function Name: offload_registry_tko_has_ipv6
+ ********************************************************************************
+ * Summary:
+ *  Tells whether any valid TCP Keepalive port connects to an IPv6 server, so
+ *  that an IPv6 address is needed.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool: true if at least one port has an IPv6 remote address.
+ *
+ *******************************************************************************/
+bool offload_registry_tko_has_ipv6(void)
+{
+    if (!registry_ready)
+    {
+        offload_registry_init();
+    }
+
+    return (0 != tko_ipv6_ports);
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,95 @@
+/******************************************************************************
+* File Name:   offload_registry.h
+*
+* Description: This file is the public interface of offload_registry.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef OFFLOAD_REGISTRY_H
+#define OFFLOAD_REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "lwip/ip_addr.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Offload descriptor names used by the configurator-generated offload list */
+#define OFFLOAD_NAME_ARP                         "ARP"
+#define OFFLOAD_NAME_PACKET_FILTER               "Pkt_Filter"
+#define OFFLOAD_NAME_TKO                         "TKO"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Offload types known to the registry */
+typedef enum
+{
+    OFFLOAD_TYPE_ARP = 0,
+    OFFLOAD_TYPE_PACKET_FILTER,
+    OFFLOAD_TYPE_TKO,
+    OFFLOAD_TYPE_MAX
+} offload_type_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t offload_registry_init(void);
+void offload_registry_tko_restore(uint32_t valid_ports, const ip_addr_t *remote_addr);
+const ol_desc_t *offload_registry_get(offload_type_t type);
+const ol_desc_t *offload_registry_find(const char *name);
+bool offload_registry_tko_port_valid(int index);
+uint32_t offload_registry_tko_port_count(void);
+const ip_addr_t *offload_registry_tko_remote_addr(int index);
+bool offload_registry_tko_has_ipv6(void);
+bool offload_registry_tko_port_set(int index, const cy_tko_ol_connect_t *port);
+void offload_registry_tko_port_release(int index);
+uint32_t offload_registry_tko_generation(void);
+
+#endif /* OFFLOAD_REGISTRY_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,245 @@
+/******************************************************************************
+* File Name:   retry_scheduler.c
+*
+* Description: This file implements the retry scheduler shared by the Wi-Fi
+*              join and the TCP socket connections. It spaces the attempts
+*              with an exponential back-off and a per-device random jitter,
+*              and gives up when the attempt or power budget is spent. The
+*              MCU sleeps in between attempts.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include "app_platform.h"
+#include "retry_scheduler.h"
+
+/********************************************************************************
+ * Function Name: retry_mix
+ ********************************************************************************
+ * Summary:
+ *  Mixes all the bits of a value into each bit of the result (the finalizer of
+ *  MurmurHash3), so that device IDs that differ in a few bits only give
+ *  unrelated jitter sequences.
+ *
+ * Parameters:
+ *  x: Value to mix.
+ *
+ * Return:
+ *  uint32_t: Mixed value.
+ *
+ *******************************************************************************/
+static uint32_t retry_mix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+
+    return x;
+}
+
+/********************************************************************************
+ * Function Name: retry_random
+ ********************************************************************************
+ * Summary:
+ *  Returns the next value of the xorshift32 generator of the retried operation.
+ *
+ * Parameters:
+ *  state: State of the retried operation.
+ *
+ * Return:
+ *  uint32_t: Pseudo random value.
+ *
+ *******************************************************************************/
+static uint32_t retry_random(retry_state_t *state)
+{
+    uint32_t x = state->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state->seed = x;
+
+    return x;
+}
+
+/********************************************************************************
+ * Function Name: retry_init
+ ********************************************************************************
+ * Summary:
+ *  Initializes the state of a retried operation. The jitter is seeded from the
+ *  unique ID of the device so that devices which power up together spread out
+ *  their attempts. If the policy has an initial jitter, the calling task sleeps
+ *  for a random part of it.
+ *
+ * Parameters:
+ *  state: State of the retried operation.
+ *  policy: Retry policy to apply. Must stay valid while the state is in use.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void retry_init(retry_state_t *state, const retry_policy_t *policy)
+{
+    uint64_t unique_id = APP_PLATFORM_DEVICE_ID();
+
+    state->policy = policy;
+    state->attempt = 0;
+    state->spent_ms = 0;
+    state->seed = retry_mix((uint32_t)unique_id ^ (uint32_t)(unique_id >> 32) ^ APP_PLATFORM_NOW_MS());
+
+    if (0 == state->seed)
+    {
+        state->seed = 1;
+    }
+
+    if (policy->initial_jitter_ms > 0)
+    {
+        APP_PLATFORM_SLEEP_MS(retry_random(state) % policy->initial_jitter_ms);
+    }
+}
+
+/********************************************************************************
+ * Function Name: retry_attempt_begin
+ ********************************************************************************
+ * Summary:
+ *  Marks the start of an attempt, to account its duration against the budget.
+ *
+ * Parameters:
+ *  state: State of the retried operation.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void retry_attempt_begin(retry_state_t *state)
+{
+    state->attempt_start_ms = APP_PLATFORM_NOW_MS();
+}
+
+/********************************************************************************
+ * Function Name: retry_next_delay_ms
+ ********************************************************************************
+ * Summary:
+ *  Returns the delay before the next attempt: the base delay doubled for each
+ *  failed attempt up to the maximum delay, of which a random half is taken
+ *  ("equal jitter").
+ *
+ * Parameters:
+ *  state: State of the retried operation.
+ *
+ * Return:
+ *  uint32_t: Delay in milliseconds.
+ *
+ *******************************************************************************/
+uint32_t retry_next_delay_ms(retry_state_t *state)
+{
+    const retry_policy_t *policy = state->policy;
+    uint32_t delay_ms = policy->base_delay_ms;
+    uint32_t index;
+
+    for (index = 1; (index < state->attempt) && (delay_ms < policy->max_delay_ms); index++)
+    {
+        delay_ms *= 2;
+    }
+
+    if (delay_ms > policy->max_delay_ms)
+    {
+        delay_ms = policy->max_delay_ms;
+    }
+
+    return (delay_ms / 2) + ((delay_ms > 1) ? (retry_random(state) % (delay_ms / 2)) : 0);
+}
+
+/********************************************************************************
+ * Function Name: retry_attempt_record_failure
+ ********************************************************************************
+ * Summary:
+ *  Accounts a failed attempt without waiting. The caller schedules the next
+ *  attempt after retry_next_delay_ms() itself.
+ *
+ * Parameters:
+ *  state: State of the retried operation.
+ *
+ * Return:
+ *  bool: true if the operation should be attempted again, false if the attempt
+ *  limit or the power budget is reached.
+ *
+ *******************************************************************************/
+bool retry_attempt_record_failure(retry_state_t *state)
+{
+    const retry_policy_t *policy = state->policy;
+
+    state->attempt++;
+    state->spent_ms += APP_PLATFORM_NOW_MS() - state->attempt_start_ms;
+
+    return !(((0 != policy->max_attempts) && (state->attempt >= policy->max_attempts)) ||
+             ((0 != policy->budget_ms) && (state->spent_ms >= policy->budget_ms)));
+}
+
+/********************************************************************************
+ * Function Name: retry_attempt_failed
+ ********************************************************************************
+ * Summary:
+ *  Accounts a failed attempt. If another attempt is allowed by the policy, the
+ *  calling task sleeps for the back-off delay, which lets the MCU enter
+ *  deep-sleep, and true is returned.
+ *
+ * Parameters:
+ *  state: State of the retried operation.
+ *
+ * Return:
+ *  bool: true if the operation should be attempted again, false if the attempt
+ *  limit or the power budget is reached.
+ *
+ *******************************************************************************/
+bool retry_attempt_failed(retry_state_t *state)
+{
+    if (!retry_attempt_record_failure(state))
+    {
+        return false;
+    }
+
+    APP_PLATFORM_SLEEP_MS(retry_next_delay_ms(state));
+
+    return true;
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,84 @@
+/******************************************************************************
+* File Name:   retry_scheduler.h
+*
+* Description: This file is the public interface of retry_scheduler.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef RETRY_SCHEDULER_H
+#define RETRY_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Retry policy. A value of 0 for max_attempts or budget_ms means no limit. */
+typedef struct
+{
+    uint32_t initial_jitter_ms;   /* Random delay before the first attempt */
+    uint32_t base_delay_ms;       /* Delay after the first failed attempt */
+    uint32_t max_delay_ms;        /* Upper limit of the exponential back-off */
+    uint32_t max_attempts;        /* Attempts before giving up */
+    uint32_t budget_ms;           /* Awake time that can be spent on attempts */
+} retry_policy_t;
+
+/* State of one retried operation */
+typedef struct
+{
+    const retry_policy_t *policy;
+    uint32_t attempt;
+    uint32_t spent_ms;
+    uint32_t seed;
+    uint32_t attempt_start_ms;
+} retry_state_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void retry_init(retry_state_t *state, const retry_policy_t *policy);
+void retry_attempt_begin(retry_state_t *state);
+bool retry_attempt_failed(retry_state_t *state);
+bool retry_attempt_record_failure(retry_state_t *state);
+uint32_t retry_next_delay_ms(retry_state_t *state);
+
+#endif /* RETRY_SCHEDULER_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,517 @@
+/******************************************************************************
+* File Name:   sleep_stats.c
+*
+* Description: This file counts the sleep and deep-sleep entries of the
+*              tickless idle, their residency, and the source of the early
+*              wakes.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "cyhal.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+#include "debug_uart.h"
+#include "sleep_stats.h"
+#include "tcp_keepalive_offload.h"
+
+#if defined(APP_SLEEP_STATS)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    SLEEP_STATS_MODE_SLEEP = 0,
+    SLEEP_STATS_MODE_DEEPSLEEP,
+    SLEEP_STATS_MODE_COUNT
+} sleep_stats_mode_t;
+
+/* Task or timer that ended sleeps early. The name is copied, as tasks such
+ * as the socket connect tasks are deleted.
+ */
+typedef struct
+{
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t count;
+} sleep_stats_source_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+/* Tickless idle implementation of the RTOS abstraction library */
+extern void vApplicationSleep(uint32_t xExpectedIdleTime);
+
+static bool sleep_stats_syspm_cb(cyhal_syspm_callback_state_t state, cyhal_syspm_callback_mode_t mode, void *arg);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const char *const sleep_mode_name[SLEEP_STATS_MODE_COUNT] = { "Sleep", "Deep sleep" };
+
+/* Free running LP timer of the residency and of the run-time statistics */
+static cyhal_lptimer_t counter_timer;
+static bool counter_ready = false;
+
+static cyhal_syspm_callback_data_t syspm_cb_data =
+{
+    .callback     = sleep_stats_syspm_cb,
+    .states       = (cyhal_syspm_callback_state_t)(CYHAL_SYSPM_CB_CPU_SLEEP | CYHAL_SYSPM_CB_CPU_DEEPSLEEP),
+    .ignore_modes = (cyhal_syspm_callback_mode_t)(CYHAL_SYSPM_CHECK_READY | CYHAL_SYSPM_BEFORE_TRANSITION),
+    .args         = NULL,
+    .next         = NULL
+};
+
+/* Set by the power mode callback when the CPU comes back from each mode */
+static volatile bool mode_entered[SLEEP_STATS_MODE_COUNT];
+
+static uint32_t sleep_calls = 0;
+static uint32_t sleep_not_entered = 0;
+static uint32_t deepsleep_refused = 0;
+static uint32_t mode_entries[SLEEP_STATS_MODE_COUNT];
+static uint64_t mode_residency_ms[SLEEP_STATS_MODE_COUNT];
+static uint32_t residency_histogram[SLEEP_STATS_MODE_COUNT][SLEEP_STATS_HISTOGRAM_BUCKETS];
+
+static uint32_t early_wakes = 0;
+static sleep_stats_source_t wake_sources[SLEEP_STATS_MAX_WAKE_SOURCES];
+static uint32_t wake_source_count = 0;
+static uint32_t other_wakes = 0;
+
+/* An early wake waiting for the first task switched in, and for the timer
+ * when that task is the timer service task.
+ */
+static volatile bool wake_pending = false;
+static volatile bool wake_timer_pending = false;
+
+static TaskStatus_t task_status[SLEEP_STATS_MAX_TASKS];
+
+/********************************************************************************
+ * Function Name: sleep_stats_syspm_cb
+ ********************************************************************************
+ * Summary:
+ *  Power mode callback. Records the sleep and deep-sleep entries, and the
+ *  deep-sleep requests refused by another driver.
+ *
+ * Parameters:
+ *  state: CPU power mode of the transition.
+ *  mode: Stage of the transition.
+ *  arg: Unused.
+ *
+ * Return:
+ *  bool: Always true, the statistics never block a transition.
+ *
+ *******************************************************************************/
+static bool sleep_stats_syspm_cb(cyhal_syspm_callback_state_t state, cyhal_syspm_callback_mode_t mode, void *arg)
+{
+    sleep_stats_mode_t sleep_mode = (CYHAL_SYSPM_CB_CPU_DEEPSLEEP == state) ?
+                                    SLEEP_STATS_MODE_DEEPSLEEP : SLEEP_STATS_MODE_SLEEP;
+
+    (void)arg;
+
+    if (CYHAL_SYSPM_AFTER_TRANSITION == mode)
+    {
+        mode_entered[sleep_mode] = true;
+    }
+    else if ((CYHAL_SYSPM_CHECK_FAIL == mode) && (SLEEP_STATS_MODE_DEEPSLEEP == sleep_mode))
+    {
+        deepsleep_refused++;
+    }
+
+    return true;
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_attribute
+ ********************************************************************************
+ * Summary:
+ *  Counts an early wake against its source.
+ *
+ * Parameters:
+ *  name: Name of the task or timer. NULL for an interrupt that made no task
+ *  ready.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sleep_stats_attribute(const char *name)
+{
+    uint32_t index;
+
+    name = (NULL != name) ? name : "(interrupt)";
+
+    for (index = 0; index < wake_source_count; index++)
+    {
+        if (0 == strncmp(wake_sources[index].name, name, sizeof(wake_sources[index].name) - 1))
+        {
+            wake_sources[index].count++;
+            return;
+        }
+    }
+
+    if (wake_source_count < SLEEP_STATS_MAX_WAKE_SOURCES)
+    {
+        strncpy(wake_sources[wake_source_count].name, name, sizeof(wake_sources[wake_source_count].name) - 1);
+        wake_sources[wake_source_count].count = 1;
+        wake_source_count++;
+    }
+    else
+    {
+        other_wakes++;
+    }
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_bucket
+ ********************************************************************************
+ * Summary:
+ *  Returns the histogram bucket of a residency.
+ *
+ * Parameters:
+ *  residency_ms: Time spent in the power mode, in milliseconds.
+ *
+ * Return:
+ *  uint32_t: Bucket index, see SLEEP_STATS_HISTOGRAM_BUCKETS.
+ *
+ *******************************************************************************/
+static uint32_t sleep_stats_bucket(uint32_t residency_ms)
+{
+    uint32_t bucket = (0 == residency_ms) ? 0 : (uint32_t)(32 - __builtin_clz(residency_ms));
+
+    return (bucket < SLEEP_STATS_HISTOGRAM_BUCKETS) ? bucket : (SLEEP_STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_sleep
+ ********************************************************************************
+ * Summary:
+ *  portSUPPRESS_TICKS_AND_SLEEP() of the statistics build. Runs the tickless
+ *  idle of the RTOS abstraction library and records the power mode it reached
+ *  and for how long. A sleep that ends before the expected idle time is an
+ *  early wake, attributed to the first task switched in after it.
+ *
+ * Parameters:
+ *  expected_idle_time: Ticks until the next task or timer is due.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sleep_stats_sleep(uint32_t expected_idle_time)
+{
+    sleep_stats_mode_t mode;
+    uint32_t start;
+    uint32_t residency_ms;
+
+    /* The previous early wake made no task ready, or ran a pended function */
+    if (wake_pending)
+    {
+        wake_pending = false;
+        sleep_stats_attribute(NULL);
+    }
+    else if (wake_timer_pending)
+    {
+        wake_timer_pending = false;
+        sleep_stats_attribute(configTIMER_SERVICE_TASK_NAME);
+    }
+
+    mode_entered[SLEEP_STATS_MODE_SLEEP] = false;
+    mode_entered[SLEEP_STATS_MODE_DEEPSLEEP] = false;
+    sleep_calls++;
+
+    start = sleep_stats_counter_read();
+    vApplicationSleep(expected_idle_time);
+    residency_ms = (uint32_t)(((uint64_t)(sleep_stats_counter_read() - start) * 1000u) / SLEEP_STATS_LPTIMER_HZ);
+
+    if (mode_entered[SLEEP_STATS_MODE_DEEPSLEEP])
+    {
+        mode = SLEEP_STATS_MODE_DEEPSLEEP;
+    }
+    else if (mode_entered[SLEEP_STATS_MODE_SLEEP])
+    {
+        mode = SLEEP_STATS_MODE_SLEEP;
+    }
+    else
+    {
+        /* A task became ready before the CPU went to sleep */
+        sleep_not_entered++;
+        return;
+    }
+
+    mode_entries[mode]++;
+    mode_residency_ms[mode] += residency_ms;
+    residency_histogram[mode][sleep_stats_bucket(residency_ms)]++;
+
+    /* The idle time can be close to portMAX_DELAY, so it is converted in 64 bits */
+    if (((uint64_t)residency_ms + SLEEP_STATS_EARLY_WAKE_MARGIN_MS) <
+        (((uint64_t)expected_idle_time * 1000u) / configTICK_RATE_HZ))
+    {
+        early_wakes++;
+        wake_pending = true;
+    }
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_counter_init
+ ********************************************************************************
+ * Summary:
+ *  portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() of the statistics build. Starts a
+ *  free running LP timer. It keeps counting in deep sleep and raises no
+ *  interrupt.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sleep_stats_counter_init(void)
+{
+    counter_ready = (CY_RSLT_SUCCESS == cyhal_lptimer_init(&counter_timer));
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_counter_read
+ ********************************************************************************
+ * Summary:
+ *  portGET_RUN_TIME_COUNTER_VALUE() of the statistics build. The counter
+ *  wraps after about 36 hours.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: LP timer count, at SLEEP_STATS_LPTIMER_HZ.
+ *
+ *******************************************************************************/
+uint32_t sleep_stats_counter_read(void)
+{
+    return counter_ready ? cyhal_lptimer_read(&counter_timer) : 0;
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_task_switched_in
+ ********************************************************************************
+ * Summary:
+ *  traceTASK_SWITCHED_IN() of the statistics build. Attributes a pending early
+ *  wake to the task switched in. For the timer service task, the wake is
+ *  attributed to the timer it runs next.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sleep_stats_task_switched_in(void)
+{
+    const char *name;
+    bool timer_task;
+
+    if (!wake_pending && !wake_timer_pending)
+    {
+        return;
+    }
+
+    name = pcTaskGetName(NULL);
+
+    if (0 == strcmp(name, configIDLE_TASK_NAME))
+    {
+        return;
+    }
+
+    timer_task = (0 == strcmp(name, configTIMER_SERVICE_TASK_NAME));
+
+    if (wake_timer_pending && !timer_task)
+    {
+        /* The timer service task ran a pended function, not a timer */
+        wake_timer_pending = false;
+        sleep_stats_attribute(configTIMER_SERVICE_TASK_NAME);
+    }
+
+    if (wake_pending)
+    {
+        wake_pending = false;
+
+        if (timer_task)
+        {
+            wake_timer_pending = true;
+        }
+        else
+        {
+            sleep_stats_attribute(name);
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_timer_expired
+ ********************************************************************************
+ * Summary:
+ *  traceTIMER_EXPIRED() of the statistics build. Attributes a pending early
+ *  wake to the software timer.
+ *
+ * Parameters:
+ *  timer: Expired timer.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sleep_stats_timer_expired(void *timer)
+{
+    if (wake_timer_pending)
+    {
+        wake_timer_pending = false;
+        sleep_stats_attribute(pcTimerGetName((TimerHandle_t)timer));
+    }
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the sleep statistics and the run time of each task. It is run by the
+ *  debug UART command SLEEP_STATS_REPORT_COMMAND.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sleep_stats_report(void)
+{
+    UBaseType_t task_count;
+    uint32_t total_run_time;
+    uint32_t mode;
+    uint32_t bucket;
+    uint32_t index;
+
+    APP_INFO(("Idle sleeps: %"PRIu32", not entered: %"PRIu32", deep sleep refused: %"PRIu32"\n",
+              sleep_calls, sleep_not_entered, deepsleep_refused));
+
+    for (mode = 0; mode < SLEEP_STATS_MODE_COUNT; mode++)
+    {
+        APP_INFO(("%s: %"PRIu32" entries, %"PRIu32" ms\n", sleep_mode_name[mode],
+                  mode_entries[mode], (uint32_t)mode_residency_ms[mode]));
+
+        for (bucket = 0; bucket < SLEEP_STATS_HISTOGRAM_BUCKETS; bucket++)
+        {
+            if (0 == residency_histogram[mode][bucket])
+            {
+                continue;
+            }
+
+            if ((SLEEP_STATS_HISTOGRAM_BUCKETS - 1) == bucket)
+            {
+                APP_INFO(("  >= %"PRIu32" ms: %"PRIu32"\n", (uint32_t)(1u << (bucket - 1)),
+                          residency_histogram[mode][bucket]));
+            }
+            else
+            {
+                APP_INFO(("  %"PRIu32"-%"PRIu32" ms: %"PRIu32"\n", (0 == bucket) ? 0 : (uint32_t)(1u << (bucket - 1)),
+                          (uint32_t)(1u << bucket), residency_histogram[mode][bucket]));
+            }
+        }
+    }
+
+    APP_INFO(("Early wakes: %"PRIu32"\n", early_wakes));
+
+    for (index = 0; index < wake_source_count; index++)
+    {
+        APP_INFO(("  %s: %"PRIu32"\n", wake_sources[index].name, wake_sources[index].count));
+    }
+
+    if (0 != other_wakes)
+    {
+        APP_INFO(("  Others: %"PRIu32"\n", other_wakes));
+    }
+
+    task_count = uxTaskGetSystemState(task_status, SLEEP_STATS_MAX_TASKS, &total_run_time);
+
+    if (!counter_ready || (0 == total_run_time))
+    {
+        APP_INFO(("Run time: LP timer not available\n"));
+        return;
+    }
+
+    APP_INFO(("Run time of %"PRIu32" ms:\n", (uint32_t)(((uint64_t)total_run_time * 1000u) / SLEEP_STATS_LPTIMER_HZ)));
+
+    for (index = 0; index < task_count; index++)
+    {
+        APP_INFO(("  %-16s %3"PRIu32"%%\n", task_status[index].pcTaskName,
+                  (uint32_t)(((uint64_t)task_status[index].ulRunTimeCounter * 100u) / total_run_time)));
+    }
+}
+
+/********************************************************************************
+ * Function Name: sleep_stats_init
+ ********************************************************************************
+ * Summary:
+ *  Registers the power mode callback of the statistics and the debug UART
+ *  command that prints them. The LP timer is started by the scheduler.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the command is registered.
+ *
+ *******************************************************************************/
+cy_rslt_t sleep_stats_init(void)
+{
+    cyhal_syspm_register_callback(&syspm_cb_data);
+
+    return debug_uart_register_command(SLEEP_STATS_REPORT_COMMAND, sleep_stats_report);
+}
+
+#endif /* APP_SLEEP_STATS */
+
+
+/* [] END OF FILE */
+
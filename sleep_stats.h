@@ -0,0 +1,89 @@
+/******************************************************************************
+* File Name:   sleep_stats.h
+*
+* Description: This file is the public interface of sleep_stats.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef SLEEP_STATS_H
+#define SLEEP_STATS_H
+
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Debug UART command byte that prints the sleep statistics */
+#define SLEEP_STATS_REPORT_COMMAND               ('p')
+
+/* Frequency of the LP timer that measures the residency and the run time */
+#define SLEEP_STATS_LPTIMER_HZ                   (32768u)
+
+/* Residency histogram: bucket 0 counts the sleeps shorter than 1 ms, bucket n
+ * the ones from 2^(n-1) to 2^n ms, and the last bucket the longer ones.
+ */
+#define SLEEP_STATS_HISTOGRAM_BUCKETS            (12)
+
+/* A sleep that ends this much before the expected idle time is an early wake */
+#define SLEEP_STATS_EARLY_WAKE_MARGIN_MS         (2)
+
+/* Sources of early wakes counted individually. The others share one count. */
+#define SLEEP_STATS_MAX_WAKE_SOURCES             (8)
+
+/* Size of the task table read for the run-time statistics */
+#define SLEEP_STATS_MAX_TASKS                    (24)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t sleep_stats_init(void);
+void sleep_stats_report(void);
+
+/* Hooks of FreeRTOSConfig.h */
+void sleep_stats_sleep(uint32_t expected_idle_time);
+void sleep_stats_counter_init(void);
+uint32_t sleep_stats_counter_read(void);
+void sleep_stats_task_switched_in(void);
+void sleep_stats_timer_expired(void *timer);
+
+#endif /* SLEEP_STATS_H */
+
+
+/* [] END OF FILE */
+
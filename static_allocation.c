@@ -0,0 +1,127 @@
+/******************************************************************************
+* File Name:   static_allocation.c
+*
+* Description: This file checks at build time that the fixed memory arenas of
+*              the static allocation build (make STATIC_ALLOCATION=1) fit the
+*              configured connections and RAM ceiling, and reports their
+*              usage at runtime.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#if defined(APP_STATIC_ALLOCATION)
+
+#include <inttypes.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "lwip/opt.h"
+#include "lwip/api.h"
+#include "lwip/stats.h"
+#include "lwip/priv/tcp_priv.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "static_allocation.h"
+#include "tcp_keepalive_offload.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* RAM taken by the arenas: the FreeRTOS heap, the lwIP heap and the lwIP pools */
+#define STATIC_ALLOCATION_RAM_SIZE                                              \
+    ((configTOTAL_HEAP_SIZE) + (MEM_SIZE) +                                     \
+     (MEMP_NUM_TCP_PCB) * sizeof(struct tcp_pcb) +                              \
+     (MEMP_NUM_TCP_SEG) * sizeof(struct tcp_seg) +                              \
+     (MEMP_NUM_NETCONN) * sizeof(struct netconn) +                              \
+     (PBUF_POOL_SIZE) * ((PBUF_POOL_BUFSIZE) + sizeof(struct pbuf)))
+
+/*******************************************************************************
+* Build time checks
+********************************************************************************/
+_Static_assert(APP_STATIC_CONNECTIONS >= MAX_TKO,
+               "STATIC_ALLOCATION_CONNECTIONS must cover the MAX_TKO offload slots");
+
+#if ENABLE_TKO_SESSION_MANAGER
+_Static_assert(APP_STATIC_CONNECTIONS >= TKO_SESSION_MAX,
+               "STATIC_ALLOCATION_CONNECTIONS must cover the TKO_SESSION_MAX sessions");
+#endif
+
+_Static_assert(MEM_LIBC_MALLOC == 0, "The static allocation build requires MEM_LIBC_MALLOC 0");
+
+_Static_assert(STATIC_ALLOCATION_RAM_SIZE <= APP_STATIC_RAM_CEILING,
+               "The static allocation arenas exceed STATIC_ALLOCATION_RAM_CEILING");
+
+/********************************************************************************
+ * Function Name: static_allocation_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the size of the fixed arenas and the most they have been used.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void static_allocation_report(void)
+{
+    APP_INFO(("Static arenas: %"PRIu32" bytes for %d connections, ceiling %"PRIu32" bytes\n",
+              (uint32_t)STATIC_ALLOCATION_RAM_SIZE, APP_STATIC_CONNECTIONS, (uint32_t)APP_STATIC_RAM_CEILING));
+    APP_INFO(("FreeRTOS heap: %"PRIu32" of %"PRIu32" bytes used at most\n",
+              (uint32_t)(configTOTAL_HEAP_SIZE - xPortGetMinimumEverFreeHeapSize()), (uint32_t)configTOTAL_HEAP_SIZE));
+#if MEM_STATS
+    APP_INFO(("lwIP heap: %"PRIu32" of %"PRIu32" bytes used at most\n",
+              (uint32_t)lwip_stats.mem.max, (uint32_t)MEM_SIZE));
+#endif
+}
+
+#endif /* APP_STATIC_ALLOCATION */
+
+
+/* [] END OF FILE */
+
@@ -49,6 +49,9 @@
 
 /* lwIP header file */
 #include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/netif.h"
+#include "lwip/priv/tcp_priv.h"
 
 /* Socket management header file */
 #include "cy_secure_sockets.h"
@@ -65,10 +68,68 @@
  */
 #include "tcp_keepalive_offload.h"
 
+/* Decides when and how the network stack is suspended */
+#include "network_suspend_scheduler.h"
+
+/* Counters and timestamps of the suspend/resume path */
+#include "network_suspend_stats.h"
+
+/* Offload descriptors resolved once at startup */
+#include "offload_registry.h"
+
+/* Retry scheduler */
+#include "retry_scheduler.h"
+
+/* Coalesced host TCP keepalive */
+#include "host_keepalive.h"
+
+/* Footprint profiling build */
+#include "footprint_profile.h"
+
+/* Zero-copy data path */
+#include "tko_zero_copy.h"
+
+/* Wake reason classification */
+#include "wake_dispatcher.h"
+
+/* Warm boot record */
+#include "warm_boot.h"
+
+/* TLS layer of the connections */
+#include "tko_tls.h"
+
+/* Packet filters of the TCP Keepalive servers */
+#include "tko_packet_filter.h"
+
+/* Batched uplink queue */
+#include "tko_uplink.h"
+
+/* WLAN power save settings of the suspend states */
+#include "wlan_power_policy.h"
+
+/* Candidate APs refreshed by background scans */
+#include "wifi_ap_candidates.h"
+
 /*******************************************************************************
 * Macros
 ********************************************************************************/
-#define TCP_KEEPALIVE_OFFLOAD             "TKO"
+/* Completion bit of each socket connection worker in socket_connect_events */
+#define SOCKET_CONNECT_EVENT_BIT(index)   ((EventBits_t)1 << (index))
+
+/* A worker runs the TLS handshake after the TCP connection, so its barrier
+ * waits for both.
+ */
+#if ENABLE_TKO_TLS
+#define SOCKET_CONNECT_BARRIER_MS         (TCP_SOCKET_CONNECT_TIMEOUT_MS + TKO_TLS_HANDSHAKE_TIMEOUT_MS)
+#else
+#define SOCKET_CONNECT_BARRIER_MS         (TCP_SOCKET_CONNECT_TIMEOUT_MS)
+#endif
+
+/* The network idle task waits on tcpip_thread to suspend and resume the stack,
+ * so a task topology must not let it preempt tcpip_thread.
+ */
+_Static_assert(NETWORK_ACTIVITY_TASK_PRIORITY < TCPIP_THREAD_PRIO,
+               "NETWORK_ACTIVITY_TASK_PRIORITY must be below TCPIP_THREAD_PRIO");
 
 /*******************************************************************************
 * Global Variables
@@ -80,12 +141,52 @@ cy_wcm_ip_address_t ip_addr;
 /* TCP socket handle for each connection */
 struct cy_socket_ctx_t *global_socket[MAX_TKO] = { NULL };
 
+/* Completion barrier and per-socket result of the parallel socket bring-up */
+static EventGroupHandle_t socket_connect_events = NULL;
+static cy_rslt_t socket_connect_result[MAX_TKO];
+
+/* Sockets whose connection worker is still running */
+static volatile uint32_t socket_connect_busy = 0;
+
+/* Sockets whose caller stopped waiting for the worker. The worker closes the
+ * socket instead of publishing its result.
+ */
+static volatile uint32_t socket_connect_abandoned = 0;
+
+/*
+ * Runtime copy of the configurator-generated TCP Keepalive configuration.
+ * It is handed to the LPA middleware for every connection, so that the
+ * keepalive parameters can be changed at runtime by tko_set_keepalive_params().
+ */
+cy_tko_ol_cfg_t tko_runtime_cfg;
+static bool tko_runtime_cfg_valid = false;
+
+/*
+ * Retry policy of the Wi-Fi join. The initial jitter spreads out the first
+ * attempts of devices that power up together, e.g. after a power outage.
+ */
+static const retry_policy_t wifi_join_retry_policy =
+{
+    .initial_jitter_ms = WIFI_JOIN_INITIAL_JITTER_MS,
+    .base_delay_ms     = WIFI_JOIN_RETRY_BASE_DELAY_MS,
+    .max_delay_ms      = WIFI_JOIN_RETRY_MAX_DELAY_MS,
+    .max_attempts      = MAX_WIFI_RETRY_COUNT,
+    .budget_ms         = WIFI_JOIN_RETRY_BUDGET_MS,
+};
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static cy_rslt_t tcp_socket_connect(int index);
+static void tcp_socket_close(int index);
+
 /********************************************************************************
  * Function Name: find_my_tko_descriptor
  ********************************************************************************
  * Summary:
  *  Finds the OLM (Offload Manager) descriptor for the given offload type and return
- *  the offload list.
+ *  the offload list. The offload types known to the offload registry are looked up
+ *  without scanning the offload list.
  *
  * Parameters:
  *  name: Offload type for which the configuration list is requested.
@@ -98,10 +199,18 @@ const ol_desc_t *find_my_tko_descriptor(const char *name)
 {
     const ol_desc_t *offloads_list;
 
+    /* Offload types known to the registry are resolved in constant time */
+    offloads_list = offload_registry_find(name);
+
+    if (NULL != offloads_list)
+    {
+        return offloads_list;
+    }
+
     /* Take offload configuration defined by the configurator */
     offloads_list = (const ol_desc_t *)get_default_ol_list();
 
-    /* Return the TCP keepalive offload configuration if it exists. */
+    /* Return the offload configuration if it exists. */
     while (offloads_list && offloads_list->name &&
            (0 != strncmp(offloads_list->name, name, strlen(name))))
     {
@@ -127,6 +236,9 @@ const ol_desc_t *find_my_tko_descriptor(const char *name)
  *  whenever any Tx/Rx activity is detected in the EMAC interface (path between Wi-Fi
  *  driver and network stack).
  *
+ *  The network suspend scheduler decides when to attempt the next suspend and
+ *  with which inactivity window, based on the EMAC activity it observes.
+ *
  * Parameters:
  *  void *arg: Task specific arguments. Never used.
  *
@@ -137,22 +249,396 @@ const ol_desc_t *find_my_tko_descriptor(const char *name)
 void network_idle_task(void *arg)
 {
     struct netif* wifi = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    net_suspend_params_t params;
+    TickType_t suspend_start;
+    int32_t status;
 
-    while( true )
+    net_suspend_stats_init();
+    net_suspend_scheduler_init(xTaskGetCurrentTaskHandle());
+
+    if (CY_RSLT_SUCCESS != wake_dispatcher_init())
     {
-        /* Suspend the network stack */
-        wait_net_suspend(wifi,
-                         portMAX_DELAY,
-                         NETWORK_INACTIVE_INTERVAL_MS,
-                         NETWORK_INACTIVE_WINDOW_MS);
+        ERR_INFO(("Failed to start the wake dispatcher.\n"));
+    }
 
+    while( true )
+    {
         /*
-         * Safe delay to avoid race conditions when switching between
-         * offload enable and disable states when network stack is suspended
-         * and resumed by the offload manager.
+         * Wait until the network has been quiet for the scheduler hold-off.
+         * This also acts as the safe delay that avoids race conditions when
+         * switching between offload enable and disable states.
          */
-        vTaskDelay(pdMS_TO_TICKS(NETWORK_SUSPEND_DELAY_MS));
+        net_suspend_scheduler_wait_for_idle(&params);
+
+        /* Suspend the network stack */
+        suspend_start = xTaskGetTickCount();
+        net_suspend_scheduler_offload_event(true);
+        net_suspend_stats_suspend_begin();
+        wake_dispatcher_suspend_begin();
+#if ENABLE_TKO_PACKET_FILTER
+        tko_pf_suspend_begin();
+#endif
+#if ENABLE_WLAN_POWER_POLICY
+        wlan_power_policy_suspend_begin();
+#endif
+
+        status = wait_net_suspend(wifi,
+                                  portMAX_DELAY,
+                                  params.inactive_interval_ms,
+                                  params.inactive_window_ms);
+
+#if ENABLE_WLAN_POWER_POLICY
+        wlan_power_policy_resume();
+#endif
+#if ENABLE_TKO_PACKET_FILTER
+        tko_pf_resume();
+#endif
+
+        net_suspend_stats_suspend_end(status, params.inactive_window_ms);
+        net_suspend_scheduler_suspend_done(status, suspend_start);
+
+        /* Work out what woke the host and handle only that */
+        wake_dispatcher_resume(status);
+
+#if ENABLE_TKO_UPLINK_QUEUE
+        /* Send the queued data while the host is awake anyway */
+        tko_uplink_wake();
+#endif
+
+#if ENABLE_WIFI_AP_CANDIDATES
+        /* Refresh the candidate APs while the host is awake anyway */
+        wifi_ap_candidates_wake();
+#endif
+
+#if ENABLE_WARM_BOOT
+        warm_boot_heartbeat();
+#endif
+    }
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_connect_task
+ ********************************************************************************
+ * Summary:
+ *  Worker task that brings up a single TCP socket connection. One worker is
+ *  spawned per configured socket so that all the TCP handshakes run in parallel.
+ *  The result is stored in socket_connect_result[] and the worker signals its
+ *  completion bit in the socket_connect_events event group before it deletes
+ *  itself. If the caller timed out in the meantime, the result is discarded and
+ *  the socket is closed, so that nothing changes after the caller has reported
+ *  the failure.
+ *
+ *  The result is published and the busy bit cleared under the same critical
+ *  section that the caller takes when it times out, so exactly one of them
+ *  owns the outcome.
+ *
+ * Parameters:
+ *  void *arg: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tcp_socket_connect_task(void *arg)
+{
+    int index = (int)(intptr_t)arg;
+    cy_rslt_t result;
+    bool late;
+
+    result = tcp_socket_connect(index);
+
+    taskENTER_CRITICAL();
+    late = (0 != (socket_connect_abandoned & SOCKET_CONNECT_EVENT_BIT(index)));
+    if (!late)
+    {
+        socket_connect_result[index] = result;
+        socket_connect_busy &= ~SOCKET_CONNECT_EVENT_BIT(index);
+    }
+    taskEXIT_CRITICAL();
+
+    if (late)
+    {
+        /* The socket stays busy until it is closed, so no new attempt races with it */
+        tcp_socket_close(index);
+
+        taskENTER_CRITICAL();
+        socket_connect_abandoned &= ~SOCKET_CONNECT_EVENT_BIT(index);
+        socket_connect_busy &= ~SOCKET_CONNECT_EVENT_BIT(index);
+        taskEXIT_CRITICAL();
+    }
+
+    xEventGroupSetBits(socket_connect_events, SOCKET_CONNECT_EVENT_BIT(index));
+
+#if defined(APP_FOOTPRINT_PROFILE)
+    footprint_profile_task_exit();
+#endif
+
+    vTaskDelete(NULL);
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_connect
+ ********************************************************************************
+ * Summary:
+ *  Creates a socket, binds to the socket, and then establishes TCP connection
+ *  with the remote TCP server configured at the given index of the TCP Keepalive
+ *  port table. This call blocks until the TCP handshake completes or fails.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the connection is successfully created,
+ *  a socket error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t tcp_socket_connect(int index)
+{
+    const cy_tko_ol_connect_t *port = &tko_runtime_cfg.ports[index];
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    cy_rslt_t result;
+
+    /*
+     * Configure TCP Keepalive with the given remote TCP server.
+     * This is a helper function which creates a socket, binds to
+     * the socket, and then establishes TCP connection with the given
+     * TCP remote server. Enable(1) or Disable(0) the Host TCP keepalive
+     * using the macro ENABLE_HOST_TCP_KEEPALIVE.
+     */
+    result = cy_tcp_create_socket_connection(netif,
+                                             (void **)&global_socket[index],
+                                             port->remote_ip,
+                                             port->remote_port,
+                                             port->local_port,
+                                             &tko_runtime_cfg,
+                                             ENABLE_HOST_TCP_KEEPALIVE);
+
+#if ENABLE_TKO_TLS
+    /* The data is encrypted, so it takes the TLS layer instead of the zero-copy path */
+    if (CY_RSLT_SUCCESS == result)
+    {
+        result = tko_tls_connect(index);
+
+        if (CY_RSLT_SUCCESS != result)
+        {
+            /* Do not keep an unauthenticated connection alive */
+            cy_socket_disconnect(global_socket[index], 0);
+            cy_socket_delete(global_socket[index]);
+            global_socket[index] = NULL;
+        }
+    }
+#else
+    /* Put the received data of this socket on the zero-copy path, if requested */
+    if (CY_RSLT_SUCCESS == result)
+    {
+        tko_zc_attach(index);
     }
+#endif
+
+#if ENABLE_HOST_TCP_KEEPALIVE && HOST_TCP_KEEPALIVE_COALESCED
+    /* Line the keepalive of this socket up with the others on one wake-up */
+    if (CY_RSLT_SUCCESS == result)
+    {
+        host_keepalive_adopt(index);
+    }
+#endif
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_close
+ ********************************************************************************
+ * Summary:
+ *  Closes the socket at the given index of the TCP Keepalive port table, with
+ *  its TLS session, if it is open.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tcp_socket_close(int index)
+{
+    if (NULL == global_socket[index])
+    {
+        return;
+    }
+
+#if ENABLE_TKO_TLS
+    tko_tls_close(index);
+#endif
+    cy_socket_disconnect(global_socket[index], 0);
+    cy_socket_delete(global_socket[index]);
+    global_socket[index] = NULL;
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_connect_parallel
+ ********************************************************************************
+ * Summary:
+ *  Starts the TCP socket connection of all the sockets in the given mask at once,
+ *  each from its own worker task, and waits on a single completion barrier for
+ *  all of them. The time taken is therefore bounded by the slowest handshake
+ *  rather than the sum of all of them, and one unreachable server does not delay
+ *  the others. If a worker task cannot be created, that socket is connected from
+ *  the calling task instead. A socket whose worker from a previous call is still
+ *  running is not started again. A socket that does not connect before the
+ *  barrier times out is reported as failed, and its worker closes it when the
+ *  late handshake completes.
+ *
+ * Parameters:
+ *  socket_mask: Bit n set to connect the socket at index n of the port table.
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the connection is successfully created
+ *  for all the sockets in the mask, a socket error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t tcp_socket_connect_parallel(uint32_t socket_mask)
+{
+    const cy_tko_ol_connect_t *port;
+    int index = 0;
+    EventBits_t pending_bits = 0;
+    EventBits_t done_bits = 0;
+    cy_rslt_t socket_connection_status = CY_RSLT_SUCCESS;
+    bool timed_out;
+
+    if (NULL == socket_connect_events)
+    {
+        socket_connect_events = xEventGroupCreate();
+
+        if (NULL == socket_connect_events)
+        {
+            ERR_INFO(("%s: Unable to create the socket connection event group.\n", __func__));
+            return CY_RSLT_TYPE_ERROR;
+        }
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (!(socket_mask & SOCKET_CONNECT_EVENT_BIT(index)))
+        {
+            continue;
+        }
+
+        if (socket_connect_busy & SOCKET_CONNECT_EVENT_BIT(index))
+        {
+            /* The handshake from a previous attempt is still in progress */
+            socket_connection_status = CY_RSLT_TYPE_ERROR;
+            continue;
+        }
+
+        xEventGroupClearBits(socket_connect_events, SOCKET_CONNECT_EVENT_BIT(index));
+
+        taskENTER_CRITICAL();
+        socket_connect_busy |= SOCKET_CONNECT_EVENT_BIT(index);
+        taskEXIT_CRITICAL();
+
+        if (pdPASS == xTaskCreate(tcp_socket_connect_task,
+                                  "SockConn",
+                                  TCP_SOCKET_CONNECT_TASK_STACK_SIZE,
+                                  (void *)(intptr_t)index,
+                                  TCP_SOCKET_CONNECT_TASK_PRIORITY,
+                                  NULL))
+        {
+            pending_bits |= SOCKET_CONNECT_EVENT_BIT(index);
+        }
+        else
+        {
+            /* Not enough memory for a worker; connect from this task instead. */
+            socket_connect_result[index] = tcp_socket_connect(index);
+
+            taskENTER_CRITICAL();
+            socket_connect_busy &= ~SOCKET_CONNECT_EVENT_BIT(index);
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    /* Wait for all the outstanding connections to complete */
+    if (0 != pending_bits)
+    {
+        done_bits = xEventGroupWaitBits(socket_connect_events,
+                                        pending_bits,
+                                        pdFALSE,
+                                        pdTRUE,
+                                        pdMS_TO_TICKS(SOCKET_CONNECT_BARRIER_MS));
+    }
+
+    /* Report the result of each socket in order of the port table */
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        port = &tko_runtime_cfg.ports[index];
+
+        if (!(socket_mask & SOCKET_CONNECT_EVENT_BIT(index)))
+        {
+            continue;
+        }
+
+        timed_out = false;
+
+        if ((pending_bits & SOCKET_CONNECT_EVENT_BIT(index)) &&
+            !(done_bits & SOCKET_CONNECT_EVENT_BIT(index)))
+        {
+            taskENTER_CRITICAL();
+            timed_out = (0 != (socket_connect_busy & SOCKET_CONNECT_EVENT_BIT(index)));
+            if (timed_out)
+            {
+                /*
+                 * The handshake is still in progress. The worker keeps running,
+                 * and closes the socket when it completes.
+                 */
+                socket_connect_abandoned |= SOCKET_CONNECT_EVENT_BIT(index);
+                socket_connect_result[index] = CY_RSLT_TYPE_ERROR;
+            }
+            taskEXIT_CRITICAL();
+        }
+
+        if (timed_out)
+        {
+            ERR_INFO(("Socket[%d]: Timed out waiting for connection. TCP Server IP: %s, Local Port: %d, "
+                                              "Remote Port: %d\n", index, port->remote_ip,
+                                                             port->local_port, port->remote_port));
+            socket_connection_status = CY_RSLT_TYPE_ERROR;
+        }
+        else if (CY_RSLT_SUCCESS != socket_connect_result[index])
+        {
+            ERR_INFO(("Socket[%d]: ERROR %"PRIu32", Unable to connect. TCP Server IP: %s, Local Port: %d, "
+                                              "Remote Port: %d\n", index, socket_connect_result[index],
+                                              port->remote_ip, port->local_port, port->remote_port));
+            socket_connection_status = socket_connect_result[index];
+        }
+        else if (NULL != global_socket[index])
+        {
+            APP_INFO(("Socket[%d]: Created connection to IP %s, local port %d, remote port %d\n",
+                                 index, port->remote_ip, port->local_port, port->remote_port));
+        }
+    }
+
+    return socket_connection_status;
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_runtime_cfg_restore
+ ********************************************************************************
+ * Summary:
+ *  Sets the runtime TCP Keepalive configuration, such as the one saved by the
+ *  previous boot, so that tcp_socket_connection_start() uses it instead of the
+ *  configurator defaults. Call it before tcp_socket_connection_start().
+ *
+ * Parameters:
+ *  cfg: TCP Keepalive configuration to use.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tcp_socket_runtime_cfg_restore(const cy_tko_ol_cfg_t *cfg)
+{
+    memcpy(&tko_runtime_cfg, cfg, sizeof(tko_runtime_cfg));
+    tko_runtime_cfg_valid = true;
 }
 
 /********************************************************************************
@@ -161,14 +647,16 @@ void network_idle_task(void *arg)
  * Summary:
  *  Establishes TCP socket connection with the TCP server. Maximum up to MAX_TKO
  *  number of connections are allowed as defined by the LPA (Low Power Assistant)
- *  middleware.
+ *  middleware. All the configured connections are started in parallel, see
+ *  tcp_socket_connect_parallel().
  *
  * Parameters:
  *  void
  *
  * Return:
  *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the connection is successfully created
- *  for all the configured sockets, a socket error code otherwise.
+ *  for all the configured sockets, a socket error code otherwise. The result for
+ *  each socket is available through tcp_socket_connection_result().
  *
  *******************************************************************************/
 cy_rslt_t tcp_socket_connection_start(void)
@@ -176,17 +664,15 @@ cy_rslt_t tcp_socket_connection_start(void)
     const ol_desc_t *offload_list;
     const cy_tko_ol_cfg_t *downloaded;
     cy_rslt_t result = CY_RSLT_SUCCESS;
-    const cy_tko_ol_connect_t *port;
     int index = 0;
-    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
-    cy_rslt_t socket_connection_status = CY_RSLT_SUCCESS;
+    uint32_t socket_mask = 0;
 
     result = cy_socket_init();
 
     PRINT_AND_ASSERT(result, "%s Socket initialization failed. Error code:%"PRIu32"\n", __func__, result);
 
     /* Take reference to the configured offload list */
-    offload_list = find_my_tko_descriptor(TCP_KEEPALIVE_OFFLOAD);
+    offload_list = offload_registry_get(OFFLOAD_TYPE_TKO);
 
     if (NULL == offload_list)
     {
@@ -197,103 +683,362 @@ cy_rslt_t tcp_socket_connection_start(void)
     /* Take reference to the TCP Keepalive configuration */
     downloaded = (const cy_tko_ol_cfg_t *)offload_list->cfg;
 
-    if (NULL != downloaded)
+    if (NULL == downloaded)
+    {
+        ERR_INFO(("%s: Offload descriptor %s not found. No TCP connection has been established.\n"
+                "Check the TCP Keepalive offload settings in ModusToolbox Device Configurator tool\n", __func__, OFFLOAD_NAME_TKO));
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    /* Keep the runtime overrides of the parameters across reconnections */
+    if (!tko_runtime_cfg_valid)
     {
         APP_INFO(("Taking TCP Keepalive configuration from the Generated sources.\n"));
-        /*
-         * Offload descriptor was found.
-         * Start TCP socket connection to the configured TCP server.
-         */
-        for (index = 0; index < MAX_TKO; index++)
+        memcpy(&tko_runtime_cfg, downloaded, sizeof(tko_runtime_cfg));
+        tko_runtime_cfg_valid = true;
+    }
+
+    /*
+     * Offload descriptor was found.
+     * Start TCP socket connection to all the configured TCP servers at once.
+     */
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        socket_connect_result[index] = CY_RSLT_SUCCESS;
+
+        /* The port table was validated once when the offload registry was built */
+        if (offload_registry_tko_port_valid(index))
+        {
+            socket_mask |= SOCKET_CONNECT_EVENT_BIT(index);
+        }
+        else
         {
-             port = &downloaded->ports[index];
+            APP_INFO(("Skipped TCP socket connection for socket id[%d]. Check the TCP Keepalive "
+                                                                   "configuration.\n", index));
+        }
+    }
 
-             if ((port->remote_port > 0) &&
-                 (port->local_port > 0) &&
-                 (strcmp(port->remote_ip, NULL_IP_ADDRESS) != 0))
-             {
-                 /*
-                  * Configure TCP Keepalive with the given remote TCP server.
-                  * This is a helper function which creates a socket, binds to
-                  * the socket, and then establishes TCP connection with the given
-                  * TCP remote server. Enable(1) or Disable(0) the Host TCP keepalive
-                  * using the macro ENABLE_HOST_TCP_KEEPALIVE.
-                  */
-                 result = cy_tcp_create_socket_connection(netif,
-                                                          (void **)&global_socket[index],
-                                                          port->remote_ip,
-                                                          port->remote_port,
-                                                          port->local_port,
-                                                          (cy_tko_ol_cfg_t *)downloaded,
-                                                          ENABLE_HOST_TCP_KEEPALIVE);
-
-                 if (CY_RSLT_SUCCESS != result)
-                 {
-                     ERR_INFO(("Socket[%d]: ERROR %"PRIu32", Unable to connect. TCP Server IP: %s, Local Port: %d, "
-                                                       "Remote Port: %d\n", index, result, port->remote_ip,
-                                                                      port->local_port, port->remote_port));
-                     socket_connection_status = result;
-                 }
-                 else
-                 {
-                     APP_INFO(("Socket[%d]: Created connection to IP %s, local port %d, remote port %d\n",
-                                          index, port->remote_ip, port->local_port, port->remote_port));
-                 }
-             }
-             else
-             {
-                 APP_INFO(("Skipped TCP socket connection for socket id[%d]. Check the TCP Keepalive "
-                                                                        "configuration.\n", index));
-             }
+    return tcp_socket_connect_parallel(socket_mask);
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_reconnect
+ ********************************************************************************
+ * Summary:
+ *  Closes the given sockets, if they are open, and connects them again in
+ *  parallel. The other sockets are not touched. tcp_socket_connection_start()
+ *  must have been called before.
+ *
+ * Parameters:
+ *  socket_mask: Bit n set to reconnect the socket at index n of the port table.
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if all the sockets in the mask are
+ *  connected again, a socket error code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_socket_reconnect(uint32_t socket_mask)
+{
+    int index;
+
+    if (!tko_runtime_cfg_valid)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (!(socket_mask & SOCKET_CONNECT_EVENT_BIT(index)))
+        {
+            continue;
+        }
+
+        if (!offload_registry_tko_port_valid(index))
+        {
+            socket_mask &= ~SOCKET_CONNECT_EVENT_BIT(index);
+            continue;
+        }
+
+        if (!(socket_connect_busy & SOCKET_CONNECT_EVENT_BIT(index)))
+        {
+            tcp_socket_close(index);
         }
     }
-    else
+
+    return tcp_socket_connect_parallel(socket_mask);
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_get_pcb
+ ********************************************************************************
+ * Summary:
+ *  Looks up the lwIP TCP protocol control block of a connected socket by its
+ *  local port, remote port and remote IP address. The lwIP core must be locked
+ *  by the caller (LOCK_TCPIP_CORE) for as long as the returned PCB is used.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  struct tcp_pcb *: PCB of the connection, or NULL if there is none.
+ *
+ *******************************************************************************/
+struct tcp_pcb *tcp_socket_get_pcb(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO) || (NULL == global_socket[index]))
     {
-        ERR_INFO(("%s: Offload descriptor %s not found. No TCP connection has been established.\n"
-                "Check the TCP Keepalive offload settings in ModusToolbox Device Configurator tool\n", __func__, "TKO"));
-        socket_connection_status = CY_RSLT_TYPE_ERROR;
+        return NULL;
     }
 
-    return socket_connection_status;
+    return tcp_socket_find_pcb(&tko_runtime_cfg.ports[index]);
 }
 
 /********************************************************************************
- * Function Name: wifi_connect
+ * Function Name: tcp_socket_find_pcb
  ********************************************************************************
  * Summary:
- *  The device associates to the Access Point with given SSID, PASSWORD, and SECURITY
- *  type. It retries for MAX_WIFI_RETRY_COUNT times if the Wi-Fi connection fails.
+ *  Looks up the lwIP TCP protocol control block of a connection by its local
+ *  port, remote port and remote IP address. The lwIP core must be locked by the
+ *  caller (LOCK_TCPIP_CORE) for as long as the returned PCB is used.
+ *
+ * Parameters:
+ *  port: Endpoints of the connection.
+ *
+ * Return:
+ *  struct tcp_pcb *: PCB of the connection, or NULL if there is none.
+ *
+ *******************************************************************************/
+struct tcp_pcb *tcp_socket_find_pcb(const cy_tko_ol_connect_t *port)
+{
+    struct tcp_pcb *pcb;
+    ip_addr_t remote_ip;
+
+    if (!ipaddr_aton(port->remote_ip, &remote_ip))
+    {
+        return NULL;
+    }
+
+    for (pcb = tcp_active_pcbs; NULL != pcb; pcb = pcb->next)
+    {
+        if ((pcb->local_port == port->local_port) &&
+            (pcb->remote_port == port->remote_port) &&
+            ip_addr_cmp(&pcb->remote_ip, &remote_ip))
+        {
+            return pcb;
+        }
+    }
+
+    return NULL;
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_is_established
+ ********************************************************************************
+ * Summary:
+ *  Tells whether the TCP connection of a socket is still in the ESTABLISHED
+ *  state.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  bool: true if the connection is established, false otherwise.
+ *
+ *******************************************************************************/
+bool tcp_socket_is_established(int index)
+{
+    struct tcp_pcb *pcb;
+    bool established;
+
+    LOCK_TCPIP_CORE();
+    pcb = tcp_socket_get_pcb(index);
+    established = (NULL != pcb) && (ESTABLISHED == pcb->state);
+    UNLOCK_TCPIP_CORE();
+
+    return established;
+}
+
+/********************************************************************************
+ * Function Name: tcp_socket_connection_result
+ ********************************************************************************
+ * Summary:
+ *  Returns the result of the last connection attempt made by
+ *  tcp_socket_connection_start() for the given socket.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the socket is connected or was skipped because
+ *  it is not configured, an error code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_socket_connection_result(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    return socket_connect_result[index];
+}
+
+/********************************************************************************
+ * Function Name: wifi_ipv6_address_wait
+ ********************************************************************************
+ * Summary:
+ *  Turns on the stateless address autoconfiguration (SLAAC) of the STA
+ *  interface, and waits for a routable IPv6 address from the router
+ *  advertisements, at most IPV6_SLAAC_TIMEOUT_MS. Returns at once if the
+ *  interface already has one, for example after a rejoin.
  *
  * Parameters:
  *  void
  *
  * Return:
- *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the Wi-Fi connection is successfully
- *  established, a WCM error code otherwise.
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if an IPv6 address other than the
+ *  link-local one is valid. It is then stored in ip_addr.
  *
  *******************************************************************************/
-cy_rslt_t wifi_connect(void)
+cy_rslt_t wifi_ipv6_address_wait(void)
 {
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    TickType_t start = xTaskGetTickCount();
+    int found = -1;
+    int index;
+
+    if (NULL == netif)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    LOCK_TCPIP_CORE();
+    netif_set_ip6_autoconfig_enabled(netif, 1);
+    UNLOCK_TCPIP_CORE();
+
+    while (true)
+    {
+        LOCK_TCPIP_CORE();
+
+        for (index = 0; (index < LWIP_IPV6_NUM_ADDRESSES) && (found < 0); index++)
+        {
+            if (ip6_addr_isvalid(netif_ip6_addr_state(netif, index)) &&
+                !ip6_addr_islinklocal(netif_ip6_addr(netif, index)))
+            {
+                ip_addr.version = CY_WCM_IP_VER_V6;
+                memcpy(ip_addr.ip.v6, netif_ip6_addr(netif, index)->addr, sizeof(ip_addr.ip.v6));
+                found = index;
+            }
+        }
+
+        UNLOCK_TCPIP_CORE();
+
+        if (found >= 0)
+        {
+            APP_INFO(("Assigned IPv6 address: %s\n", ip6addr_ntoa((const ip6_addr_t *)ip_addr.ip.v6)));
+            return CY_RSLT_SUCCESS;
+        }
+
+        if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(IPV6_SLAAC_TIMEOUT_MS))
+        {
+            ERR_INFO(("No IPv6 address from the router advertisements\n"));
+            return CY_RSLT_TYPE_ERROR;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(IPV6_SLAAC_POLL_MS));
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_init
+ ********************************************************************************
+ * Summary:
+ *  Initializes the WCM on the first call and fills in connect_param with the
+ *  SSID, PASSWORD, and SECURITY type of the AP. Later calls have no effect.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the WCM is initialized, a WCM error
+ *  code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_init(void)
+{
+    static bool wcm_initialized = false;
     cy_rslt_t result = CY_RSLT_SUCCESS;
-    uint32_t retry_count = 0;
     cy_wcm_config_t wcm_config = {.interface = CY_WCM_INTERFACE_TYPE_STA};
+#if defined(APP_IPV6_ONLY)
+    static cy_wcm_ip_setting_t no_ipv4_settings;
+#endif
+
+    if (wcm_initialized)
+    {
+        return CY_RSLT_SUCCESS;
+    }
 
     result = cy_wcm_init(&wcm_config);
+    wcm_initialized = (CY_RSLT_SUCCESS == result);
 
-    if (CY_RSLT_SUCCESS == result)
+    if (wcm_initialized)
     {
         APP_INFO(("Wi-Fi initialization is successful\n"));
+
         memcpy(&connect_param.ap_credentials.SSID, WIFI_SSID, sizeof(WIFI_SSID));
         memcpy(&connect_param.ap_credentials.password, WIFI_PASSWORD, sizeof(WIFI_PASSWORD));
         connect_param.ap_credentials.security = WIFI_SECURITY_TYPE;
+#if defined(APP_IPV6_ONLY)
+        /* A static address of 0.0.0.0: no DHCPv4 exchange on the join */
+        connect_param.static_ip_settings = &no_ipv4_settings;
+#endif
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: wifi_connect
+ ********************************************************************************
+ * Summary:
+ *  The device associates to the Access Point with given SSID, PASSWORD, and SECURITY
+ *  type. If the Wi-Fi connection fails, it retries with the exponential back-off
+ *  of wifi_join_retry_policy, for at most MAX_WIFI_RETRY_COUNT attempts.
+ *  The WCM is initialized on the first call only, so the function can also be
+ *  used to rejoin the AP after the link is lost.
+ *
+ *  The IPv6-only build configures no IPv4 address, so the WCM skips DHCPv4,
+ *  and waits for the SLAAC address instead. The dual-stack build also waits for
+ *  it when a TCP Keepalive server is on IPv6.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the Wi-Fi connection is successfully
+ *  established, a WCM error code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_connect(void)
+{
+    cy_rslt_t result;
+    retry_state_t retry;
+
+    result = wifi_init();
+
+    if (CY_RSLT_SUCCESS == result)
+    {
         APP_INFO(("Join to AP: %s\n", connect_param.ap_credentials.SSID));
 
         /*
          * Connect to Access Point. It validates the connection parameters
          * and then establishes connection to AP.
          */
-        for (retry_count = 0; retry_count < MAX_WIFI_RETRY_COUNT; retry_count++)
+        retry_init(&retry, &wifi_join_retry_policy);
+
+        do
         {
+             retry_attempt_begin(&retry);
              result = cy_wcm_connect_ap(&connect_param, &ip_addr);
 
              if (CY_RSLT_SUCCESS == result)
@@ -309,8 +1054,21 @@ cy_rslt_t wifi_connect(void)
              }
 
              ERR_INFO(("Failed to join Wi-Fi network. Retrying...\n"));
-        }
+        } while (retry_attempt_failed(&retry));
+    }
+
+#if defined(APP_IPV6_ONLY)
+    if (CY_RSLT_SUCCESS == result)
+    {
+        result = wifi_ipv6_address_wait();
+    }
+#else
+    /* The IPv4 servers are reachable without it */
+    if ((CY_RSLT_SUCCESS == result) && offload_registry_tko_has_ipv6())
+    {
+        (void)wifi_ipv6_address_wait();
     }
+#endif
 
     return result;
 }
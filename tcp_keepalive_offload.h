@@ -41,9 +41,23 @@
 #ifndef TCP_KEEPALIVE_OFFLOAD_H
 #define TCP_KEEPALIVE_OFFLOAD_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /* FreeRTOS header files */
 #include <FreeRTOS.h>
 #include <task.h>
+#include <event_groups.h>
+
+#include "cy_result.h"
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* Wi-Fi connection manager header file */
+#include "cy_wcm.h"
+
+#include "app_log.h"
 
 /*******************************************************************************
 * Macros
@@ -51,27 +65,72 @@
 #define MAX_WIFI_RETRY_COUNT                     (3)
 #define NULL_IP_ADDRESS                          "0.0.0.0"
 
-#define CHECK_RESULT(x)                          do { if (CY_RSLT_SUCCESS != x) { CY_ASSERT(0); } } while(0);
-#define APP_INFO(x)                              do { printf("Info: "); printf x; } while(0);
-#define ERR_INFO(x)                              do { printf("Error: "); printf x; } while(0);
+#define CHECK_RESULT(x)                          do { if (CY_RSLT_SUCCESS != x) { app_log_flush(); CY_ASSERT(0); } } while(0);
 
 #define PRINT_AND_ASSERT(result, msg, args...)   do                                 \
                                                  {                                  \
                                                      if (CY_RSLT_SUCCESS != result) \
                                                      {                              \
                                                          ERR_INFO((msg, ## args));  \
+                                                         app_log_flush();           \
                                                          CY_ASSERT(0);              \
                                                      }                              \
                                                  } while(0);
 
-#define TCP_SOCKET_ERROR_DELAY_MS                (2000)
+/* Stack size and priority of the task that suspends and resumes the network
+ * stack. Besides wait_net_suspend(), it builds the packet filters, sets the
+ * WLAN power save mode through the WHD ioctls, and starts the AP candidate
+ * scan with cy_wcm_start_scan().
+ */
+#ifndef NETWORK_ACTIVITY_TASK_STACK_SIZE
+#define NETWORK_ACTIVITY_TASK_STACK_SIZE         (1024)
+#endif
+#ifndef NETWORK_ACTIVITY_TASK_PRIORITY
+#define NETWORK_ACTIVITY_TASK_PRIORITY           (1)
+#endif
+
+/* Stack size and priority of the task that brings up each TCP socket */
+#ifndef TCP_SOCKET_CONNECT_TASK_STACK_SIZE
+#define TCP_SOCKET_CONNECT_TASK_STACK_SIZE       (1024)
+#endif
+#ifndef TCP_SOCKET_CONNECT_TASK_PRIORITY
+#define TCP_SOCKET_CONNECT_TASK_PRIORITY         (2)
+#endif
+
+/* Maximum time to wait for all the TCP socket connections to complete. With
+ * ENABLE_TKO_TLS, the wait also covers the TLS handshake that follows.
+ */
+#define TCP_SOCKET_CONNECT_TIMEOUT_MS            (15000)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Connection parameters to the Wi-Fi connection manager (WCM) */
+extern cy_wcm_connect_params_t connect_param;
+extern cy_wcm_ip_address_t ip_addr;
+
+/* TCP socket handle for each connection */
+extern struct cy_socket_ctx_t *global_socket[MAX_TKO];
+
+/* Runtime TCP Keepalive configuration handed to the LPA middleware */
+extern cy_tko_ol_cfg_t tko_runtime_cfg;
 
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
+struct tcp_pcb;
+
+cy_rslt_t wifi_init(void);
 cy_rslt_t wifi_connect(void);
+cy_rslt_t wifi_ipv6_address_wait(void);
 void network_idle_task(void *arg);
+void tcp_socket_runtime_cfg_restore(const cy_tko_ol_cfg_t *cfg);
 cy_rslt_t tcp_socket_connection_start(void);
+cy_rslt_t tcp_socket_connection_result(int index);
+cy_rslt_t tcp_socket_reconnect(uint32_t socket_mask);
+struct tcp_pcb *tcp_socket_get_pcb(int index);
+struct tcp_pcb *tcp_socket_find_pcb(const cy_tko_ol_connect_t *port);
+bool tcp_socket_is_established(int index);
 const ol_desc_t *find_my_tko_descriptor(const char *name);
 
 #endif /* TCP_KEEPALIVE_OFFLOAD_H */
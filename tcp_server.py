@@ -44,14 +44,113 @@
 A simple "TCP server" for demonstrating TCP usage.
 The server listens for TCP packets and prints the message received from the TCP client.
 
+In benchmark mode (--benchmark), the server accepts up to MAX_TKO concurrent
+connections, records the arrival time of each TCP keepalive, measures its
+jitter against the configured interval, and times how long the device takes to
+resume from deep-sleep and acknowledge an inbound packet. The results are
+written as CSV or JSON.
+
+In scale mode (--scale), an asyncio server accepts thousands of concurrent
+connections on one or more ports, tracks the last keepalive of each client,
+counts the missed keepalives, and injects wake probes toward chosen clients to
+time their acknowledgement and reply. With --load, the script is instead the
+load generator: it opens many keepalive connections to one or more servers,
+each replying to the wake probes like a device waking up.
+
+With --tls-cert and --tls-key, the echo server runs TLS on each connection,
+and prints whether the client resumed its previous session.
+
+With --metrics, the echo server sends a metrics request to the device at the
+given period, and prints the metrics frames it answers with instead of
+echoing them (see tko_metrics.h).
+
 """
 
 import socket
 import optparse
 import time
 import sys
+import select
+import struct
+import json
+import csv
+import random
+import asyncio
+import ssl
+import heapq
+
+# Frames of the debug UART format: A5 5A, type, length (LE16), payload, and a
+# CRC-16/CCITT-FALSE of the type, length and payload (LE16)
+FRAME_SYNC = b"\xa5\x5a"
+FRAME_HEADER_LEN = 5
+METRICS_FRAME_TYPE = 0x02
+METRICS_REQUEST_FRAME_TYPE = 0x03
+
+# Layout of tko_metrics_t, version 1
+METRICS_FORMAT = "<HHIIIIIIIIIII4H4I"
+WAKE_REASONS = ("tko_failure", "data", "link_loss", "other")
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
 
-def echo_server(port):
+def build_frame(frame_type, payload=b""):
+    body = struct.pack("<BH", frame_type, len(payload)) + payload
+    return FRAME_SYNC + body + struct.pack("<H", crc16_ccitt(body))
+
+def split_metrics_frames(buffer):
+    """
+    Returns (data, frames, rest): the bytes of the buffer before the first
+    metrics frame that is not complete, the payloads of the metrics frames with
+    a valid CRC, and the bytes to keep for the next read.
+    """
+    data = b""
+    frames = []
+    while True:
+        start = buffer.find(FRAME_SYNC + bytes((METRICS_FRAME_TYPE,)))
+        if start < 0:
+            # A sync split over two reads is kept for the next one
+            keep = 2 if buffer.endswith(FRAME_SYNC) else (1 if buffer.endswith(FRAME_SYNC[:1]) else 0)
+            return data + buffer[:len(buffer) - keep], frames, buffer[len(buffer) - keep:]
+        data += buffer[:start]
+        buffer = buffer[start:]
+        if len(buffer) < FRAME_HEADER_LEN:
+            return data, frames, buffer
+        length, = struct.unpack_from("<H", buffer, 3)
+        if len(buffer) < FRAME_HEADER_LEN + length + 2:
+            return data, frames, buffer
+        body = buffer[2:FRAME_HEADER_LEN + length]
+        crc, = struct.unpack_from("<H", buffer, FRAME_HEADER_LEN + length)
+        if crc == crc16_ccitt(body):
+            frames.append(body[3:])
+        else:
+            print("Metrics frame with a bad CRC dropped")
+        buffer = buffer[FRAME_HEADER_LEN + length + 2:]
+
+def print_metrics(addr, payload):
+    if len(payload) < struct.calcsize(METRICS_FORMAT):
+        print(("Metrics frame too short: %d bytes" % (len(payload))))
+        return
+    fields = struct.unpack_from(METRICS_FORMAT, payload)
+    (version, _, uptime_s, suspend_calls, resume_count, awake_s, waiting_s, suspended_s,
+     latency_max_us, losses, reconnects, heap_free, heap_free_min) = fields[:13]
+    pools = fields[13:17]
+    wakes = fields[17:21]
+    print((time.strftime("%b %d %H:%M:%S ", time.localtime()), addr[0], ": metrics v%d" % (version)))
+    print(("  uptime %d s, awake %d s, waiting %d s, suspended %d s" % (uptime_s, awake_s, waiting_s, suspended_s)))
+    print(("  suspend calls %d, resumes %d, max resume latency %d us" % (suspend_calls, resume_count, latency_max_us)))
+    print(("  connections lost %d, reconnected %d" % (losses, reconnects)))
+    print(("  heap free %d, lowest %d" % (heap_free, heap_free_min)))
+    print(("  pool max: tcp_pcb %s, tcp_seg %s, pbuf %s, netconn %s" %
+           tuple("-" if p == 0xFFFF else str(p) for p in pools)))
+    print(("  wakes: " + ", ".join("%s %d" % (n, w) for n, w in zip(WAKE_REASONS, wakes))))
+    print("")
+
+def echo_server(port, tls_context=None, metrics_period=0):
     print("==========================")
     print("TCP Server")
     print("==========================")
@@ -81,11 +180,36 @@ def echo_server(port):
 
         print(('Incoming connection accepted: ', addr))
 
+        if tls_context is not None:
+            try:
+                conn = tls_context.wrap_socket(conn, server_side=True)
+            except (ssl.SSLError, OSError) as msg:
+                print(("TLS handshake failed: ", msg))
+                conn.close()
+                continue
+            print(("TLS %s %s, session %s" % (conn.version(), conn.cipher()[0],
+                                              "resumed" if conn.session_reused else "new")))
+
         try:
+            pending = b""
+            next_request = time.time() + metrics_period
             while 1:
+                if metrics_period > 0:
+                    if time.time() >= next_request:
+                        conn.send(build_frame(METRICS_REQUEST_FRAME_TYPE))
+                        next_request = time.time() + metrics_period
+                    tls_pending = tls_context is not None and conn.pending() > 0
+                    if not tls_pending:
+                        readable, _, _ = select.select([conn], [], [], max(next_request - time.time(), 0))
+                        if not readable: continue
                 data = conn.recv(4096)
                 if not data: break
-                print((time.strftime("%b %d %H:%M:%S ", time.localtime()), addr[0], ":", data.decode('utf-8')))
+                if metrics_period > 0:
+                    data, frames, pending = split_metrics_frames(pending + data)
+                    for frame in frames:
+                        print_metrics(addr, frame)
+                    if not data: continue
+                print((time.strftime("%b %d %H:%M:%S ", time.localtime()), addr[0], ":", data.decode('utf-8', 'replace')))
                 print("")
                 conn.send(data)
         except KeyboardInterrupt:
@@ -93,14 +217,718 @@ def echo_server(port):
             s.close()
             s = None
             sys.exit(1)
+        except (ssl.SSLError, OSError) as msg:
+            print(("Connection error: ", msg))
+
+        conn.close()
+
+# Offsets of the fields used from the Linux 'struct tcp_info' (linux/tcp.h)
+TCP_INFO_LEN = 160
+TCP_INFO_UNACKED_OFFSET = 24
+TCP_INFO_SEGS_IN_OFFSET = 140
+TCP_INFO_DATA_SEGS_IN_OFFSET = 152
+
+WAKE_PROBE_PAYLOAD = b"TKO-WAKE-PROBE"
+
+def read_tcp_info(conn):
+    """
+    Returns (unacked, segs_in, data_segs_in) of the connection, or None when
+    TCP_INFO is not supported by the host OS.
+    """
+    if not hasattr(socket, "TCP_INFO"):
+        return None
+    try:
+        info = conn.getsockopt(socket.IPPROTO_TCP, socket.TCP_INFO, TCP_INFO_LEN)
+    except (OSError, socket.error):
+        return None
+    if len(info) < TCP_INFO_LEN:
+        return None
+    unacked, = struct.unpack_from("I", info, TCP_INFO_UNACKED_OFFSET)
+    segs_in, = struct.unpack_from("I", info, TCP_INFO_SEGS_IN_OFFSET)
+    data_segs_in, = struct.unpack_from("I", info, TCP_INFO_DATA_SEGS_IN_OFFSET)
+    return (unacked, segs_in, data_segs_in)
+
+class BenchmarkConnection(object):
+    """
+    Keepalive arrivals and wake probe results of a single TCP client.
+    A keepalive is an incoming segment that carries no data, detected by
+    polling the segment counters of TCP_INFO.
+    """
+    def __init__(self, conn_id, conn, addr, now):
+        self.conn_id = conn_id
+        self.conn = conn
+        self.addr = addr
+        self.accepted = now
+        self.events = []
+        self.keepalives = []
+        self.probe_latencies = []
+        self.probe_sent = None
+        self.awaiting_ack = False
+        self.last_probe = now
+        info = read_tcp_info(conn)
+        self.segs_in = info[1] if info else 0
+        self.data_segs_in = info[2] if info else 0
+
+    def poll(self, now, interval):
+        info = read_tcp_info(self.conn)
+        if info is None:
+            return
+        unacked, segs_in, data_segs_in = info
+        keepalives = (segs_in - self.segs_in) - (data_segs_in - self.data_segs_in)
+        # The acknowledgement of data sent to the client is not a keepalive
+        if self.awaiting_ack and unacked == 0:
+            keepalives -= 1
+        self.awaiting_ack = unacked > 0
+        self.segs_in = segs_in
+        self.data_segs_in = data_segs_in
+        for _ in range(max(keepalives, 0)):
+            delta = (now - self.keepalives[-1]) if self.keepalives else None
+            jitter = (delta - interval) if delta is not None else None
+            self.keepalives.append(now)
+            self.events.append((self.conn_id, self.addr[0], "keepalive", now, delta, jitter))
+        if self.probe_sent is not None and unacked == 0:
+            latency = now - self.probe_sent
+            self.probe_latencies.append(latency)
+            self.events.append((self.conn_id, self.addr[0], "wake_probe", now, latency, None))
+            self.probe_sent = None
+
+    def maybe_probe(self, now, interval, probe_period):
+        """
+        Sends a wake probe halfway between two keepalives, when the device is
+        expected to be in deep-sleep, and times the TCP acknowledgement.
+        """
+        if probe_period <= 0 or self.probe_sent is not None or not self.keepalives:
+            return
+        if now - self.last_probe < probe_period or now - self.keepalives[-1] < interval / 2.0:
+            return
+        try:
+            self.conn.send(WAKE_PROBE_PAYLOAD)
+        except (OSError, socket.error):
+            return
+        self.probe_sent = now
+        self.last_probe = now
+        self.awaiting_ack = True
+
+    def summary(self, interval):
+        deltas = [b - a for a, b in zip(self.keepalives, self.keepalives[1:])]
+        jitters = [d - interval for d in deltas]
+        result = {
+            "id": self.conn_id,
+            "peer": "%s:%d" % (self.addr[0], self.addr[1]),
+            "keepalives": len(self.keepalives),
+            "mean_interval_s": (sum(deltas) / len(deltas)) if deltas else None,
+            "mean_abs_jitter_ms": (1000.0 * sum(abs(j) for j in jitters) / len(jitters)) if jitters else None,
+            "max_abs_jitter_ms": (1000.0 * max(abs(j) for j in jitters)) if jitters else None,
+            "wake_probes": len(self.probe_latencies),
+            "min_wake_latency_ms": (1000.0 * min(self.probe_latencies)) if self.probe_latencies else None,
+            "mean_wake_latency_ms": (1000.0 * sum(self.probe_latencies) / len(self.probe_latencies))
+                                    if self.probe_latencies else None,
+            "max_wake_latency_ms": (1000.0 * max(self.probe_latencies)) if self.probe_latencies else None,
+        }
+        return result
+
+def write_benchmark_results(path, interval, connections):
+    summaries = [c.summary(interval) for c in connections]
+    events = sorted([e for c in connections for e in c.events], key=lambda e: e[3])
+
+    if path is None:
+        for s in summaries:
+            print(s)
+        return
+
+    if path.endswith(".json"):
+        with open(path, "w") as f:
+            json.dump({"interval_s": interval,
+                       "connections": summaries,
+                       "events": [dict(zip(("id", "peer", "event", "time", "delta_s", "jitter_s"), e))
+                                  for e in events]}, f, indent=2)
+    else:
+        with open(path, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(("id", "peer", "event", "time", "delta_s", "jitter_s"))
+            for e in events:
+                writer.writerow(e)
+    print("Results written to %s" % (path))
+
+def benchmark_server(port, max_connections, interval, probe_period, duration, poll_ms, output):
+    print("==========================")
+    print("TCP Server (Benchmark)")
+    print("==========================")
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    try:
+        s.bind(("", port))
+        s.listen(max_connections)
+    except socket.error as msg:
+        print(("ERROR: ", msg))
+        s.close()
+        sys.exit(1)
+
+    if read_tcp_info(s) is None:
+        print("WARNING: TCP_INFO is not available, keepalive arrivals cannot be recorded.")
+
+    print(("Listening on: %d, up to %d connections, keepalive interval %.1f s" % (port, max_connections, interval)))
+
+    connections = []
+    active = {}
+    next_id = 0
+    start = time.time()
 
+    try:
+        while duration <= 0 or time.time() - start < duration:
+            # Poll faster while a wake probe is waiting for its acknowledgement
+            probing = any(c.probe_sent is not None for c in active.values())
+            timeout = 0.001 if probing else poll_ms / 1000.0
+
+            readable, _, _ = select.select([s] + list(active.keys()), [], [], timeout)
+            now = time.time()
+
+            for r in readable:
+                if r is s:
+                    conn, addr = s.accept()
+                    if len(active) >= max_connections:
+                        print(('Rejected connection, limit reached: ', addr))
+                        conn.close()
+                        continue
+                    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                    c = BenchmarkConnection(next_id, conn, addr, now)
+                    next_id += 1
+                    connections.append(c)
+                    active[conn] = c
+                    print(('Incoming connection accepted: ', addr))
+                    continue
+
+                c = active[r]
+                try:
+                    data = r.recv(4096)
+                except (OSError, socket.error):
+                    data = b""
+                if not data:
+                    print(('Connection closed: ', c.addr))
+                    del active[r]
+                    r.close()
+                    continue
+                c.events.append((c.conn_id, c.addr[0], "data", now, len(data), None))
+                r.send(data)
+                c.awaiting_ack = True
+
+            for c in active.values():
+                c.poll(now, interval)
+                c.maybe_probe(now, interval, probe_period)
+    except KeyboardInterrupt:
+        print("Closing Connection")
+
+    for conn in list(active.keys()):
         conn.close()
+    s.close()
+
+    write_benchmark_results(output, interval, connections)
+
+# Scale mode: an asyncio server for thousands of concurrent keepalive
+# connections, and a load generator that simulates the devices.
+
+WAKE_PROBE_REPLY = b"TKO-WAKE-REPLY"
+
+def raise_fd_limit(needed):
+    """
+    Raises the soft limit of open files towards the hard limit, as each
+    connection takes a file descriptor.
+    """
+    try:
+        import resource
+    except ImportError:
+        return
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    wanted = needed + 64
+    if hard != resource.RLIM_INFINITY:
+        wanted = min(wanted, hard)
+    if soft != resource.RLIM_INFINITY and soft < wanted:
+        try:
+            resource.setrlimit(resource.RLIMIT_NOFILE, (wanted, hard))
+        except (ValueError, OSError):
+            print("WARNING: Unable to raise the open file limit to %d" % (wanted))
+
+def percentile(values, p):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))]
+
+def format_ms(value):
+    return "-" if value is None else "%.1f" % (1000.0 * value)
+
+class ScaleConnection(asyncio.Protocol):
+    """
+    Keepalive and wake probe tracking of one client of the scale server.
+    Keepalives are counted from TCP_INFO like in benchmark mode, by the sweep
+    of ScaleServer. A gap between two keepalives longer than the interval plus
+    the tolerance counts the keepalives missed in it. Data from the client
+    restarts its keepalive timer, so it is counted as the last keepalive.
+    """
+    def __init__(self, server):
+        self.server = server
+        self.transport = None
+        self.sock = None
+        self.conn_id = None
+        self.peer = None
+        self.accepted = None
+        self.closed = None
+        self.last_keepalive = None
+        self.keepalives = 0
+        self.missed = 0
+        self.segs_in = 0
+        self.data_segs_in = 0
+        self.awaiting_ack = False
+        self.probe_sent = None
+        self.reply_pending = None
+        self.ack_latencies = []
+        self.reply_latencies = []
+        self.next_poll = None
+
+    def connection_made(self, transport):
+        self.transport = transport
+        self.sock = transport.get_extra_info("socket")
+        self.peer = transport.get_extra_info("peername")
+        self.accepted = time.time()
+        self.last_keepalive = self.accepted
+        info = read_tcp_info(self.sock)
+        self.segs_in = info[1] if info else 0
+        self.data_segs_in = info[2] if info else 0
+        if not self.server.register(self):
+            transport.abort()
+
+    def connection_lost(self, exc):
+        self.closed = time.time()
+        self.server.unregister(self)
+
+    def data_received(self, data):
+        now = time.time()
+        self.last_keepalive = now
+        if data.startswith(WAKE_PROBE_REPLY):
+            if self.reply_pending is not None:
+                self.reply_latencies.append(now - self.reply_pending)
+                self.reply_pending = None
+            return
+        # Application data of a device is echoed back, like in benchmark mode
+        self.transport.write(data)
+        self.awaiting_ack = True
+
+    def poll(self, now, interval, tolerance):
+        """
+        Returns whether a keepalive was counted.
+        """
+        info = read_tcp_info(self.sock)
+        if info is None:
+            return False
+        unacked, segs_in, data_segs_in = info
+        data_segs = data_segs_in - self.data_segs_in
+        keepalives = (segs_in - self.segs_in) - data_segs
+        # The pure acknowledgement of data sent to the client is not a keepalive
+        if self.awaiting_ack and unacked == 0 and data_segs == 0:
+            keepalives -= 1
+        if unacked == 0:
+            self.awaiting_ack = False
+        self.segs_in = segs_in
+        self.data_segs_in = data_segs_in
+        if keepalives > 0:
+            gap = now - self.last_keepalive
+            if gap > interval * (1.0 + tolerance):
+                self.missed += max(int(gap / interval + 0.5) - 1, 0)
+            self.keepalives += keepalives
+            self.last_keepalive = now
+        if self.probe_sent is not None and unacked == 0:
+            self.ack_latencies.append(now - self.probe_sent)
+            self.probe_sent = None
+        return keepalives > 0
+
+    def overdue(self, now, interval, tolerance):
+        return now - self.last_keepalive > interval * (1.0 + tolerance)
+
+    def inject(self, now):
+        """
+        Sends a wake probe. Its TCP acknowledgement and the reply of a
+        simulated device are timed separately.
+        """
+        if self.probe_sent is not None or self.transport.is_closing():
+            return False
+        self.transport.write(WAKE_PROBE_PAYLOAD)
+        self.probe_sent = now
+        self.reply_pending = now
+        self.awaiting_ack = True
+        return True
+
+    def summary(self):
+        return {
+            "id": self.conn_id,
+            "peer": "%s:%d" % (self.peer[0], self.peer[1]),
+            "connected_s": (self.closed or time.time()) - self.accepted,
+            "closed": self.closed is not None,
+            "keepalives": self.keepalives,
+            "missed_keepalives": self.missed,
+            "wake_probes": len(self.ack_latencies),
+            "mean_ack_latency_ms": (1000.0 * sum(self.ack_latencies) / len(self.ack_latencies))
+                                   if self.ack_latencies else None,
+            "max_ack_latency_ms": (1000.0 * max(self.ack_latencies)) if self.ack_latencies else None,
+            "mean_reply_latency_ms": (1000.0 * sum(self.reply_latencies) / len(self.reply_latencies))
+                                     if self.reply_latencies else None,
+        }
+
+class ScaleServer(object):
+    """
+    Connections of the scale server, their TCP_INFO sweep, the wake probe
+    injection, and the periodic report. The connections are kept in a heap by
+    the time of their next poll.
+    """
+    def __init__(self, max_connections, interval, tolerance):
+        self.max_connections = max_connections
+        self.interval = interval
+        self.tolerance = tolerance
+        self.connections = []
+        self.active = set()
+        self.due = []
+        self.polls = 0
+        self.rejected = 0
+        self.start = time.time()
+        self.probe_event = asyncio.Event()
+
+    def register(self, c):
+        if len(self.active) >= self.max_connections:
+            self.rejected += 1
+            return False
+        c.conn_id = len(self.connections)
+        self.connections.append(c)
+        self.active.add(c)
+        self.schedule(c, c.accepted)
+        return True
+
+    def schedule(self, c, when):
+        # The earlier heap entries of the connection are skipped when popped
+        c.next_poll = when
+        heapq.heappush(self.due, (when, c.conn_id, c))
+
+    def pop_due(self, now, batch):
+        """
+        Returns at most batch active connections whose poll is due, the most
+        overdue first.
+        """
+        polled = []
+        while self.due and self.due[0][0] <= now and len(polled) < batch:
+            when, _, c = heapq.heappop(self.due)
+            if c in self.active and c.next_poll == when:
+                polled.append(c)
+        return polled
+
+    def unregister(self, c):
+        self.active.discard(c)
+
+    async def sweep(self, poll_ms, batch):
+        """
+        Polls the connections whose keepalive is due, at most batch of them
+        each poll period, and the connections with a wake probe in flight
+        every millisecond. A connection is due again one poll period after a
+        poll that saw no keepalive, and interval * (1 - tolerance) after one
+        that did, so that it is not polled between two keepalives. The
+        segment counters of TCP_INFO add up, so a connection polled late only
+        has its keepalive time recorded late. Woken up by the injector.
+        """
+        period = poll_ms / 1000.0
+        quiet = max(self.interval * (1.0 - self.tolerance), period)
+        last_sweep = 0
+        while True:
+            now = time.time()
+            probed = [c for c in self.active if c.probe_sent is not None]
+            polled = list(probed)
+            if now - last_sweep >= period:
+                last_sweep = now
+                polled.extend(c for c in self.pop_due(now, batch) if c.probe_sent is None)
+            for c in polled:
+                if c.poll(now, self.interval, self.tolerance):
+                    self.schedule(c, now + quiet)
+                elif c.next_poll <= now:
+                    self.schedule(c, now + period)
+            self.polls += len(polled)
+            probing = any(c.probe_sent is not None for c in self.active)
+            try:
+                await asyncio.wait_for(self.probe_event.wait(), 0.001 if probing else period)
+            except asyncio.TimeoutError:
+                pass
+            self.probe_event.clear()
+
+    async def injector(self, period, count, clients):
+        """
+        Every period, sends a wake probe to count clients picked at random, or
+        to the chosen client ids, that have sent at least one keepalive.
+        """
+        while True:
+            await asyncio.sleep(period)
+            now = time.time()
+            candidates = [c for c in self.active if c.keepalives > 0 and c.probe_sent is None and
+                          (clients is None or c.conn_id in clients)]
+            for c in random.sample(candidates, min(count, len(candidates))):
+                c.inject(now)
+            self.probe_event.set()
+
+    def report_line(self):
+        now = time.time()
+        acks = [l for c in self.connections for l in c.ack_latencies]
+        replies = [l for c in self.connections for l in c.reply_latencies]
+        return ("t=%ds conns=%d rejected=%d polls=%d keepalives=%d missed=%d overdue=%d probes=%d "
+                "ack p50/p95/p99=%s/%s/%s ms reply p50/p95/p99=%s/%s/%s ms" %
+                (now - self.start, len(self.active), self.rejected, self.polls,
+                 sum(c.keepalives for c in self.connections), sum(c.missed for c in self.connections),
+                 sum(1 for c in self.active if c.overdue(now, self.interval, self.tolerance)), len(acks),
+                 format_ms(percentile(acks, 50)), format_ms(percentile(acks, 95)), format_ms(percentile(acks, 99)),
+                 format_ms(percentile(replies, 50)), format_ms(percentile(replies, 95)),
+                 format_ms(percentile(replies, 99))))
+
+    async def reporter(self, period):
+        while True:
+            await asyncio.sleep(period)
+            print(self.report_line())
+
+def write_scale_results(path, interval, server):
+    summaries = [c.summary() for c in server.connections]
+
+    if path is None:
+        return
+
+    if path.endswith(".json"):
+        acks = [l for c in server.connections for l in c.ack_latencies]
+        with open(path, "w") as f:
+            json.dump({"interval_s": interval,
+                       "connections": len(server.connections),
+                       "rejected": server.rejected,
+                       "keepalives": sum(c.keepalives for c in server.connections),
+                       "missed_keepalives": sum(c.missed for c in server.connections),
+                       "ack_latency_ms": {"p50": percentile(acks, 50) and 1000.0 * percentile(acks, 50),
+                                          "p95": percentile(acks, 95) and 1000.0 * percentile(acks, 95),
+                                          "p99": percentile(acks, 99) and 1000.0 * percentile(acks, 99)},
+                       "clients": summaries}, f, indent=2)
+    else:
+        with open(path, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(summaries[0].keys()) if summaries else ["id"])
+            writer.writeheader()
+            for s in summaries:
+                writer.writerow(s)
+    print("Results written to %s" % (path))
+
+async def run_for(duration):
+    if duration > 0:
+        await asyncio.sleep(duration)
+    else:
+        await asyncio.Event().wait()
+
+async def scale_server(ports, max_connections, interval, tolerance, poll_ms, sweep_batch, inject_period,
+                       inject_count, inject_clients, report_period, duration, output):
+    print("==========================")
+    print("TCP Server (Scale)")
+    print("==========================")
+    raise_fd_limit(max_connections)
+    loop = asyncio.get_running_loop()
+    server = ScaleServer(max_connections, interval, tolerance)
+
+    listeners = []
+    for port in ports:
+        listeners.append(await loop.create_server(lambda: ScaleConnection(server), None, port,
+                                                  backlog=min(max_connections, 4096), reuse_address=True))
+        print(("Listening on: %d" % (port)))
+
+    if read_tcp_info(listeners[0].sockets[0]) is None:
+        print("WARNING: TCP_INFO is not available, keepalive arrivals cannot be recorded.")
+
+    tasks = [asyncio.ensure_future(server.sweep(poll_ms, sweep_batch)), asyncio.ensure_future(server.reporter(report_period))]
+    if inject_period > 0:
+        tasks.append(asyncio.ensure_future(server.injector(inject_period, inject_count, inject_clients)))
+
+    try:
+        await run_for(duration)
+    finally:
+        for t in tasks:
+            t.cancel()
+        for l in listeners:
+            l.close()
+        for c in list(server.active):
+            c.transport.abort()
+        print(server.report_line())
+        write_scale_results(output, interval, server)
+
+def set_keepalive(sock, interval):
+    """
+    Enables the kernel TCP keepalive of a simulated device, one probe per
+    interval once the connection is idle.
+    """
+    seconds = max(1, int(round(interval)))
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_KEEPALIVE, 1)
+    if hasattr(socket, "TCP_KEEPIDLE"):
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPIDLE, seconds)
+    elif hasattr(socket, "TCP_KEEPALIVE"):
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPALIVE, seconds)
+    if hasattr(socket, "TCP_KEEPINTVL"):
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPINTVL, seconds)
+    if hasattr(socket, "TCP_KEEPCNT"):
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPCNT, 5)
+
+class LoadClient(asyncio.Protocol):
+    """
+    One simulated device: a TCP connection kept alive by the kernel, which
+    replies to each wake probe after the wake delay.
+    """
+    def __init__(self, generator):
+        self.generator = generator
+        self.transport = None
+
+    def connection_made(self, transport):
+        self.transport = transport
+        set_keepalive(transport.get_extra_info("socket"), self.generator.interval)
+        self.generator.connected += 1
+
+    def connection_lost(self, exc):
+        self.generator.connected -= 1
+        self.generator.lost += 1
+
+    def data_received(self, data):
+        if WAKE_PROBE_PAYLOAD in data:
+            self.generator.probes += 1
+            asyncio.get_event_loop().call_later(self.generator.wake_delay, self.reply)
+
+    def reply(self):
+        if not self.transport.is_closing():
+            self.transport.write(WAKE_PROBE_REPLY)
+
+class LoadGenerator(object):
+    def __init__(self, interval, wake_delay):
+        self.interval = interval
+        self.wake_delay = wake_delay
+        self.connected = 0
+        self.failed = 0
+        self.lost = 0
+        self.probes = 0
+        self.clients = []
+
+    def report_line(self):
+        return ("connected=%d failed=%d lost=%d probes=%d" %
+                (self.connected, self.failed, self.lost, self.probes))
+
+    async def reporter(self, period):
+        while True:
+            await asyncio.sleep(period)
+            print(self.report_line())
+
+async def load_generator(targets, count, interval, wake_delay_ms, connect_rate, report_period, duration):
+    print("==========================")
+    print("TCP Keepalive Load Generator")
+    print("==========================")
+    raise_fd_limit(count)
+    loop = asyncio.get_running_loop()
+    generator = LoadGenerator(interval, wake_delay_ms / 1000.0)
+    reporter = asyncio.ensure_future(generator.reporter(report_period))
+
+    print(("Opening %d connections to %s, keepalive interval %.1f s" %
+           (count, ", ".join("%s:%d" % t for t in targets), interval)))
+
+    try:
+        # Connections are opened at connect_rate per second, over the servers in turn
+        for index in range(count):
+            host, port = targets[index % len(targets)]
+            try:
+                transport, client = await loop.create_connection(lambda: LoadClient(generator), host, port)
+                generator.clients.append(transport)
+            except OSError:
+                generator.failed += 1
+            await asyncio.sleep(1.0 / connect_rate)
+        print(generator.report_line())
+        await run_for(duration)
+    finally:
+        reporter.cancel()
+        for transport in generator.clients:
+            transport.abort()
+        print(generator.report_line())
+
+def parse_targets(value, default_port):
+    targets = []
+    for item in value.split(","):
+        host, _, port = item.strip().rpartition(":")
+        if not host:
+            host, port = port, default_port
+        targets.append((host, int(port)))
+    return targets
 
 if __name__ == '__main__':
     parser = optparse.OptionParser()
     parser.add_option("-p", "--port", dest="port", type="int", default=50007, help="Port to listen on [default: %default].")
+    parser.add_option("-b", "--benchmark", dest="benchmark", action="store_true", default=False,
+                      help="Run the keepalive and wake latency benchmark.")
+    parser.add_option("-s", "--scale", dest="scale", action="store_true", default=False,
+                      help="Run the asyncio scale server for many concurrent clients.")
+    parser.add_option("-l", "--load", dest="load", default=None, metavar="HOST:PORT[,HOST:PORT...]",
+                      help="Run the load generator against the given servers.")
+    parser.add_option("-n", "--connections", dest="connections", type="int", default=None,
+                      help="Maximum concurrent connections, MAX_TKO on the device [default: 4]. "
+                           "Maximum clients in scale mode [default: 10000], or connections opened by "
+                           "the load generator [default: 100].")
+    parser.add_option("-i", "--interval", dest="interval", type="float", default=5.0,
+                      help="Configured TCP keepalive interval in seconds [default: %default].")
+    parser.add_option("-w", "--wake-probe", dest="probe_period", type="float", default=60.0,
+                      help="Seconds between wake probes on each connection, 0 to disable [default: %default].")
+    parser.add_option("-d", "--duration", dest="duration", type="float", default=0,
+                      help="Benchmark duration in seconds, 0 to run until Ctrl+C [default: %default].")
+    parser.add_option("--poll", dest="poll_ms", type="int", default=20,
+                      help="TCP_INFO polling period in milliseconds [default: %default].")
+    parser.add_option("--sweep-batch", dest="sweep_batch", type="int", default=1000,
+                      help="Most connections the scale server polls each polling period [default: %default].")
+    parser.add_option("-o", "--output", dest="output", default=None,
+                      help="Write the results to a .csv or .json file instead of the console.")
+    parser.add_option("--ports", dest="ports", default=None,
+                      help="Comma-separated ports the scale server listens on [default: --port].")
+    parser.add_option("--tolerance", dest="tolerance", type="float", default=0.5,
+                      help="Fraction of the interval a keepalive may be late before it is missed [default: %default].")
+    parser.add_option("--inject", dest="inject_period", type="float", default=0,
+                      help="Seconds between wake probe rounds in scale mode, 0 to disable [default: %default].")
+    parser.add_option("--inject-count", dest="inject_count", type="int", default=10,
+                      help="Clients picked at random for each wake probe round [default: %default].")
+    parser.add_option("--inject-clients", dest="inject_clients", default=None,
+                      help="Comma-separated client ids to send the wake probes to, instead of random clients.")
+    parser.add_option("--report", dest="report_period", type="float", default=10.0,
+                      help="Seconds between the progress reports of the scale modes [default: %default].")
+    parser.add_option("--wake-delay", dest="wake_delay_ms", type="float", default=0,
+                      help="Milliseconds the simulated devices take to reply to a wake probe [default: %default].")
+    parser.add_option("--connect-rate", dest="connect_rate", type="float", default=200.0,
+                      help="Connections opened per second by the load generator [default: %default].")
+
+    parser.add_option("--tls-cert", dest="tls_cert", default=None,
+                      help="PEM certificate chain of the echo server, to run TLS on each connection.")
+    parser.add_option("--tls-key", dest="tls_key", default=None,
+                      help="PEM private key of the echo server certificate.")
+    parser.add_option("--metrics", dest="metrics_period", type="float", default=0, metavar="SECONDS",
+                      help="Seconds between the metrics requests of the echo server, 0 to disable [default: %default].")
 
     (options, args) = parser.parse_args()
 
-    echo_server(options.port)
+    if options.load:
+        try:
+            asyncio.run(load_generator(parse_targets(options.load, options.port),
+                                       options.connections or 100, options.interval, options.wake_delay_ms,
+                                       options.connect_rate, options.report_period, options.duration))
+        except KeyboardInterrupt:
+            print("Closing Connections")
+    elif options.scale:
+        ports = [int(p) for p in options.ports.split(",")] if options.ports else [options.port]
+        clients = set(int(c) for c in options.inject_clients.split(",")) if options.inject_clients else None
+        try:
+            asyncio.run(scale_server(ports, options.connections or 10000, options.interval, options.tolerance,
+                                     options.poll_ms, options.sweep_batch, options.inject_period,
+                                     options.inject_count, clients,
+                                     options.report_period, options.duration, options.output))
+        except KeyboardInterrupt:
+            print("Closing Connections")
+    elif options.benchmark:
+        benchmark_server(options.port, options.connections or 4, options.interval, options.probe_period,
+                         options.duration, options.poll_ms, options.output)
+    else:
+        tls_context = None
+        if options.tls_cert:
+            tls_context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+            tls_context.load_cert_chain(options.tls_cert, options.tls_key)
+        echo_server(options.port, tls_context, options.metrics_period)
 
@@ -0,0 +1,187 @@
+/******************************************************************************
+* File Name:   bench.c
+*
+* Description: Host microbenchmarks of the retry scheduler, the suspend
+*              scheduler decisions and the parallel socket reconnect. The
+*              figures are host CPU time, not target time; compare them
+*              between changes on the same machine.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "app_config.h"
+#include "cy_OlmInterface.h"
+#include "fake_network.h"
+#include "network_activity_handler.h"
+#include "network_suspend_scheduler.h"
+#include "offload_registry.h"
+#include "retry_scheduler.h"
+#include "tcp_keepalive_offload.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_CALLS                              (10000000u)
+#define BENCH_RECONNECTS                         (100000u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Results are summed here so that the compiler keeps the calls */
+static volatile uint32_t bench_sink;
+
+static const cy_tko_ol_connect_t bench_ports[MAX_TKO] =
+{
+    { .local_port = 50007, .remote_port = 3360, .remote_ip = "192.168.0.20" },
+    { .local_port = 50008, .remote_port = 3360, .remote_ip = "192.168.0.21" },
+    { .local_port = 50009, .remote_port = 3360, .remote_ip = "192.168.0.22" },
+    { .local_port = 50010, .remote_port = 3360, .remote_ip = "192.168.0.23" },
+};
+
+/********************************************************************************
+ * Function Name: bench_now_ns
+ ********************************************************************************
+ * Summary:
+ *  Returns the CPU time used by the process.
+ *
+ *******************************************************************************/
+static uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void bench_report(const char *name, uint64_t elapsed_ns, uint32_t count)
+{
+    printf("%-40s %10.1f ns/op %12u ops\n", name, (double)elapsed_ns / count, count);
+}
+
+static void bench_retry_delay(void)
+{
+    const retry_policy_t policy = { 0, 1000, 30000, 0, 0 };
+    retry_state_t retry;
+    uint32_t sum = 0;
+    uint64_t start;
+    uint32_t call;
+
+    retry_init(&retry, &policy);
+    start = bench_now_ns();
+
+    for (call = 0; call < BENCH_CALLS; call++)
+    {
+        retry.attempt = call & 15;
+        sum += retry_next_delay_ms(&retry);
+    }
+
+    bench_report("retry_next_delay_ms", bench_now_ns() - start, BENCH_CALLS);
+    bench_sink = sum;
+}
+
+static void bench_scheduler_decisions(void)
+{
+    uint32_t holdoff = NETWORK_SUSPEND_GUARD_MS;
+    uint32_t sum = 0;
+    uint64_t start;
+    uint32_t call;
+
+    start = bench_now_ns();
+
+    for (call = 0; call < BENCH_CALLS; call++)
+    {
+        holdoff = net_suspend_scheduler_next_holdoff_ms(holdoff, ST_SUCCESS, (call & 1023) * 2);
+        sum += holdoff + net_suspend_scheduler_window_ms(call & 255, 0 == (call & 63));
+    }
+
+    bench_report("suspend scheduler decisions", bench_now_ns() - start, BENCH_CALLS);
+    bench_sink = sum;
+}
+
+static void bench_reconnect(void)
+{
+    uint64_t switches = sim_switches();
+    uint64_t start;
+    uint32_t cycle;
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        fake_socket_set(index, 50 + 10 * (uint32_t)index, CY_RSLT_SUCCESS);
+    }
+
+    start = bench_now_ns();
+
+    for (cycle = 0; cycle < BENCH_RECONNECTS; cycle++)
+    {
+        if (CY_RSLT_SUCCESS != tcp_socket_reconnect((1u << MAX_TKO) - 1))
+        {
+            printf("tcp_socket_reconnect failed\n");
+            return;
+        }
+    }
+
+    bench_report("tcp_socket_reconnect, 4 sockets", bench_now_ns() - start, BENCH_RECONNECTS);
+    printf("%-40s %10.1f per reconnect\n", "task switches",
+           (double)(sim_switches() - switches) / BENCH_RECONNECTS);
+}
+
+int main(void)
+{
+    sim_reset(0);
+    fake_network_reset();
+    fake_ol_set_ports(bench_ports, MAX_TKO);
+
+    if ((CY_RSLT_SUCCESS != offload_registry_init()) || (CY_RSLT_SUCCESS != tcp_socket_connection_start()))
+    {
+        return 1;
+    }
+
+    bench_retry_delay();
+    bench_scheduler_decisions();
+    bench_reconnect();
+
+    return 0;
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,91 @@
+/******************************************************************************
+* File Name:   FreeRTOS.h
+*
+* Description: FreeRTOS types and macros for the host tests, with a 1 ms tick
+*              like the target configuration.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Tick rate of the target. One tick is one millisecond of simulated time. */
+#define configTICK_RATE_HZ                       (1000)
+#define portTICK_PERIOD_MS                       ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY                            ((TickType_t)0xFFFFFFFFu)
+
+/* As in FreeRTOS, the product is computed in TickType_t, so that it wraps for
+ * the same delays as on the target
+ */
+#define pdMS_TO_TICKS(ms)                        ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / \
+                                                               (TickType_t)1000U))
+
+#define pdFALSE                                  ((BaseType_t)0)
+#define pdTRUE                                   ((BaseType_t)1)
+#define pdFAIL                                   (pdFALSE)
+#define pdPASS                                   (pdTRUE)
+
+/* Tasks run cooperatively and an interrupt never preempts them */
+#define taskENTER_CRITICAL()                     do { } while (0)
+#define taskEXIT_CRITICAL()                      do { } while (0)
+#define taskENTER_CRITICAL_FROM_ISR()            (0)
+#define taskEXIT_CRITICAL_FROM_ISR(mask)         do { (void)(mask); } while (0)
+#define portYIELD_FROM_ISR(woken)                do { (void)(woken); } while (0)
+#define xPortIsInsideInterrupt()                 (pdFALSE)
+
+#define configASSERT(x)                          do { if (!(x)) { abort(); } } while (0)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint16_t configSTACK_DEPTH_TYPE;
+
+#endif /* FREERTOS_H */
+
+
+/* [] END OF FILE */
+
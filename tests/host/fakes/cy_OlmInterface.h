@@ -0,0 +1,95 @@
+/******************************************************************************
+* File Name:   cy_OlmInterface.h
+*
+* Description: Offload Manager types of the Low Power Assistant used by the
+*              application, for the host tests. The offload list and the
+*              socket creation are scripted by fake_network.h.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef CY_OLMINTERFACE_H
+#define CY_OLMINTERFACE_H
+
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* TCP Keepalive connections offloaded at most */
+#define MAX_TKO                                  (4)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    uint16_t local_port;
+    uint16_t remote_port;
+    char remote_ip[46];
+} cy_tko_ol_connect_t;
+
+typedef struct
+{
+    uint16_t interval;
+    uint16_t retry_interval;
+    uint16_t retry_count;
+    cy_tko_ol_connect_t ports[MAX_TKO];
+} cy_tko_ol_cfg_t;
+
+typedef struct ol_desc
+{
+    const char *name;
+    const void *cfg;
+    const void *fns;
+    void *ol;
+} ol_desc_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+const void *get_default_ol_list(void);
+cy_rslt_t cy_tcp_create_socket_connection(void *net_intf, void **global_socket_ptr, const char *remote_ip,
+                                          uint16_t remote_port, uint16_t local_port,
+                                          cy_tko_ol_cfg_t *downloaded, int enable_ka);
+
+#endif /* CY_OLMINTERFACE_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,162 @@
+/******************************************************************************
+* File Name:   cy_wcm.h
+*
+* Description: Types and calls of the Wi-Fi connection manager used by the
+*              application, for the host tests. cy_wcm_connect_ap() is
+*              scripted by fake_network.h.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef CY_WCM_H
+#define CY_WCM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_WCM_MAX_SSID_LEN                      (32)
+#define CY_WCM_MAX_PASSPHRASE_LEN                (63)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    CY_WCM_INTERFACE_TYPE_STA = 0
+} cy_wcm_interface_t;
+
+typedef enum
+{
+    CY_WCM_SECURITY_OPEN = 0,
+    CY_WCM_SECURITY_WPA2_AES_PSK
+} cy_wcm_security_t;
+
+typedef enum
+{
+    CY_WCM_IP_VER_V4 = 4,
+    CY_WCM_IP_VER_V6 = 6
+} cy_wcm_ip_version_t;
+
+typedef enum
+{
+    CY_WCM_WIFI_BAND_ANY = 0,
+    CY_WCM_WIFI_BAND_5GHZ,
+    CY_WCM_WIFI_BAND_2_4GHZ
+} cy_wcm_wifi_band_t;
+
+typedef enum
+{
+    CY_WCM_EVENT_CONNECTING = 0,
+    CY_WCM_EVENT_CONNECTED,
+    CY_WCM_EVENT_CONNECT_FAILED,
+    CY_WCM_EVENT_RECONNECTED,
+    CY_WCM_EVENT_DISCONNECTED,
+    CY_WCM_EVENT_IP_CHANGED
+} cy_wcm_event_t;
+
+typedef uint8_t cy_wcm_mac_t[6];
+
+typedef struct
+{
+    cy_wcm_interface_t interface;
+} cy_wcm_config_t;
+
+typedef struct
+{
+    cy_wcm_ip_version_t version;
+    union
+    {
+        uint32_t v4;
+        uint32_t v6[4];
+    } ip;
+} cy_wcm_ip_address_t;
+
+typedef struct
+{
+    cy_wcm_ip_address_t ip_address;
+    cy_wcm_ip_address_t gateway;
+    cy_wcm_ip_address_t netmask;
+} cy_wcm_ip_setting_t;
+
+typedef struct
+{
+    uint8_t SSID[CY_WCM_MAX_SSID_LEN + 1];
+    uint8_t password[CY_WCM_MAX_PASSPHRASE_LEN + 1];
+    cy_wcm_security_t security;
+} cy_wcm_ap_credentials_t;
+
+typedef struct
+{
+    cy_wcm_ap_credentials_t ap_credentials;
+    cy_wcm_mac_t BSSID;
+    cy_wcm_ip_setting_t *static_ip_settings;
+    cy_wcm_wifi_band_t band;
+} cy_wcm_connect_params_t;
+
+typedef struct
+{
+    uint8_t SSID[CY_WCM_MAX_SSID_LEN + 1];
+    cy_wcm_mac_t BSSID;
+    uint8_t channel;
+    int16_t signal_strength;
+} cy_wcm_associated_ap_info_t;
+
+typedef union
+{
+    cy_wcm_ip_address_t ip_addr;
+} cy_wcm_event_data_t;
+
+typedef void (*cy_wcm_event_callback_t)(cy_wcm_event_t event, cy_wcm_event_data_t *event_data);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cy_wcm_init(const cy_wcm_config_t *config);
+cy_rslt_t cy_wcm_connect_ap(const cy_wcm_connect_params_t *connect_params, cy_wcm_ip_address_t *ip_addr);
+cy_rslt_t cy_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info);
+bool cy_wcm_is_connected_to_ap(void);
+cy_rslt_t cy_wcm_register_event_callback(cy_wcm_event_callback_t event_callback);
+
+#endif /* CY_WCM_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,70 @@
+/******************************************************************************
+* File Name:   cyhal.h
+*
+* Description: Host stand-in of the flash driver of the HAL. A written row is
+*              kept in RAM, where a test can read it back.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef CYHAL_H
+#define CYHAL_H
+
+#include <stdint.h>
+
+#include "cy_result.h"
+#include "cy_syslib.h"
+
+#define CY_FLASH_SIZEOF_ROW                      (512u)
+
+typedef struct
+{
+    int unused;
+} cyhal_flash_t;
+
+/* Last row written with cyhal_flash_write(), and the number of writes */
+extern uint8_t fake_flash_row[CY_FLASH_SIZEOF_ROW];
+extern uint32_t fake_flash_writes;
+
+cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj);
+void cyhal_flash_free(cyhal_flash_t *obj);
+cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data);
+
+#endif /* CYHAL_H */
+
+
+/* [] END OF FILE */
+
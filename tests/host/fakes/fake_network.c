@@ -0,0 +1,663 @@
+/******************************************************************************
+* File Name:   fake_network.c
+*
+* Description: Scripted fakes of the Wi-Fi connection manager, the Low Power
+*              Assistant and the socket layer for the host tests. Each call
+*              takes simulated time, and the tests set what it returns.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cy_lwip.h"
+#include "cy_secure_sockets.h"
+#include "cy_wcm.h"
+#include "network_activity_handler.h"
+#include "lwip/dhcp.h"
+#include "lwip/etharp.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+
+#include "fake_network.h"
+#include "sim.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Sockets open at the same time at most. More means they leak. */
+#define FAKE_MAX_SOCKETS                         (64)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    bool in_use;
+    int index;
+} fake_socket_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Offload list of the configurator, with the TCP Keepalive descriptor only */
+static cy_tko_ol_cfg_t fake_tko_cfg =
+{
+    .interval = 20,
+    .retry_interval = 3,
+    .retry_count = 3,
+};
+
+static const ol_desc_t fake_ol_list[] =
+{
+    { .name = "TKO", .cfg = &fake_tko_cfg },
+    { .name = NULL },
+};
+
+static fake_socket_t fake_sockets[FAKE_MAX_SOCKETS];
+static uint32_t fake_open_sockets = 0;
+static fake_step_t fake_connect_step[MAX_TKO];
+static uint32_t fake_connect_count[MAX_TKO];
+
+static fake_step_t fake_wcm_steps[FAKE_MAX_RECORDS];
+static uint32_t fake_wcm_step_count = 0;
+static uint64_t fake_wcm_times[FAKE_MAX_RECORDS];
+static uint32_t fake_wcm_call_count = 0;
+
+static fake_step_t fake_suspend_steps[FAKE_MAX_RECORDS];
+static uint32_t fake_suspend_step_count = 0;
+static fake_suspend_call_t fake_suspend_log[FAKE_MAX_RECORDS];
+static uint32_t fake_suspend_call_count = 0;
+
+static bool fake_wcm_connected = true;
+static uint8_t fake_wcm_bssid_last = 1;
+static uint8_t fake_wcm_channel = 6;
+static cy_wcm_connect_params_t fake_wcm_params;
+static cy_wcm_event_callback_t fake_wcm_callback = NULL;
+
+static activity_cb_t fake_activity_cb = NULL;
+
+static struct netif fake_netif;
+static struct dhcp fake_dhcp;
+static bool fake_dhcp_bound = false;
+static uint32_t fake_dhcp_start_count = 0;
+struct tcp_pcb *tcp_active_pcbs = NULL;
+
+/********************************************************************************
+ * Function Name: fake_network_reset
+ ********************************************************************************
+ * Summary:
+ *  Forgets the scripts and the recorded calls. Every socket must be closed.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void fake_network_reset(void)
+{
+    memset(fake_sockets, 0, sizeof(fake_sockets));
+    memset(fake_connect_step, 0, sizeof(fake_connect_step));
+    memset(fake_connect_count, 0, sizeof(fake_connect_count));
+    fake_open_sockets = 0;
+    fake_wcm_step_count = 0;
+    fake_wcm_call_count = 0;
+    fake_suspend_step_count = 0;
+    fake_suspend_call_count = 0;
+    fake_dhcp_start_count = 0;
+    fake_wcm_set_link(true, 1, 6);
+}
+
+/********************************************************************************
+ * Function Name: fake_ol_set_ports
+ ********************************************************************************
+ * Summary:
+ *  Sets the port table of the TCP Keepalive descriptor. The other ports are
+ *  left unconfigured.
+ *
+ * Parameters:
+ *  ports: Ports to configure.
+ *  count: Number of ports, at most MAX_TKO.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void fake_ol_set_ports(const cy_tko_ol_connect_t *ports, int count)
+{
+    memset(fake_tko_cfg.ports, 0, sizeof(fake_tko_cfg.ports));
+    memcpy(fake_tko_cfg.ports, ports, (size_t)count * sizeof(*ports));
+}
+
+/********************************************************************************
+ * Function Name: fake_socket_set
+ ********************************************************************************
+ * Summary:
+ *  Sets how long the next connections of a socket take and what they return.
+ *
+ * Parameters:
+ *  index: Index of the socket in the port table.
+ *  duration_ms: Time the handshake takes.
+ *  result: Result of the handshake.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void fake_socket_set(int index, uint32_t duration_ms, cy_rslt_t result)
+{
+    fake_connect_step[index].duration_ms = duration_ms;
+    fake_connect_step[index].result = (int32_t)result;
+}
+
+uint32_t fake_socket_connects(int index)
+{
+    return fake_connect_count[index];
+}
+
+uint32_t fake_sockets_open(void)
+{
+    return fake_open_sockets;
+}
+
+bool fake_socket_is_open(const void *socket)
+{
+    const fake_socket_t *fake = socket;
+
+    return (fake >= &fake_sockets[0]) && (fake < &fake_sockets[FAKE_MAX_SOCKETS]) && fake->in_use;
+}
+
+/********************************************************************************
+ * Function Name: fake_socket_check
+ ********************************************************************************
+ * Summary:
+ *  Aborts on a socket handle that is not open, such as a socket used after it
+ *  was deleted.
+ *
+ * Parameters:
+ *  socket: Socket handle.
+ *  caller: Name of the calling function.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void fake_socket_check(const void *socket, const char *caller)
+{
+    if (!fake_socket_is_open(socket))
+    {
+        fprintf(stderr, "%s: socket %p is not open\n", caller, socket);
+        abort();
+    }
+}
+
+void fake_wcm_script(const fake_step_t *steps, uint32_t count)
+{
+    memcpy(fake_wcm_steps, steps, count * sizeof(*steps));
+    fake_wcm_step_count = count;
+    fake_wcm_call_count = 0;
+}
+
+uint32_t fake_wcm_calls(void)
+{
+    return fake_wcm_call_count;
+}
+
+uint64_t fake_wcm_call_time(uint32_t call)
+{
+    return fake_wcm_times[call];
+}
+
+void fake_wcm_set_link(bool connected, uint8_t bssid_last, uint8_t channel)
+{
+    fake_wcm_connected = connected;
+    fake_wcm_bssid_last = bssid_last;
+    fake_wcm_channel = channel;
+}
+
+const cy_wcm_connect_params_t *fake_wcm_last_params(void)
+{
+    return &fake_wcm_params;
+}
+
+/********************************************************************************
+ * Function Name: fake_wcm_event
+ ********************************************************************************
+ * Summary:
+ *  Reports a WCM event to the registered callback. A disconnection takes the
+ *  link down.
+ *
+ *******************************************************************************/
+void fake_wcm_event(cy_wcm_event_t event)
+{
+    if (CY_WCM_EVENT_DISCONNECTED == event)
+    {
+        fake_wcm_connected = false;
+    }
+
+    if (NULL != fake_wcm_callback)
+    {
+        fake_wcm_callback(event, NULL);
+    }
+}
+
+/********************************************************************************
+ * Function Name: fake_netif_set_lease
+ ********************************************************************************
+ * Summary:
+ *  Configures the address 192.168.0.<host>/24 on the interface, with the link
+ *  up, leased by DHCP for the given times, or static if lease_s is 0.
+ *
+ *******************************************************************************/
+void fake_netif_set_lease(uint8_t host, uint32_t lease_s, uint32_t renew_s)
+{
+    fake_netif.ip_addr.addr = htonl(0xC0A80000u | host);
+    fake_netif.netmask.addr = htonl(0xFFFFFF00u);
+    fake_netif.gw.addr = htonl(0xC0A80001u);
+    fake_netif.flags |= NETIF_FLAG_LINK_UP;
+
+    fake_dhcp.offered_t0_lease = lease_s;
+    fake_dhcp.offered_t1_renew = renew_s;
+    fake_dhcp.offered_t2_rebind = lease_s - (lease_s / 8);
+    fake_netif.dhcp = (0 != lease_s) ? &fake_dhcp : NULL;
+    fake_dhcp_bound = (0 != lease_s);
+}
+
+uint32_t fake_dhcp_starts(void)
+{
+    return fake_dhcp_start_count;
+}
+
+void fake_suspend_script(const fake_step_t *steps, uint32_t count)
+{
+    memcpy(fake_suspend_steps, steps, count * sizeof(*steps));
+    fake_suspend_step_count = count;
+    fake_suspend_call_count = 0;
+}
+
+uint32_t fake_suspend_calls(void)
+{
+    return fake_suspend_call_count;
+}
+
+const fake_suspend_call_t *fake_suspend_call(uint32_t call)
+{
+    return &fake_suspend_log[call];
+}
+
+void fake_network_activity(bool is_tx)
+{
+    if (NULL != fake_activity_cb)
+    {
+        fake_activity_cb(is_tx);
+    }
+}
+
+/*******************************************************************************
+* LPA middleware
+********************************************************************************/
+const void *get_default_ol_list(void)
+{
+    return fake_ol_list;
+}
+
+/********************************************************************************
+ * Function Name: cy_tcp_create_socket_connection
+ ********************************************************************************
+ * Summary:
+ *  Fake of the LPA helper. Like the middleware, it stores the socket handle
+ *  before the handshake, and deletes the socket and clears the handle if the
+ *  handshake fails.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_tcp_create_socket_connection(void *net_intf, void **global_socket_ptr, const char *remote_ip,
+                                          uint16_t remote_port, uint16_t local_port,
+                                          cy_tko_ol_cfg_t *downloaded, int enable_ka)
+{
+    fake_socket_t *socket = NULL;
+    fake_step_t step;
+    int index;
+    int slot;
+
+    (void)net_intf;
+    (void)remote_ip;
+    (void)remote_port;
+    (void)enable_ka;
+
+    for (index = 0; (index < MAX_TKO) && (downloaded->ports[index].local_port != local_port); index++)
+    {
+    }
+
+    for (slot = 0; (slot < FAKE_MAX_SOCKETS) && (NULL == socket); slot++)
+    {
+        if (!fake_sockets[slot].in_use)
+        {
+            socket = &fake_sockets[slot];
+        }
+    }
+
+    if ((MAX_TKO == index) || (NULL == socket))
+    {
+        fprintf(stderr, "%s: unknown local port %u or too many open sockets\n", __func__, local_port);
+        abort();
+    }
+
+    socket->in_use = true;
+    socket->index = index;
+    fake_open_sockets++;
+    fake_connect_count[index]++;
+    *global_socket_ptr = socket;
+
+    step = fake_connect_step[index];
+    sim_sleep_ms(step.duration_ms);
+
+    if (CY_RSLT_SUCCESS != (cy_rslt_t)step.result)
+    {
+        (void)cy_socket_delete(socket);
+        *global_socket_ptr = NULL;
+    }
+
+    return (cy_rslt_t)step.result;
+}
+
+void cy_network_activity_register_cb(activity_cb_t cb)
+{
+    fake_activity_cb = cb;
+}
+
+/********************************************************************************
+ * Function Name: wait_net_suspend
+ ********************************************************************************
+ * Summary:
+ *  Fake of the LPA suspend. Takes the next scripted step, and blocks forever
+ *  when the script has run out.
+ *
+ *******************************************************************************/
+int wait_net_suspend(void *net_intf, uint32_t wait_ms, uint32_t network_inactive_interval_ms,
+                     uint32_t network_inactive_window_ms)
+{
+    fake_suspend_call_t *call;
+    fake_step_t step;
+
+    (void)net_intf;
+    (void)wait_ms;
+
+    if (fake_suspend_call_count >= fake_suspend_step_count)
+    {
+        (void)sim_block(SIM_WAIT_NONE, NULL, SIM_FOREVER);
+    }
+
+    call = &fake_suspend_log[fake_suspend_call_count];
+    call->start_ms = sim_time_ms();
+    call->inactive_interval_ms = network_inactive_interval_ms;
+    call->inactive_window_ms = network_inactive_window_ms;
+
+    step = fake_suspend_steps[fake_suspend_call_count++];
+    sim_sleep_ms(step.duration_ms);
+
+    return step.result;
+}
+
+/*******************************************************************************
+* Secure sockets
+********************************************************************************/
+cy_rslt_t cy_socket_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_disconnect(cy_socket_t handle, uint32_t timeout)
+{
+    (void)timeout;
+
+    fake_socket_check(handle, __func__);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_delete(cy_socket_t handle)
+{
+    fake_socket_check(handle, __func__);
+
+    ((fake_socket_t *)handle)->in_use = false;
+    fake_open_sockets--;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Wi-Fi connection manager
+********************************************************************************/
+cy_rslt_t cy_wcm_init(const cy_wcm_config_t *config)
+{
+    (void)config;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: cy_wcm_connect_ap
+ ********************************************************************************
+ * Summary:
+ *  Fake of the join. Takes the next scripted step, and succeeds at once when
+ *  the script has run out. A successful join brings the link up, with the
+ *  static address if one is given, or with 192.168.0.10 otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_wcm_connect_ap(const cy_wcm_connect_params_t *connect_params, cy_wcm_ip_address_t *ip_addr)
+{
+    const cy_wcm_ip_setting_t *settings = connect_params->static_ip_settings;
+    fake_step_t step = { 0, CY_RSLT_SUCCESS };
+
+    fake_wcm_params = *connect_params;
+
+    if (fake_wcm_call_count < FAKE_MAX_RECORDS)
+    {
+        fake_wcm_times[fake_wcm_call_count] = sim_time_ms();
+    }
+
+    if (fake_wcm_call_count < fake_wcm_step_count)
+    {
+        step = fake_wcm_steps[fake_wcm_call_count];
+    }
+
+    fake_wcm_call_count++;
+    sim_sleep_ms(step.duration_ms);
+
+    if (CY_RSLT_SUCCESS == (cy_rslt_t)step.result)
+    {
+        ip_addr->version = CY_WCM_IP_VER_V4;
+        ip_addr->ip.v4 = ((NULL != settings) && (0 != settings->ip_address.ip.v4)) ?
+                         settings->ip_address.ip.v4 : htonl(0xC0A8000Au);
+        fake_netif.ip_addr.addr = ip_addr->ip.v4;
+        fake_netif.flags |= NETIF_FLAG_LINK_UP;
+        fake_dhcp_bound = (NULL == settings);
+        fake_wcm_connected = true;
+    }
+
+    return (cy_rslt_t)step.result;
+}
+
+cy_rslt_t cy_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info)
+{
+    static const cy_wcm_mac_t oui = { 0x02, 0x00, 0x5E, 0x10, 0x00, 0x00 };
+
+    if (!fake_wcm_connected)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    memset(ap_info, 0, sizeof(*ap_info));
+    memcpy(ap_info->BSSID, oui, sizeof(ap_info->BSSID));
+    ap_info->BSSID[5] = fake_wcm_bssid_last;
+    ap_info->channel = fake_wcm_channel;
+
+    return CY_RSLT_SUCCESS;
+}
+
+bool cy_wcm_is_connected_to_ap(void)
+{
+    return fake_wcm_connected;
+}
+
+cy_rslt_t cy_wcm_register_event_callback(cy_wcm_event_callback_t event_callback)
+{
+    fake_wcm_callback = event_callback;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* lwIP
+********************************************************************************/
+struct netif *cy_lwip_get_interface(int iface)
+{
+    (void)iface;
+
+    return &fake_netif;
+}
+
+err_t tcpip_callback(tcpip_callback_fn function, void *ctx)
+{
+    function(ctx);
+
+    return ERR_OK;
+}
+
+int etharp_find_addr(struct netif *netif, const ip4_addr_t *ipaddr, struct eth_addr **eth_ret,
+                     const ip4_addr_t **ip_ret)
+{
+    (void)netif;
+    (void)ipaddr;
+    (void)eth_ret;
+    (void)ip_ret;
+
+    return -1;
+}
+
+err_t etharp_add_static_entry(const ip4_addr_t *ipaddr, struct eth_addr *ethaddr)
+{
+    (void)ipaddr;
+    (void)ethaddr;
+
+    return ERR_OK;
+}
+
+err_t etharp_remove_static_entry(const ip4_addr_t *ipaddr)
+{
+    (void)ipaddr;
+
+    return ERR_OK;
+}
+
+err_t etharp_request(struct netif *netif, const ip4_addr_t *ipaddr)
+{
+    (void)netif;
+    (void)ipaddr;
+
+    return ERR_OK;
+}
+
+/********************************************************************************
+ * Function Name: dhcp_start
+ ********************************************************************************
+ * Summary:
+ *  Fake of the DHCP client start. It binds at once, to the lease last set by
+ *  fake_netif_set_lease().
+ *
+ *******************************************************************************/
+err_t dhcp_start(struct netif *netif)
+{
+    fake_dhcp_start_count++;
+    netif->dhcp = &fake_dhcp;
+    fake_dhcp_bound = true;
+
+    return ERR_OK;
+}
+
+bool dhcp_supplied_address(const struct netif *netif)
+{
+    return (NULL != netif->dhcp) && fake_dhcp_bound;
+}
+
+int ipaddr_aton(const char *cp, ip_addr_t *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+
+    if (1 == inet_pton(AF_INET, cp, &addr->u_addr.ip4.addr))
+    {
+        addr->type = IPADDR_TYPE_V4;
+        return 1;
+    }
+
+    if (1 == inet_pton(AF_INET6, cp, addr->u_addr.ip6.addr))
+    {
+        addr->type = IPADDR_TYPE_V6;
+        return 1;
+    }
+
+    return 0;
+}
+
+bool ip_addr_isany(const ip_addr_t *addr)
+{
+    static const ip_addr_t any;
+
+    return (NULL == addr) || (0 == memcmp(&addr->u_addr, &any.u_addr, sizeof(any.u_addr)));
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *addr)
+{
+    static char text[INET_ADDRSTRLEN];
+
+    return (char *)inet_ntop(AF_INET, &addr->addr, text, sizeof(text));
+}
+
+char *ip6addr_ntoa(const ip6_addr_t *addr)
+{
+    static char text[INET6_ADDRSTRLEN];
+
+    return (char *)inet_ntop(AF_INET6, addr->addr, text, sizeof(text));
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,120 @@
+/******************************************************************************
+* File Name:   fake_network.h
+*
+* Description: Scripted fakes of the Wi-Fi connection manager, the Low Power
+*              Assistant and the socket layer for the host tests. Each call
+*              takes simulated time, and the tests set what it returns.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef FAKE_NETWORK_H
+#define FAKE_NETWORK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+#include "cy_OlmInterface.h"
+#include "cy_wcm.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Calls of the fakes recorded at most */
+#define FAKE_MAX_RECORDS                         (4096)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* One scripted call: how long it takes and what it returns */
+typedef struct
+{
+    uint32_t duration_ms;
+    int32_t result;
+} fake_step_t;
+
+/* One recorded call of wait_net_suspend() */
+typedef struct
+{
+    uint64_t start_ms;
+    uint32_t inactive_interval_ms;
+    uint32_t inactive_window_ms;
+} fake_suspend_call_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void fake_network_reset(void);
+
+/* Offload list returned by get_default_ol_list() */
+void fake_ol_set_ports(const cy_tko_ol_connect_t *ports, int count);
+
+/* cy_tcp_create_socket_connection() of each socket of the port table */
+void fake_socket_set(int index, uint32_t duration_ms, cy_rslt_t result);
+uint32_t fake_socket_connects(int index);
+uint32_t fake_sockets_open(void);
+bool fake_socket_is_open(const void *socket);
+
+/* cy_wcm_connect_ap(). The steps are taken in order, then it succeeds at once. */
+void fake_wcm_script(const fake_step_t *steps, uint32_t count);
+uint32_t fake_wcm_calls(void);
+uint64_t fake_wcm_call_time(uint32_t call);
+
+/* Link state and AP of cy_wcm_is_connected_to_ap() and cy_wcm_get_associated_ap_info() */
+void fake_wcm_set_link(bool connected, uint8_t bssid_last, uint8_t channel);
+
+/* Parameters of the last cy_wcm_connect_ap(), and events of the registered callback */
+const cy_wcm_connect_params_t *fake_wcm_last_params(void);
+void fake_wcm_event(cy_wcm_event_t event);
+
+/* Address and DHCP lease of the STA interface, and calls of dhcp_start() */
+void fake_netif_set_lease(uint8_t host, uint32_t lease_s, uint32_t renew_s);
+uint32_t fake_dhcp_starts(void);
+
+/* wait_net_suspend(). The steps are taken in order, then it blocks forever. */
+void fake_suspend_script(const fake_step_t *steps, uint32_t count);
+uint32_t fake_suspend_calls(void);
+const fake_suspend_call_t *fake_suspend_call(uint32_t call);
+
+/* EMAC activity seen by the callback registered with the LPA */
+void fake_network_activity(bool is_tx);
+
+#endif /* FAKE_NETWORK_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,397 @@
+/******************************************************************************
+* File Name:   freertos.c
+*
+* Description: FreeRTOS task, notification, event group and software timer
+*              API of the host tests. The calls block in simulated time
+*              through sim.h. Priorities and stack sizes are ignored.
+*              Each timer has a task of its own, so the timers do not
+*              survive sim_reset().
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+#include "timers.h"
+#include "sim.h"
+
+/* The simulated clock counts milliseconds, and the calls take ticks */
+_Static_assert(1000 == configTICK_RATE_HZ, "The simulation needs a tick of 1 ms");
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct sim_event_group
+{
+    EventBits_t bits;
+};
+
+struct sim_timer
+{
+    TickType_t period;
+    bool auto_reload;
+    bool active;
+    uint64_t expiry;
+    TimerCallbackFunction_t callback;
+};
+
+/********************************************************************************
+ * Function Name: sim_deadline
+ ********************************************************************************
+ * Summary:
+ *  Converts a FreeRTOS timeout into the wake-up time of sim_block().
+ *
+ * Parameters:
+ *  ticks: Timeout in ticks, or portMAX_DELAY.
+ *
+ * Return:
+ *  uint64_t: Wake-up time.
+ *
+ *******************************************************************************/
+static uint64_t sim_deadline(TickType_t ticks)
+{
+    return (portMAX_DELAY == ticks) ? SIM_FOREVER : (sim_time_ms() + ticks);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    sim_task_t *task;
+
+    (void)stack_depth;
+    (void)priority;
+
+    task = sim_spawn(code, arg, name);
+
+    if (NULL != handle)
+    {
+        *handle = task;
+    }
+
+    return (NULL != task) ? pdPASS : pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if ((NULL != task) && (sim_current() != task))
+    {
+        /* Only the tasks of the application delete themselves */
+        abort();
+    }
+
+    sim_exit();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_sleep_ms(ticks);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)sim_now_ms();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return sim_current();
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    sim_task_t *self = sim_current();
+    uint32_t value;
+
+    if ((0 == self->notify_value) && (0 != ticks))
+    {
+        (void)sim_block(SIM_WAIT_NOTIFY, self, sim_deadline(ticks));
+    }
+
+    value = self->notify_value;
+
+    if (0 != value)
+    {
+        self->notify_value = clear_on_exit ? 0 : (value - 1);
+    }
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    task->notify_value++;
+
+    if (!task->ready && (SIM_WAIT_NOTIFY == task->waiting))
+    {
+        sim_wake(task);
+    }
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    (void)xTaskNotifyGive(task);
+
+    if (NULL != woken)
+    {
+        *woken = pdFALSE;
+    }
+}
+
+/********************************************************************************
+ * Function Name: xTaskNotify
+ ********************************************************************************
+ * Summary:
+ *  Notifies a task. Only the actions that update the value are supported. A
+ *  value of 0 stands for no pending notification, as the application sends
+ *  bits or counts only.
+ *
+ *******************************************************************************/
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    switch (action)
+    {
+        case eSetBits:
+            task->notify_value |= value;
+            break;
+
+        case eIncrement:
+            task->notify_value++;
+            break;
+
+        default:
+            abort();
+    }
+
+    if (!task->ready && (SIM_WAIT_NOTIFY == task->waiting))
+    {
+        sim_wake(task);
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks)
+{
+    sim_task_t *self = sim_current();
+
+    if (0 == self->notify_value)
+    {
+        self->notify_value &= ~clear_on_entry;
+
+        if (0 != ticks)
+        {
+            (void)sim_block(SIM_WAIT_NOTIFY, self, sim_deadline(ticks));
+        }
+    }
+
+    if (NULL != value)
+    {
+        *value = self->notify_value;
+    }
+
+    if (0 == self->notify_value)
+    {
+        return pdFALSE;
+    }
+
+    self->notify_value &= ~clear_on_exit;
+
+    return pdTRUE;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct sim_event_group));
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    sim_wake_all(SIM_WAIT_EVENT, group);
+
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t previous = group->bits;
+
+    group->bits &= ~bits;
+
+    return previous;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks)
+{
+    uint64_t deadline = sim_deadline(ticks);
+    EventBits_t value;
+
+    for (;;)
+    {
+        value = group->bits;
+
+        if (wait_for_all ? ((value & bits) == bits) : (0 != (value & bits)))
+        {
+            if (clear_on_exit)
+            {
+                group->bits &= ~bits;
+            }
+
+            return value;
+        }
+
+        if (sim_time_ms() >= deadline)
+        {
+            return value;
+        }
+
+        (void)sim_block(SIM_WAIT_EVENT, group, deadline);
+    }
+}
+
+/********************************************************************************
+ * Function Name: sim_timer_task
+ ********************************************************************************
+ * Summary:
+ *  Task of one software timer. Runs the callback each time the timer expires,
+ *  and waits for the next expiry or for a change of the timer otherwise.
+ *
+ * Parameters:
+ *  arg: Timer.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sim_timer_task(void *arg)
+{
+    struct sim_timer *timer = arg;
+
+    for (;;)
+    {
+        if (timer->active && (sim_time_ms() >= timer->expiry))
+        {
+            timer->active = timer->auto_reload;
+            timer->expiry += timer->period;
+            timer->callback(timer);
+        }
+        else
+        {
+            (void)sim_block(SIM_WAIT_EVENT, timer, timer->active ? timer->expiry : SIM_FOREVER);
+        }
+    }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t callback)
+{
+    struct sim_timer *timer = calloc(1, sizeof(*timer));
+
+    (void)id;
+
+    if ((NULL == timer) || (0 == period))
+    {
+        free(timer);
+        return NULL;
+    }
+
+    timer->period = period;
+    timer->auto_reload = (pdFALSE != auto_reload);
+    timer->callback = callback;
+
+    if (NULL == sim_spawn(sim_timer_task, timer, name))
+    {
+        free(timer);
+        return NULL;
+    }
+
+    return timer;
+}
+
+/* As in FreeRTOS, a change of the period also starts the timer */
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks)
+{
+    (void)ticks;
+
+    if (0 == period)
+    {
+        return pdFAIL;
+    }
+
+    timer->period = period;
+    timer->expiry = sim_time_ms() + period;
+    timer->active = true;
+    sim_wake_all(SIM_WAIT_EVENT, timer);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks)
+{
+    (void)ticks;
+
+    timer->active = false;
+    sim_wake_all(SIM_WAIT_EVENT, timer);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    return timer->active ? pdTRUE : pdFALSE;
+}
+
+
+
+/* [] END OF FILE */
+
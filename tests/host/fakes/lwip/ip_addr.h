@@ -0,0 +1,104 @@
+/******************************************************************************
+* File Name:   ip_addr.h
+*
+* Description: IP address types and helpers of lwIP used by the application,
+*              for the host tests.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef LWIP_IP_ADDR_H
+#define LWIP_IP_ADDR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define IPADDR_TYPE_V4                           (0u)
+#define IPADDR_TYPE_V6                           (6u)
+
+#define IP_IS_V4(addr)                           (IPADDR_TYPE_V4 == (addr)->type)
+#define IP_IS_V6(addr)                           (IPADDR_TYPE_V6 == (addr)->type)
+#define ip_2_ip4(addr)                           (&((addr)->u_addr.ip4))
+#define ip_2_ip6(addr)                           (&((addr)->u_addr.ip6))
+#define ip_addr_copy(dest, src)                  ((dest) = (src))
+#define ip_addr_cmp(a, b)                        (0 == memcmp((a), (b), sizeof(ip_addr_t)))
+#define ip4_addr_copy(dest, src)                 ((dest).addr = (src).addr)
+#define ip4_addr_cmp(a, b)                       ((a)->addr == (b)->addr)
+#define ip4_addr_isany(addr)                     ((NULL == (addr)) || (0 == (addr)->addr))
+#define ip4_addr_isany_val(ipaddr)               (0 == (ipaddr).addr)
+#define ip4_addr_get_u32(ipaddr)                 ((ipaddr)->addr)
+#define ip4_addr_netcmp(a, b, mask)              (0 == (((a)->addr ^ (b)->addr) & (mask)->addr))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    uint32_t addr;
+} ip4_addr_t;
+
+typedef struct
+{
+    uint32_t addr[4];
+} ip6_addr_t;
+
+typedef struct
+{
+    union
+    {
+        ip6_addr_t ip6;
+        ip4_addr_t ip4;
+    } u_addr;
+    uint8_t type;
+} ip_addr_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+int ipaddr_aton(const char *cp, ip_addr_t *addr);
+bool ip_addr_isany(const ip_addr_t *addr);
+char *ip4addr_ntoa(const ip4_addr_t *addr);
+char *ip6addr_ntoa(const ip6_addr_t *addr);
+
+#endif /* LWIP_IP_ADDR_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,91 @@
+/******************************************************************************
+* File Name:   netif.h
+*
+* Description: Network interface of lwIP, reduced to the fields the
+*              application reads, for the host tests.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef LWIP_NETIF_H
+#define LWIP_NETIF_H
+
+#include <stdint.h>
+
+#include "lwip/ip_addr.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define LWIP_IPV6_NUM_ADDRESSES                  (3)
+#define IP6_ADDR_VALID                           (0x10)
+
+#define NETIF_FLAG_LINK_UP                       (0x04u)
+
+#define netif_ip4_addr(netif)                    (&(netif)->ip_addr)
+#define netif_ip4_netmask(netif)                 (&(netif)->netmask)
+#define netif_ip4_gw(netif)                      (&(netif)->gw)
+#define netif_is_link_up(netif)                  (0 != ((netif)->flags & NETIF_FLAG_LINK_UP))
+#define netif_ip6_addr(netif, i)                 (&(netif)->ip6_addr[i])
+#define netif_ip6_addr_state(netif, i)           ((netif)->ip6_addr_state[i])
+#define netif_set_ip6_autoconfig_enabled(netif, on) ((netif)->ip6_autoconfig_enabled = (on))
+#define ip6_addr_isvalid(state)                  (0 != ((state) & IP6_ADDR_VALID))
+#define ip6_addr_islinklocal(ip6addr)            (0xFE80 == (((const uint8_t *)((ip6addr)->addr))[0] << 8 | \
+                                                           (((const uint8_t *)((ip6addr)->addr))[1] & 0xC0)))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct dhcp;
+
+struct netif
+{
+    void *state;
+    ip4_addr_t ip_addr;
+    ip4_addr_t netmask;
+    ip4_addr_t gw;
+    uint8_t flags;
+    struct dhcp *dhcp;
+    ip6_addr_t ip6_addr[LWIP_IPV6_NUM_ADDRESSES];
+    uint8_t ip6_addr_state[LWIP_IPV6_NUM_ADDRESSES];
+    uint8_t ip6_autoconfig_enabled;
+};
+
+#endif /* LWIP_NETIF_H */
+
+
+/* [] END OF FILE */
+
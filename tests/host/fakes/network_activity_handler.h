@@ -0,0 +1,78 @@
+/******************************************************************************
+* File Name:   network_activity_handler.h
+*
+* Description: Network activity handler of the Low Power Assistant, for the
+*              host tests. wait_net_suspend() is scripted by fake_network.h,
+*              and the activity callback is called by the test.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef NETWORK_ACTIVITY_HANDLER_H
+#define NETWORK_ACTIVITY_HANDLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Return codes of wait_net_suspend() */
+#define ST_SUCCESS                               (0)
+#define ST_WAIT_TIMEOUT_EXPIRED                  (1)
+#define ST_WAIT_INACTIVITY_TIMEOUT_EXPIRED       (2)
+#define ST_WAIT_ACTIVITY_TIMEOUT_EXPIRED         (3)
+#define ST_NET_ACTIVITY                          (4)
+#define ST_BAD_ARGS                              (5)
+#define ST_BAD_STATE                             (6)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef void (*activity_cb_t)(bool is_tx);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void cy_network_activity_register_cb(activity_cb_t cb);
+int wait_net_suspend(void *net_intf, uint32_t wait_ms, uint32_t network_inactive_interval_ms,
+                     uint32_t network_inactive_window_ms);
+
+#endif /* NETWORK_ACTIVITY_HANDLER_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,560 @@
+/******************************************************************************
+* File Name:   sim.c
+*
+* Description: Discrete-event simulator behind the FreeRTOS fakes of the host
+*              tests. Each task runs on its own ucontext stack until it
+*              blocks; the task with the earliest wake-up time runs next and
+*              the clock jumps to it.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "sim.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* The test program itself, running on the process stack */
+static ucontext_t main_context;
+static sim_task_t main_task = { .name = "main", .context = &main_context, .ready = true };
+
+static sim_task_t *tasks = &main_task;
+static sim_task_t *current = &main_task;
+
+static uint64_t now_ms = 0;
+static uint64_t next_order = 0;
+static uint64_t switch_count = 0;
+static uint32_t failing_spawns = 0;
+
+/********************************************************************************
+ * Function Name: sim_free_task
+ ********************************************************************************
+ * Summary:
+ *  Frees the stack and the context of a task. Never called on the running task.
+ *
+ * Parameters:
+ *  task: Task to free.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sim_free_task(sim_task_t *task)
+{
+    free(task->stack);
+    free(task->context);
+    free(task);
+}
+
+/********************************************************************************
+ * Function Name: sim_collect
+ ********************************************************************************
+ * Summary:
+ *  Frees the tasks that have ended, except the running one.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sim_collect(void)
+{
+    sim_task_t **link = &main_task.next;
+    sim_task_t *task;
+
+    while (NULL != *link)
+    {
+        task = *link;
+
+        if (task->done && (task != current))
+        {
+            *link = task->next;
+            sim_free_task(task);
+        }
+        else
+        {
+            link = &task->next;
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: sim_schedule
+ ********************************************************************************
+ * Summary:
+ *  Switches to the task with the earliest wake-up time, the longest waiting one
+ *  first, and moves the clock forward to it. Aborts if every task is blocked
+ *  forever, as the program would hang on the target too.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sim_schedule(void)
+{
+    sim_task_t *previous = current;
+    sim_task_t *best = NULL;
+    sim_task_t *task;
+
+    for (task = tasks; NULL != task; task = task->next)
+    {
+        if (task->done)
+        {
+            continue;
+        }
+
+        if ((NULL == best) || (task->wake_at < best->wake_at) ||
+            ((task->wake_at == best->wake_at) && (task->order < best->order)))
+        {
+            best = task;
+        }
+    }
+
+    if ((NULL == best) || (SIM_FOREVER == best->wake_at))
+    {
+        fprintf(stderr, "sim: deadlock at %llu ms, every task is blocked forever\n", (unsigned long long)now_ms);
+        abort();
+    }
+
+    if (best->wake_at > now_ms)
+    {
+        now_ms = best->wake_at;
+    }
+
+    best->ready = true;
+    best->waiting = SIM_WAIT_NONE;
+    best->wait_object = NULL;
+    current = best;
+
+    if (best != previous)
+    {
+        switch_count++;
+        swapcontext((ucontext_t *)previous->context, (ucontext_t *)best->context);
+    }
+}
+
+/********************************************************************************
+ * Function Name: sim_trampoline
+ ********************************************************************************
+ * Summary:
+ *  Entry point of each task context. A task that returns ends like one that
+ *  deletes itself.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sim_trampoline(void)
+{
+    current->entry(current->arg);
+    sim_exit();
+}
+
+/********************************************************************************
+ * Function Name: sim_make_context
+ ********************************************************************************
+ * Summary:
+ *  Prepares the context of a new task to start in sim_trampoline() on the
+ *  given stack.
+ *
+ * Parameters:
+ *  context: Context to prepare.
+ *  stack: Stack of SIM_TASK_STACK_SIZE bytes.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void sim_make_context(ucontext_t *context, void *stack)
+{
+    getcontext(context);
+    context->uc_stack.ss_sp = stack;
+    context->uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+    context->uc_link = NULL;
+    makecontext(context, sim_trampoline, 0);
+}
+
+/********************************************************************************
+ * Function Name: sim_reset
+ ********************************************************************************
+ * Summary:
+ *  Drops all the tasks but the calling test program, and sets the clock. Must
+ *  be called from the test program.
+ *
+ * Parameters:
+ *  start_ms: Time the clock starts at, for example close to 2^32 to check
+ *            the wrap of the millisecond counter.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sim_reset(uint64_t start_ms)
+{
+    sim_task_t *task = main_task.next;
+    sim_task_t *next;
+
+    while (NULL != task)
+    {
+        next = task->next;
+        sim_free_task(task);
+        task = next;
+    }
+
+    main_task.next = NULL;
+    main_task.ready = true;
+    main_task.wake_at = start_ms;
+    main_task.notify_value = 0;
+    current = &main_task;
+    now_ms = start_ms;
+    failing_spawns = 0;
+}
+
+/********************************************************************************
+ * Function Name: sim_time_ms
+ ********************************************************************************
+ * Summary:
+ *  Returns the simulated time, without wrap.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint64_t: Milliseconds since the start of the simulation.
+ *
+ *******************************************************************************/
+uint64_t sim_time_ms(void)
+{
+    return now_ms;
+}
+
+/********************************************************************************
+ * Function Name: sim_now_ms
+ ********************************************************************************
+ * Summary:
+ *  Returns the simulated time as the 32-bit millisecond counter of the target.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Milliseconds, wrapping at 2^32.
+ *
+ *******************************************************************************/
+uint32_t sim_now_ms(void)
+{
+    return (uint32_t)now_ms;
+}
+
+/********************************************************************************
+ * Function Name: sim_sleep_ms
+ ********************************************************************************
+ * Summary:
+ *  Blocks the calling task for the given simulated time. The other tasks run in
+ *  the meantime. A sleep of 0 lets the tasks ready at the same time run first.
+ *
+ * Parameters:
+ *  ms: Time to sleep.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sim_sleep_ms(uint32_t ms)
+{
+    (void)sim_block(SIM_WAIT_NONE, NULL, now_ms + ms);
+}
+
+/********************************************************************************
+ * Function Name: sim_spawn
+ ********************************************************************************
+ * Summary:
+ *  Creates a task, ready to run after the tasks already ready at this time.
+ *
+ * Parameters:
+ *  entry: Task function.
+ *  arg: Argument of the task function.
+ *  name: Name of the task.
+ *
+ * Return:
+ *  sim_task_t *: The task, or NULL for a failure requested by
+ *  sim_fail_spawns().
+ *
+ *******************************************************************************/
+sim_task_t *sim_spawn(void (*entry)(void *arg), void *arg, const char *name)
+{
+    ucontext_t *context;
+    sim_task_t *task;
+
+    if (failing_spawns > 0)
+    {
+        failing_spawns--;
+        return NULL;
+    }
+
+    sim_collect();
+
+    task = calloc(1, sizeof(*task));
+    context = calloc(1, sizeof(*context));
+
+    if ((NULL == task) || (NULL == context) || (NULL == (task->stack = malloc(SIM_TASK_STACK_SIZE))))
+    {
+        fprintf(stderr, "sim: out of memory\n");
+        abort();
+    }
+
+    sim_make_context(context, task->stack);
+
+    task->name = name;
+    task->entry = entry;
+    task->arg = arg;
+    task->context = context;
+    task->ready = true;
+    task->wake_at = now_ms;
+    task->order = next_order++;
+    task->next = main_task.next;
+    main_task.next = task;
+
+    return task;
+}
+
+/********************************************************************************
+ * Function Name: sim_exit
+ ********************************************************************************
+ * Summary:
+ *  Ends the calling task. Its stack is freed later, from another task.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void: Does not return.
+ *
+ *******************************************************************************/
+void sim_exit(void)
+{
+    if (&main_task == current)
+    {
+        fprintf(stderr, "sim: the test program cannot delete itself\n");
+        abort();
+    }
+
+    current->done = true;
+    sim_schedule();
+
+    /* A task that has ended is never scheduled again */
+    abort();
+}
+
+/********************************************************************************
+ * Function Name: sim_current
+ ********************************************************************************
+ * Summary:
+ *  Returns the running task.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  sim_task_t *: Running task.
+ *
+ *******************************************************************************/
+sim_task_t *sim_current(void)
+{
+    return current;
+}
+
+/********************************************************************************
+ * Function Name: sim_block
+ ********************************************************************************
+ * Summary:
+ *  Blocks the calling task until sim_wake() is called for it with a matching
+ *  wait, or until the wake-up time, whichever comes first.
+ *
+ * Parameters:
+ *  waiting: What the task waits for, SIM_WAIT_NONE for a plain delay.
+ *  object: Object waited on, such as an event group.
+ *  wake_at: Time the wait ends without an event, or SIM_FOREVER.
+ *
+ * Return:
+ *  bool: true if the task was woken up by an event, false on the timeout.
+ *
+ *******************************************************************************/
+bool sim_block(sim_wait_t waiting, const void *object, uint64_t wake_at)
+{
+    current->ready = false;
+    current->woken = false;
+    current->waiting = waiting;
+    current->wait_object = object;
+    current->wake_at = wake_at;
+    current->order = next_order++;
+
+    sim_schedule();
+
+    return current->woken;
+}
+
+/********************************************************************************
+ * Function Name: sim_wake
+ ********************************************************************************
+ * Summary:
+ *  Makes a blocked task ready at the current time. The caller keeps running.
+ *
+ * Parameters:
+ *  task: Task to wake up.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sim_wake(sim_task_t *task)
+{
+    if ((NULL == task) || task->ready || task->done)
+    {
+        return;
+    }
+
+    task->ready = true;
+    task->woken = true;
+    task->wake_at = now_ms;
+    task->order = next_order++;
+}
+
+/********************************************************************************
+ * Function Name: sim_wake_all
+ ********************************************************************************
+ * Summary:
+ *  Wakes up all the tasks blocked on the given object.
+ *
+ * Parameters:
+ *  waiting: Kind of wait.
+ *  object: Object waited on.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sim_wake_all(sim_wait_t waiting, const void *object)
+{
+    sim_task_t *task;
+
+    for (task = tasks; NULL != task; task = task->next)
+    {
+        if (!task->ready && (task->waiting == waiting) && (task->wait_object == object))
+        {
+            sim_wake(task);
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: sim_fail_spawns
+ ********************************************************************************
+ * Summary:
+ *  Makes the next task creations fail, as when the heap is exhausted.
+ *
+ * Parameters:
+ *  count: Number of creations to fail.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void sim_fail_spawns(uint32_t count)
+{
+    failing_spawns = count;
+}
+
+/********************************************************************************
+ * Function Name: sim_live_tasks
+ ********************************************************************************
+ * Summary:
+ *  Returns the number of tasks that have not ended, the test program included.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Number of tasks.
+ *
+ *******************************************************************************/
+uint32_t sim_live_tasks(void)
+{
+    const sim_task_t *task;
+    uint32_t count = 0;
+
+    for (task = tasks; NULL != task; task = task->next)
+    {
+        count += task->done ? 0 : 1;
+    }
+
+    return count;
+}
+
+/********************************************************************************
+ * Function Name: sim_switches
+ ********************************************************************************
+ * Summary:
+ *  Returns the number of context switches since the program started.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint64_t: Number of context switches.
+ *
+ *******************************************************************************/
+uint64_t sim_switches(void)
+{
+    return switch_count;
+}
+
+
+/* [] END OF FILE */
+
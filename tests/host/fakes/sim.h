@@ -0,0 +1,112 @@
+/******************************************************************************
+* File Name:   sim.h
+*
+* Description: Discrete-event simulator behind the FreeRTOS fakes of the host
+*              tests. Tasks run cooperatively on their own stacks, in order
+*              of their wake-up time, and the clock only moves when every
+*              task is blocked.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Stack of each simulated task, whatever the task asks for */
+#define SIM_TASK_STACK_SIZE                      (64 * 1024)
+
+/* Wake-up time of a task blocked without a timeout */
+#define SIM_FOREVER                              (UINT64_MAX)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct sim_task sim_task_t;
+
+/* What a blocked task waits for, so that only the right event wakes it */
+typedef enum
+{
+    SIM_WAIT_NONE = 0,
+    SIM_WAIT_NOTIFY,
+    SIM_WAIT_EVENT
+} sim_wait_t;
+
+struct sim_task
+{
+    const char *name;
+    void (*entry)(void *arg);
+    void *arg;
+    void *stack;
+    void *context;
+    bool ready;
+    bool done;
+    bool woken;
+    uint64_t wake_at;
+    uint64_t order;
+    sim_wait_t waiting;
+    const void *wait_object;
+    uint32_t notify_value;
+    sim_task_t *next;
+};
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void sim_reset(uint64_t start_ms);
+uint64_t sim_time_ms(void);
+uint32_t sim_now_ms(void);
+void sim_sleep_ms(uint32_t ms);
+sim_task_t *sim_spawn(void (*entry)(void *arg), void *arg, const char *name);
+void sim_exit(void);
+sim_task_t *sim_current(void);
+bool sim_block(sim_wait_t waiting, const void *object, uint64_t wake_at);
+void sim_wake(sim_task_t *task);
+void sim_wake_all(sim_wait_t waiting, const void *object);
+void sim_fail_spawns(uint32_t count);
+uint32_t sim_live_tasks(void);
+uint64_t sim_switches(void);
+
+#endif /* SIM_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,135 @@
+/******************************************************************************
+* File Name:   stubs.c
+*
+* Description: Empty stand-ins of the modules and drivers that the code under
+*              test calls but the host tests do not cover.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cy_result.h"
+#include "cyhal.h"
+
+#include "app_log.h"
+#include "network_suspend_stats.h"
+#include "tko_zero_copy.h"
+#include "wake_dispatcher.h"
+
+/* Unique ID of the simulated device */
+uint64_t host_device_id = 0x0123456789ABCDEFull;
+
+void net_suspend_stats_init(void)
+{
+}
+
+void net_suspend_stats_suspend_begin(void)
+{
+}
+
+void net_suspend_stats_activity(void)
+{
+}
+
+void net_suspend_stats_suspend_end(int32_t status, uint32_t inactive_window_ms)
+{
+    (void)status;
+    (void)inactive_window_ms;
+}
+
+cy_rslt_t wake_dispatcher_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+void wake_dispatcher_suspend_begin(void)
+{
+}
+
+void wake_dispatcher_resume(int32_t status)
+{
+    (void)status;
+}
+
+void tko_zc_attach(int index)
+{
+    (void)index;
+}
+
+uint8_t fake_flash_row[CY_FLASH_SIZEOF_ROW];
+uint32_t fake_flash_writes = 0;
+
+cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj)
+{
+    (void)obj;
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_flash_free(cyhal_flash_t *obj)
+{
+    (void)obj;
+}
+
+/* The address is truncated to 32 bits on the host, so it is not used */
+cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data)
+{
+    (void)obj;
+    (void)address;
+
+    memcpy(fake_flash_row, data, sizeof(fake_flash_row));
+    fake_flash_writes++;
+
+    return CY_RSLT_SUCCESS;
+}
+
+void app_log_flush(void)
+{
+}
+
+void app_log_lock(void)
+{
+}
+
+void app_log_unlock(void)
+{
+}
+
+
+/* [] END OF FILE */
+
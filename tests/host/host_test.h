@@ -0,0 +1,98 @@
+/******************************************************************************
+* File Name:   host_test.h
+*
+* Description: Check macros and the simulated-time helpers shared by the host
+*              tests.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sim.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Counts and reports a failed check, and goes on with the test */
+#define CHECK(cond)                              do                                                      \
+                                                 {                                                       \
+                                                     if (!(cond))                                        \
+                                                     {                                                   \
+                                                         host_test_failures++;                           \
+                                                         printf("%s:%d: %s failed at %" PRIu64 " ms\n",  \
+                                                                __FILE__, __LINE__, #cond, sim_time_ms()); \
+                                                     }                                                   \
+                                                 } while (0)
+
+/* Checks a value against the expected one, and reports both if they differ */
+#define CHECK_EQ(actual, expected)               do                                                      \
+                                                 {                                                       \
+                                                     uint64_t a_ = (uint64_t)(actual);                   \
+                                                     uint64_t e_ = (uint64_t)(expected);                 \
+                                                     if (a_ != e_)                                       \
+                                                     {                                                   \
+                                                         host_test_failures++;                           \
+                                                         printf("%s:%d: %s is %" PRIu64 ", expected %"   \
+                                                                PRIu64 "\n", __FILE__, __LINE__,         \
+                                                                #actual, a_, e_);                        \
+                                                     }                                                   \
+                                                 } while (0)
+
+/* Runs a test function and prints its name */
+#define RUN_TEST(test)                           do                                                      \
+                                                 {                                                       \
+                                                     uint32_t before_ = host_test_failures;              \
+                                                     test();                                             \
+                                                     printf("%-48s %s\n", #test,                         \
+                                                            (before_ == host_test_failures) ? "ok" : "FAILED"); \
+                                                 } while (0)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Failed checks of the test program. Each test program defines it. */
+extern uint32_t host_test_failures;
+
+#endif /* HOST_TEST_H */
+
+
+/* [] END OF FILE */
+
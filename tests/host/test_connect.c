@@ -0,0 +1,389 @@
+/******************************************************************************
+* File Name:   test_connect.c
+*
+* Description: Host tests of the parallel TCP socket bring-up and the Wi-Fi
+*              join: reconnect cycles with random handshake times and
+*              failures, a handshake that completes after the barrier, the
+*              fallback when no worker task can be created, and the join
+*              back-off, in simulated time.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "app_config.h"
+#include "fake_network.h"
+#include "host_test.h"
+#include "offload_registry.h"
+#include "tcp_keepalive_offload.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Sockets configured in the port table; the last entry is left unconfigured */
+#define TEST_SOCKETS                             (3)
+#define TEST_SOCKET_MASK                         ((1u << TEST_SOCKETS) - 1)
+
+/* Barrier of tcp_socket_connect_parallel() without TLS */
+#define BARRIER_MS                               (TCP_SOCKET_CONNECT_TIMEOUT_MS)
+
+#define RECONNECT_CYCLES                         (1000)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint32_t host_test_failures = 0;
+
+static const cy_tko_ol_connect_t test_ports[MAX_TKO] =
+{
+    { .local_port = 50007, .remote_port = 3360, .remote_ip = "192.168.0.20" },
+    { .local_port = 50008, .remote_port = 3360, .remote_ip = "192.168.0.21" },
+    { .local_port = 50009, .remote_port = 3361, .remote_ip = "fd00::20" },
+    { .local_port = 50010, .remote_port = 3362, .remote_ip = "0.0.0.0" },
+};
+
+/********************************************************************************
+ * Function Name: check_sockets
+ ********************************************************************************
+ * Summary:
+ *  Every socket handle is open, and every open socket has a handle: no socket
+ *  leaked or was used after it was deleted.
+ *
+ *******************************************************************************/
+static void check_sockets(void)
+{
+    uint32_t handles = 0;
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (NULL != global_socket[index])
+        {
+            CHECK(fake_socket_is_open(global_socket[index]));
+            handles++;
+        }
+    }
+
+    CHECK_EQ(fake_sockets_open(), handles);
+}
+
+/********************************************************************************
+ * Function Name: test_connection_start
+ ********************************************************************************
+ * Summary:
+ *  The configured sockets connect in parallel, so the bring-up takes as long
+ *  as the slowest handshake, and the unconfigured one is skipped.
+ *
+ *******************************************************************************/
+static void test_connection_start(void)
+{
+    uint64_t start;
+    int index;
+
+    fake_socket_set(0, 100, CY_RSLT_SUCCESS);
+    fake_socket_set(1, 300, CY_RSLT_SUCCESS);
+    fake_socket_set(2, 200, CY_RSLT_SUCCESS);
+
+    start = sim_time_ms();
+    CHECK_EQ(tcp_socket_connection_start(), CY_RSLT_SUCCESS);
+    CHECK_EQ(sim_time_ms() - start, 300);
+
+    for (index = 0; index < TEST_SOCKETS; index++)
+    {
+        CHECK(NULL != global_socket[index]);
+        CHECK_EQ(tcp_socket_connection_result(index), CY_RSLT_SUCCESS);
+        CHECK_EQ(fake_socket_connects(index), 1);
+    }
+
+    CHECK(NULL == global_socket[TEST_SOCKETS]);
+    CHECK_EQ(fake_socket_connects(TEST_SOCKETS), 0);
+    CHECK_EQ(fake_sockets_open(), TEST_SOCKETS);
+    check_sockets();
+}
+
+/********************************************************************************
+ * Function Name: test_reconnect_cycles
+ ********************************************************************************
+ * Summary:
+ *  Reconnects random subsets of the sockets, with random handshake times, some
+ *  beyond the barrier, and random failures. After every cycle the result and
+ *  the duration match the script, and no socket leaked. A socket whose late
+ *  handshake from a previous cycle is still running fails at once.
+ *
+ *******************************************************************************/
+static void test_reconnect_cycles(void)
+{
+    uint64_t late_until[TEST_SOCKETS] = { 0 };
+    uint32_t duration[TEST_SOCKETS];
+    cy_rslt_t outcome[TEST_SOCKETS];
+    cy_rslt_t expected_status;
+    cy_rslt_t expected;
+    cy_rslt_t status;
+    uint64_t expected_ms;
+    uint64_t start;
+    uint32_t cycle;
+    uint32_t mask;
+    int index;
+
+    srand(2021);
+
+    for (cycle = 0; cycle < RECONNECT_CYCLES; cycle++)
+    {
+        mask = 1 + ((uint32_t)rand() % TEST_SOCKET_MASK);
+        start = sim_time_ms();
+        expected_status = CY_RSLT_SUCCESS;
+        expected_ms = 0;
+
+        for (index = 0; index < TEST_SOCKETS; index++)
+        {
+            /* Keep clear of the barrier itself, where the order is arbitrary */
+            duration[index] = (uint32_t)rand() % (BARRIER_MS * 3 / 2);
+            if ((duration[index] > BARRIER_MS - 10) && (duration[index] < BARRIER_MS + 10))
+            {
+                duration[index] += 20;
+            }
+
+            outcome[index] = (0 == rand() % 5) ? (cy_rslt_t)CY_RSLT_TYPE_ERROR + 1 : CY_RSLT_SUCCESS;
+            fake_socket_set(index, duration[index], outcome[index]);
+        }
+
+        status = tcp_socket_reconnect(mask);
+
+        for (index = 0; index < TEST_SOCKETS; index++)
+        {
+            if (!(mask & (1u << index)))
+            {
+                continue;
+            }
+
+            if (late_until[index] > start)
+            {
+                /* Not started again */
+                expected = CY_RSLT_TYPE_ERROR;
+            }
+            else if (duration[index] >= BARRIER_MS)
+            {
+                expected = CY_RSLT_TYPE_ERROR;
+                late_until[index] = start + duration[index];
+                expected_ms = BARRIER_MS;
+            }
+            else
+            {
+                expected = outcome[index];
+                expected_ms = (duration[index] > expected_ms) ? duration[index] : expected_ms;
+            }
+
+            CHECK_EQ(tcp_socket_connection_result(index), expected);
+            CHECK_EQ((CY_RSLT_SUCCESS == expected), (NULL != global_socket[index]) &&
+                                                    (late_until[index] <= start));
+
+            if (CY_RSLT_SUCCESS != expected)
+            {
+                expected_status = CY_RSLT_TYPE_ERROR;
+            }
+        }
+
+        CHECK_EQ(CY_RSLT_SUCCESS == status, CY_RSLT_SUCCESS == expected_status);
+        CHECK_EQ(sim_time_ms() - start, expected_ms);
+        check_sockets();
+
+        /* Some time between the cycles, for the late handshakes to complete */
+        sim_sleep_ms((uint32_t)rand() % BARRIER_MS);
+
+        /* Do not start a cycle at the very time a late handshake completes */
+        for (index = 0; index < TEST_SOCKETS; index++)
+        {
+            if (late_until[index] == sim_time_ms())
+            {
+                sim_sleep_ms(1);
+            }
+        }
+
+        check_sockets();
+    }
+
+    /* All the late workers complete and close their sockets */
+    sim_sleep_ms(BARRIER_MS * 2);
+    check_sockets();
+    CHECK_EQ(sim_live_tasks(), 1);
+}
+
+/********************************************************************************
+ * Function Name: test_late_worker
+ ********************************************************************************
+ * Summary:
+ *  A handshake that completes after the barrier is reported as failed, is not
+ *  started again while it runs, and its socket is closed when it completes.
+ *
+ *******************************************************************************/
+static void test_late_worker(void)
+{
+    uint32_t connects = fake_socket_connects(0);
+    uint64_t start;
+
+    fake_socket_set(0, BARRIER_MS + 5000, CY_RSLT_SUCCESS);
+    start = sim_time_ms();
+    CHECK(CY_RSLT_SUCCESS != tcp_socket_reconnect(1u << 0));
+    CHECK_EQ(sim_time_ms() - start, BARRIER_MS);
+    CHECK(CY_RSLT_SUCCESS != tcp_socket_connection_result(0));
+
+    /* Still in the handshake: not started again */
+    fake_socket_set(0, 100, CY_RSLT_SUCCESS);
+    CHECK(CY_RSLT_SUCCESS != tcp_socket_reconnect(1u << 0));
+    CHECK_EQ(sim_time_ms() - start, BARRIER_MS);
+    CHECK_EQ(fake_socket_connects(0), connects + 1);
+    CHECK_EQ(sim_live_tasks(), 2);
+    check_sockets();
+
+    /* The late handshake succeeds, and the worker closes the socket */
+    sim_sleep_ms(5000);
+    CHECK(NULL == global_socket[0]);
+    check_sockets();
+    CHECK_EQ(sim_live_tasks(), 1);
+
+    CHECK_EQ(tcp_socket_reconnect(1u << 0), CY_RSLT_SUCCESS);
+    CHECK(NULL != global_socket[0]);
+    CHECK_EQ(fake_socket_connects(0), connects + 2);
+    check_sockets();
+}
+
+/********************************************************************************
+ * Function Name: test_worker_spawn_failure
+ ********************************************************************************
+ * Summary:
+ *  Without the memory for the worker tasks, the sockets are connected one
+ *  after the other from the calling task.
+ *
+ *******************************************************************************/
+static void test_worker_spawn_failure(void)
+{
+    uint64_t start;
+    int index;
+
+    for (index = 0; index < TEST_SOCKETS; index++)
+    {
+        fake_socket_set(index, 100 * (uint32_t)(index + 1), CY_RSLT_SUCCESS);
+    }
+
+    sim_fail_spawns(TEST_SOCKETS);
+    start = sim_time_ms();
+    CHECK_EQ(tcp_socket_reconnect(TEST_SOCKET_MASK), CY_RSLT_SUCCESS);
+    CHECK_EQ(sim_time_ms() - start, 100 + 200 + 300);
+    CHECK_EQ(sim_live_tasks(), 1);
+    check_sockets();
+
+    /* One worker fails, the others still run in parallel */
+    sim_fail_spawns(1);
+    start = sim_time_ms();
+    CHECK_EQ(tcp_socket_reconnect(TEST_SOCKET_MASK), CY_RSLT_SUCCESS);
+    CHECK_EQ(sim_time_ms() - start, 100 + 300);
+    check_sockets();
+}
+
+/********************************************************************************
+ * Function Name: test_wifi_join_backoff
+ ********************************************************************************
+ * Summary:
+ *  The join is attempted MAX_WIFI_RETRY_COUNT times after the initial jitter,
+ *  with the back-off delays of the join policy in between, and fewer times
+ *  when the attempts use up the power budget.
+ *
+ *******************************************************************************/
+static void test_wifi_join_backoff(void)
+{
+    const fake_step_t failures[] =
+    {
+        { 5000, CY_RSLT_TYPE_ERROR + 1 },
+        { 5000, CY_RSLT_TYPE_ERROR + 1 },
+        { 5000, CY_RSLT_TYPE_ERROR + 1 },
+    };
+    const fake_step_t slow_failures[] =
+    {
+        { 40000, CY_RSLT_TYPE_ERROR + 1 },
+        { 40000, CY_RSLT_TYPE_ERROR + 1 },
+    };
+    uint32_t expected = WIFI_JOIN_RETRY_BASE_DELAY_MS;
+    uint64_t start;
+    uint64_t gap;
+    uint32_t call;
+
+    start = sim_time_ms();
+    fake_wcm_script(failures, 3);
+    CHECK(CY_RSLT_SUCCESS != wifi_connect());
+    CHECK_EQ(fake_wcm_calls(), MAX_WIFI_RETRY_COUNT);
+    CHECK(fake_wcm_call_time(0) - start < WIFI_JOIN_INITIAL_JITTER_MS);
+
+    for (call = 1; call < fake_wcm_calls(); call++)
+    {
+        gap = fake_wcm_call_time(call) - (fake_wcm_call_time(call - 1) + failures[call - 1].duration_ms);
+        CHECK((gap >= expected / 2) && (gap < expected));
+        expected *= 2;
+    }
+
+    /* Joins on the last attempt */
+    fake_wcm_script(failures, 2);
+    CHECK_EQ(wifi_connect(), CY_RSLT_SUCCESS);
+    CHECK_EQ(fake_wcm_calls(), 3);
+
+    /* 80 s spent in two attempts is over the 60 s budget */
+    fake_wcm_script(slow_failures, 2);
+    CHECK(CY_RSLT_SUCCESS != wifi_connect());
+    CHECK_EQ(fake_wcm_calls(), 2);
+}
+
+int main(void)
+{
+    sim_reset(0);
+    fake_network_reset();
+    fake_ol_set_ports(test_ports, MAX_TKO);
+    CHECK_EQ(offload_registry_init(), CY_RSLT_SUCCESS);
+    CHECK_EQ(offload_registry_tko_port_count(), TEST_SOCKETS);
+
+    RUN_TEST(test_connection_start);
+    RUN_TEST(test_reconnect_cycles);
+    RUN_TEST(test_late_worker);
+    RUN_TEST(test_worker_spawn_failure);
+    RUN_TEST(test_wifi_join_backoff);
+
+    return (0 == host_test_failures) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,256 @@
+/******************************************************************************
+* File Name:   test_fast_rejoin.c
+*
+* Description: Host tests of the Wi-Fi fast rejoin: how long a DHCP lease is
+*              reused, the DHCP restart at its renewal time, for leases
+*              longer than the 32-bit tick conversions, and the retries of a
+*              failed rejoin.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+/* The statics of the module are checked */
+#include "wifi_fast_rejoin.c"
+
+#include "fake_network.h"
+#include "host_test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define TEST_HOUR_S                              (3600u)
+#define TEST_DAY_S                               (24u * TEST_HOUR_S)
+
+/* Host part of the address leased to the device */
+#define TEST_HOST                                (20)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint32_t host_test_failures = 0;
+
+/********************************************************************************
+ * Function Name: lease_reuse_ms
+ ********************************************************************************
+ * Summary:
+ *  Takes a snapshot of the rejoin state with the given lease, and returns how
+ *  long its address can be reused without DHCP.
+ *
+ *******************************************************************************/
+static uint32_t lease_reuse_ms(uint32_t lease_s, uint32_t renew_s)
+{
+    wifi_fast_rejoin_cache_clear();
+    fake_netif_set_lease(TEST_HOST, lease_s, renew_s);
+    wifi_fast_rejoin_cache_update();
+    CHECK(rejoin_cache.valid);
+
+    return rejoin_cache.lease_reuse_ms;
+}
+
+/********************************************************************************
+ * Function Name: check_renewal
+ ********************************************************************************
+ * Summary:
+ *  Caches the given lease, rejoins by BSSID after the link is lost, and checks
+ *  that DHCP restarts exactly when the renewal time of the lease is due.
+ *
+ *******************************************************************************/
+static void check_renewal(uint32_t lease_s, uint32_t renew_s, uint32_t cached_ms, uint64_t renew_ms)
+{
+    uint64_t cached;
+    uint32_t starts;
+
+    (void)lease_reuse_ms(lease_s, renew_s);
+    cached = sim_time_ms();
+    sim_sleep_ms(cached_ms);
+
+    fake_wcm_event(CY_WCM_EVENT_DISCONNECTED);
+    starts = fake_dhcp_starts();
+    CHECK_EQ(wifi_fast_rejoin_join(), CY_RSLT_SUCCESS);
+    CHECK(NULL != fake_wcm_last_params()->static_ip_settings);
+    CHECK_EQ(fake_wcm_last_params()->BSSID[5], 1);
+
+    sim_sleep_ms((uint32_t)(cached + renew_ms - 1 - sim_time_ms()));
+    CHECK_EQ(fake_dhcp_starts(), starts);
+
+    sim_sleep_ms(1);
+    CHECK_EQ(fake_dhcp_starts(), starts + 1);
+}
+
+/********************************************************************************
+ * Function Name: test_lease_reuse_time
+ ********************************************************************************
+ * Summary:
+ *  An address is reused until T1 of its lease. A T1 past 49.7 days saturates
+ *  below UINT32_MAX, which only an infinite lease, or a static address, maps
+ *  to.
+ *
+ *******************************************************************************/
+static void test_lease_reuse_time(void)
+{
+    wifi_rejoin_state_t state;
+
+    CHECK_EQ(lease_reuse_ms(TEST_DAY_S, TEST_DAY_S / 2), TEST_DAY_S / 2 * 1000u);
+    CHECK_EQ(lease_reuse_ms(120 * TEST_DAY_S, 60 * TEST_DAY_S), UINT32_MAX - 1);
+
+    /* lwIP takes half of an infinite lease as T1 */
+    CHECK_EQ(lease_reuse_ms(REJOIN_DHCP_INFINITE_LEASE, REJOIN_DHCP_INFINITE_LEASE / 2), UINT32_MAX);
+    CHECK(wifi_fast_rejoin_cache_export(&state));
+    CHECK_EQ(state.lease_left_ms, UINT32_MAX);
+
+    CHECK_EQ(lease_reuse_ms(0, 0), UINT32_MAX);
+}
+
+/********************************************************************************
+ * Function Name: test_long_lease_renewal
+ ********************************************************************************
+ * Summary:
+ *  A T1 of two hours left 110 minutes after the rejoin, beyond the 71.6
+ *  minutes pdMS_TO_TICKS() converts without a wrap.
+ *
+ *******************************************************************************/
+static void test_long_lease_renewal(void)
+{
+    check_renewal(4 * TEST_HOUR_S, 2 * TEST_HOUR_S, 10 * 60 * 1000u, 2 * TEST_HOUR_S * 1000ull);
+}
+
+/********************************************************************************
+ * Function Name: test_saturated_lease_renewal
+ ********************************************************************************
+ * Summary:
+ *  A T1 of 60 days, saturated to UINT32_MAX - 1 ms, waited for by a timer
+ *  period close to portMAX_DELAY, across the wrap of the tick count.
+ *
+ *******************************************************************************/
+static void test_saturated_lease_renewal(void)
+{
+    check_renewal(120 * TEST_DAY_S, 60 * TEST_DAY_S, 0, UINT32_MAX - 1);
+}
+
+/********************************************************************************
+ * Function Name: test_infinite_lease
+ ********************************************************************************
+ * Summary:
+ *  An infinite lease is reused without ever restarting DHCP.
+ *
+ *******************************************************************************/
+static void test_infinite_lease(void)
+{
+    uint32_t starts;
+
+    (void)lease_reuse_ms(REJOIN_DHCP_INFINITE_LEASE, REJOIN_DHCP_INFINITE_LEASE / 2);
+    fake_wcm_event(CY_WCM_EVENT_DISCONNECTED);
+    starts = fake_dhcp_starts();
+    CHECK_EQ(wifi_fast_rejoin_join(), CY_RSLT_SUCCESS);
+    CHECK(NULL != fake_wcm_last_params()->static_ip_settings);
+
+    sim_sleep_ms(UINT32_MAX);
+    CHECK_EQ(fake_dhcp_starts(), starts);
+    CHECK(!xTimerIsTimerActive(dhcp_timer));
+}
+
+/********************************************************************************
+ * Function Name: test_rejoin_retry
+ ********************************************************************************
+ * Summary:
+ *  The rejoin task retries a failed rejoin after the back-off of
+ *  wifi_rejoin_retry_policy, until the AP is joined, and then stops.
+ *
+ *******************************************************************************/
+static void test_rejoin_retry(void)
+{
+    /* A failed fast join, then two full joins of MAX_WIFI_RETRY_COUNT failed attempts each */
+    fake_step_t failures[1 + (2 * MAX_WIFI_RETRY_COUNT)];
+    const uint32_t first = 1 + MAX_WIFI_RETRY_COUNT;
+    const uint32_t second = first + MAX_WIFI_RETRY_COUNT;
+    uint64_t gap;
+    uint32_t index;
+
+    for (index = 0; index < (sizeof(failures) / sizeof(failures[0])); index++)
+    {
+        failures[index].duration_ms = 0;
+        failures[index].result = CY_RSLT_TYPE_ERROR + 1;
+    }
+
+    wifi_fast_rejoin_cache_clear();
+    fake_netif_set_lease(TEST_HOST, TEST_DAY_S, TEST_DAY_S / 2);
+    CHECK_EQ(wifi_fast_rejoin_init(), CY_RSLT_SUCCESS);
+    CHECK(rejoin_cache.valid);
+
+    fake_wcm_script(failures, sizeof(failures) / sizeof(failures[0]));
+    fake_wcm_event(CY_WCM_EVENT_DISCONNECTED);
+    sim_sleep_ms(WIFI_REJOIN_RETRY_MAX_DELAY_MS);
+
+    /* Joined on the first attempt of the third rejoin */
+    CHECK_EQ(fake_wcm_calls(), second + 1);
+    CHECK(cy_wcm_is_connected_to_ap());
+    CHECK(rejoin_cache.valid);
+
+    /* Each rejoin starts with the random initial delay of wifi_connect() */
+    gap = fake_wcm_call_time(first) - fake_wcm_call_time(first - 1);
+    CHECK((gap >= (WIFI_REJOIN_RETRY_BASE_DELAY_MS / 2)) &&
+          (gap < (WIFI_REJOIN_RETRY_BASE_DELAY_MS + WIFI_JOIN_INITIAL_JITTER_MS)));
+
+    gap = fake_wcm_call_time(second) - fake_wcm_call_time(second - 1);
+    CHECK((gap >= WIFI_REJOIN_RETRY_BASE_DELAY_MS) &&
+          (gap < ((2 * WIFI_REJOIN_RETRY_BASE_DELAY_MS) + WIFI_JOIN_INITIAL_JITTER_MS)));
+
+    sim_sleep_ms(WIFI_REJOIN_RETRY_MAX_DELAY_MS);
+    CHECK_EQ(fake_wcm_calls(), second + 1);
+}
+
+int main(void)
+{
+    sim_reset(0);
+    fake_network_reset();
+
+    RUN_TEST(test_lease_reuse_time);
+    RUN_TEST(test_long_lease_renewal);
+    RUN_TEST(test_saturated_lease_renewal);
+    RUN_TEST(test_infinite_lease);
+    RUN_TEST(test_rejoin_retry);
+
+    return (0 == host_test_failures) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
+
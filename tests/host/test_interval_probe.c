@@ -0,0 +1,233 @@
+/******************************************************************************
+* File Name:   test_interval_probe.c
+*
+* Description: Host tests of the keepalive interval probe: the search up to
+*              TKO_PROBE_INTERVAL_MAX_S, the confirmation time of long
+*              intervals, and the failures that count against an interval.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "app_config.h"
+
+/* The probe is built in this file with the feature on */
+#undef ENABLE_TKO_INTERVAL_PROBE
+#define ENABLE_TKO_INTERVAL_PROBE         (1)
+
+/* The flash row address is a 32-bit value on the target */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+#include "tko_interval_probe.c"
+#pragma GCC diagnostic pop
+
+#include "fake_network.h"
+#include "host_test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define TICKS_S(seconds)                         ((TickType_t)((seconds) * 1000u))
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint32_t host_test_failures = 0;
+
+/* Parameters set on socket 0 by the probe */
+static tko_keepalive_params_t socket_params;
+
+/*******************************************************************************
+* Fakes of tko_runtime_config.c and debug_uart.c
+********************************************************************************/
+cy_rslt_t tko_get_keepalive_params(int index, tko_keepalive_params_t *params)
+{
+    (void)index;
+
+    *params = socket_params;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* With a single connection, the offload uses its interval */
+cy_rslt_t tko_set_keepalive_params(int index, const tko_keepalive_params_t *params)
+{
+    (void)index;
+
+    socket_params = *params;
+    tko_runtime_cfg.interval = params->interval;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t debug_uart_register_command(uint8_t command, debug_uart_command_handler_t handler)
+{
+    (void)command;
+    (void)handler;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: probe_setup
+ ********************************************************************************
+ * Summary:
+ *  Starts the probe of socket 0 from the given interval, and applies it at
+ *  the given tick count.
+ *
+ *******************************************************************************/
+static void probe_setup(uint16_t interval_s, TickType_t now)
+{
+    fake_network_reset();
+    fake_flash_writes = 0;
+    socket_params.interval = interval_s;
+    socket_params.retry_interval = 3;
+    socket_params.retry_count = 3;
+    tko_runtime_cfg.interval = interval_s;
+    CHECK_EQ(tko_probe_init(), CY_RSLT_SUCCESS);
+
+    tko_probe_check(0, now);
+    CHECK_EQ(probe[0].phase, TKO_PROBE_PROBING);
+    CHECK(probe[0].applied);
+    CHECK_EQ(socket_params.interval, interval_s);
+}
+
+/********************************************************************************
+ * Function Name: test_probe_max_interval
+ ********************************************************************************
+ * Summary:
+ *  An interval of TKO_PROBE_INTERVAL_MAX_S is confirmed only after it held for
+ *  TKO_PROBE_CONFIRM_INTERVALS of it, and then learned. In 32 bits, the ticks
+ *  of that time wrap to about 18 minutes. The tick count wraps too.
+ *
+ *******************************************************************************/
+static void test_probe_max_interval(void)
+{
+    const uint32_t confirm_s = TKO_PROBE_INTERVAL_MAX_S * TKO_PROBE_CONFIRM_INTERVALS;
+    TickType_t now = (TickType_t)0xFFFFFFFFu - TICKS_S(1000);
+    TickType_t applied;
+
+    probe_setup(1000, now);
+
+    /* 1000 s held three times: doubled, and capped to the maximum */
+    now += TICKS_S(1000 * TKO_PROBE_CONFIRM_INTERVALS);
+    tko_probe_check(0, now);
+    CHECK_EQ(probe[0].good_s, 1000);
+    CHECK_EQ(probe[0].interval_s, TKO_PROBE_INTERVAL_MAX_S);
+    CHECK_EQ(socket_params.interval, TKO_PROBE_INTERVAL_MAX_S);
+    applied = now;
+
+    /* Checked every health check interval, short of the confirmation time */
+    for (now = applied + TICKS_S(60); (TickType_t)(now - applied) < TICKS_S(confirm_s); now += TICKS_S(60))
+    {
+        tko_probe_check(0, now);
+        CHECK_EQ(probe[0].phase, TKO_PROBE_PROBING);
+    }
+
+    CHECK_EQ(probe[0].good_s, 1000);
+    CHECK_EQ(fake_flash_writes, 0);
+
+    tko_probe_check(0, applied + TICKS_S(confirm_s));
+    CHECK_EQ(probe[0].phase, TKO_PROBE_LEARNED);
+    CHECK_EQ(probe[0].interval_s, TKO_PROBE_INTERVAL_MAX_S);
+    CHECK_EQ(probe_record.count, 1);
+    CHECK_EQ(probe_record.paths[0].interval_s, TKO_PROBE_INTERVAL_MAX_S);
+    CHECK_EQ(fake_flash_writes, 1);
+}
+
+/********************************************************************************
+ * Function Name: test_probe_failure_at_max
+ ********************************************************************************
+ * Summary:
+ *  A loss before TKO_PROBE_INTERVAL_MAX_S elapsed is not caused by the
+ *  interval. A loss after it bounds the search, which goes on halfway down.
+ *
+ *******************************************************************************/
+static void test_probe_failure_at_max(void)
+{
+    TickType_t now = 0;
+
+    probe_setup(1000, now);
+    now += TICKS_S(1000 * TKO_PROBE_CONFIRM_INTERVALS);
+    tko_probe_check(0, now);
+    CHECK_EQ(probe[0].interval_s, TKO_PROBE_INTERVAL_MAX_S);
+
+    tko_probe_failure(0, now + TICKS_S(TKO_PROBE_INTERVAL_MAX_S - 1));
+    CHECK_EQ(probe[0].bad_s, 0);
+    CHECK_EQ(probe[0].interval_s, TKO_PROBE_INTERVAL_MAX_S);
+
+    /* Set again on the recovered connection */
+    tko_probe_check(0, now);
+    CHECK(probe[0].applied);
+
+    tko_probe_failure(0, now + TICKS_S(TKO_PROBE_INTERVAL_MAX_S));
+    CHECK_EQ(probe[0].bad_s, TKO_PROBE_INTERVAL_MAX_S);
+    CHECK_EQ(probe[0].interval_s, (1000 + TKO_PROBE_INTERVAL_MAX_S) / 2);
+    CHECK_EQ(probe[0].phase, TKO_PROBE_PROBING);
+}
+
+/********************************************************************************
+ * Function Name: test_probe_link_loss
+ ********************************************************************************
+ * Summary:
+ *  A loss of the Wi-Fi link does not count against the interval.
+ *
+ *******************************************************************************/
+static void test_probe_link_loss(void)
+{
+    probe_setup(TKO_PROBE_INTERVAL_MAX_S, 0);
+
+    fake_wcm_set_link(false, 1, 6);
+    tko_probe_failure(0, TICKS_S(TKO_PROBE_INTERVAL_MAX_S * 2));
+    CHECK_EQ(probe[0].bad_s, 0);
+    CHECK_EQ(probe[0].phase, TKO_PROBE_PROBING);
+}
+
+int main(void)
+{
+    RUN_TEST(test_probe_max_interval);
+    RUN_TEST(test_probe_failure_at_max);
+    RUN_TEST(test_probe_link_loss);
+
+    return (0 == host_test_failures) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,241 @@
+/******************************************************************************
+* File Name:   test_retry_scheduler.c
+*
+* Description: Host tests of the retry scheduler: the exponential back-off
+*              with equal jitter, the attempt limit, the power budget and the
+*              initial jitter, in simulated time.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "host_platform.h"
+#include "host_test.h"
+#include "retry_scheduler.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint32_t host_test_failures = 0;
+
+/* Policy of the Wi-Fi join of app_config.h, without the limits */
+static const retry_policy_t unlimited_policy =
+{
+    .initial_jitter_ms = 0,
+    .base_delay_ms     = 1000,
+    .max_delay_ms      = 30000,
+    .max_attempts      = 0,
+    .budget_ms         = 0,
+};
+
+/********************************************************************************
+ * Function Name: test_backoff_sequence
+ ********************************************************************************
+ * Summary:
+ *  The delay after failed attempt n is a random value in [d/2, d), where d is
+ *  the base delay doubled n - 1 times up to the maximum delay. Checked for many
+ *  device IDs, so that many jitter seeds are covered.
+ *
+ *******************************************************************************/
+static void test_backoff_sequence(void)
+{
+    retry_state_t retry;
+    uint64_t before;
+    uint32_t expected;
+    uint32_t slept;
+    uint32_t device;
+    uint32_t attempt;
+
+    for (device = 0; device < 1000; device++)
+    {
+        sim_reset(device * 7919u);
+        host_device_id = 0x1000000000000000ull + device;
+        retry_init(&retry, &unlimited_policy);
+        expected = unlimited_policy.base_delay_ms;
+
+        for (attempt = 1; attempt <= 12; attempt++)
+        {
+            retry_attempt_begin(&retry);
+            before = sim_time_ms();
+            CHECK(retry_attempt_failed(&retry));
+            slept = (uint32_t)(sim_time_ms() - before);
+
+            CHECK((slept >= expected / 2) && (slept < expected));
+
+            expected = (expected * 2 > unlimited_policy.max_delay_ms) ? unlimited_policy.max_delay_ms
+                                                                      : (expected * 2);
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: test_jitter_spread
+ ********************************************************************************
+ * Summary:
+ *  Devices that power up together do not take the same delays.
+ *
+ *******************************************************************************/
+static void test_jitter_spread(void)
+{
+    static bool seen[1000];
+    retry_state_t retry;
+    uint32_t distinct = 0;
+    uint32_t device;
+    uint32_t delay;
+
+    for (device = 0; device < 1000; device++)
+    {
+        sim_reset(0);
+        host_device_id = 0xA5A5000000000000ull + ((uint64_t)device << 20);
+        retry_init(&retry, &unlimited_policy);
+        retry_attempt_begin(&retry);
+        (void)retry_attempt_record_failure(&retry);
+
+        /* In [500, 1000) after the first failure */
+        delay = retry_next_delay_ms(&retry) - 500;
+        CHECK(delay < 500);
+
+        if ((delay < 500) && !seen[delay])
+        {
+            seen[delay] = true;
+            distinct++;
+        }
+    }
+
+    /* 1000 draws from 500 values leave about 430 distinct ones */
+    CHECK(distinct > 350);
+}
+
+/********************************************************************************
+ * Function Name: test_initial_jitter
+ ********************************************************************************
+ * Summary:
+ *  retry_init() sleeps for less than the initial jitter of the policy.
+ *
+ *******************************************************************************/
+static void test_initial_jitter(void)
+{
+    retry_policy_t policy = unlimited_policy;
+    retry_state_t retry;
+    uint64_t longest = 0;
+    uint32_t device;
+
+    policy.initial_jitter_ms = 2000;
+
+    for (device = 0; device < 200; device++)
+    {
+        sim_reset(0);
+        host_device_id = 0x5000000000000000ull + device;
+        retry_init(&retry, &policy);
+        CHECK(sim_time_ms() < policy.initial_jitter_ms);
+        longest = (sim_time_ms() > longest) ? sim_time_ms() : longest;
+    }
+
+    CHECK(longest > policy.initial_jitter_ms / 2);
+}
+
+/********************************************************************************
+ * Function Name: test_attempt_limit
+ ********************************************************************************
+ * Summary:
+ *  With max_attempts of 3, the operation is attempted three times.
+ *
+ *******************************************************************************/
+static void test_attempt_limit(void)
+{
+    retry_policy_t policy = unlimited_policy;
+    retry_state_t retry;
+    uint32_t attempts = 0;
+
+    policy.max_attempts = 3;
+    sim_reset(0);
+    retry_init(&retry, &policy);
+
+    do
+    {
+        retry_attempt_begin(&retry);
+        attempts++;
+    } while (retry_attempt_failed(&retry) && (attempts < 100));
+
+    CHECK_EQ(attempts, 3);
+}
+
+/********************************************************************************
+ * Function Name: test_budget
+ ********************************************************************************
+ * Summary:
+ *  The time spent in the attempts, not in the back-off delays, is accounted
+ *  against the budget. Attempts of 25 s exhaust a budget of 60 s on the third.
+ *  The clock starts just before the wrap of the millisecond counter.
+ *
+ *******************************************************************************/
+static void test_budget(void)
+{
+    retry_policy_t policy = unlimited_policy;
+    retry_state_t retry;
+    uint32_t attempts = 0;
+
+    policy.budget_ms = 60000;
+    sim_reset(0xFFFFFFFFull - 30000);
+    retry_init(&retry, &policy);
+
+    do
+    {
+        retry_attempt_begin(&retry);
+        sim_sleep_ms(25000);
+        attempts++;
+    } while (retry_attempt_failed(&retry) && (attempts < 100));
+
+    CHECK_EQ(attempts, 3);
+    CHECK_EQ(retry.spent_ms, 75000);
+}
+
+int main(void)
+{
+    RUN_TEST(test_backoff_sequence);
+    RUN_TEST(test_jitter_spread);
+    RUN_TEST(test_initial_jitter);
+    RUN_TEST(test_attempt_limit);
+    RUN_TEST(test_budget);
+
+    return (0 == host_test_failures) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
+
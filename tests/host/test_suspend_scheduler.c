@@ -0,0 +1,214 @@
+/******************************************************************************
+* File Name:   test_suspend_scheduler.c
+*
+* Description: Host tests of the network suspend scheduler: the hold-off of a
+*              bouncing stack, the inactivity window sized from the traffic,
+*              and network_idle_task() driving a scripted wait_net_suspend()
+*              in simulated time.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "fake_network.h"
+#include "host_test.h"
+#include "network_activity_handler.h"
+#include "network_suspend_scheduler.h"
+#include "tcp_keepalive_offload.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* A suspend that ends this soon is a bounce */
+#define BOUNCE_MS                                (NETWORK_SUSPEND_BOUNCE_MS / 2)
+
+/* A suspend that lasts */
+#define LONG_SUSPEND_MS                          (NETWORK_SUSPEND_BOUNCE_MS * 5)
+
+/* Packet gap of a burst, shorter than the guard delay so that the burst holds
+ * the suspend off
+ */
+#define BURST_GAP_MS                             (16)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint32_t host_test_failures = 0;
+
+/* Hold-off after each further bounce, starting from the guard delay */
+static const uint32_t bounce_holdoffs[] = { 100, 200, 400, 800, 1600, 3200, 3200, 3200 };
+
+#define BOUNCES                                  (sizeof(bounce_holdoffs) / sizeof(bounce_holdoffs[0]))
+
+/********************************************************************************
+ * Function Name: test_holdoff_sequence
+ ********************************************************************************
+ * Summary:
+ *  The hold-off doubles from NETWORK_SUSPEND_DELAY_MS on every bounce up to
+ *  NETWORK_SUSPEND_DELAY_MAX_MS, returns to the guard delay after a suspend
+ *  that lasted, and does not change after a failed suspend.
+ *
+ *******************************************************************************/
+static void test_holdoff_sequence(void)
+{
+    uint32_t holdoff = NETWORK_SUSPEND_GUARD_MS;
+    uint32_t bounce;
+
+    for (bounce = 0; bounce < BOUNCES; bounce++)
+    {
+        holdoff = net_suspend_scheduler_next_holdoff_ms(holdoff, ST_SUCCESS, BOUNCE_MS);
+        CHECK_EQ(holdoff, bounce_holdoffs[bounce]);
+    }
+
+    CHECK_EQ(net_suspend_scheduler_next_holdoff_ms(holdoff, ST_BAD_STATE, BOUNCE_MS), holdoff);
+    CHECK_EQ(net_suspend_scheduler_next_holdoff_ms(holdoff, ST_SUCCESS, NETWORK_SUSPEND_BOUNCE_MS),
+             NETWORK_SUSPEND_GUARD_MS);
+}
+
+/********************************************************************************
+ * Function Name: test_window_limits
+ ********************************************************************************
+ * Summary:
+ *  The inactivity window is twice the average intra-burst gap, within
+ *  NETWORK_INACTIVE_WINDOW_MIN_MS and NETWORK_INACTIVE_WINDOW_MS, and the
+ *  shortest one when expedited.
+ *
+ *******************************************************************************/
+static void test_window_limits(void)
+{
+    CHECK_EQ(net_suspend_scheduler_window_ms(0, false), NETWORK_INACTIVE_WINDOW_MIN_MS);
+    CHECK_EQ(net_suspend_scheduler_window_ms(10, false), NETWORK_INACTIVE_WINDOW_MIN_MS);
+    CHECK_EQ(net_suspend_scheduler_window_ms(40, false), 80);
+    CHECK_EQ(net_suspend_scheduler_window_ms(100, false), NETWORK_INACTIVE_WINDOW_MS);
+    CHECK_EQ(net_suspend_scheduler_window_ms(1000, false), NETWORK_INACTIVE_WINDOW_MS);
+    CHECK_EQ(net_suspend_scheduler_window_ms(40, true), NETWORK_INACTIVE_WINDOW_MIN_MS);
+}
+
+/********************************************************************************
+ * Function Name: test_idle_task
+ ********************************************************************************
+ * Summary:
+ *  Runs network_idle_task() against a wait_net_suspend() that bounces, then
+ *  lasts, then sees a burst of traffic with a 16 ms gap before the next
+ *  suspend. Each suspend must start the current hold-off after the stack
+ *  resumed or the last packet, with the window sized from the traffic.
+ *
+ *******************************************************************************/
+static void test_idle_task(void)
+{
+    fake_step_t script[BOUNCES + 2];
+    const fake_suspend_call_t *call;
+    const fake_suspend_call_t *previous;
+    uint64_t burst_start;
+    uint64_t resumed;
+    uint32_t index;
+
+    for (index = 0; index < BOUNCES; index++)
+    {
+        script[index].duration_ms = BOUNCE_MS;
+        script[index].result = ST_SUCCESS;
+    }
+
+    script[BOUNCES].duration_ms = LONG_SUSPEND_MS;
+    script[BOUNCES].result = ST_SUCCESS;
+    script[BOUNCES + 1].duration_ms = LONG_SUSPEND_MS;
+    script[BOUNCES + 1].result = ST_SUCCESS;
+
+    sim_reset(0);
+    fake_network_reset();
+    fake_suspend_script(script, BOUNCES + 2);
+    CHECK(NULL != sim_spawn(network_idle_task, NULL, "NetAct"));
+
+    /* Let the bounces and the long suspend run */
+    sim_sleep_ms(60000);
+
+    CHECK_EQ(fake_suspend_calls(), BOUNCES + 2);
+    CHECK_EQ(fake_suspend_call(0)->start_ms, NETWORK_SUSPEND_GUARD_MS);
+
+    for (index = 1; index <= BOUNCES + 1; index++)
+    {
+        previous = fake_suspend_call(index - 1);
+        call = fake_suspend_call(index);
+        resumed = previous->start_ms + script[index - 1].duration_ms;
+
+        CHECK_EQ(call->start_ms - resumed, (index <= BOUNCES) ? bounce_holdoffs[index - 1]
+                                                              : NETWORK_SUSPEND_GUARD_MS);
+        CHECK_EQ(call->inactive_window_ms, NETWORK_INACTIVE_WINDOW_MS);
+        CHECK_EQ(call->inactive_interval_ms, NETWORK_INACTIVE_INTERVAL_MS);
+    }
+
+    /* A burst with a short gap while the task waits for the stack to go idle */
+    script[0].duration_ms = LONG_SUSPEND_MS;
+    script[0].result = ST_SUCCESS;
+    sim_reset(0);
+    fake_suspend_script(script, 1);
+    CHECK(NULL != sim_spawn(network_idle_task, NULL, "NetAct"));
+
+    burst_start = NETWORK_SUSPEND_GUARD_MS / 2;
+    sim_sleep_ms((uint32_t)burst_start);
+
+    for (index = 0; index < 60; index++)
+    {
+        fake_network_activity(0 == (index % 2));
+        sim_sleep_ms(BURST_GAP_MS);
+    }
+
+    sim_sleep_ms(NETWORK_SUSPEND_GUARD_MS);
+
+    CHECK_EQ(fake_suspend_calls(), 1);
+    call = fake_suspend_call(0);
+    CHECK_EQ(call->start_ms, burst_start + 59 * BURST_GAP_MS + NETWORK_SUSPEND_GUARD_MS);
+    CHECK_EQ(call->inactive_window_ms, 2 * BURST_GAP_MS);
+    CHECK_EQ(call->inactive_interval_ms, 2 * BURST_GAP_MS + (NETWORK_INACTIVE_INTERVAL_MS - NETWORK_INACTIVE_WINDOW_MS));
+
+    sim_reset(0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_holdoff_sequence);
+    RUN_TEST(test_window_limits);
+    RUN_TEST(test_idle_task);
+
+    return (0 == host_test_failures) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
+
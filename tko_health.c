@@ -0,0 +1,491 @@
+/******************************************************************************
+* File Name:   tko_health.c
+*
+* Description: This file implements the health monitor of the TCP Keepalive
+*              connections. It tracks the state of each connection, and
+*              rebuilds only the connections that are lost, with an
+*              exponential back-off per connection, leaving the other
+*              connections and the network stack suspend alone.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "debug_uart.h"
+#include "network_suspend_scheduler.h"
+#include "offload_registry.h"
+#include "retry_scheduler.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_health.h"
+#include "tko_interval_probe.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    tko_health_state_t state;
+    retry_state_t retry;
+    TickType_t next_attempt;
+    bool given_up;
+} tko_health_socket_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static TaskHandle_t health_task = NULL;
+static tko_health_socket_t health[MAX_TKO];
+
+/* Sockets reported as lost, taken by the health task */
+static volatile uint32_t reported_mask = 0;
+
+/* Slots released on purpose, such as a closed session, left alone until claimed */
+static volatile uint32_t released_mask = 0;
+
+/* Connections lost and recovered since the start */
+static uint32_t loss_count = 0;
+static uint32_t reconnect_count = 0;
+
+static const retry_policy_t tko_health_retry_policy =
+{
+    .initial_jitter_ms = 0,
+    .base_delay_ms     = TCP_SOCKET_RETRY_BASE_DELAY_MS,
+    .max_delay_ms      = TCP_SOCKET_RETRY_MAX_DELAY_MS,
+    .max_attempts      = TCP_SOCKET_RETRY_MAX_ATTEMPTS,
+    .budget_ms         = TCP_SOCKET_RETRY_BUDGET_MS,
+};
+
+static const char *const health_state_name[] =
+{
+    "unused", "offloaded", "host-owned", "failed", "reconnecting"
+};
+
+/********************************************************************************
+ * Function Name: tko_health_connected_state
+ ********************************************************************************
+ * Summary:
+ *  Returns the state of a connected socket: offloaded while the network stack
+ *  is suspended, host-owned otherwise.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  tko_health_state_t: State of the connection.
+ *
+ *******************************************************************************/
+static tko_health_state_t tko_health_connected_state(void)
+{
+    return net_suspend_scheduler_is_offloaded() ? TKO_HEALTH_OFFLOADED : TKO_HEALTH_HOST_OWNED;
+}
+
+/********************************************************************************
+ * Function Name: tko_health_fail
+ ********************************************************************************
+ * Summary:
+ *  Marks a socket as lost, and schedules its first reconnect right away.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  now: Current tick count.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_health_fail(int index, TickType_t now)
+{
+    tko_health_socket_t *socket = &health[index];
+
+    if (TKO_HEALTH_FAILED == socket->state)
+    {
+        /* A new report re-arms a socket that ran out of attempts */
+        if (socket->given_up)
+        {
+            retry_init(&socket->retry, &tko_health_retry_policy);
+            socket->given_up = false;
+            socket->next_attempt = now;
+        }
+
+        return;
+    }
+
+    ERR_INFO(("Socket[%d]: TCP connection lost.\n", index));
+    loss_count++;
+
+#if ENABLE_TKO_INTERVAL_PROBE
+    tko_probe_failure(index, now);
+#endif
+
+    socket->state = TKO_HEALTH_FAILED;
+    socket->given_up = false;
+    socket->next_attempt = now;
+    retry_init(&socket->retry, &tko_health_retry_policy);
+}
+
+/********************************************************************************
+ * Function Name: tko_health_recover
+ ********************************************************************************
+ * Summary:
+ *  Reconnects a lost socket through the regular socket connect path. On
+ *  failure the next attempt is scheduled after the back-off delay.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_health_recover(int index)
+{
+    tko_health_socket_t *socket = &health[index];
+
+    socket->state = TKO_HEALTH_RECONNECTING;
+    retry_attempt_begin(&socket->retry);
+
+    if (CY_RSLT_SUCCESS == tcp_socket_reconnect(1u << index))
+    {
+        APP_INFO(("Socket[%d]: TCP connection recovered.\n", index));
+        reconnect_count++;
+        socket->state = tko_health_connected_state();
+        return;
+    }
+
+    socket->state = TKO_HEALTH_FAILED;
+
+    if (retry_attempt_record_failure(&socket->retry))
+    {
+        socket->next_attempt = xTaskGetTickCount() + pdMS_TO_TICKS(retry_next_delay_ms(&socket->retry));
+    }
+    else
+    {
+        ERR_INFO(("Socket[%d]: Giving up the reconnection after %"PRIu32" attempts.\n",
+                  index, socket->retry.attempt));
+        socket->given_up = true;
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_health_task
+ ********************************************************************************
+ * Summary:
+ *  Checks the connections when a loss is reported, and every
+ *  TKO_HEALTH_CHECK_INTERVAL_MS otherwise. The check reads the lwIP state of
+ *  the connections only; it does not resume the network stack. Lost
+ *  connections are reconnected one by one when their back-off expires.
+ *
+ * Parameters:
+ *  arg: Unused.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_health_task(void *arg)
+{
+    tko_health_socket_t *socket;
+    TickType_t timeout;
+    TickType_t now;
+    uint32_t mask;
+    int index;
+
+    (void)arg;
+
+    while (true)
+    {
+        now = xTaskGetTickCount();
+        timeout = pdMS_TO_TICKS(TKO_HEALTH_CHECK_INTERVAL_MS);
+
+        taskENTER_CRITICAL();
+        mask = reported_mask;
+        reported_mask = 0;
+        taskEXIT_CRITICAL();
+
+        for (index = 0; index < MAX_TKO; index++)
+        {
+            socket = &health[index];
+
+            if (released_mask & (1u << index))
+            {
+                socket->state = TKO_HEALTH_UNUSED;
+                continue;
+            }
+
+            if (TKO_HEALTH_UNUSED == socket->state)
+            {
+                continue;
+            }
+
+            if ((mask & (1u << index)) || !tcp_socket_is_established(index))
+            {
+                tko_health_fail(index, now);
+            }
+            else if (TKO_HEALTH_FAILED != socket->state)
+            {
+                socket->state = tko_health_connected_state();
+
+#if ENABLE_TKO_INTERVAL_PROBE
+                tko_probe_check(index, now);
+#endif
+            }
+
+            if ((TKO_HEALTH_FAILED != socket->state) || socket->given_up)
+            {
+                continue;
+            }
+
+            /* The link is restored by the Wi-Fi rejoin before the sockets */
+            if (cy_wcm_is_connected_to_ap() && ((int32_t)(now - socket->next_attempt) >= 0))
+            {
+                tko_health_recover(index);
+                now = xTaskGetTickCount();
+            }
+
+            if ((TKO_HEALTH_FAILED == socket->state) && !socket->given_up &&
+                ((int32_t)(socket->next_attempt - now) > 0) && ((socket->next_attempt - now) < timeout))
+            {
+                timeout = socket->next_attempt - now;
+            }
+        }
+
+        (void)ulTaskNotifyTake(pdTRUE, timeout);
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_health_init
+ ********************************************************************************
+ * Summary:
+ *  Starts monitoring the configured TCP Keepalive connections. The ones that
+ *  failed to connect at start-up are recovered like the ones lost later.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the health task is started.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_health_init(void)
+{
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        health[index].state = offload_registry_tko_port_valid(index) ? TKO_HEALTH_HOST_OWNED : TKO_HEALTH_UNUSED;
+    }
+
+    if (pdPASS != xTaskCreate(tko_health_task, "TkoHealth", TKO_HEALTH_TASK_STACK_SIZE,
+                              NULL, TKO_HEALTH_TASK_PRIORITY, &health_task))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    debug_uart_register_command(TKO_HEALTH_REPORT_COMMAND, tko_health_report);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_health_report_failure
+ ********************************************************************************
+ * Summary:
+ *  Reports sockets whose connection is known to be lost, for example by the
+ *  TCP Keepalive offload. Only these sockets are reconnected.
+ *
+ * Parameters:
+ *  socket_mask: Bit n set for the socket at index n of the port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_health_report_failure(uint32_t socket_mask)
+{
+    taskENTER_CRITICAL();
+    reported_mask |= socket_mask;
+    taskEXIT_CRITICAL();
+
+    if (NULL != health_task)
+    {
+        xTaskNotifyGive(health_task);
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_health_release
+ ********************************************************************************
+ * Summary:
+ *  Stops monitoring a slot whose connection is closed on purpose, such as the
+ *  slot of a session closed by the session manager, so that it is not
+ *  reconnected. Call it before the socket is closed.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_health_release(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    released_mask |= (1u << index);
+    reported_mask &= ~(1u << index);
+    health[index].state = TKO_HEALTH_UNUSED;
+    taskEXIT_CRITICAL();
+}
+
+/********************************************************************************
+ * Function Name: tko_health_claim
+ ********************************************************************************
+ * Summary:
+ *  Monitors a slot again once it holds a new connection, such as a session
+ *  moved into it by the session manager.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_health_claim(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    released_mask &= ~(1u << index);
+    health[index].state = tko_health_connected_state();
+    health[index].given_up = false;
+    taskEXIT_CRITICAL();
+}
+
+/********************************************************************************
+ * Function Name: tko_health_get_state
+ ********************************************************************************
+ * Summary:
+ *  Returns the state of a TCP Keepalive connection, as of the last check.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  tko_health_state_t: State of the connection.
+ *
+ *******************************************************************************/
+tko_health_state_t tko_health_get_state(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return TKO_HEALTH_UNUSED;
+    }
+
+    return health[index].state;
+}
+
+/********************************************************************************
+ * Function Name: tko_health_get_counts
+ ********************************************************************************
+ * Summary:
+ *  Returns the number of connections lost and recovered since the start.
+ *
+ * Parameters:
+ *  losses: Filled in with the number of connections lost.
+ *  reconnects: Filled in with the number of connections recovered.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_health_get_counts(uint32_t *losses, uint32_t *reconnects)
+{
+    *losses = loss_count;
+    *reconnects = reconnect_count;
+}
+
+/********************************************************************************
+ * Function Name: tko_health_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the state of each TCP Keepalive connection. It is run by the debug
+ *  UART command TKO_HEALTH_REPORT_COMMAND.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_health_report(void)
+{
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        APP_INFO(("Socket[%d]: %s, %"PRIu32" failed attempts\n", index,
+                  health_state_name[health[index].state], health[index].retry.attempt));
+    }
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,93 @@
+/******************************************************************************
+* File Name:   tko_health.h
+*
+* Description: This file is the public interface of tko_health.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TKO_HEALTH_H
+#define TKO_HEALTH_H
+
+#include <stdint.h>
+
+/* FreeRTOS header file */
+#include <FreeRTOS.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Stack size and priority of the task that monitors and recovers the sockets */
+#ifndef TKO_HEALTH_TASK_STACK_SIZE
+#define TKO_HEALTH_TASK_STACK_SIZE               (1024)
+#endif
+#ifndef TKO_HEALTH_TASK_PRIORITY
+#define TKO_HEALTH_TASK_PRIORITY                 (1)
+#endif
+
+/* Debug UART command byte that prints the state of the connections */
+#define TKO_HEALTH_REPORT_COMMAND                ('h')
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    TKO_HEALTH_UNUSED = 0,          /* Not configured in the port table */
+    TKO_HEALTH_OFFLOADED,           /* Kept alive by the WLAN firmware */
+    TKO_HEALTH_HOST_OWNED,          /* Kept alive by the host network stack */
+    TKO_HEALTH_FAILED,              /* Lost, waiting for the next reconnect */
+    TKO_HEALTH_RECONNECTING         /* Being reconnected */
+} tko_health_state_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tko_health_init(void);
+void tko_health_report_failure(uint32_t socket_mask);
+void tko_health_release(int index);
+void tko_health_claim(int index);
+tko_health_state_t tko_health_get_state(int index);
+void tko_health_report(void);
+void tko_health_get_counts(uint32_t *losses, uint32_t *reconnects);
+
+#endif /* TKO_HEALTH_H */
+
+
+/* [] END OF FILE */
+
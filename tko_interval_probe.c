@@ -0,0 +1,673 @@
+/******************************************************************************
+* File Name:   tko_interval_probe.c
+*
+* Description: Learns the largest keepalive interval that each network path
+*              keeps a TCP connection open with, from the failures seen by
+*              the health monitor, and keeps the learned values in flash.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cyhal.h"
+#include "cy_syslib.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* Wi-Fi connection manager header file */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "app_crc.h"
+#include "debug_uart.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_interval_probe.h"
+#include "tko_runtime_config.h"
+
+#if ENABLE_TKO_INTERVAL_PROBE
+
+#if ENABLE_TKO_SESSION_MANAGER
+#error "ENABLE_TKO_INTERVAL_PROBE does not follow the connections moved by the TCP Keepalive session manager"
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define TKO_PROBE_RECORD_MAGIC            (0x50414B54u) /* "TKAP" */
+#define TKO_PROBE_RECORD_VERSION          (1)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    TKO_PROBE_IDLE = 0,           /* Not started on the current path */
+    TKO_PROBE_PROBING,            /* Searching for the largest safe interval */
+    TKO_PROBE_LEARNED             /* Using the interval learned for the path */
+} tko_probe_phase_t;
+
+typedef struct
+{
+    tko_probe_phase_t phase;
+    uint32_t path;
+
+    /* Search bounds: largest interval that held, smallest that failed (0: none) */
+    uint16_t good_s;
+    uint16_t bad_s;
+
+    /* Interval being probed or learned, and when it took effect */
+    uint16_t interval_s;
+    bool applied;
+    TickType_t applied_tick;
+} tko_probe_socket_t;
+
+typedef struct
+{
+    uint32_t path;
+    uint16_t interval_s;
+    uint16_t reserved;
+} tko_probe_path_t;
+
+/* Learned intervals, the most recently learned first */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    tko_probe_path_t paths[TKO_PROBE_MAX_PATHS];
+
+    /* CRC-32 of the record up to here */
+    uint32_t crc;
+} tko_probe_record_t;
+
+/* Identity of a network path: the AP and the server of the connection */
+typedef struct
+{
+    cy_wcm_mac_t bssid;
+    uint16_t remote_port;
+    char remote_ip[sizeof(((cy_tko_ol_connect_t *)0)->remote_ip)];
+} tko_probe_path_id_t;
+
+_Static_assert(sizeof(tko_probe_record_t) <= CY_FLASH_SIZEOF_ROW, "Probe record does not fit in a flash row");
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/*
+ * Flash row of the learned intervals, in the emulated EEPROM region. The row
+ * is part of the programmed image, so programming a new build erases it.
+ */
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(CY_FLASH_SIZEOF_ROW)
+static const volatile uint8_t probe_flash[CY_FLASH_SIZEOF_ROW] = { 0 };
+
+static uint32_t probe_row[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+static tko_probe_record_t probe_record;
+static tko_probe_socket_t probe[MAX_TKO];
+
+static const char *const probe_phase_name[] = { "idle", "probing", "learned" };
+
+/********************************************************************************
+ * Function Name: tko_probe_record_save
+ ********************************************************************************
+ * Summary:
+ *  Erases the flash row of the learned intervals and programs it with the
+ *  record. The CPU is stalled while the row is programmed.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_record_save(void)
+{
+    cyhal_flash_t flash;
+    cy_rslt_t result;
+
+    probe_record.magic = TKO_PROBE_RECORD_MAGIC;
+    probe_record.version = TKO_PROBE_RECORD_VERSION;
+    probe_record.crc = app_crc32(&probe_record, offsetof(tko_probe_record_t, crc));
+
+    memset(probe_row, 0, sizeof(probe_row));
+    memcpy(probe_row, &probe_record, sizeof(probe_record));
+
+    result = cyhal_flash_init(&flash);
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        result = cyhal_flash_write(&flash, (uint32_t)probe_flash, probe_row);
+        cyhal_flash_free(&flash);
+    }
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Failed to save the learned keepalive intervals. Error code:%"PRIu32"\n", result));
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_record_load
+ ********************************************************************************
+ * Summary:
+ *  Reads the learned intervals from their flash row. A blank or corrupted row
+ *  gives an empty table.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_record_load(void)
+{
+    uint8_t *byte = (uint8_t *)&probe_record;
+    size_t index;
+
+    for (index = 0; index < sizeof(probe_record); index++)
+    {
+        byte[index] = probe_flash[index];
+    }
+
+    if ((TKO_PROBE_RECORD_MAGIC != probe_record.magic) || (TKO_PROBE_RECORD_VERSION != probe_record.version) ||
+        (probe_record.count > TKO_PROBE_MAX_PATHS) ||
+        (app_crc32(&probe_record, offsetof(tko_probe_record_t, crc)) != probe_record.crc))
+    {
+        memset(&probe_record, 0, sizeof(probe_record));
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_path_find
+ ********************************************************************************
+ * Summary:
+ *  Looks up a network path in the table of learned intervals.
+ *
+ * Parameters:
+ *  path: Key of the network path.
+ *
+ * Return:
+ *  int: Index of the path in the table, -1 if it has no learned interval.
+ *
+ *******************************************************************************/
+static int tko_probe_path_find(uint32_t path)
+{
+    int index;
+
+    for (index = 0; index < probe_record.count; index++)
+    {
+        if (probe_record.paths[index].path == path)
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_path_store
+ ********************************************************************************
+ * Summary:
+ *  Records the learned interval of a network path at the head of the table,
+ *  dropping the least recently learned path if the table is full, or forgets
+ *  the path, and writes the table to flash.
+ *
+ * Parameters:
+ *  path: Key of the network path.
+ *  interval_s: Learned interval, 0 to forget the path.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_path_store(uint32_t path, uint16_t interval_s)
+{
+    int found = tko_probe_path_find(path);
+    int last = (found >= 0) ? found : ((probe_record.count < TKO_PROBE_MAX_PATHS) ? probe_record.count :
+                                                                                     (TKO_PROBE_MAX_PATHS - 1));
+
+    if (0 == interval_s)
+    {
+        if (found < 0)
+        {
+            return;
+        }
+
+        memmove(&probe_record.paths[found], &probe_record.paths[found + 1],
+                (probe_record.count - found - 1) * sizeof(probe_record.paths[0]));
+        probe_record.count--;
+    }
+    else
+    {
+        memmove(&probe_record.paths[1], &probe_record.paths[0], last * sizeof(probe_record.paths[0]));
+        probe_record.paths[0].path = path;
+        probe_record.paths[0].interval_s = interval_s;
+        probe_record.paths[0].reserved = 0;
+
+        if (found < 0)
+        {
+            probe_record.count = (uint16_t)(last + 1);
+        }
+    }
+
+    tko_probe_record_save();
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_path_key
+ ********************************************************************************
+ * Summary:
+ *  Computes the key of the network path of a connection, from the BSSID of
+ *  the AP and the remote address and port of the server.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  path: Filled in with the key of the path.
+ *
+ * Return:
+ *  bool: true on success, false if the device is not associated to an AP.
+ *
+ *******************************************************************************/
+static bool tko_probe_path_key(int index, uint32_t *path)
+{
+    cy_wcm_associated_ap_info_t ap_info;
+    tko_probe_path_id_t id;
+
+    if (CY_RSLT_SUCCESS != cy_wcm_get_associated_ap_info(&ap_info))
+    {
+        return false;
+    }
+
+    memset(&id, 0, sizeof(id));
+    memcpy(id.bssid, ap_info.BSSID, sizeof(id.bssid));
+    id.remote_port = tko_runtime_cfg.ports[index].remote_port;
+    strncpy(id.remote_ip, (const char *)tko_runtime_cfg.ports[index].remote_ip, sizeof(id.remote_ip) - 1);
+
+    *path = app_crc32(&id, sizeof(id));
+
+    return true;
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_elapsed
+ ********************************************************************************
+ * Summary:
+ *  Tells whether the given number of seconds has elapsed since a tick count.
+ *  The comparison is done in 64 bits in milliseconds, as the intervals times
+ *  TKO_PROBE_CONFIRM_INTERVALS do not fit in 32 bits once converted to ticks.
+ *
+ * Parameters:
+ *  since: Tick count at the start.
+ *  now: Current tick count.
+ *  seconds: Time to check for.
+ *
+ * Return:
+ *  bool: true if the time has elapsed, false otherwise.
+ *
+ *******************************************************************************/
+static bool tko_probe_elapsed(TickType_t since, TickType_t now, uint32_t seconds)
+{
+    return ((uint64_t)(TickType_t)(now - since) * portTICK_PERIOD_MS) >= ((uint64_t)seconds * 1000u);
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_apply
+ ********************************************************************************
+ * Summary:
+ *  Sets the interval of the probe on the connection, keeping its retry
+ *  parameters.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  now: Current tick count.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_apply(int index, TickType_t now)
+{
+    tko_probe_socket_t *socket = &probe[index];
+    tko_keepalive_params_t params;
+
+    if (CY_RSLT_SUCCESS != tko_get_keepalive_params(index, &params))
+    {
+        return;
+    }
+
+    /* The retry interval of the connection is a lower limit of the interval */
+    params.interval = (socket->interval_s > params.retry_interval) ? socket->interval_s : params.retry_interval;
+
+    if (CY_RSLT_SUCCESS == tko_set_keepalive_params(index, &params))
+    {
+        socket->applied = true;
+        socket->applied_tick = now;
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_learn
+ ********************************************************************************
+ * Summary:
+ *  Ends the search of a connection. When a failure bounded the search, the
+ *  largest interval that held is reduced by TKO_PROBE_MARGIN_PERCENT, so that
+ *  a small variation of the timeout of the path does not drop the connection.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_learn(int index)
+{
+    tko_probe_socket_t *socket = &probe[index];
+    uint16_t interval_s = socket->good_s;
+
+    if (0 != socket->bad_s)
+    {
+        interval_s = (uint16_t)(((uint32_t)interval_s * (100u - TKO_PROBE_MARGIN_PERCENT)) / 100u);
+    }
+
+    if (interval_s < TKO_PROBE_INTERVAL_MIN_S)
+    {
+        interval_s = TKO_PROBE_INTERVAL_MIN_S;
+    }
+
+    APP_INFO(("Socket[%d]: Learned keepalive interval %d s (held %d s, failed %d s)\n",
+              index, interval_s, socket->good_s, socket->bad_s));
+
+    socket->phase = TKO_PROBE_LEARNED;
+    socket->interval_s = interval_s;
+    tko_probe_path_store(socket->path, interval_s);
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_next
+ ********************************************************************************
+ * Summary:
+ *  Picks the next interval to probe: twice the largest one that held until a
+ *  failure is seen, then the middle of the interval that held and the one
+ *  that failed. The search ends when they are TKO_PROBE_RESOLUTION_S apart,
+ *  or when TKO_PROBE_INTERVAL_MAX_S held.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_next(int index)
+{
+    tko_probe_socket_t *socket = &probe[index];
+    uint32_t interval_s;
+
+    if ((socket->good_s >= TKO_PROBE_INTERVAL_MAX_S) ||
+        ((0 != socket->bad_s) && ((socket->bad_s - socket->good_s) <= TKO_PROBE_RESOLUTION_S)))
+    {
+        tko_probe_learn(index);
+        return;
+    }
+
+    interval_s = (0 != socket->bad_s) ? (((uint32_t)socket->good_s + socket->bad_s) / 2u) :
+                                        ((uint32_t)socket->good_s * 2u);
+
+    socket->interval_s = (uint16_t)((interval_s < TKO_PROBE_INTERVAL_MAX_S) ? interval_s : TKO_PROBE_INTERVAL_MAX_S);
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_start
+ ********************************************************************************
+ * Summary:
+ *  Starts on the network path of a connection: uses the interval learned for
+ *  the path, or probes from the configured interval upwards.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_start(int index)
+{
+    tko_probe_socket_t *socket = &probe[index];
+    tko_keepalive_params_t params;
+    int found;
+
+    if (!tko_probe_path_key(index, &socket->path) ||
+        (CY_RSLT_SUCCESS != tko_get_keepalive_params(index, &params)))
+    {
+        return;
+    }
+
+    socket->applied = false;
+    socket->bad_s = 0;
+    socket->good_s = TKO_PROBE_INTERVAL_MIN_S;
+    found = tko_probe_path_find(socket->path);
+
+    if (found >= 0)
+    {
+        socket->phase = TKO_PROBE_LEARNED;
+        socket->interval_s = probe_record.paths[found].interval_s;
+    }
+    else
+    {
+        socket->phase = TKO_PROBE_PROBING;
+        socket->interval_s = (params.interval > TKO_PROBE_INTERVAL_MIN_S) ? params.interval : TKO_PROBE_INTERVAL_MIN_S;
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_check
+ ********************************************************************************
+ * Summary:
+ *  Called by the health monitor for each connected socket. Sets the interval
+ *  of the probe on a new connection, and takes the probed interval as safe
+ *  once the connection held for TKO_PROBE_CONFIRM_INTERVALS of it. The time
+ *  counts only while the WLAN offload uses the probed interval, as the
+ *  firmware applies the shortest interval of all the connections.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  now: Current tick count.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_probe_check(int index, TickType_t now)
+{
+    tko_probe_socket_t *socket = &probe[index];
+
+    if (TKO_PROBE_IDLE == socket->phase)
+    {
+        tko_probe_start(index);
+    }
+
+    if (TKO_PROBE_IDLE == socket->phase)
+    {
+        return;
+    }
+
+    if (!socket->applied)
+    {
+        tko_probe_apply(index, now);
+        return;
+    }
+
+    if (TKO_PROBE_PROBING != socket->phase)
+    {
+        return;
+    }
+
+    if (tko_runtime_cfg.interval < socket->interval_s)
+    {
+        socket->applied_tick = now;
+    }
+    else if (tko_probe_elapsed(socket->applied_tick, now, (uint32_t)socket->interval_s * TKO_PROBE_CONFIRM_INTERVALS))
+    {
+        socket->good_s = socket->interval_s;
+        tko_probe_next(index);
+        tko_probe_apply(index, now);
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_failure
+ ********************************************************************************
+ * Summary:
+ *  Called by the health monitor when a connection is lost. A loss once the
+ *  probed interval has elapsed without traffic is taken as the timeout of the
+ *  path: the interval failed and the search continues below it. A loss of
+ *  the learned interval means that the path changed, so its search starts
+ *  again. Losses of the Wi-Fi link, or before the interval elapsed, are not
+ *  caused by the interval and are ignored. The interval is set again on the
+ *  connection once it is recovered.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  now: Current tick count.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_probe_failure(int index, TickType_t now)
+{
+    tko_probe_socket_t *socket = &probe[index];
+    bool caused = socket->applied && cy_wcm_is_connected_to_ap() &&
+                  tko_probe_elapsed(socket->applied_tick, now, socket->interval_s);
+
+    socket->applied = false;
+
+    if ((TKO_PROBE_IDLE == socket->phase) || !caused)
+    {
+        return;
+    }
+
+    ERR_INFO(("Socket[%d]: Connection lost with a keepalive interval of %d s\n", index, socket->interval_s));
+
+    if (TKO_PROBE_LEARNED == socket->phase)
+    {
+        tko_probe_path_store(socket->path, 0);
+        socket->phase = TKO_PROBE_PROBING;
+        socket->good_s = TKO_PROBE_INTERVAL_MIN_S;
+    }
+
+    socket->bad_s = socket->interval_s;
+
+    if (socket->bad_s <= socket->good_s)
+    {
+        /* Even the shortest interval fails; nothing lower is probed */
+        socket->good_s = TKO_PROBE_INTERVAL_MIN_S;
+        tko_probe_learn(index);
+        return;
+    }
+
+    tko_probe_next(index);
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the probe state of each connection and the number of paths learned.
+ *  It is run by the debug UART command TKO_PROBE_REPORT_COMMAND.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_probe_report(void)
+{
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        APP_INFO(("Socket[%d]: %s, interval %d s, held %d s, failed %d s\n", index,
+                  probe_phase_name[probe[index].phase], probe[index].interval_s,
+                  probe[index].good_s, probe[index].bad_s));
+    }
+
+    APP_INFO(("Learned paths: %d of %d\n", probe_record.count, TKO_PROBE_MAX_PATHS));
+}
+
+/********************************************************************************
+ * Function Name: tko_probe_init
+ ********************************************************************************
+ * Summary:
+ *  Loads the learned intervals and registers the debug UART command that
+ *  prints the probe state. The probes start at the next health check.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the command is registered.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_probe_init(void)
+{
+    memset(probe, 0, sizeof(probe));
+    tko_probe_record_load();
+
+    return debug_uart_register_command(TKO_PROBE_REPORT_COMMAND, tko_probe_report);
+}
+
+#endif /* ENABLE_TKO_INTERVAL_PROBE */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,341 @@
+/******************************************************************************
+* File Name:   tko_metrics.c
+*
+* Description: Answers the metrics requests received on a TCP Keepalive
+*              connection with a binary frame of the power and connection
+*              counters of the device.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "lwip/opt.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+/* Socket management header file */
+#include "cy_secure_sockets.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "app_crc.h"
+#include "debug_uart.h"
+#include "network_suspend_stats.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_health.h"
+#include "tko_metrics.h"
+#include "tko_tls.h"
+#include "wake_dispatcher.h"
+
+#if ENABLE_TKO_METRICS
+
+_Static_assert(TKO_METRICS_WAKE_REASONS == WAKE_REASON_MAX, "TKO_METRICS_WAKE_REASONS must match wake_reason_t");
+_Static_assert(TKO_METRICS_SOCKET_INDEX < MAX_TKO, "TKO_METRICS_SOCKET_INDEX must be a TCP Keepalive port");
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Bytes read from the socket at a time */
+#define TKO_METRICS_RECV_CHUNK_SIZE       (32)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Position of the request parser in the frame format of debug_uart.c */
+typedef enum
+{
+    TKO_METRICS_PARSE_SYNC_0 = 0,
+    TKO_METRICS_PARSE_SYNC_1,
+    TKO_METRICS_PARSE_TYPE,
+    TKO_METRICS_PARSE_LENGTH_LOW,
+    TKO_METRICS_PARSE_LENGTH_HIGH,
+    TKO_METRICS_PARSE_CRC_LOW,
+    TKO_METRICS_PARSE_CRC_HIGH
+} tko_metrics_parse_state_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Kept across reads, as a request can be split over TCP segments */
+static tko_metrics_parse_state_t parse_state = TKO_METRICS_PARSE_SYNC_0;
+static uint8_t parse_header[DEBUG_UART_FRAME_HEADER_SIZE - 2];
+static uint8_t parse_crc_low;
+
+#if MEMP_STATS
+static const memp_t metrics_pools[TKO_METRICS_POOLS] =
+{
+    MEMP_TCP_PCB, MEMP_TCP_SEG, MEMP_PBUF_POOL, MEMP_NETCONN
+};
+#endif
+
+/********************************************************************************
+ * Function Name: tko_metrics_parse
+ ********************************************************************************
+ * Summary:
+ *  Looks for metrics requests in the data received: frames of type
+ *  TKO_METRICS_REQUEST_FRAME_TYPE without payload and with a valid CRC. The
+ *  other bytes are dropped.
+ *
+ * Parameters:
+ *  data: Data received.
+ *  length: Number of bytes received.
+ *
+ * Return:
+ *  uint32_t: Number of requests found.
+ *
+ *******************************************************************************/
+static uint32_t tko_metrics_parse(const uint8_t *data, uint32_t length)
+{
+    uint32_t requests = 0;
+    uint16_t crc;
+    uint8_t byte;
+
+    while (length--)
+    {
+        byte = *data++;
+
+        switch (parse_state)
+        {
+            case TKO_METRICS_PARSE_SYNC_0:
+                parse_state = (DEBUG_UART_FRAME_SYNC_0 == byte) ? TKO_METRICS_PARSE_SYNC_1 : TKO_METRICS_PARSE_SYNC_0;
+                break;
+
+            case TKO_METRICS_PARSE_SYNC_1:
+                parse_state = (DEBUG_UART_FRAME_SYNC_1 == byte) ? TKO_METRICS_PARSE_TYPE :
+                              ((DEBUG_UART_FRAME_SYNC_0 == byte) ? TKO_METRICS_PARSE_SYNC_1 : TKO_METRICS_PARSE_SYNC_0);
+                break;
+
+            case TKO_METRICS_PARSE_TYPE:
+            case TKO_METRICS_PARSE_LENGTH_LOW:
+            case TKO_METRICS_PARSE_LENGTH_HIGH:
+                parse_header[parse_state - TKO_METRICS_PARSE_TYPE] = byte;
+                parse_state++;
+                break;
+
+            case TKO_METRICS_PARSE_CRC_LOW:
+                parse_crc_low = byte;
+                parse_state = TKO_METRICS_PARSE_CRC_HIGH;
+                break;
+
+            case TKO_METRICS_PARSE_CRC_HIGH:
+            default:
+                crc = app_crc16(0xFFFF, parse_header, sizeof(parse_header));
+
+                if ((TKO_METRICS_REQUEST_FRAME_TYPE == parse_header[0]) && (0 == parse_header[1]) &&
+                    (0 == parse_header[2]) && (crc == (uint16_t)(parse_crc_low | ((uint16_t)byte << 8))))
+                {
+                    requests++;
+                }
+
+                parse_state = TKO_METRICS_PARSE_SYNC_0;
+                break;
+        }
+    }
+
+    return requests;
+}
+
+/********************************************************************************
+ * Function Name: tko_metrics_get
+ ********************************************************************************
+ * Summary:
+ *  Takes a snapshot of the metrics.
+ *
+ * Parameters:
+ *  metrics: Filled in with the current metrics.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_metrics_get(tko_metrics_t *metrics)
+{
+    net_suspend_stats_t stats;
+    uint32_t index;
+
+    net_suspend_stats_get(&stats);
+
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->version = TKO_METRICS_VERSION;
+    metrics->uptime_s = stats.uptime_ms / 1000u;
+    metrics->suspend_calls = stats.suspend_calls;
+    metrics->resume_count = stats.resume_count;
+    metrics->awake_s = (uint32_t)(stats.awake_ms / 1000u);
+    metrics->waiting_s = (uint32_t)(stats.waiting_ms / 1000u);
+    metrics->suspended_s = (uint32_t)(stats.suspended_ms / 1000u);
+    metrics->resume_latency_max_us = stats.resume_latency_max_us;
+
+    tko_health_get_counts(&metrics->connection_losses, &metrics->reconnects);
+
+    metrics->heap_free = (uint32_t)xPortGetFreeHeapSize();
+    metrics->heap_free_min = (uint32_t)xPortGetMinimumEverFreeHeapSize();
+
+    for (index = 0; index < TKO_METRICS_POOLS; index++)
+    {
+#if MEMP_STATS
+        metrics->pool_max[index] = (uint16_t)lwip_stats.memp[metrics_pools[index]]->max;
+#else
+        metrics->pool_max[index] = TKO_METRICS_POOL_UNKNOWN;
+#endif
+    }
+
+    wake_dispatcher_get_counts(metrics->wakes);
+}
+
+/********************************************************************************
+ * Function Name: tko_metrics_send
+ ********************************************************************************
+ * Summary:
+ *  Sends the metrics as one frame of type TKO_METRICS_FRAME_TYPE on the
+ *  metrics socket.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, a socket or TLS error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t tko_metrics_send(void)
+{
+    uint8_t frame[sizeof(tko_metrics_t) + DEBUG_UART_FRAME_OVERHEAD];
+    tko_metrics_t metrics;
+    uint32_t sent = 0;
+    uint16_t crc;
+
+    tko_metrics_get(&metrics);
+
+    frame[0] = DEBUG_UART_FRAME_SYNC_0;
+    frame[1] = DEBUG_UART_FRAME_SYNC_1;
+    frame[2] = TKO_METRICS_FRAME_TYPE;
+    frame[3] = (uint8_t)(sizeof(metrics) & 0xFF);
+    frame[4] = (uint8_t)(sizeof(metrics) >> 8);
+    memcpy(&frame[DEBUG_UART_FRAME_HEADER_SIZE], &metrics, sizeof(metrics));
+
+    crc = app_crc16(0xFFFF, &frame[2], (DEBUG_UART_FRAME_HEADER_SIZE - 2) + sizeof(metrics));
+    frame[DEBUG_UART_FRAME_HEADER_SIZE + sizeof(metrics)] = (uint8_t)(crc & 0xFF);
+    frame[DEBUG_UART_FRAME_HEADER_SIZE + sizeof(metrics) + 1] = (uint8_t)(crc >> 8);
+
+#if ENABLE_TKO_TLS
+    return tko_tls_send(TKO_METRICS_SOCKET_INDEX, frame, sizeof(frame), &sent);
+#else
+    return cy_socket_send(global_socket[TKO_METRICS_SOCKET_INDEX], frame, sizeof(frame), CY_SOCKET_FLAGS_NONE, &sent);
+#endif
+}
+
+/********************************************************************************
+ * Function Name: tko_metrics_serve
+ ********************************************************************************
+ * Summary:
+ *  Reads the data received on the metrics socket, and answers with one
+ *  metrics frame if it holds a request. It is run by the wake dispatcher for
+ *  a wake on data received on TKO_METRICS_SOCKET_INDEX, so the answer goes
+ *  out in the same awake window as the request. Each read waits at most
+ *  TKO_METRICS_RECV_TIMEOUT_MS, or TKO_TLS_RECV_TIMEOUT_MS over TLS.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_metrics_serve(void)
+{
+    uint8_t buffer[TKO_METRICS_RECV_CHUNK_SIZE];
+    uint32_t requests = 0;
+    uint32_t received = 0;
+    cy_rslt_t result;
+
+    if (NULL == global_socket[TKO_METRICS_SOCKET_INDEX])
+    {
+        return;
+    }
+
+#if !ENABLE_TKO_TLS
+    {
+        uint32_t timeout_ms = TKO_METRICS_RECV_TIMEOUT_MS;
+
+        (void)cy_socket_setsockopt(global_socket[TKO_METRICS_SOCKET_INDEX], CY_SOCKET_SOL_SOCKET,
+                                   CY_SOCKET_SO_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+    }
+#endif
+
+    do
+    {
+#if ENABLE_TKO_TLS
+        result = tko_tls_recv(TKO_METRICS_SOCKET_INDEX, buffer, sizeof(buffer), &received);
+#else
+        result = cy_socket_recv(global_socket[TKO_METRICS_SOCKET_INDEX], buffer, sizeof(buffer),
+                                CY_SOCKET_FLAGS_NONE, &received);
+#endif
+
+        if (CY_RSLT_SUCCESS == result)
+        {
+            requests += tko_metrics_parse(buffer, received);
+        }
+    } while ((CY_RSLT_SUCCESS == result) && (0 != received));
+
+    if (0 == requests)
+    {
+        return;
+    }
+
+    result = tko_metrics_send();
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Socket[%d]: Failed to send the metrics. Error code:%"PRIu32"\n", TKO_METRICS_SOCKET_INDEX, result));
+    }
+}
+
+#endif /* ENABLE_TKO_METRICS */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,111 @@
+/******************************************************************************
+* File Name:   tko_metrics.h
+*
+* Description: Answers the metrics requests received on a TCP Keepalive
+*              connection with a binary frame of the power and connection
+*              counters of the device.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TKO_METRICS_H
+#define TKO_METRICS_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Frame types, in the frame format of the debug UART (see debug_uart.c) */
+#define TKO_METRICS_FRAME_TYPE                   (0x02)
+#define TKO_METRICS_REQUEST_FRAME_TYPE           (0x03)
+
+/* Layout version of the metrics payload */
+#define TKO_METRICS_VERSION                      (1)
+
+/* Wake reasons and lwIP pools in the payload */
+#define TKO_METRICS_WAKE_REASONS                 (4)
+#define TKO_METRICS_POOLS                        (4)
+
+/* High-water mark of a pool when the lwIP statistics are not built in */
+#define TKO_METRICS_POOL_UNKNOWN                 (0xFFFF)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Layout of the metrics payload. All fields are little-endian. */
+typedef struct __attribute__((packed))
+{
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t uptime_s;
+
+    /* wait_net_suspend() calls, and the resumes from a suspend */
+    uint32_t suspend_calls;
+    uint32_t resume_count;
+
+    /* Time spent awake between suspends, waiting for inactivity, and suspended */
+    uint32_t awake_s;
+    uint32_t waiting_s;
+    uint32_t suspended_s;
+    uint32_t resume_latency_max_us;
+
+    /* TCP Keepalive connections lost and recovered */
+    uint32_t connection_losses;
+    uint32_t reconnects;
+
+    /* FreeRTOS heap: free now, and lowest free since the start */
+    uint32_t heap_free;
+    uint32_t heap_free_min;
+
+    /* High-water marks of the TCP PCB, TCP segment, pbuf and netconn pools */
+    uint16_t pool_max[TKO_METRICS_POOLS];
+
+    /* Wakes by reason, see wake_reason_t */
+    uint32_t wakes[TKO_METRICS_WAKE_REASONS];
+} tko_metrics_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void tko_metrics_get(tko_metrics_t *metrics);
+void tko_metrics_serve(void);
+
+#endif /* TKO_METRICS_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,540 @@
+/******************************************************************************
+* File Name:   tko_packet_filter.c
+*
+* Description: This file builds WLAN packet filters from the TCP Keepalive
+*              port table, so that only the traffic of the TCP Keepalive
+*              servers wakes the host while the network stack is suspended.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/ip_addr.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip6.h"
+
+/* Wi-Fi Host Driver header file */
+#include "whd_wifi_api.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "debug_uart.h"
+#include "offload_registry.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_packet_filter.h"
+
+#if ENABLE_TKO_PACKET_FILTER
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* The patterns start at the EtherType of the Ethernet frame */
+#define TKO_PF_PATTERN_OFFSET             (12)
+#define TKO_PF_PATTERN_MAX                (46)
+
+/* Offsets in the Ethernet frame, for an IPv4 header without options */
+#define TKO_PF_ETHERTYPE                  (12)
+#define TKO_PF_IPV4_VERSION_IHL           (14)
+#define TKO_PF_IPV4_PROTOCOL              (23)
+#define TKO_PF_IPV4_SOURCE                (26)
+#define TKO_PF_IPV4_TCP_PORTS             (34)
+#define TKO_PF_ARP_SENDER_IP              (28)
+
+/* Offsets in the Ethernet frame, for an IPv6 header without extension headers */
+#define TKO_PF_IPV6_VERSION               (14)
+#define TKO_PF_IPV6_NEXT_HEADER           (20)
+#define TKO_PF_IPV6_SOURCE                (22)
+#define TKO_PF_IPV6_PAYLOAD               (54)
+
+#define TKO_PF_ETHERTYPE_IPV4             (0x0800)
+#define TKO_PF_ETHERTYPE_ARP              (0x0806)
+#define TKO_PF_ETHERTYPE_IPV6             (0x86DD)
+#define TKO_PF_ICMPV6_NEIGHBOR_SOLICIT    (135)
+
+/* One filter for each TCP Keepalive port, the gateway ARP, and IPv6 neighbor discovery */
+#define TKO_PF_FILTER_ARP                 (MAX_TKO)
+#define TKO_PF_FILTER_ND                  (MAX_TKO + 1)
+#define TKO_PF_FILTER_COUNT               (MAX_TKO + 2)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    bool installed;
+    bool enabled;
+    uint16_t size;
+    uint8_t mask[TKO_PF_PATTERN_MAX];
+    uint8_t pattern[TKO_PF_PATTERN_MAX];
+} tko_pf_filter_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static tko_pf_filter_t filters[TKO_PF_FILTER_COUNT];
+
+/* Gateway and port table generation the filters were built for */
+static ip4_addr_t built_gateway;
+static uint32_t built_generation = 0;
+static bool built = false;
+
+/* Number of suspends with the filters enabled */
+static uint32_t filtered_suspends = 0;
+
+/********************************************************************************
+ * Function Name: tko_pf_match
+ ********************************************************************************
+ * Summary:
+ *  Adds bytes that must match, under the given mask, to the pattern of a filter.
+ *
+ * Parameters:
+ *  filter: Filter to add the bytes to.
+ *  frame_offset: Offset of the bytes in the Ethernet frame.
+ *  bytes: Bytes to match.
+ *  length: Number of bytes.
+ *  mask: Mask applied to each byte.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_match(tko_pf_filter_t *filter, uint16_t frame_offset, const uint8_t *bytes,
+                         uint16_t length, uint8_t mask)
+{
+    uint16_t position = frame_offset - TKO_PF_PATTERN_OFFSET;
+    uint16_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        filter->pattern[position + index] = bytes[index] & mask;
+        filter->mask[position + index] = mask;
+    }
+
+    if (filter->size < (position + length))
+    {
+        filter->size = position + length;
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_match_u16
+ ********************************************************************************
+ * Summary:
+ *  Adds a 16-bit field in network byte order to the pattern of a filter.
+ *
+ * Parameters:
+ *  filter: Filter to add the field to.
+ *  frame_offset: Offset of the field in the Ethernet frame.
+ *  value: Value of the field, in host byte order.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_match_u16(tko_pf_filter_t *filter, uint16_t frame_offset, uint16_t value)
+{
+    uint8_t bytes[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+
+    tko_pf_match(filter, frame_offset, bytes, sizeof(bytes), 0xFF);
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_build_port
+ ********************************************************************************
+ * Summary:
+ *  Builds the filter that lets the TCP segments from the server of a TCP
+ *  Keepalive port through: the remote address and port as the source, and the
+ *  local port as the destination.
+ *
+ * Parameters:
+ *  filter: Filter to build.
+ *  remote_addr: Remote IP address of the port.
+ *  port: Port entry of the TCP Keepalive configuration.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_build_port(tko_pf_filter_t *filter, const ip_addr_t *remote_addr, const cy_tko_ol_connect_t *port)
+{
+    uint8_t value;
+    uint16_t ports_offset;
+
+    memset(filter, 0, sizeof(*filter));
+
+    if (IP_IS_V6(remote_addr))
+    {
+        tko_pf_match_u16(filter, TKO_PF_ETHERTYPE, TKO_PF_ETHERTYPE_IPV6);
+        value = 0x60;
+        tko_pf_match(filter, TKO_PF_IPV6_VERSION, &value, 1, 0xF0);
+        value = IP_PROTO_TCP;
+        tko_pf_match(filter, TKO_PF_IPV6_NEXT_HEADER, &value, 1, 0xFF);
+        tko_pf_match(filter, TKO_PF_IPV6_SOURCE, (const uint8_t *)ip_2_ip6(remote_addr)->addr, 16, 0xFF);
+        ports_offset = TKO_PF_IPV6_PAYLOAD;
+    }
+    else
+    {
+        tko_pf_match_u16(filter, TKO_PF_ETHERTYPE, TKO_PF_ETHERTYPE_IPV4);
+        value = 0x45;
+        tko_pf_match(filter, TKO_PF_IPV4_VERSION_IHL, &value, 1, 0xFF);
+        value = IP_PROTO_TCP;
+        tko_pf_match(filter, TKO_PF_IPV4_PROTOCOL, &value, 1, 0xFF);
+        tko_pf_match(filter, TKO_PF_IPV4_SOURCE, (const uint8_t *)&ip_2_ip4(remote_addr)->addr, 4, 0xFF);
+        ports_offset = TKO_PF_IPV4_TCP_PORTS;
+    }
+
+    tko_pf_match_u16(filter, ports_offset, port->remote_port);
+    tko_pf_match_u16(filter, ports_offset + 2, port->local_port);
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_install
+ ********************************************************************************
+ * Summary:
+ *  Adds a built filter to the WLAN firmware as a positive match filter, which
+ *  is left disabled until the next suspend. A filter with the same ID is
+ *  replaced.
+ *
+ * Parameters:
+ *  ifp: WHD interface of the STA.
+ *  slot: Index of the filter in filters[].
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_install(whd_interface_t ifp, int slot)
+{
+    tko_pf_filter_t *filter = &filters[slot];
+    whd_packet_filter_t settings;
+    whd_result_t result;
+
+    settings.id = TKO_PF_FILTER_ID_BASE + slot;
+    settings.rule = WHD_FILTER_RULE_POSITIVE_MATCHING;
+    settings.offset = TKO_PF_PATTERN_OFFSET;
+    settings.mask_size = filter->size;
+    settings.mask = filter->mask;
+    settings.pattern = filter->pattern;
+
+    (void)whd_pf_remove_packet_filter(ifp, (uint8_t)settings.id);
+    result = whd_pf_add_packet_filter(ifp, &settings);
+
+    filter->installed = (WHD_SUCCESS == result);
+    filter->enabled = false;
+
+    if (!filter->installed)
+    {
+        ERR_INFO(("Packet filter %"PRIu32": add failed. Error code:%"PRIu32"\n", settings.id, (uint32_t)result));
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_uninstall
+ ********************************************************************************
+ * Summary:
+ *  Removes a filter from the WLAN firmware, such as the filter of a port that
+ *  is no longer valid, and clears its pattern so that it can be built again.
+ *
+ * Parameters:
+ *  ifp: WHD interface of the STA.
+ *  slot: Index of the filter in filters[].
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_uninstall(whd_interface_t ifp, int slot)
+{
+    if (filters[slot].installed)
+    {
+        (void)whd_pf_remove_packet_filter(ifp, (uint8_t)(TKO_PF_FILTER_ID_BASE + slot));
+    }
+
+    memset(&filters[slot], 0, sizeof(filters[slot]));
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_build
+ ********************************************************************************
+ * Summary:
+ *  Builds and installs the filters: one for each valid TCP Keepalive port, one
+ *  for the ARP packets sent by the gateway, and, when a server is on IPv6, one
+ *  for the neighbor solicitations that resolve the address of the device.
+ *
+ * Parameters:
+ *  ifp: WHD interface of the STA.
+ *  gateway: IPv4 address of the gateway, or 0.0.0.0 if there is none.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_build(whd_interface_t ifp, const ip4_addr_t *gateway)
+{
+    const ip_addr_t *remote_addr;
+    tko_pf_filter_t *filter;
+    uint8_t value;
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        remote_addr = offload_registry_tko_remote_addr(index);
+
+        if (NULL != remote_addr)
+        {
+            tko_pf_build_port(&filters[index], remote_addr, &tko_runtime_cfg.ports[index]);
+            tko_pf_install(ifp, index);
+        }
+        else
+        {
+            tko_pf_uninstall(ifp, index);
+        }
+    }
+
+    tko_pf_uninstall(ifp, TKO_PF_FILTER_ARP);
+    filter = &filters[TKO_PF_FILTER_ARP];
+
+    if (!ip4_addr_isany(gateway))
+    {
+        tko_pf_match_u16(filter, TKO_PF_ETHERTYPE, TKO_PF_ETHERTYPE_ARP);
+        tko_pf_match(filter, TKO_PF_ARP_SENDER_IP, (const uint8_t *)&gateway->addr, 4, 0xFF);
+        tko_pf_install(ifp, TKO_PF_FILTER_ARP);
+    }
+
+    tko_pf_uninstall(ifp, TKO_PF_FILTER_ND);
+    filter = &filters[TKO_PF_FILTER_ND];
+
+    if (offload_registry_tko_has_ipv6())
+    {
+        tko_pf_match_u16(filter, TKO_PF_ETHERTYPE, TKO_PF_ETHERTYPE_IPV6);
+        value = IP6_NEXTH_ICMP6;
+        tko_pf_match(filter, TKO_PF_IPV6_NEXT_HEADER, &value, 1, 0xFF);
+        value = TKO_PF_ICMPV6_NEIGHBOR_SOLICIT;
+        tko_pf_match(filter, TKO_PF_IPV6_PAYLOAD, &value, 1, 0xFF);
+        tko_pf_install(ifp, TKO_PF_FILTER_ND);
+    }
+
+    ip4_addr_copy(built_gateway, *gateway);
+    built_generation = offload_registry_tko_generation();
+    built = true;
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the counters of each filter kept by the WLAN firmware. A packet that
+ *  no filter lets through is discarded by the firmware instead of waking the
+ *  host, so the discarded count is the number of wakes avoided.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_pf_report(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    whd_pkt_filter_stats_t stats;
+    uint32_t discarded = 0;
+    int slot;
+
+    if ((NULL == netif) || (NULL == netif->state))
+    {
+        return;
+    }
+
+    APP_INFO(("Filter      ID  Matched  Forwarded  Discarded\n"));
+
+    for (slot = 0; slot < TKO_PF_FILTER_COUNT; slot++)
+    {
+        if (!filters[slot].installed)
+        {
+            continue;
+        }
+
+        memset(&stats, 0, sizeof(stats));
+        (void)whd_pf_get_packet_filter_stats((whd_interface_t)netif->state, TKO_PF_FILTER_ID_BASE + slot, &stats);
+
+        if (slot < MAX_TKO)
+        {
+            APP_INFO(("Socket[%d] %4d %8"PRIu32" %10"PRIu32" %10"PRIu32"\n", slot, TKO_PF_FILTER_ID_BASE + slot,
+                      stats.num_pkts_matched, stats.num_pkts_forwarded, stats.num_pkts_discarded));
+        }
+        else
+        {
+            APP_INFO(("%-9s %4d %8"PRIu32" %10"PRIu32" %10"PRIu32"\n", (TKO_PF_FILTER_ARP == slot) ? "ARP" : "IPv6 ND",
+                      TKO_PF_FILTER_ID_BASE + slot, stats.num_pkts_matched, stats.num_pkts_forwarded,
+                      stats.num_pkts_discarded));
+        }
+
+        /* Each filter counts all the packets discarded while the filters are enabled */
+        if (stats.num_pkts_discarded > discarded)
+        {
+            discarded = stats.num_pkts_discarded;
+        }
+    }
+
+    APP_INFO(("Suspends filtered: %"PRIu32", wakes avoided: %"PRIu32"\n", filtered_suspends, discarded));
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_init
+ ********************************************************************************
+ * Summary:
+ *  Registers the debug UART command that prints the filter counters. The
+ *  filters themselves are built at the first suspend, once the port table and
+ *  the gateway are known.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_pf_init(void)
+{
+    debug_uart_register_command(TKO_PF_REPORT_COMMAND, tko_pf_report);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_suspend_begin
+ ********************************************************************************
+ * Summary:
+ *  Enables the filters before the network stack is suspended, so that only
+ *  the TCP Keepalive servers, the gateway ARP, and the IPv6 neighbor discovery
+ *  can wake the host. The filters are rebuilt first if the gateway or the
+ *  TCP Keepalive port table changed, such as after the session manager moved
+ *  a session into a firmware slot. Nothing is filtered if no port is valid.
+ *  When the last port is released, the filters of the previous build are
+ *  left disabled in the firmware.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_pf_suspend_begin(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    whd_interface_t ifp;
+    ip4_addr_t gateway;
+    int slot;
+
+    if ((NULL == netif) || (NULL == netif->state) || (0 == offload_registry_tko_port_count()))
+    {
+        return;
+    }
+
+    ifp = (whd_interface_t)netif->state;
+
+    LOCK_TCPIP_CORE();
+    ip4_addr_copy(gateway, *netif_ip4_gw(netif));
+    UNLOCK_TCPIP_CORE();
+
+    if (!built || !ip4_addr_cmp(&gateway, &built_gateway) ||
+        (built_generation != offload_registry_tko_generation()))
+    {
+        tko_pf_build(ifp, &gateway);
+    }
+
+    for (slot = 0; slot < TKO_PF_FILTER_COUNT; slot++)
+    {
+        if (filters[slot].installed)
+        {
+            filters[slot].enabled = (WHD_SUCCESS == whd_pf_enable_packet_filter(ifp, TKO_PF_FILTER_ID_BASE + slot));
+        }
+    }
+
+    filtered_suspends++;
+}
+
+/********************************************************************************
+ * Function Name: tko_pf_resume
+ ********************************************************************************
+ * Summary:
+ *  Disables the filters once the network stack has resumed, so that the host
+ *  receives all the traffic, such as DHCP and DNS, while it is awake.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_pf_resume(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    int slot;
+
+    if ((NULL == netif) || (NULL == netif->state))
+    {
+        return;
+    }
+
+    for (slot = 0; slot < TKO_PF_FILTER_COUNT; slot++)
+    {
+        if (filters[slot].enabled)
+        {
+            (void)whd_pf_disable_packet_filter((whd_interface_t)netif->state, TKO_PF_FILTER_ID_BASE + slot);
+            filters[slot].enabled = false;
+        }
+    }
+}
+
+#endif /* ENABLE_TKO_PACKET_FILTER */
+
+
+/* [] END OF FILE */
+
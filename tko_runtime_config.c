@@ -0,0 +1,362 @@
+/******************************************************************************
+* File Name:   tko_runtime_config.c
+*
+* Description: This file changes the keepalive interval and retry parameters
+*              of live TCP connections and reprograms the WLAN offload in
+*              place, without reconnecting the sockets.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header file */
+#include "cy_lwip.h"
+
+/* Socket management header file */
+#include "cy_secure_sockets.h"
+
+/* Wi-Fi Host Driver header file */
+#include "whd_wifi_api.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "tcp_keepalive_offload.h"
+#include "network_suspend_scheduler.h"
+#include "tko_runtime_config.h"
+#include "warm_boot.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Parameters requested for each connection */
+static tko_keepalive_params_t connection_params[MAX_TKO];
+static bool connection_params_valid = false;
+
+/********************************************************************************
+ * Function Name: tko_init_connection_params
+ ********************************************************************************
+ * Summary:
+ *  Initializes the parameters of every connection to the configurator-generated
+ *  values held in the runtime TCP Keepalive configuration.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_init_connection_params(void)
+{
+    int index;
+
+    /* Nothing to take the defaults from until the configuration is loaded */
+    if (connection_params_valid || (0 == tko_runtime_cfg.interval))
+    {
+        return;
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        connection_params[index].interval = tko_runtime_cfg.interval;
+        connection_params[index].retry_interval = tko_runtime_cfg.retry_interval;
+        connection_params[index].retry_count = tko_runtime_cfg.retry_count;
+    }
+
+    connection_params_valid = true;
+}
+
+/********************************************************************************
+ * Function Name: tko_get_offload_params
+ ********************************************************************************
+ * Summary:
+ *  Computes the parameters to program in the WLAN firmware. The firmware holds
+ *  a single set of parameters for all the offloaded connections, so the set
+ *  that satisfies every connected socket is used: the shortest interval and
+ *  retry interval, and the largest retry count.
+ *
+ * Parameters:
+ *  params: Filled in with the parameters for the WLAN offload.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_get_offload_params(tko_keepalive_params_t *params)
+{
+    int index;
+    bool found = false;
+
+    tko_init_connection_params();
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (NULL == global_socket[index])
+        {
+            continue;
+        }
+
+        if (!found)
+        {
+            *params = connection_params[index];
+            found = true;
+            continue;
+        }
+
+        if (connection_params[index].interval < params->interval)
+        {
+            params->interval = connection_params[index].interval;
+        }
+
+        if (connection_params[index].retry_interval < params->retry_interval)
+        {
+            params->retry_interval = connection_params[index].retry_interval;
+        }
+
+        if (connection_params[index].retry_count > params->retry_count)
+        {
+            params->retry_count = connection_params[index].retry_count;
+        }
+    }
+
+    if (!found)
+    {
+        params->interval = tko_runtime_cfg.interval;
+        params->retry_interval = tko_runtime_cfg.retry_interval;
+        params->retry_count = tko_runtime_cfg.retry_count;
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_apply_host_keepalive
+ ********************************************************************************
+ * Summary:
+ *  Applies the parameters to the lwIP keepalive of a socket. Only used when the
+ *  Host TCP keepalive is enabled with ENABLE_HOST_TCP_KEEPALIVE.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, a socket error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t tko_apply_host_keepalive(int index)
+{
+    cy_rslt_t result;
+    uint32_t value;
+
+    value = (uint32_t)connection_params[index].interval * 1000u;
+    result = cy_socket_setsockopt(global_socket[index], CY_SOCKET_SOL_TCP,
+                                  CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME, &value, sizeof(value));
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        value = (uint32_t)connection_params[index].retry_interval * 1000u;
+        result = cy_socket_setsockopt(global_socket[index], CY_SOCKET_SOL_TCP,
+                                      CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL, &value, sizeof(value));
+    }
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        value = connection_params[index].retry_count;
+        result = cy_socket_setsockopt(global_socket[index], CY_SOCKET_SOL_TCP,
+                                      CY_SOCKET_SO_TCP_KEEPALIVE_COUNT, &value, sizeof(value));
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: tko_apply_offload_params
+ ********************************************************************************
+ * Summary:
+ *  Updates the runtime TCP Keepalive configuration used by the LPA middleware
+ *  when it enables the offload, and writes the parameters to the WLAN firmware.
+ *  If the offload is currently enabled, it is toggled so that the firmware picks
+ *  up the new parameters for the connections it already holds.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, a WHD error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t tko_apply_offload_params(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    whd_interface_t ifp;
+    tko_keepalive_params_t params;
+    cy_rslt_t result;
+    bool offloaded = net_suspend_scheduler_is_offloaded();
+
+    tko_get_offload_params(&params);
+
+    tko_runtime_cfg.interval = params.interval;
+    tko_runtime_cfg.retry_interval = params.retry_interval;
+    tko_runtime_cfg.retry_count = params.retry_count;
+
+    if ((NULL == netif) || (NULL == netif->state))
+    {
+        /* Not connected yet; the parameters are used at the next offload enable */
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* The lwIP STA interface carries the WHD interface as its state */
+    ifp = (whd_interface_t)netif->state;
+
+    if (offloaded)
+    {
+        whd_tko_toggle(ifp, WHD_FALSE);
+    }
+
+    result = whd_tko_param(ifp, params.interval, params.retry_interval, params.retry_count);
+
+    if (offloaded)
+    {
+        whd_tko_toggle(ifp, WHD_TRUE);
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: tko_set_keepalive_params
+ ********************************************************************************
+ * Summary:
+ *  Changes the keepalive interval and retry parameters of a live connection in
+ *  global_socket[] without tearing down the TCP session. The WLAN offload is
+ *  reprogrammed in place, see tko_get_offload_params() for how the parameters
+ *  of several connections are combined.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *  params: New keepalive parameters, in seconds.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, CY_RSLT_TYPE_ERROR if the index or the
+ *  parameters are invalid or the socket is not connected, a socket or WHD error
+ *  code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_set_keepalive_params(int index, const tko_keepalive_params_t *params)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((index < 0) || (index >= MAX_TKO) || (NULL == params) || (NULL == global_socket[index]))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    if ((0 == params->interval) || (params->interval > TKO_KEEPALIVE_INTERVAL_MAX_S) ||
+        (0 == params->retry_interval) || (params->retry_interval > params->interval) ||
+        (0 == params->retry_count) || (params->retry_count > TKO_KEEPALIVE_RETRY_COUNT_MAX))
+    {
+        ERR_INFO(("Socket[%d]: Invalid keepalive parameters interval %d, retry interval %d, "
+                  "retry count %d\n", index, params->interval, params->retry_interval, params->retry_count));
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    tko_init_connection_params();
+    connection_params[index] = *params;
+
+    if (ENABLE_HOST_TCP_KEEPALIVE)
+    {
+        result = tko_apply_host_keepalive(index);
+    }
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        result = tko_apply_offload_params();
+    }
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        ERR_INFO(("Socket[%d]: Unable to apply keepalive parameters. Error code:%"PRIu32"\n", index, result));
+    }
+    else
+    {
+        APP_INFO(("Socket[%d]: Keepalive interval %d s, retry interval %d s, retry count %d\n",
+                  index, params->interval, params->retry_interval, params->retry_count));
+
+#if ENABLE_WARM_BOOT
+        /* Keep the new parameters across a reset */
+        (void)warm_boot_save();
+#endif
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: tko_get_keepalive_params
+ ********************************************************************************
+ * Summary:
+ *  Returns the keepalive parameters requested for a connection.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *  params: Filled in with the keepalive parameters, in seconds.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, CY_RSLT_TYPE_ERROR if the index is
+ *  invalid.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_get_keepalive_params(int index, tko_keepalive_params_t *params)
+{
+    if ((index < 0) || (index >= MAX_TKO) || (NULL == params))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    tko_init_connection_params();
+    *params = connection_params[index];
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,78 @@
+/******************************************************************************
+* File Name:   tko_runtime_config.h
+*
+* Description: This file is the public interface of tko_runtime_config.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TKO_RUNTIME_CONFIG_H
+#define TKO_RUNTIME_CONFIG_H
+
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Limits of the keepalive parameters in seconds */
+#define TKO_KEEPALIVE_INTERVAL_MAX_S             (3600)
+#define TKO_KEEPALIVE_RETRY_COUNT_MAX            (10)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Keepalive parameters of a TCP connection. Intervals are in seconds. */
+typedef struct
+{
+    uint16_t interval;
+    uint16_t retry_interval;
+    uint16_t retry_count;
+} tko_keepalive_params_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tko_set_keepalive_params(int index, const tko_keepalive_params_t *params);
+cy_rslt_t tko_get_keepalive_params(int index, tko_keepalive_params_t *params);
+void tko_get_offload_params(tko_keepalive_params_t *params);
+
+#endif /* TKO_RUNTIME_CONFIG_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,741 @@
+/******************************************************************************
+* File Name:   tko_session_manager.c
+*
+* Description: This file implements a connection manager that serves more TCP
+*              Keepalive sessions than the WLAN firmware has offload slots.
+*              The most recently active sessions are kept in the firmware TCP
+*              Keepalive slots, and the others are kept alive by the host
+*              with keepalive probes that are batched into one wake-up per
+*              coalescing window. Sessions are promoted and demoted between
+*              the two modes based on their data activity.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+/* LPA header files */
+#include "cy_OlmInterface.h"
+#include "network_activity_handler.h"
+
+/* lwIP header files */
+#include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+
+/* Socket management header file */
+#include "cy_secure_sockets.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "offload_registry.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_health.h"
+#include "tko_session_manager.h"
+#include "tko_zero_copy.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    TKO_SESSION_FREE = 0,
+    TKO_SESSION_OFFLOADED,   /* Held in a firmware TCP Keepalive slot */
+    TKO_SESSION_HOST,        /* Kept alive by the coalesced host probes */
+    TKO_SESSION_DOWN         /* Lost, to be connected again */
+} tko_session_state_t;
+
+typedef struct
+{
+    tko_session_state_t state;
+    cy_tko_ol_connect_t endpoint;
+    struct cy_socket_ctx_t *socket;   /* Socket, when not in a firmware slot */
+    int slot;                         /* Firmware slot, or -1 */
+    TickType_t last_active;           /* Last time data was sent or received */
+    TickType_t last_rx;               /* Last time a segment was received */
+    uint32_t snd_nxt;
+    uint32_t rcv_nxt;
+    uint32_t rx_tmr;
+} tko_session_t;
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define TKO_SESSION_WINDOW_TICKS          pdMS_TO_TICKS(TKO_SESSION_KEEPALIVE_WINDOW_MS)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static tko_session_t sessions[TKO_SESSION_MAX];
+static SemaphoreHandle_t session_mutex = NULL;
+
+/* Firmware slots handed over to the manager */
+static uint32_t managed_slots = 0;
+
+#ifdef TKO_SESSION_EXTRA_SERVERS
+/* Sessions opened by the manager in addition to the configured connections */
+static const cy_tko_ol_connect_t extra_servers[] = TKO_SESSION_EXTRA_SERVERS;
+#endif
+
+/********************************************************************************
+ * Function Name: tko_session_connect
+ ********************************************************************************
+ * Summary:
+ *  Connects the socket of a session. The lwIP keepalive is left disabled, as
+ *  the session is kept alive either by the firmware or by the manager.
+ *
+ * Parameters:
+ *  session: Session to connect.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, a socket error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t tko_session_connect(tko_session_t *session)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+
+    return cy_tcp_create_socket_connection(netif,
+                                           (void **)&session->socket,
+                                           session->endpoint.remote_ip,
+                                           session->endpoint.remote_port,
+                                           session->endpoint.local_port,
+                                           &tko_runtime_cfg,
+                                           0);
+}
+
+/********************************************************************************
+ * Function Name: tko_session_free_slot
+ ********************************************************************************
+ * Summary:
+ *  Returns a managed firmware slot that holds no session.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  int: Index of the slot, or -1 if all the managed slots are in use.
+ *
+ *******************************************************************************/
+static int tko_session_free_slot(void)
+{
+    uint32_t used = 0;
+    int index;
+
+    for (index = 0; index < TKO_SESSION_MAX; index++)
+    {
+        if (TKO_SESSION_OFFLOADED == sessions[index].state)
+        {
+            used |= (1u << sessions[index].slot);
+        }
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if ((managed_slots & ~used) & (1u << index))
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/********************************************************************************
+ * Function Name: tko_session_promote
+ ********************************************************************************
+ * Summary:
+ *  Moves a host kept session into a firmware slot. The slot entry of the runtime
+ *  TCP Keepalive configuration is rewritten, so the LPA middleware offloads the
+ *  session the next time the network stack is suspended. The registry and the
+ *  health monitor take the new entry of the slot.
+ *
+ * Parameters:
+ *  session: Session to promote.
+ *  slot: Free firmware slot.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_session_promote(tko_session_t *session, int slot)
+{
+    memcpy(&tko_runtime_cfg.ports[slot], &session->endpoint, sizeof(tko_runtime_cfg.ports[slot]));
+    global_socket[slot] = session->socket;
+    (void)offload_registry_tko_port_set(slot, &session->endpoint);
+    tko_health_claim(slot);
+
+    session->socket = NULL;
+    session->slot = slot;
+    session->state = TKO_SESSION_OFFLOADED;
+
+    /* The slot's receive callback now applies to this session */
+    tko_zc_attach(slot);
+}
+
+/********************************************************************************
+ * Function Name: tko_session_demote
+ ********************************************************************************
+ * Summary:
+ *  Takes a session out of its firmware slot, to be kept alive by the host.
+ *
+ * Parameters:
+ *  session: Offloaded session to demote.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_session_demote(tko_session_t *session)
+{
+    uint32_t value = 0;
+
+    session->socket = global_socket[session->slot];
+    global_socket[session->slot] = NULL;
+    session->slot = -1;
+    session->state = TKO_SESSION_HOST;
+    session->last_rx = xTaskGetTickCount();
+
+    /* The sessions adopted from the bring-up may have the lwIP keepalive enabled */
+    cy_socket_setsockopt(session->socket, CY_SOCKET_SOL_SOCKET,
+                         CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE, &value, sizeof(value));
+}
+
+/********************************************************************************
+ * Function Name: tko_session_poll
+ ********************************************************************************
+ * Summary:
+ *  Updates the activity of every session from its lwIP PCB, and sends one
+ *  keepalive probe on each host kept session that has received nothing for a
+ *  coalescing window. All the probes of a window go out in one burst. Host
+ *  kept sessions that have received nothing for TKO_SESSION_HOST_TIMEOUT_MS
+ *  are marked down. The session mutex must be held by the caller.
+ *
+ * Parameters:
+ *  now: Current tick count.
+ *
+ * Return:
+ *  uint32_t: Number of probes sent.
+ *
+ *******************************************************************************/
+static uint32_t tko_session_poll(TickType_t now)
+{
+    tko_session_t *session;
+    struct tcp_pcb *pcb;
+    uint32_t probes = 0;
+    int index;
+
+    LOCK_TCPIP_CORE();
+
+    for (index = 0; index < TKO_SESSION_MAX; index++)
+    {
+        session = &sessions[index];
+
+        if ((TKO_SESSION_OFFLOADED != session->state) && (TKO_SESSION_HOST != session->state))
+        {
+            continue;
+        }
+
+        pcb = tcp_socket_find_pcb(&session->endpoint);
+
+        if ((NULL == pcb) || (ESTABLISHED != pcb->state))
+        {
+            /* Lost offloaded sessions are reconnected by the slot owner */
+            if (TKO_SESSION_HOST == session->state)
+            {
+                session->state = TKO_SESSION_DOWN;
+            }
+
+            continue;
+        }
+
+        if ((pcb->snd_nxt != session->snd_nxt) || (pcb->rcv_nxt != session->rcv_nxt))
+        {
+            session->snd_nxt = pcb->snd_nxt;
+            session->rcv_nxt = pcb->rcv_nxt;
+            session->last_active = now;
+        }
+
+        /* lwIP restarts the PCB timer on every segment received */
+        if (pcb->tmr != session->rx_tmr)
+        {
+            session->rx_tmr = pcb->tmr;
+            session->last_rx = now;
+        }
+
+        if (TKO_SESSION_HOST != session->state)
+        {
+            continue;
+        }
+
+        if ((now - session->last_rx) >= pdMS_TO_TICKS(TKO_SESSION_HOST_TIMEOUT_MS))
+        {
+            ERR_INFO(("Session %d to %s:%d timed out.\n", index,
+                      session->endpoint.remote_ip, session->endpoint.remote_port));
+            session->state = TKO_SESSION_DOWN;
+        }
+        else if ((now - session->last_rx) >= TKO_SESSION_WINDOW_TICKS)
+        {
+            tcp_keepalive(pcb);
+            probes++;
+        }
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+    return probes;
+}
+
+/********************************************************************************
+ * Function Name: tko_session_rebalance
+ ********************************************************************************
+ * Summary:
+ *  Fills the free firmware slots with the most recently active host kept
+ *  sessions, then swaps the most recently active host kept session with the
+ *  least recently active offloaded session when it has been active more
+ *  recently by at least TKO_SESSION_PROMOTE_HYSTERESIS_MS. One swap is made per
+ *  window, which keeps the slots from thrashing. The session mutex must be held
+ *  by the caller.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool: true if a slot has changed.
+ *
+ *******************************************************************************/
+static bool tko_session_rebalance(void)
+{
+    tko_session_t *hottest_host;
+    tko_session_t *coldest_offloaded;
+    bool changed = false;
+    int slot;
+    int index;
+
+    do
+    {
+        hottest_host = NULL;
+        coldest_offloaded = NULL;
+
+        for (index = 0; index < TKO_SESSION_MAX; index++)
+        {
+            if ((TKO_SESSION_HOST == sessions[index].state) &&
+                ((NULL == hottest_host) || ((int32_t)(sessions[index].last_active - hottest_host->last_active) > 0)))
+            {
+                hottest_host = &sessions[index];
+            }
+            else if ((TKO_SESSION_OFFLOADED == sessions[index].state) &&
+                     ((NULL == coldest_offloaded) || ((int32_t)(sessions[index].last_active - coldest_offloaded->last_active) < 0)))
+            {
+                coldest_offloaded = &sessions[index];
+            }
+        }
+
+        if (NULL == hottest_host)
+        {
+            return changed;
+        }
+
+        slot = tko_session_free_slot();
+
+        if (slot < 0)
+        {
+            break;
+        }
+
+        tko_session_promote(hottest_host, slot);
+        changed = true;
+    } while (true);
+
+    if ((NULL != coldest_offloaded) &&
+        ((int32_t)(hottest_host->last_active - coldest_offloaded->last_active) >=
+         (int32_t)pdMS_TO_TICKS(TKO_SESSION_PROMOTE_HYSTERESIS_MS)))
+    {
+        slot = coldest_offloaded->slot;
+
+        APP_INFO(("Session %d moved to TCP Keepalive slot %d in place of session %d.\n",
+                  (int)(hottest_host - sessions), slot, (int)(coldest_offloaded - sessions)));
+
+        tko_session_demote(coldest_offloaded);
+        tko_session_promote(hottest_host, slot);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/********************************************************************************
+ * Function Name: tko_session_reopen
+ ********************************************************************************
+ * Summary:
+ *  Connects the lost host kept sessions again. The session mutex must be held
+ *  by the caller.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_session_reopen(void)
+{
+    tko_session_t *session;
+    int index;
+
+    for (index = 0; index < TKO_SESSION_MAX; index++)
+    {
+        session = &sessions[index];
+
+        if (TKO_SESSION_DOWN != session->state)
+        {
+            continue;
+        }
+
+        if (NULL != session->socket)
+        {
+            cy_socket_disconnect(session->socket, 0);
+            cy_socket_delete(session->socket);
+            session->socket = NULL;
+        }
+
+        if (CY_RSLT_SUCCESS == tko_session_connect(session))
+        {
+            APP_INFO(("Session %d to %s:%d reconnected.\n", index,
+                      session->endpoint.remote_ip, session->endpoint.remote_port));
+            session->state = TKO_SESSION_HOST;
+            session->last_rx = xTaskGetTickCount();
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_session_task
+ ********************************************************************************
+ * Summary:
+ *  Services the sessions once per coalescing window: the host keepalive probes,
+ *  the slot rebalancing, and the reconnection of lost sessions. The task blocks
+ *  for the rest of the window, so the host wakes at most once per window
+ *  whatever the number of sessions. The network stack is resumed before the
+ *  slots or the host kept sessions are touched, which also takes the
+ *  connections out of the firmware offload.
+ *
+ * Parameters:
+ *  arg: Unused.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_session_task(void *arg)
+{
+    TickType_t wake_time = xTaskGetTickCount();
+    uint32_t probes;
+    int index;
+
+    (void)arg;
+
+    while (true)
+    {
+        vTaskDelayUntil(&wake_time, TKO_SESSION_WINDOW_TICKS);
+
+        xSemaphoreTake(session_mutex, portMAX_DELAY);
+
+        for (index = 0; index < TKO_SESSION_MAX; index++)
+        {
+            if (TKO_SESSION_HOST == sessions[index].state)
+            {
+                cy_network_activity_notify(CY_NETWORK_ACTIVITY_TX);
+                break;
+            }
+        }
+
+        probes = tko_session_poll(xTaskGetTickCount());
+
+        tko_session_rebalance();
+
+        tko_session_reopen();
+
+        xSemaphoreGive(session_mutex);
+
+        if (probes > 0)
+        {
+            APP_INFO(("Sent %"PRIu32" host keepalive probes.\n", probes));
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_session_manager_init
+ ********************************************************************************
+ * Summary:
+ *  Takes over the firmware slots whose connection was established by
+ *  tcp_socket_connection_start(), opens the sessions of TKO_SESSION_EXTRA_SERVERS
+ *  and starts the session task.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the manager is started.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_session_manager_init(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    int slot;
+
+    session_mutex = xSemaphoreCreateMutex();
+
+    if (NULL == session_mutex)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    for (slot = 0; (slot < MAX_TKO) && (slot < TKO_SESSION_MAX); slot++)
+    {
+        if ((NULL == global_socket[slot]) || (CY_RSLT_SUCCESS != tcp_socket_connection_result(slot)))
+        {
+            continue;
+        }
+
+        memcpy(&sessions[slot].endpoint, &tko_runtime_cfg.ports[slot], sizeof(sessions[slot].endpoint));
+        sessions[slot].slot = slot;
+        sessions[slot].last_active = now;
+        sessions[slot].last_rx = now;
+        sessions[slot].state = TKO_SESSION_OFFLOADED;
+        managed_slots |= (1u << slot);
+    }
+
+#ifdef TKO_SESSION_EXTRA_SERVERS
+    for (slot = 0; slot < (int)(sizeof(extra_servers) / sizeof(extra_servers[0])); slot++)
+    {
+        if (TKO_SESSION_INVALID == tko_session_open(extra_servers[slot].remote_ip,
+                                                    extra_servers[slot].remote_port,
+                                                    extra_servers[slot].local_port))
+        {
+            ERR_INFO(("Failed to open the session to %s:%d.\n",
+                      extra_servers[slot].remote_ip, extra_servers[slot].remote_port));
+        }
+    }
+#endif
+
+    if (pdPASS != xTaskCreate(tko_session_task, "TkoSess", TKO_SESSION_TASK_STACK_SIZE,
+                              NULL, TKO_SESSION_TASK_PRIORITY, NULL))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_session_open
+ ********************************************************************************
+ * Summary:
+ *  Opens a TCP connection managed in a firmware slot if one is free, or kept
+ *  alive by the host otherwise.
+ *
+ * Parameters:
+ *  remote_ip: IPv4 or IPv6 address of the remote TCP server. Only IPv6 in
+ *  the IPv6-only build.
+ *  remote_port: Port of the remote TCP server.
+ *  local_port: Local port of the connection.
+ *
+ * Return:
+ *  int: ID of the session, or TKO_SESSION_INVALID on failure.
+ *
+ *******************************************************************************/
+int tko_session_open(const char *remote_ip, uint16_t remote_port, uint16_t local_port)
+{
+    tko_session_t *session = NULL;
+    ip_addr_t remote_addr;
+    int index;
+    int slot;
+
+    if ((NULL == session_mutex) || (NULL == remote_ip) ||
+        (strlen(remote_ip) >= sizeof(session->endpoint.remote_ip)) ||
+        !ipaddr_aton(remote_ip, &remote_addr) || ip_addr_isany(&remote_addr))
+    {
+        return TKO_SESSION_INVALID;
+    }
+
+#if defined(APP_IPV6_ONLY)
+    if (!IP_IS_V6(&remote_addr))
+    {
+        return TKO_SESSION_INVALID;
+    }
+#endif
+
+    xSemaphoreTake(session_mutex, portMAX_DELAY);
+
+    for (index = 0; index < TKO_SESSION_MAX; index++)
+    {
+        if (TKO_SESSION_FREE == sessions[index].state)
+        {
+            session = &sessions[index];
+            break;
+        }
+    }
+
+    if (NULL == session)
+    {
+        xSemaphoreGive(session_mutex);
+        return TKO_SESSION_INVALID;
+    }
+
+    memset(session, 0, sizeof(*session));
+    strcpy(session->endpoint.remote_ip, remote_ip);
+    session->endpoint.remote_port = remote_port;
+    session->endpoint.local_port = local_port;
+    session->slot = -1;
+
+    if (CY_RSLT_SUCCESS != tko_session_connect(session))
+    {
+        xSemaphoreGive(session_mutex);
+        return TKO_SESSION_INVALID;
+    }
+
+    session->last_active = xTaskGetTickCount();
+    session->last_rx = session->last_active;
+    session->state = TKO_SESSION_HOST;
+
+    slot = tko_session_free_slot();
+
+    if (slot >= 0)
+    {
+        tko_session_promote(session, slot);
+    }
+
+    xSemaphoreGive(session_mutex);
+
+    return index;
+}
+
+/********************************************************************************
+ * Function Name: tko_session_close
+ ********************************************************************************
+ * Summary:
+ *  Closes a session. If it held a firmware slot, the slot is released in the
+ *  health monitor and the registry first, so it is not reconnected, and its
+ *  port entry is emptied. The slot is given to the most recently active host
+ *  kept session at the next window.
+ *
+ * Parameters:
+ *  session: ID of the session.
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the session is closed.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_session_close(int session)
+{
+    tko_session_t *entry;
+
+    if ((session < 0) || (session >= TKO_SESSION_MAX) || (NULL == session_mutex))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    xSemaphoreTake(session_mutex, portMAX_DELAY);
+
+    entry = &sessions[session];
+
+    if (TKO_SESSION_OFFLOADED == entry->state)
+    {
+        tko_health_release(entry->slot);
+        offload_registry_tko_port_release(entry->slot);
+
+        memset(&tko_runtime_cfg.ports[entry->slot], 0, sizeof(tko_runtime_cfg.ports[entry->slot]));
+        strncpy(tko_runtime_cfg.ports[entry->slot].remote_ip, NULL_IP_ADDRESS,
+                sizeof(tko_runtime_cfg.ports[entry->slot].remote_ip) - 1);
+
+        entry->socket = global_socket[entry->slot];
+        global_socket[entry->slot] = NULL;
+    }
+
+    if (NULL != entry->socket)
+    {
+        cy_socket_disconnect(entry->socket, 0);
+        cy_socket_delete(entry->socket);
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->slot = -1;
+
+    xSemaphoreGive(session_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_session_get_slot
+ ********************************************************************************
+ * Summary:
+ *  Returns the firmware TCP Keepalive slot that holds a session.
+ *
+ * Parameters:
+ *  session: ID of the session.
+ *
+ * Return:
+ *  int: Index of the slot in the TCP Keepalive port table, or -1 if the session
+ *  is kept alive by the host or is not open.
+ *
+ *******************************************************************************/
+int tko_session_get_slot(int session)
+{
+    if ((session < 0) || (session >= TKO_SESSION_MAX))
+    {
+        return -1;
+    }
+
+    return (TKO_SESSION_OFFLOADED == sessions[session].state) ? sessions[session].slot : -1;
+}
+
+
+/* [] END OF FILE */
+
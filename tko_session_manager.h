@@ -0,0 +1,78 @@
+/******************************************************************************
+* File Name:   tko_session_manager.h
+*
+* Description: This file is the public interface of tko_session_manager.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TKO_SESSION_MANAGER_H
+#define TKO_SESSION_MANAGER_H
+
+/* FreeRTOS header file */
+#include <FreeRTOS.h>
+
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Stack size and priority of the task that services the sessions */
+#ifndef TKO_SESSION_TASK_STACK_SIZE
+#define TKO_SESSION_TASK_STACK_SIZE              (1024)
+#endif
+#ifndef TKO_SESSION_TASK_PRIORITY
+#define TKO_SESSION_TASK_PRIORITY                (1)
+#endif
+
+/* Session ID returned when no session could be opened */
+#define TKO_SESSION_INVALID                      (-1)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tko_session_manager_init(void);
+int tko_session_open(const char *remote_ip, uint16_t remote_port, uint16_t local_port);
+cy_rslt_t tko_session_close(int session);
+int tko_session_get_slot(int session);
+
+#endif /* TKO_SESSION_MANAGER_H */
+
+
+/* [] END OF FILE */
+
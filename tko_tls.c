@@ -0,0 +1,622 @@
+/******************************************************************************
+* File Name:   tko_tls.c
+*
+* Description: This file runs TLS over the TCP Keepalive connections with
+*              mbed TLS, and caches the TLS session of each server for an
+*              abbreviated handshake on reconnect.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* Secure socket header file */
+#include "cy_secure_sockets.h"
+
+/* mbed TLS header files */
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/net_sockets.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "tcp_keepalive_offload.h"
+#include "debug_uart.h"
+#include "tko_tls.h"
+
+#if ENABLE_TKO_TLS
+
+#if ENABLE_TKO_SESSION_MANAGER
+#error "ENABLE_TKO_TLS does not cover the connections of the TCP Keepalive session manager"
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Personalization string of the random generator */
+#define TKO_TLS_DRBG_PERSONALIZATION      "tko_tls"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Session of the last handshake with a server */
+typedef struct
+{
+    bool valid;
+    TickType_t tick;                /* Time of the full handshake that created it */
+    mbedtls_ssl_session session;
+} tko_tls_cache_entry_t;
+
+typedef struct
+{
+    uint32_t full;
+    uint32_t resumed;
+    uint32_t failed;
+    uint32_t last_ms;               /* Time taken by the last handshake */
+} tko_tls_stats_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static mbedtls_entropy_context tls_entropy;
+static mbedtls_ctr_drbg_context tls_drbg;
+static SemaphoreHandle_t tls_drbg_lock = NULL;
+static mbedtls_x509_crt tls_ca;
+static mbedtls_ssl_config tls_conf;
+static bool tls_ready = false;
+
+/* TLS context of each socket in global_socket[] */
+static mbedtls_ssl_context tls_ssl[MAX_TKO];
+static bool tls_active[MAX_TKO];
+
+/*
+ * The SRAM is retained in deep sleep, so the sessions are kept however long
+ * the host sleeps between the reconnects, but not across a reset.
+ */
+static tko_tls_cache_entry_t tls_cache[MAX_TKO];
+static tko_tls_stats_t tls_stats[MAX_TKO];
+
+/********************************************************************************
+ * Function Name: tko_tls_random
+ ********************************************************************************
+ * Summary:
+ *  Random generator of the TLS configuration. The handshakes of the sockets run
+ *  in parallel workers, so the generator is shared under a lock.
+ *
+ * Parameters:
+ *  ctx: CTR-DRBG context.
+ *  output: Buffer to fill in.
+ *  length: Length of the buffer.
+ *
+ * Return:
+ *  int: 0 on success, an mbed TLS error code otherwise.
+ *
+ *******************************************************************************/
+static int tko_tls_random(void *ctx, unsigned char *output, size_t length)
+{
+    int ret;
+
+    xSemaphoreTake(tls_drbg_lock, portMAX_DELAY);
+    ret = mbedtls_ctr_drbg_random(ctx, output, length);
+    xSemaphoreGive(tls_drbg_lock);
+
+    return ret;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_bio_send
+ ********************************************************************************
+ * Summary:
+ *  Sends the TLS records of a socket over its TCP connection.
+ *
+ * Parameters:
+ *  ctx: Index of the socket in global_socket[].
+ *  buf: Data to send.
+ *  len: Length of the data.
+ *
+ * Return:
+ *  int: Number of bytes sent, or an mbed TLS error code.
+ *
+ *******************************************************************************/
+static int tko_tls_bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    int index = (int)(intptr_t)ctx;
+    uint32_t sent = 0;
+
+    if (NULL == global_socket[index])
+    {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    if (CY_RSLT_SUCCESS != cy_socket_send(global_socket[index], buf, len, CY_SOCKET_FLAGS_NONE, &sent))
+    {
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return (int)sent;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_bio_recv
+ ********************************************************************************
+ * Summary:
+ *  Receives the TLS records of a socket from its TCP connection. Waits at most
+ *  TKO_TLS_RECV_TIMEOUT_MS, the receive timeout of the socket.
+ *
+ * Parameters:
+ *  ctx: Index of the socket in global_socket[].
+ *  buf: Buffer to fill in.
+ *  len: Length of the buffer.
+ *
+ * Return:
+ *  int: Number of bytes received, or an mbed TLS error code.
+ *
+ *******************************************************************************/
+static int tko_tls_bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    int index = (int)(intptr_t)ctx;
+    uint32_t received = 0;
+    cy_rslt_t result;
+
+    if (NULL == global_socket[index])
+    {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    result = cy_socket_recv(global_socket[index], buf, len, CY_SOCKET_FLAGS_NONE, &received);
+
+    if (CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT == result)
+    {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    else if (CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED == result)
+    {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    else if (CY_RSLT_SUCCESS != result)
+    {
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    return (int)received;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the number of full, abbreviated, and failed handshakes of each
+ *  socket, the time taken by the last one, and the age of its cached session.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_tls_report(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    int index;
+
+    APP_INFO(("Socket  Full  Resumed  Failed  Last ms  Session age s\n"));
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (tls_cache[index].valid)
+        {
+            APP_INFO(("%6d %5"PRIu32" %8"PRIu32" %7"PRIu32" %8"PRIu32" %14"PRIu32"\n", index, tls_stats[index].full,
+                      tls_stats[index].resumed, tls_stats[index].failed, tls_stats[index].last_ms,
+                      (uint32_t)((now - tls_cache[index].tick) * portTICK_PERIOD_MS / 1000u)));
+        }
+        else
+        {
+            APP_INFO(("%6d %5"PRIu32" %8"PRIu32" %7"PRIu32" %8"PRIu32" %14s\n", index, tls_stats[index].full,
+                      tls_stats[index].resumed, tls_stats[index].failed, tls_stats[index].last_ms, "-"));
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_init
+ ********************************************************************************
+ * Summary:
+ *  Seeds the random generator, parses TKO_TLS_ROOT_CA_CERTIFICATE, and sets up
+ *  the client configuration shared by all the sockets: the server certificate
+ *  is verified, and session tickets are enabled where mbed TLS supports them.
+ *  Call it before tcp_socket_connection_start().
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, CY_RSLT_TYPE_ERROR otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_tls_init(void)
+{
+    static const char root_ca[] = TKO_TLS_ROOT_CA_CERTIFICATE;
+    int ret;
+
+    if (tls_ready)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    mbedtls_entropy_init(&tls_entropy);
+    mbedtls_ctr_drbg_init(&tls_drbg);
+    mbedtls_x509_crt_init(&tls_ca);
+    mbedtls_ssl_config_init(&tls_conf);
+
+    tls_drbg_lock = xSemaphoreCreateMutex();
+
+    if (NULL == tls_drbg_lock)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    ret = mbedtls_ctr_drbg_seed(&tls_drbg, mbedtls_entropy_func, &tls_entropy,
+                                (const unsigned char *)TKO_TLS_DRBG_PERSONALIZATION,
+                                strlen(TKO_TLS_DRBG_PERSONALIZATION));
+
+    if (0 == ret)
+    {
+        /* The PEM parser takes the terminating NUL as part of the length */
+        ret = mbedtls_x509_crt_parse(&tls_ca, (const unsigned char *)root_ca, sizeof(root_ca));
+    }
+
+    if (0 == ret)
+    {
+        ret = mbedtls_ssl_config_defaults(&tls_conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+
+    if (0 != ret)
+    {
+        ERR_INFO(("TLS initialization failed. Error code:-0x%04x\n", -ret));
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    mbedtls_ssl_conf_authmode(&tls_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&tls_conf, &tls_ca, NULL);
+    mbedtls_ssl_conf_rng(&tls_conf, tko_tls_random, &tls_drbg);
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    /* A ticket lets the server resume the session without keeping its state */
+    mbedtls_ssl_conf_session_tickets(&tls_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    tls_ready = true;
+
+    debug_uart_register_command(TKO_TLS_REPORT_COMMAND, tko_tls_report);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_connect
+ ********************************************************************************
+ * Summary:
+ *  Runs the TLS handshake over the connected TCP socket at the given index of
+ *  global_socket[]. The session cached from the last handshake with the same
+ *  server is offered, if it is younger than TKO_TLS_SESSION_LIFETIME_MS, so
+ *  that the server can resume it with an abbreviated handshake. The session of
+ *  a successful handshake replaces the cached one. The handshake completes
+ *  before the call returns, so no TLS record is pending when the connection is
+ *  offloaded; the TCP keepalives of the WLAN firmware are not affected by TLS.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the handshake succeeded, CY_RSLT_TYPE_ERROR
+ *  otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_tls_connect(int index)
+{
+    mbedtls_ssl_context *ssl;
+    tko_tls_cache_entry_t *cache;
+    mbedtls_ssl_session session;
+    uint32_t timeout_ms = TKO_TLS_RECV_TIMEOUT_MS;
+    TickType_t start = xTaskGetTickCount();
+    bool offered = false;
+    bool resumed = false;
+    int ret;
+
+    if (!tls_ready || (index < 0) || (index >= MAX_TKO) || (NULL == global_socket[index]))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    ssl = &tls_ssl[index];
+    cache = &tls_cache[index];
+
+    tko_tls_close(index);
+    mbedtls_ssl_init(ssl);
+    tls_active[index] = true;
+
+    ret = mbedtls_ssl_setup(ssl, &tls_conf);
+
+    if (0 == ret)
+    {
+        ret = mbedtls_ssl_set_hostname(ssl, TKO_TLS_SERVER_NAME);
+    }
+
+    if (0 == ret)
+    {
+        (void)cy_socket_setsockopt(global_socket[index], CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_RCVTIMEO,
+                                   &timeout_ms, sizeof(timeout_ms));
+        mbedtls_ssl_set_bio(ssl, (void *)(intptr_t)index, tko_tls_bio_send, tko_tls_bio_recv, NULL);
+
+        if (cache->valid &&
+            ((uint32_t)((start - cache->tick) * portTICK_PERIOD_MS) < TKO_TLS_SESSION_LIFETIME_MS))
+        {
+            offered = (0 == mbedtls_ssl_set_session(ssl, &cache->session));
+        }
+
+        do
+        {
+            ret = mbedtls_ssl_handshake(ssl);
+        } while (((MBEDTLS_ERR_SSL_WANT_READ == ret) || (MBEDTLS_ERR_SSL_WANT_WRITE == ret)) &&
+                 ((uint32_t)((xTaskGetTickCount() - start) * portTICK_PERIOD_MS) < TKO_TLS_HANDSHAKE_TIMEOUT_MS));
+    }
+
+    tls_stats[index].last_ms = (uint32_t)((xTaskGetTickCount() - start) * portTICK_PERIOD_MS);
+
+    if (0 != ret)
+    {
+        ERR_INFO(("Socket[%d]: TLS handshake failed. Error code:-0x%04x\n", index, -ret));
+        tls_stats[index].failed++;
+
+        /* The server may have dropped the session; do a full handshake next time */
+        tko_tls_session_forget(index);
+        tko_tls_close(index);
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    mbedtls_ssl_session_init(&session);
+
+    if (0 == mbedtls_ssl_get_session(ssl, &session))
+    {
+        /* A resumed session keeps the ID that was offered */
+        resumed = offered && (0 != session.id_len) && (session.id_len == cache->session.id_len) &&
+                  (0 == memcmp(session.id, cache->session.id, session.id_len));
+
+        if (cache->valid)
+        {
+            mbedtls_ssl_session_free(&cache->session);
+        }
+
+        /* The cache takes over the buffers of the session */
+        cache->session = session;
+        cache->valid = true;
+
+        if (!resumed)
+        {
+            cache->tick = start;
+        }
+    }
+    else
+    {
+        mbedtls_ssl_session_free(&session);
+    }
+
+    if (resumed)
+    {
+        tls_stats[index].resumed++;
+    }
+    else
+    {
+        tls_stats[index].full++;
+    }
+
+    APP_INFO(("Socket[%d]: %s TLS handshake in %"PRIu32" ms, %s\n", index, resumed ? "Abbreviated" : "Full",
+              tls_stats[index].last_ms, mbedtls_ssl_get_ciphersuite(ssl)));
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_send
+ ********************************************************************************
+ * Summary:
+ *  Encrypts and sends data on a TLS connection. Blocks until all the data is
+ *  sent.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *  data: Data to send.
+ *  length: Length of the data.
+ *  sent: Filled in with the number of bytes sent.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if all the data is sent, CY_RSLT_TYPE_ERROR
+ *  otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_tls_send(int index, const uint8_t *data, uint32_t length, uint32_t *sent)
+{
+    int ret;
+
+    *sent = 0;
+
+    if ((index < 0) || (index >= MAX_TKO) || !tls_active[index])
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    while (*sent < length)
+    {
+        ret = mbedtls_ssl_write(&tls_ssl[index], data + *sent, length - *sent);
+
+        if (ret > 0)
+        {
+            *sent += (uint32_t)ret;
+        }
+        else if ((MBEDTLS_ERR_SSL_WANT_WRITE != ret) && (MBEDTLS_ERR_SSL_WANT_READ != ret))
+        {
+            ERR_INFO(("Socket[%d]: TLS write failed. Error code:-0x%04x\n", index, -ret));
+            return CY_RSLT_TYPE_ERROR;
+        }
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_recv
+ ********************************************************************************
+ * Summary:
+ *  Receives and decrypts data from a TLS connection, such as from the data
+ *  handler of the wake dispatcher. Waits at most TKO_TLS_RECV_TIMEOUT_MS for
+ *  a record. Records that carry no application data, such as a new session
+ *  ticket, are processed and reported as a timeout.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *  buffer: Buffer to fill in.
+ *  length: Length of the buffer.
+ *  received: Filled in with the number of bytes received.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if data was received,
+ *  CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT if there is none,
+ *  CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED if the server closed the connection,
+ *  CY_RSLT_TYPE_ERROR otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_tls_recv(int index, uint8_t *buffer, uint32_t length, uint32_t *received)
+{
+    int ret;
+
+    *received = 0;
+
+    if ((index < 0) || (index >= MAX_TKO) || !tls_active[index])
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    ret = mbedtls_ssl_read(&tls_ssl[index], buffer, length);
+
+    if (ret > 0)
+    {
+        *received = (uint32_t)ret;
+        return CY_RSLT_SUCCESS;
+    }
+    else if ((MBEDTLS_ERR_SSL_WANT_READ == ret) || (MBEDTLS_ERR_SSL_WANT_WRITE == ret))
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+    }
+    else if ((0 == ret) || (MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY == ret))
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+    }
+
+    ERR_INFO(("Socket[%d]: TLS read failed. Error code:-0x%04x\n", index, -ret));
+
+    return CY_RSLT_TYPE_ERROR;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_close
+ ********************************************************************************
+ * Summary:
+ *  Frees the TLS context of a socket. The cached session is kept for the next
+ *  handshake. Call it before the TCP socket is deleted.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_tls_close(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO) || !tls_active[index])
+    {
+        return;
+    }
+
+    mbedtls_ssl_free(&tls_ssl[index]);
+    tls_active[index] = false;
+}
+
+/********************************************************************************
+ * Function Name: tko_tls_session_forget
+ ********************************************************************************
+ * Summary:
+ *  Drops the cached session of a socket, so that its next handshake is a full
+ *  one.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_tls_session_forget(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO) || !tls_cache[index].valid)
+    {
+        return;
+    }
+
+    mbedtls_ssl_session_free(&tls_cache[index].session);
+    tls_cache[index].valid = false;
+}
+
+#endif /* ENABLE_TKO_TLS */
+
+
+/* [] END OF FILE */
+
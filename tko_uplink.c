@@ -0,0 +1,509 @@
+/******************************************************************************
+* File Name:   tko_uplink.c
+*
+* Description: This file queues the application data of the TCP Keepalive
+*              sockets while the host sleeps, and sends it as one write per
+*              socket in the next awake window or at the earliest deadline of
+*              the queued messages.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* Secure socket header file */
+#include "cy_secure_sockets.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "debug_uart.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_tls.h"
+#include "tko_uplink.h"
+
+#if ENABLE_TKO_UPLINK_QUEUE
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Events of the flush task */
+#define TKO_UPLINK_EVENT_WAKE             (1u << 0)   /* The host is awake anyway */
+#define TKO_UPLINK_EVENT_FULL             (1u << 1)   /* A queue is over the threshold */
+#define TKO_UPLINK_EVENT_DEADLINE         (1u << 2)   /* A deadline is set or has passed */
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    TKO_UPLINK_FLUSH_WAKE = 0,
+    TKO_UPLINK_FLUSH_DEADLINE,
+    TKO_UPLINK_FLUSH_FULL,
+    TKO_UPLINK_FLUSH_MAX
+} tko_uplink_flush_reason_t;
+
+typedef struct
+{
+    uint8_t buffer[TKO_UPLINK_BUFFER_SIZE];
+    uint32_t length;                /* Bytes queued from the start of the buffer */
+    bool deadline_set;
+    TickType_t deadline;            /* Earliest deadline of the queued messages */
+} tko_uplink_queue_t;
+
+typedef struct
+{
+    uint32_t messages;
+    uint32_t dropped;
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t errors;
+} tko_uplink_stats_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* The SRAM is retained in deep sleep, so the queues are kept while the host sleeps */
+static tko_uplink_queue_t queues[MAX_TKO];
+static tko_uplink_stats_t stats[MAX_TKO];
+static uint32_t flush_count[TKO_UPLINK_FLUSH_MAX];
+
+/* Data of the write in progress, used by the flush task only */
+static uint8_t flush_buffer[TKO_UPLINK_BUFFER_SIZE];
+
+static SemaphoreHandle_t uplink_lock = NULL;
+static TaskHandle_t uplink_task = NULL;
+
+static const char *const flush_reason_name[TKO_UPLINK_FLUSH_MAX] =
+{
+    "wake", "deadline", "full"
+};
+
+/********************************************************************************
+ * Function Name: tko_uplink_next_wait
+ ********************************************************************************
+ * Summary:
+ *  Returns how long the flush task can block before the earliest deadline of
+ *  the queued messages.
+ *
+ * Parameters:
+ *  now: Current tick count.
+ *
+ * Return:
+ *  TickType_t: Ticks until the earliest deadline, 0 if it has passed, or
+ *  portMAX_DELAY if no queued message has a deadline.
+ *
+ *******************************************************************************/
+static TickType_t tko_uplink_next_wait(TickType_t now)
+{
+    TickType_t wait = portMAX_DELAY;
+    int32_t left;
+    int index;
+
+    xSemaphoreTake(uplink_lock, portMAX_DELAY);
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (!queues[index].deadline_set)
+        {
+            continue;
+        }
+
+        left = (int32_t)(queues[index].deadline - now);
+
+        if (left <= 0)
+        {
+            wait = 0;
+            break;
+        }
+
+        if ((TickType_t)left < wait)
+        {
+            wait = (TickType_t)left;
+        }
+    }
+
+    xSemaphoreGive(uplink_lock);
+
+    return wait;
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_flush_socket
+ ********************************************************************************
+ * Summary:
+ *  Sends all the data queued on a socket as one write. The bytes sent are
+ *  removed from the queue; what could not be sent stays queued for the next
+ *  flush. Nothing is sent while the connection is down.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *
+ * Return:
+ *  bool: true if data was sent.
+ *
+ *******************************************************************************/
+static bool tko_uplink_flush_socket(int index)
+{
+    tko_uplink_queue_t *queue = &queues[index];
+    uint32_t length;
+    uint32_t sent = 0;
+    cy_rslt_t result;
+
+    if ((NULL == global_socket[index]) || !tcp_socket_is_established(index))
+    {
+        return false;
+    }
+
+    /* Send from a copy, so that the queue is not locked while lwIP sends */
+    xSemaphoreTake(uplink_lock, portMAX_DELAY);
+    length = queue->length;
+    memcpy(flush_buffer, queue->buffer, length);
+    xSemaphoreGive(uplink_lock);
+
+    if (0 == length)
+    {
+        return false;
+    }
+
+#if ENABLE_TKO_TLS
+    result = tko_tls_send(index, flush_buffer, length, &sent);
+#else
+    result = cy_socket_send(global_socket[index], flush_buffer, length, CY_SOCKET_FLAGS_NONE, &sent);
+#endif
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        stats[index].errors++;
+        ERR_INFO(("Socket[%d]: Uplink write of %"PRIu32" bytes failed. Error code:%"PRIu32"\n",
+                  index, length, result));
+    }
+
+    /* Messages queued during the write are behind the bytes sent */
+    xSemaphoreTake(uplink_lock, portMAX_DELAY);
+
+    memmove(queue->buffer, queue->buffer + sent, queue->length - sent);
+    queue->length -= sent;
+
+    if (0 == queue->length)
+    {
+        queue->deadline_set = false;
+    }
+
+    xSemaphoreGive(uplink_lock);
+
+    if (0 != sent)
+    {
+        stats[index].writes++;
+        stats[index].bytes += sent;
+    }
+
+    return (0 != sent);
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_flush
+ ********************************************************************************
+ * Summary:
+ *  Flushes the queues of all the sockets.
+ *
+ * Parameters:
+ *  reason: What triggered the flush, for the counters.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_uplink_flush(tko_uplink_flush_reason_t reason)
+{
+    bool flushed = false;
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        flushed |= tko_uplink_flush_socket(index);
+    }
+
+    if (flushed)
+    {
+        flush_count[reason]++;
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_flush_task
+ ********************************************************************************
+ * Summary:
+ *  Flushes all the queues in the awake window after each resume of the network
+ *  stack, when a queue goes over TKO_UPLINK_FLUSH_THRESHOLD, and at the
+ *  earliest deadline of the queued messages. Once a deadline forces the stack
+ *  to resume, the messages without a deadline go out in the same window. The
+ *  task blocks until the earliest deadline only, so it does not wake the MCU
+ *  otherwise.
+ *
+ * Parameters:
+ *  void *arg: Not used.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_uplink_flush_task(void *arg)
+{
+    uint32_t events;
+    TickType_t wait;
+
+    (void)arg;
+
+    while (true)
+    {
+        wait = tko_uplink_next_wait(xTaskGetTickCount());
+        events = 0;
+
+        if ((0 == wait) || (pdFALSE == xTaskNotifyWait(0, UINT32_MAX, &events, wait)))
+        {
+            events |= TKO_UPLINK_EVENT_DEADLINE;
+        }
+
+        if (events & TKO_UPLINK_EVENT_WAKE)
+        {
+            tko_uplink_flush(TKO_UPLINK_FLUSH_WAKE);
+        }
+        else if (events & TKO_UPLINK_EVENT_FULL)
+        {
+            tko_uplink_flush(TKO_UPLINK_FLUSH_FULL);
+        }
+        else if ((events & TKO_UPLINK_EVENT_DEADLINE) && (0 == tko_uplink_next_wait(xTaskGetTickCount())))
+        {
+            tko_uplink_flush(TKO_UPLINK_FLUSH_DEADLINE);
+
+            /* A connection that is down keeps its data; retry at the next wake or after a delay */
+            if (0 == tko_uplink_next_wait(xTaskGetTickCount()))
+            {
+                (void)xTaskNotifyWait(0, 0, &events, pdMS_TO_TICKS(TKO_UPLINK_RETRY_DELAY_MS));
+            }
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the messages queued, dropped, the writes, and the bytes sent on each
+ *  socket, and the number of flushes by trigger.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_uplink_report(void)
+{
+    int index;
+
+    APP_INFO(("Socket  Messages  Dropped  Writes  Bytes  Errors  Queued bytes\n"));
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        APP_INFO(("%6d %9"PRIu32" %8"PRIu32" %7"PRIu32" %6"PRIu32" %7"PRIu32" %7"PRIu32"\n", index,
+                  stats[index].messages, stats[index].dropped, stats[index].writes, stats[index].bytes,
+                  stats[index].errors, queues[index].length));
+    }
+
+    for (index = 0; index < TKO_UPLINK_FLUSH_MAX; index++)
+    {
+        APP_INFO(("Flushes on %s: %"PRIu32"\n", flush_reason_name[index], flush_count[index]));
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_init
+ ********************************************************************************
+ * Summary:
+ *  Starts the task that flushes the uplink queues, and registers the debug
+ *  UART command that prints the queue counters.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, CY_RSLT_TYPE_ERROR if the task or its
+ *  lock cannot be created.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_uplink_init(void)
+{
+    uplink_lock = xSemaphoreCreateMutex();
+
+    if ((NULL == uplink_lock) ||
+        (pdPASS != xTaskCreate(tko_uplink_flush_task, "Uplink", TKO_UPLINK_TASK_STACK_SIZE,
+                               NULL, TKO_UPLINK_TASK_PRIORITY, &uplink_task)))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    debug_uart_register_command(TKO_UPLINK_REPORT_COMMAND, tko_uplink_report);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_send
+ ********************************************************************************
+ * Summary:
+ *  Queues a message on a TCP Keepalive socket. It is sent with all the other
+ *  queued data in the next awake window of the host, or at the latest after
+ *  deadline_ms, which resumes the network stack if it is suspended. A queue
+ *  over TKO_UPLINK_FLUSH_THRESHOLD is flushed right away. Messages are
+ *  concatenated on the TCP stream, so any framing is up to the application.
+ *
+ * Parameters:
+ *  index: Index of the socket in global_socket[].
+ *  data: Message to send.
+ *  length: Length of the message.
+ *  deadline_ms: Most time the message can stay queued, or TKO_UPLINK_NO_DEADLINE
+ *  to wait for the next wake.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the message is queued, CY_RSLT_TYPE_ERROR if
+ *  the parameters are invalid or the queue has no room for it.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_uplink_send(int index, const uint8_t *data, uint32_t length, uint32_t deadline_ms)
+{
+    tko_uplink_queue_t *queue;
+    TickType_t deadline = 0;
+    uint32_t events = 0;
+
+    if ((index < 0) || (index >= MAX_TKO) || (NULL == data) || (0 == length) || (NULL == uplink_task))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    queue = &queues[index];
+
+    if (TKO_UPLINK_NO_DEADLINE != deadline_ms)
+    {
+        deadline = xTaskGetTickCount() + (TickType_t)(deadline_ms / portTICK_PERIOD_MS);
+    }
+
+    xSemaphoreTake(uplink_lock, portMAX_DELAY);
+
+    if (length > (TKO_UPLINK_BUFFER_SIZE - queue->length))
+    {
+        stats[index].dropped++;
+        xSemaphoreGive(uplink_lock);
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    memcpy(queue->buffer + queue->length, data, length);
+    queue->length += length;
+    stats[index].messages++;
+
+    if ((TKO_UPLINK_NO_DEADLINE != deadline_ms) &&
+        (!queue->deadline_set || ((int32_t)(deadline - queue->deadline) < 0)))
+    {
+        queue->deadline = deadline;
+        queue->deadline_set = true;
+        events |= TKO_UPLINK_EVENT_DEADLINE;
+    }
+
+    if (queue->length >= TKO_UPLINK_FLUSH_THRESHOLD)
+    {
+        events |= TKO_UPLINK_EVENT_FULL;
+    }
+
+    xSemaphoreGive(uplink_lock);
+
+    if (0 != events)
+    {
+        xTaskNotify(uplink_task, events, eSetBits);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_uplink_wake
+ ********************************************************************************
+ * Summary:
+ *  Flushes the queues in the current awake window. Call it after each resume
+ *  of the network stack.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_uplink_wake(void)
+{
+    int index;
+
+    if (NULL == uplink_task)
+    {
+        return;
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (0 != queues[index].length)
+        {
+            xTaskNotify(uplink_task, TKO_UPLINK_EVENT_WAKE, eSetBits);
+            break;
+        }
+    }
+}
+
+#endif /* ENABLE_TKO_UPLINK_QUEUE */
+
+
+/* [] END OF FILE */
+
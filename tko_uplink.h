@@ -0,0 +1,81 @@
+/******************************************************************************
+* File Name:   tko_uplink.h
+*
+* Description: This file contains the declarations of the batched uplink
+*              queue of the TCP Keepalive sockets.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TKO_UPLINK_H
+#define TKO_UPLINK_H
+
+#include <stdint.h>
+
+/* FreeRTOS header file */
+#include <FreeRTOS.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Stack size and priority of the task that flushes the queues */
+#ifndef TKO_UPLINK_TASK_STACK_SIZE
+#define TKO_UPLINK_TASK_STACK_SIZE               (1024)
+#endif
+#ifndef TKO_UPLINK_TASK_PRIORITY
+#define TKO_UPLINK_TASK_PRIORITY                 (2)
+#endif
+
+/* Debug UART command byte that prints the queue counters */
+#define TKO_UPLINK_REPORT_COMMAND                ('u')
+
+/* Deadline of a message that can wait for the next wake however long it takes */
+#define TKO_UPLINK_NO_DEADLINE                   (UINT32_MAX)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tko_uplink_init(void);
+cy_rslt_t tko_uplink_send(int index, const uint8_t *data, uint32_t length, uint32_t deadline_ms);
+void tko_uplink_wake(void);
+
+#endif /* TKO_UPLINK_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,666 @@
+/******************************************************************************
+* File Name:   tko_zero_copy.c
+*
+* Description: This file implements the zero-copy data path of the TCP
+*              Keepalive sockets. Data is handed to lwIP by reference,
+*              without a copy into the socket buffers, and released when the
+*              server acknowledges it. Received pbufs are handed to the
+*              application as they come out of lwIP, without going through
+*              the socket receive queue.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <string.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header files */
+#include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "tcp_keepalive_offload.h"
+#include "tko_zero_copy.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* With TLS, the TCP stream of a socket carries TLS records that only the TLS
+ * layer can read and write, so the zero-copy path is not available.
+ */
+#if ENABLE_TKO_TLS
+#define TKO_ZC_AVAILABLE                         (false)
+#else
+#define TKO_ZC_AVAILABLE                         (true)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Zero-copy send waiting for its acknowledgement */
+typedef struct
+{
+    struct pbuf *chain;             /* Chain to free, NULL for a buffer */
+    tko_zc_sent_cb_t sent_cb;
+    void *arg;
+    int index;
+    uint32_t end_seq;               /* Sequence number after the last byte */
+} tko_zc_pending_t;
+
+/*
+ * Connection whose lwIP callbacks are wrapped. The callbacks of the socket
+ * layer are kept and called for everything the zero-copy path does not handle.
+ */
+typedef struct
+{
+    struct tcp_pcb *pcb;
+    void *callback_arg;
+    tcp_sent_fn sent;
+    tcp_recv_fn recv;
+    tcp_err_fn err;
+    tko_zc_pending_t pending[TKO_ZC_MAX_PENDING];
+    uint8_t head;
+    uint8_t count;
+} tko_zc_conn_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Accessed in the lwIP core context only */
+static tko_zc_conn_t conns[TKO_ZC_MAX_CONNECTIONS];
+static tko_zc_recv_cb_t recv_cbs[MAX_TKO];
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static err_t tko_zc_sent(void *arg, struct tcp_pcb *pcb, u16_t len);
+static err_t tko_zc_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
+static void tko_zc_err(void *arg, err_t err);
+
+/********************************************************************************
+ * Function Name: tko_zc_complete
+ ********************************************************************************
+ * Summary:
+ *  Completes the pending sends of a connection up to the last acknowledged
+ *  byte, or all of them if the connection is lost.
+ *
+ * Parameters:
+ *  conn: Connection.
+ *  lost: true if the connection is lost.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_zc_complete(tko_zc_conn_t *conn, bool lost)
+{
+    tko_zc_pending_t *entry;
+
+    while (conn->count > 0)
+    {
+        entry = &conn->pending[conn->head];
+
+        if (!lost && !TCP_SEQ_GEQ(conn->pcb->lastack, entry->end_seq))
+        {
+            break;
+        }
+
+        conn->head = (conn->head + 1) % TKO_ZC_MAX_PENDING;
+        conn->count--;
+
+        if (NULL != entry->chain)
+        {
+            pbuf_free(entry->chain);
+        }
+
+        if (NULL != entry->sent_cb)
+        {
+            entry->sent_cb(entry->index, entry->arg, !lost);
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_release
+ ********************************************************************************
+ * Summary:
+ *  Fails the pending sends of a connection and frees its entry.
+ *
+ * Parameters:
+ *  conn: Connection.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_zc_release(tko_zc_conn_t *conn)
+{
+    tko_zc_complete(conn, true);
+    memset(conn, 0, sizeof(*conn));
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_find
+ ********************************************************************************
+ * Summary:
+ *  Returns the connection whose lwIP callbacks get the given argument.
+ *
+ * Parameters:
+ *  arg: Callback argument of the PCB.
+ *
+ * Return:
+ *  tko_zc_conn_t *: Connection, or NULL if there is none.
+ *
+ *******************************************************************************/
+static tko_zc_conn_t *tko_zc_find(void *arg)
+{
+    int index;
+
+    for (index = 0; index < TKO_ZC_MAX_CONNECTIONS; index++)
+    {
+        if ((NULL != conns[index].pcb) && (conns[index].callback_arg == arg))
+        {
+            return &conns[index];
+        }
+    }
+
+    return NULL;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_is_live
+ ********************************************************************************
+ * Summary:
+ *  Checks that a connection still has its PCB, with the wrapped callbacks. The
+ *  socket layer clears the callbacks when it closes the connection.
+ *
+ * Parameters:
+ *  conn: Connection.
+ *
+ * Return:
+ *  bool: true if the connection is live.
+ *
+ *******************************************************************************/
+static bool tko_zc_is_live(const tko_zc_conn_t *conn)
+{
+    struct tcp_pcb *pcb;
+
+    for (pcb = tcp_active_pcbs; NULL != pcb; pcb = pcb->next)
+    {
+        if (pcb == conn->pcb)
+        {
+            return (tko_zc_sent == pcb->sent) && (conn->callback_arg == pcb->callback_arg);
+        }
+    }
+
+    return false;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_get_conn
+ ********************************************************************************
+ * Summary:
+ *  Returns the connection of the socket at an index of the TCP Keepalive port
+ *  table, wrapping the lwIP callbacks of its PCB the first time. The entries of
+ *  the connections that are no longer live are freed. Must be called in the
+ *  lwIP core context.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  tko_zc_conn_t *: Connection, or NULL if the socket is not connected or no
+ *  entry is free.
+ *
+ *******************************************************************************/
+static tko_zc_conn_t *tko_zc_get_conn(int index)
+{
+    struct tcp_pcb *pcb = tcp_socket_get_pcb(index);
+    tko_zc_conn_t *conn = NULL;
+    int entry;
+
+    if ((NULL == pcb) || (ESTABLISHED != pcb->state))
+    {
+        return NULL;
+    }
+
+    for (entry = 0; entry < TKO_ZC_MAX_CONNECTIONS; entry++)
+    {
+        if (NULL == conns[entry].pcb)
+        {
+            continue;
+        }
+
+        if (!tko_zc_is_live(&conns[entry]))
+        {
+            tko_zc_release(&conns[entry]);
+        }
+        else if (conns[entry].pcb == pcb)
+        {
+            return &conns[entry];
+        }
+    }
+
+    for (entry = 0; entry < TKO_ZC_MAX_CONNECTIONS; entry++)
+    {
+        if (NULL == conns[entry].pcb)
+        {
+            conn = &conns[entry];
+            break;
+        }
+    }
+
+    if (NULL != conn)
+    {
+        conn->pcb = pcb;
+        conn->callback_arg = pcb->callback_arg;
+        conn->sent = pcb->sent;
+        conn->recv = pcb->recv;
+        conn->err = pcb->errf;
+
+        tcp_sent(pcb, tko_zc_sent);
+        tcp_recv(pcb, tko_zc_recv);
+        tcp_err(pcb, tko_zc_err);
+    }
+
+    return conn;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_slot_of
+ ********************************************************************************
+ * Summary:
+ *  Returns the index of the TCP Keepalive port table that holds a PCB.
+ *
+ * Parameters:
+ *  pcb: PCB of the connection.
+ *
+ * Return:
+ *  int: Index, or -1 if the connection is not in the port table.
+ *
+ *******************************************************************************/
+static int tko_zc_slot_of(const struct tcp_pcb *pcb)
+{
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (tcp_socket_get_pcb(index) == pcb)
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_sent
+ ********************************************************************************
+ * Summary:
+ *  lwIP sent callback. Completes the zero-copy sends that are acknowledged, and
+ *  passes the event on to the socket layer.
+ *
+ * Parameters:
+ *  arg: Callback argument of the PCB.
+ *  pcb: PCB of the connection.
+ *  len: Number of bytes acknowledged.
+ *
+ * Return:
+ *  err_t: Result of the socket layer callback.
+ *
+ *******************************************************************************/
+static err_t tko_zc_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    tko_zc_conn_t *conn = tko_zc_find(arg);
+
+    if (NULL == conn)
+    {
+        return ERR_OK;
+    }
+
+    tko_zc_complete(conn, false);
+
+    return (NULL != conn->sent) ? conn->sent(arg, pcb, len) : ERR_OK;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_recv
+ ********************************************************************************
+ * Summary:
+ *  lwIP receive callback. Data is handed to the receive callback registered for
+ *  the socket, if any, and acknowledged to lwIP at once. Everything else,
+ *  including the end of the connection, goes to the socket layer.
+ *
+ * Parameters:
+ *  arg: Callback argument of the PCB.
+ *  pcb: PCB of the connection.
+ *  p: Received data, or NULL when the server closes the connection.
+ *  err: Receive error.
+ *
+ * Return:
+ *  err_t: Result of the socket layer callback.
+ *
+ *******************************************************************************/
+static err_t tko_zc_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    tko_zc_conn_t *conn = tko_zc_find(arg);
+    int index;
+
+    if (NULL == conn)
+    {
+        if (NULL != p)
+        {
+            pbuf_free(p);
+        }
+
+        return ERR_OK;
+    }
+
+    if ((NULL != p) && (ERR_OK == err))
+    {
+        index = tko_zc_slot_of(pcb);
+
+        if ((index >= 0) && (NULL != recv_cbs[index]))
+        {
+            tcp_recved(pcb, p->tot_len);
+            recv_cbs[index](index, p);
+            return ERR_OK;
+        }
+    }
+
+    if (NULL != conn->recv)
+    {
+        return conn->recv(arg, pcb, p, err);
+    }
+
+    if (NULL != p)
+    {
+        pbuf_free(p);
+    }
+
+    return ERR_OK;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_err
+ ********************************************************************************
+ * Summary:
+ *  lwIP error callback. The PCB is already freed: the pending zero-copy sends
+ *  are failed, and the error is passed on to the socket layer.
+ *
+ * Parameters:
+ *  arg: Callback argument of the PCB.
+ *  err: Error that closed the connection.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_zc_err(void *arg, err_t err)
+{
+    tko_zc_conn_t *conn = tko_zc_find(arg);
+    tcp_err_fn errf;
+
+    if (NULL == conn)
+    {
+        return;
+    }
+
+    errf = conn->err;
+    tko_zc_release(conn);
+
+    if (NULL != errf)
+    {
+        errf(arg, err);
+    }
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_queue
+ ********************************************************************************
+ * Summary:
+ *  Records a zero-copy send written to the PCB, and starts sending it.
+ *
+ * Parameters:
+ *  conn: Connection.
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  chain: Chain to free once acknowledged, or NULL.
+ *  sent_cb: Called when the data is acknowledged or the connection is lost.
+ *  arg: Argument passed to sent_cb.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void tko_zc_queue(tko_zc_conn_t *conn, int index, struct pbuf *chain,
+                         tko_zc_sent_cb_t sent_cb, void *arg)
+{
+    tko_zc_pending_t *entry = &conn->pending[(conn->head + conn->count) % TKO_ZC_MAX_PENDING];
+
+    entry->chain = chain;
+    entry->sent_cb = sent_cb;
+    entry->arg = arg;
+    entry->index = index;
+    entry->end_seq = conn->pcb->snd_lbb;
+    conn->count++;
+
+    tcp_output(conn->pcb);
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_send
+ ********************************************************************************
+ * Summary:
+ *  Sends a buffer on a TCP Keepalive socket without copying it. The buffer must
+ *  not change until sent_cb is called.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  buffer: Data to send.
+ *  length: Length of the data in bytes.
+ *  sent_cb: Called when the data is acknowledged or the connection is lost.
+ *  arg: Argument passed to sent_cb.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the data is queued; CY_RSLT_TYPE_ERROR if the
+ *  socket is not connected or has no room for the data, and should be retried
+ *  after a pending send completes. Always CY_RSLT_TYPE_ERROR with
+ *  ENABLE_TKO_TLS.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_zc_send(int index, const void *buffer, uint16_t length, tko_zc_sent_cb_t sent_cb, void *arg)
+{
+    cy_rslt_t result = CY_RSLT_TYPE_ERROR;
+    tko_zc_conn_t *conn;
+
+    if (!TKO_ZC_AVAILABLE || (NULL == buffer) || (0 == length))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    LOCK_TCPIP_CORE();
+
+    conn = tko_zc_get_conn(index);
+
+    if ((NULL != conn) && (conn->count < TKO_ZC_MAX_PENDING) &&
+        (ERR_OK == tcp_write(conn->pcb, buffer, length, 0)))
+    {
+        tko_zc_queue(conn, index, NULL, sent_cb, arg);
+        result = CY_RSLT_SUCCESS;
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_send_pbuf
+ ********************************************************************************
+ * Summary:
+ *  Sends a pbuf chain on a TCP Keepalive socket without copying it. On success
+ *  the chain is owned by the zero-copy path, and freed when the data is
+ *  acknowledged; on failure it is still owned by the caller.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  chain: Data to send.
+ *  sent_cb: Called when the data is acknowledged or the connection is lost.
+ *  arg: Argument passed to sent_cb.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the data is queued; CY_RSLT_TYPE_ERROR if the
+ *  socket is not connected or has no room for the data. Always
+ *  CY_RSLT_TYPE_ERROR with ENABLE_TKO_TLS.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_zc_send_pbuf(int index, struct pbuf *chain, tko_zc_sent_cb_t sent_cb, void *arg)
+{
+    cy_rslt_t result = CY_RSLT_TYPE_ERROR;
+    tko_zc_conn_t *conn;
+    struct pbuf *q;
+
+    if (!TKO_ZC_AVAILABLE || (NULL == chain) || (0 == chain->tot_len))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    LOCK_TCPIP_CORE();
+
+    conn = tko_zc_get_conn(index);
+
+    /* The whole chain must fit, as a partly written chain cannot be taken back */
+    if ((NULL != conn) && (conn->count < TKO_ZC_MAX_PENDING) &&
+        (tcp_sndbuf(conn->pcb) >= chain->tot_len) &&
+        ((tcp_sndqueuelen(conn->pcb) + pbuf_clen(chain)) <= TCP_SND_QUEUELEN))
+    {
+        for (q = chain; NULL != q; q = q->next)
+        {
+            if ((q->len > 0) &&
+                (ERR_OK != tcp_write(conn->pcb, q->payload, q->len, (NULL != q->next) ? TCP_WRITE_FLAG_MORE : 0)))
+            {
+                break;
+            }
+        }
+
+        if (NULL == q)
+        {
+            tko_zc_queue(conn, index, chain, sent_cb, arg);
+            result = CY_RSLT_SUCCESS;
+        }
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_register_recv_cb
+ ********************************************************************************
+ * Summary:
+ *  Registers the callback that receives the data of a TCP Keepalive socket
+ *  without copying it. Once registered, the data does not go to the socket's
+ *  receive queue any more. Pass NULL to go back to the socket receive path.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *  recv_cb: Receive callback, or NULL.
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS on success. Always CY_RSLT_TYPE_ERROR
+ *  with ENABLE_TKO_TLS.
+ *
+ *******************************************************************************/
+cy_rslt_t tko_zc_register_recv_cb(int index, tko_zc_recv_cb_t recv_cb)
+{
+    if (!TKO_ZC_AVAILABLE || (index < 0) || (index >= MAX_TKO))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    LOCK_TCPIP_CORE();
+    recv_cbs[index] = recv_cb;
+    (void)tko_zc_get_conn(index);
+    UNLOCK_TCPIP_CORE();
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: tko_zc_attach
+ ********************************************************************************
+ * Summary:
+ *  Wraps the lwIP callbacks of a newly connected socket that has a receive
+ *  callback registered, so that its data takes the zero-copy path right away.
+ *
+ * Parameters:
+ *  index: Index of the socket in the TCP Keepalive port table.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void tko_zc_attach(int index)
+{
+    if ((index < 0) || (index >= MAX_TKO))
+    {
+        return;
+    }
+
+    LOCK_TCPIP_CORE();
+
+    if (NULL != recv_cbs[index])
+    {
+        (void)tko_zc_get_conn(index);
+    }
+
+    UNLOCK_TCPIP_CORE();
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,90 @@
+/******************************************************************************
+* File Name:   tko_zero_copy.h
+*
+* Description: This file is the public interface of tko_zero_copy.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TKO_ZERO_COPY_H
+#define TKO_ZERO_COPY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/* lwIP header file */
+#include "lwip/pbuf.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Zero-copy sends that can wait for their acknowledgement on each connection */
+#define TKO_ZC_MAX_PENDING                       (8)
+
+/* Connections tracked at once, including the ones being closed */
+#define TKO_ZC_MAX_CONNECTIONS                   (2 * MAX_TKO)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/*
+ * Called in the lwIP core context when the data of a zero-copy send is
+ * acknowledged by the server (delivered true), or when the connection is lost
+ * (delivered false). The buffer can be reused from then on.
+ */
+typedef void (*tko_zc_sent_cb_t)(int index, void *arg, bool delivered);
+
+/*
+ * Called in the lwIP core context with the data received on a connection. The
+ * callback takes ownership of the pbuf chain and must free it with pbuf_free().
+ */
+typedef void (*tko_zc_recv_cb_t)(int index, struct pbuf *p);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tko_zc_send(int index, const void *buffer, uint16_t length, tko_zc_sent_cb_t sent_cb, void *arg);
+cy_rslt_t tko_zc_send_pbuf(int index, struct pbuf *chain, tko_zc_sent_cb_t sent_cb, void *arg);
+cy_rslt_t tko_zc_register_recv_cb(int index, tko_zc_recv_cb_t recv_cb);
+void tko_zc_attach(int index);
+
+#endif /* TKO_ZERO_COPY_H */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,503 @@
+/******************************************************************************
+* File Name:   trace_events.c
+*
+* Description: Records the task switches, the interrupts that wake tasks, the
+*              idle sleeps and the offload edges into a RAM ring buffer, and
+*              exports it as Chrome trace event JSON.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cy_syslib.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "app_log.h"
+#include "debug_uart.h"
+#include "trace_events.h"
+
+#if defined(APP_TRACE_EVENTS)
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define US_PER_TICK                       (1000000u / configTICK_RATE_HZ)
+
+/* Track of the tasks beyond TRACE_EVENTS_MAX_TASKS */
+#define TRACK_OTHER_TASKS                 (TRACE_EVENTS_MAX_TASKS)
+
+/* Thread IDs of the trace: 0 for the power and event track, then one per task */
+#define TID_EVENTS                        (0u)
+#define TID_OF_TRACK(track)               ((uint32_t)(track) + 1u)
+
+/* First interrupt number in IPSR after the system exceptions */
+#define IPSR_IRQ_BASE                     (16u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    uint32_t timestamp_us;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t arg;
+} trace_event_t;
+
+/* The name is copied, as tasks such as the socket connect tasks are deleted
+ * and their handle can be reused by a later task.
+ */
+typedef struct
+{
+    TaskHandle_t handle;
+    char name[configMAX_TASK_NAME_LEN];
+} trace_events_task_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static trace_event_t events[TRACE_EVENTS_BUFFER_EVENTS];
+static uint32_t event_head = 0;
+static uint32_t event_count = 0;
+static volatile bool recording = false;
+
+static trace_events_task_t tasks[TRACE_EVENTS_MAX_TASKS];
+static uint32_t task_count = 0;
+
+/* Separator state of the JSON array being exported */
+static bool export_first = true;
+
+/********************************************************************************
+ * Function Name: trace_events_now_us
+ ********************************************************************************
+ * Summary:
+ *  Returns the time in microseconds, from the RTOS tick count and the SysTick
+ *  counter within the tick. The tick count is stepped over tickless sleeps, so
+ *  the time stays continuous across them. It wraps after about 71 minutes.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Time in microseconds.
+ *
+ *******************************************************************************/
+static uint32_t trace_events_now_us(void)
+{
+    uint32_t reload = SysTick->LOAD + 1u;
+    uint32_t tick = (uint32_t)xTaskGetTickCountFromISR();
+    uint32_t elapsed = reload - SysTick->VAL;
+
+    /* The counter wrapped, and the tick interrupt is not serviced yet */
+    if (0u != (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+    {
+        elapsed = reload - SysTick->VAL;
+        tick++;
+    }
+
+    return (tick * US_PER_TICK) + ((elapsed * US_PER_TICK) / reload);
+}
+
+/********************************************************************************
+ * Function Name: trace_events_record
+ ********************************************************************************
+ * Summary:
+ *  Appends an event to the ring buffer, overwriting the oldest one if it is
+ *  full. Can be called from tasks and from interrupts up to
+ *  configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * Parameters:
+ *  type: Type of the event.
+ *  arg: Argument of the event, see trace_event_type_t.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void trace_events_record(trace_event_type_t type, uint16_t arg)
+{
+    UBaseType_t mask;
+    trace_event_t *event;
+
+    if (!recording)
+    {
+        return;
+    }
+
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    event = &events[event_head];
+    event->timestamp_us = trace_events_now_us();
+    event->type = (uint8_t)type;
+    event->arg = arg;
+
+    event_head = (event_head + 1u) % TRACE_EVENTS_BUFFER_EVENTS;
+
+    if (event_count < TRACE_EVENTS_BUFFER_EVENTS)
+    {
+        event_count++;
+    }
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/********************************************************************************
+ * Function Name: trace_events_task_switched_in
+ ********************************************************************************
+ * Summary:
+ *  traceTASK_SWITCHED_IN() of the trace build. Records the task that starts
+ *  running, by its track in the task table.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void trace_events_task_switched_in(void)
+{
+    TaskHandle_t handle;
+    const char *name;
+    uint32_t track;
+
+    if (!recording)
+    {
+        return;
+    }
+
+    handle = xTaskGetCurrentTaskHandle();
+    name = pcTaskGetName(handle);
+
+    for (track = 0; track < task_count; track++)
+    {
+        if ((tasks[track].handle == handle) &&
+            (0 == strncmp(tasks[track].name, name, sizeof(tasks[track].name) - 1)))
+        {
+            break;
+        }
+    }
+
+    if (track == task_count)
+    {
+        if (task_count < TRACE_EVENTS_MAX_TASKS)
+        {
+            tasks[track].handle = handle;
+            strncpy(tasks[track].name, name, sizeof(tasks[track].name) - 1);
+            task_count++;
+        }
+        else
+        {
+            track = TRACK_OTHER_TASKS;
+        }
+    }
+
+    trace_events_record(TRACE_EVENT_TASK_SWITCH, (uint16_t)track);
+}
+
+/********************************************************************************
+ * Function Name: trace_events_isr
+ ********************************************************************************
+ * Summary:
+ *  Hook of the FromISR queue and task notification APIs in the trace build.
+ *  Records the interrupt that signals a task, such as the WLAN host wake or
+ *  the debug UART, by its exception number. Calls from a task are ignored.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void trace_events_isr(void)
+{
+    uint32_t ipsr = __get_IPSR();
+
+    if (0u != ipsr)
+    {
+        trace_events_record(TRACE_EVENT_ISR, (uint16_t)ipsr);
+    }
+}
+
+/********************************************************************************
+ * Function Name: trace_events_sleep
+ ********************************************************************************
+ * Summary:
+ *  traceLOW_POWER_IDLE_BEGIN() and traceLOW_POWER_IDLE_END() of the trace
+ *  build. Records the tickless idle periods of the idle task.
+ *
+ * Parameters:
+ *  begin: true before the idle task sleeps, false after it wakes.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void trace_events_sleep(bool begin)
+{
+    trace_events_record(begin ? TRACE_EVENT_SLEEP_BEGIN : TRACE_EVENT_SLEEP_END, 0);
+}
+
+/********************************************************************************
+ * Function Name: trace_events_print_begin
+ ********************************************************************************
+ * Summary:
+ *  Starts a trace event object, preceded by the separator of the JSON array if
+ *  it is not the first one.
+ *
+ * Parameters:
+ *  name: Name of the event.
+ *  phase: Phase of the event, such as "X" for a complete event.
+ *  tid: Thread ID of the track of the event.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void trace_events_print_begin(const char *name, const char *phase, uint32_t tid)
+{
+    printf("%s{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%"PRIu32,
+           export_first ? "" : ",\n", name, phase, tid);
+    export_first = false;
+}
+
+/********************************************************************************
+ * Function Name: trace_events_print_us
+ ********************************************************************************
+ * Summary:
+ *  Prints a field in microseconds. The value is split in two parts, as the
+ *  nano C library prints no 64-bit integers.
+ *
+ * Parameters:
+ *  field: Name of the field.
+ *  value_us: Value in microseconds.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void trace_events_print_us(const char *field, uint64_t value_us)
+{
+    if (value_us >= 1000000u)
+    {
+        printf(",\"%s\":%"PRIu32"%06"PRIu32, field,
+               (uint32_t)(value_us / 1000000u), (uint32_t)(value_us % 1000000u));
+    }
+    else
+    {
+        printf(",\"%s\":%"PRIu32, field, (uint32_t)value_us);
+    }
+}
+
+/********************************************************************************
+ * Function Name: trace_events_print_task_span
+ ********************************************************************************
+ * Summary:
+ *  Prints the period a task ran as a complete event on the track of the task.
+ *
+ * Parameters:
+ *  track: Track of the task.
+ *  start_us: Time at which the task was switched in.
+ *  end_us: Time at which the next task was switched in.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void trace_events_print_task_span(uint32_t track, uint64_t start_us, uint64_t end_us)
+{
+    trace_events_print_begin((track < task_count) ? tasks[track].name : "(other)", "X", TID_OF_TRACK(track));
+    trace_events_print_us("ts", start_us);
+    trace_events_print_us("dur", end_us - start_us);
+    printf("}");
+}
+
+/********************************************************************************
+ * Function Name: trace_events_export
+ ********************************************************************************
+ * Summary:
+ *  Prints the ring buffer on the debug UART as Chrome trace event JSON, which
+ *  chrome://tracing and Perfetto load. Each task has a track showing when it
+ *  ran, and the power track shows the idle sleeps, the interrupts that
+ *  signaled a task and the offload edges. The time starts at the oldest event
+ *  in the buffer. Recording pauses during the export, and the buffer is
+ *  cleared after it. It is run by the debug UART command
+ *  TRACE_EVENTS_EXPORT_COMMAND.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void trace_events_export(void)
+{
+    const trace_event_t *event;
+    uint32_t index;
+    uint32_t track;
+    uint32_t previous_us = 0;
+    uint64_t time_us = 0;
+    uint64_t span_start_us = 0;
+    uint32_t span_track = 0;
+    bool span_open = false;
+    char name[24];
+
+    recording = false;
+
+    /* Keep the buffered logs out of the JSON */
+    app_log_flush();
+
+    export_first = true;
+    printf("\n{\"traceEvents\":[\n");
+
+    trace_events_print_begin("process_name", "M", TID_EVENTS);
+    printf(",\"args\":{\"name\":\"TCP Keepalive Offload\"}}");
+    trace_events_print_begin("thread_name", "M", TID_EVENTS);
+    printf(",\"args\":{\"name\":\"Power and events\"}}");
+
+    for (track = 0; track <= task_count; track++)
+    {
+        trace_events_print_begin("thread_name", "M", TID_OF_TRACK((track < task_count) ? track : TRACK_OTHER_TASKS));
+        printf(",\"args\":{\"name\":\"%s\"}}", (track < task_count) ? tasks[track].name : "(other)");
+    }
+
+    for (index = 0; index < event_count; index++)
+    {
+        event = &events[(event_head + TRACE_EVENTS_BUFFER_EVENTS - event_count + index) % TRACE_EVENTS_BUFFER_EVENTS];
+
+        /* Unsigned difference, so that the wrap of the 32-bit time is handled */
+        if (0 != index)
+        {
+            time_us += event->timestamp_us - previous_us;
+        }
+
+        previous_us = event->timestamp_us;
+
+        switch ((trace_event_type_t)event->type)
+        {
+            case TRACE_EVENT_TASK_SWITCH:
+                if (span_open)
+                {
+                    trace_events_print_task_span(span_track, span_start_us, time_us);
+                }
+
+                span_open = true;
+                span_start_us = time_us;
+                span_track = event->arg;
+                break;
+
+            case TRACE_EVENT_ISR:
+                if (event->arg >= IPSR_IRQ_BASE)
+                {
+                    snprintf(name, sizeof(name), "IRQ %u", (unsigned int)(event->arg - IPSR_IRQ_BASE));
+                }
+                else
+                {
+                    snprintf(name, sizeof(name), "Exception %u", (unsigned int)event->arg);
+                }
+
+                trace_events_print_begin(name, "i", TID_EVENTS);
+                trace_events_print_us("ts", time_us);
+                printf(",\"s\":\"t\"}");
+                break;
+
+            case TRACE_EVENT_SLEEP_BEGIN:
+            case TRACE_EVENT_SLEEP_END:
+                trace_events_print_begin("Idle sleep", (TRACE_EVENT_SLEEP_BEGIN == event->type) ? "B" : "E", TID_EVENTS);
+                trace_events_print_us("ts", time_us);
+                printf("}");
+                break;
+
+            case TRACE_EVENT_OFFLOAD_ENABLED:
+            case TRACE_EVENT_OFFLOAD_DISABLED:
+                trace_events_print_begin((TRACE_EVENT_OFFLOAD_ENABLED == event->type) ?
+                                         "Offload enabled" : "Offload disabled", "i", TID_EVENTS);
+                trace_events_print_us("ts", time_us);
+                printf(",\"s\":\"g\"}");
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* The task running at the export ends at the last event */
+    if (span_open)
+    {
+        trace_events_print_task_span(span_track, span_start_us, time_us);
+    }
+
+    printf("\n]}\n");
+
+    event_head = 0;
+    event_count = 0;
+    recording = true;
+}
+
+/********************************************************************************
+ * Function Name: trace_events_init
+ ********************************************************************************
+ * Summary:
+ *  Starts recording and registers the debug UART command that exports the
+ *  trace.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the command is registered.
+ *
+ *******************************************************************************/
+cy_rslt_t trace_events_init(void)
+{
+    recording = true;
+
+    return debug_uart_register_command(TRACE_EVENTS_EXPORT_COMMAND, trace_events_export);
+}
+
+#endif /* APP_TRACE_EVENTS */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name:   trace_events.h
+*
+* Description: Records the task switches, the interrupts that wake tasks, the
+*              idle sleeps and the offload edges into a RAM ring buffer, and
+*              exports it as Chrome trace event JSON.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Debug UART command byte that exports the trace */
+#define TRACE_EVENTS_EXPORT_COMMAND              ('x')
+
+/* Events kept in the ring buffer, 8 bytes each. The oldest are overwritten. */
+#define TRACE_EVENTS_BUFFER_EVENTS               (512)
+
+/* Tasks named individually in the trace. The others share one track. */
+#define TRACE_EVENTS_MAX_TASKS                   (24)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    TRACE_EVENT_TASK_SWITCH = 0,     /* arg: task track */
+    TRACE_EVENT_ISR,                 /* arg: interrupt number */
+    TRACE_EVENT_SLEEP_BEGIN,
+    TRACE_EVENT_SLEEP_END,
+    TRACE_EVENT_OFFLOAD_ENABLED,
+    TRACE_EVENT_OFFLOAD_DISABLED,
+    TRACE_EVENT_TYPE_COUNT
+} trace_event_type_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t trace_events_init(void);
+void trace_events_record(trace_event_type_t type, uint16_t arg);
+void trace_events_export(void);
+
+/* Hooks of FreeRTOSConfig.h */
+void trace_events_task_switched_in(void);
+void trace_events_isr(void);
+void trace_events_sleep(bool begin);
+
+#endif /* TRACE_EVENTS_H */
+
+
+/* [] END OF FILE */
+
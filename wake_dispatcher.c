@@ -0,0 +1,415 @@
+/******************************************************************************
+* File Name:   wake_dispatcher.c
+*
+* Description: This file implements the wake dispatcher. When the network
+*              stack resumes from a suspend, it works out why the host was
+*              woken: a connection lost by the TCP Keepalive offload, data
+*              received on a TCP Keepalive socket, a link loss, or anything
+*              else. It then runs only the handling that the reason needs,
+*              and lets the network stack suspend again right away after a
+*              spurious wake.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header files */
+#include "cy_OlmInterface.h"
+#include "network_activity_handler.h"
+
+/* lwIP header files */
+#include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+
+/* Wi-Fi Host Driver header file */
+#include "whd_wifi_api.h"
+
+/* Wi-Fi connection manager header files */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "debug_uart.h"
+#include "network_suspend_scheduler.h"
+#include "tcp_keepalive_offload.h"
+#include "tko_health.h"
+#include "tko_metrics.h"
+#include "wake_dispatcher.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static TaskHandle_t dispatcher_task = NULL;
+static wake_data_handler_t data_handler = NULL;
+
+/* Receive sequence number of each socket when the stack was suspended */
+static uint32_t rcv_nxt_snapshot[MAX_TKO];
+
+/* Number of wakes by reason */
+static uint32_t wake_count[WAKE_REASON_MAX];
+
+static const char *const wake_reason_name[WAKE_REASON_MAX] =
+{
+    "TKO failure", "data", "link loss", "other"
+};
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_tko_status
+ ********************************************************************************
+ * Summary:
+ *  Reads the status of the offloaded connections from the WLAN firmware.
+ *
+ * Parameters:
+ *  failed_mask: Set to the sockets whose connection the offload has lost.
+ *  data_mask: Set to the sockets on which the offload has seen data.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wake_dispatcher_tko_status(uint32_t *failed_mask, uint32_t *data_mask)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    whd_tko_status_t tko_status;
+    int index;
+
+    *failed_mask = 0;
+    *data_mask = 0;
+
+    memset(&tko_status, 0, sizeof(tko_status));
+
+    if (WHD_SUCCESS != whd_tko_get_status((whd_interface_t)netif->state, &tko_status))
+    {
+        return;
+    }
+
+    for (index = 0; (index < tko_status.count) && (index < MAX_TKO); index++)
+    {
+        switch (tko_status.status[index])
+        {
+            case TKO_STATUS_NORMAL:
+            case TKO_STATUS_UNAVAILABLE:
+                break;
+
+            case TKO_STATUS_TCP_DATA:
+                *data_mask |= (1u << index);
+                break;
+
+            default:
+                *failed_mask |= (1u << index);
+                break;
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_rx_mask
+ ********************************************************************************
+ * Summary:
+ *  Returns the sockets that have received data since the network stack was
+ *  suspended.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Bit n set if the socket at index n has received data.
+ *
+ *******************************************************************************/
+static uint32_t wake_dispatcher_rx_mask(void)
+{
+    struct tcp_pcb *pcb;
+    uint32_t mask = 0;
+    int index;
+
+    LOCK_TCPIP_CORE();
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        pcb = tcp_socket_get_pcb(index);
+
+        if ((NULL != pcb) && (pcb->rcv_nxt != rcv_nxt_snapshot[index]))
+        {
+            mask |= (1u << index);
+        }
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+    return mask;
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_task
+ ********************************************************************************
+ * Summary:
+ *  Classifies each wake signalled by wake_dispatcher_resume() and runs its
+ *  handling: a reconnect of only the sockets lost by the offload, by the
+ *  health monitor (see tko_health.c), the
+ *  application data handler for the sockets that received data, nothing for a
+ *  link loss (see wifi_fast_rejoin.c), and an immediate suspend otherwise.
+ *
+ * Parameters:
+ *  arg: Unused.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wake_dispatcher_task(void *arg)
+{
+    uint32_t failed_mask;
+    uint32_t data_mask;
+    bool classified;
+
+    (void)arg;
+
+    while (true)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        classified = false;
+        wake_dispatcher_tko_status(&failed_mask, &data_mask);
+
+        if (!cy_wcm_is_connected_to_ap())
+        {
+            wake_count[WAKE_REASON_LINK_LOSS]++;
+            continue;
+        }
+
+        /* Let lwIP process the packets that were queued while suspended */
+        vTaskDelay(pdMS_TO_TICKS(WAKE_DISPATCHER_RX_SETTLE_MS));
+        data_mask |= wake_dispatcher_rx_mask();
+        data_mask &= ~failed_mask;
+
+        if (0 != data_mask)
+        {
+            wake_count[WAKE_REASON_DATA]++;
+            classified = true;
+
+#if ENABLE_TKO_METRICS
+            /* The metrics requests are answered in this awake window */
+            if (0 != (data_mask & (1u << TKO_METRICS_SOCKET_INDEX)))
+            {
+                data_mask &= ~(1u << TKO_METRICS_SOCKET_INDEX);
+                tko_metrics_serve();
+            }
+#endif
+
+            if ((0 != data_mask) && (NULL != data_handler))
+            {
+                data_handler(data_mask);
+            }
+        }
+
+        if (0 != failed_mask)
+        {
+            wake_count[WAKE_REASON_TKO_FAILURE]++;
+            classified = true;
+
+            /* Only the lost sockets are rebuilt, by the health monitor */
+            tko_health_report_failure(failed_mask);
+        }
+
+        if (!classified)
+        {
+            wake_count[WAKE_REASON_OTHER]++;
+            net_suspend_scheduler_expedite();
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_init
+ ********************************************************************************
+ * Summary:
+ *  Starts the wake dispatcher task, and registers the debug UART command that
+ *  prints the wake counters.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: Returns CY_RSLT_SUCCESS if the task is started.
+ *
+ *******************************************************************************/
+cy_rslt_t wake_dispatcher_init(void)
+{
+    if (pdPASS != xTaskCreate(wake_dispatcher_task, "WakeDisp", WAKE_DISPATCHER_TASK_STACK_SIZE,
+                              NULL, WAKE_DISPATCHER_TASK_PRIORITY, &dispatcher_task))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    debug_uart_register_command(WAKE_DISPATCHER_REPORT_COMMAND, wake_dispatcher_report);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_register_data_handler
+ ********************************************************************************
+ * Summary:
+ *  Registers the application handler for the wakes caused by received data.
+ *  It runs in the wake dispatcher task.
+ *
+ * Parameters:
+ *  handler: Data handler, or NULL.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wake_dispatcher_register_data_handler(wake_data_handler_t handler)
+{
+    data_handler = handler;
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_suspend_begin
+ ********************************************************************************
+ * Summary:
+ *  Takes the receive state of the sockets before the network stack is
+ *  suspended. It is called by the network idle task.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wake_dispatcher_suspend_begin(void)
+{
+    struct tcp_pcb *pcb;
+    int index;
+
+    LOCK_TCPIP_CORE();
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        pcb = tcp_socket_get_pcb(index);
+        rcv_nxt_snapshot[index] = (NULL != pcb) ? pcb->rcv_nxt : 0;
+    }
+
+    UNLOCK_TCPIP_CORE();
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_resume
+ ********************************************************************************
+ * Summary:
+ *  Hands a wake over to the wake dispatcher task. It is called by the network
+ *  idle task when wait_net_suspend() returns. The buffered logs are printed
+ *  while the system is awake.
+ *
+ * Parameters:
+ *  status: Return code of wait_net_suspend(). Only a resume from a suspend
+ *  (ST_SUCCESS) is a wake.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wake_dispatcher_resume(int32_t status)
+{
+    if ((ST_SUCCESS == status) && (NULL != dispatcher_task))
+    {
+        xTaskNotifyGive(dispatcher_task);
+    }
+
+    app_log_kick();
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_get_counts
+ ********************************************************************************
+ * Summary:
+ *  Returns the number of wakes by reason since the start.
+ *
+ * Parameters:
+ *  counts: Filled in with the number of wakes, by wake_reason_t.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wake_dispatcher_get_counts(uint32_t counts[WAKE_REASON_MAX])
+{
+    int reason;
+
+    for (reason = 0; reason < WAKE_REASON_MAX; reason++)
+    {
+        counts[reason] = wake_count[reason];
+    }
+}
+
+/********************************************************************************
+ * Function Name: wake_dispatcher_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the number of wakes by reason. It is run by the debug UART command
+ *  WAKE_DISPATCHER_REPORT_COMMAND.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wake_dispatcher_report(void)
+{
+    int reason;
+
+    for (reason = 0; reason < WAKE_REASON_MAX; reason++)
+    {
+        APP_INFO(("Wakes on %s: %"PRIu32"\n", wake_reason_name[reason], wake_count[reason]));
+    }
+}
+
+
+/* [] END OF FILE */
+
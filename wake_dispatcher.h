@@ -0,0 +1,100 @@
+/******************************************************************************
+* File Name:   wake_dispatcher.h
+*
+* Description: This file is the public interface of wake_dispatcher.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef WAKE_DISPATCHER_H
+#define WAKE_DISPATCHER_H
+
+#include <stdint.h>
+
+/* FreeRTOS header file */
+#include <FreeRTOS.h>
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Stack size and priority of the task that handles the wakes */
+#ifndef WAKE_DISPATCHER_TASK_STACK_SIZE
+#define WAKE_DISPATCHER_TASK_STACK_SIZE          (1024)
+#endif
+#ifndef WAKE_DISPATCHER_TASK_PRIORITY
+#define WAKE_DISPATCHER_TASK_PRIORITY            (2)
+#endif
+
+/* Time given to lwIP to process the packets queued while suspended */
+#define WAKE_DISPATCHER_RX_SETTLE_MS             (10)
+
+/* Debug UART command byte that prints the wake counters */
+#define WAKE_DISPATCHER_REPORT_COMMAND           ('w')
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    WAKE_REASON_TKO_FAILURE = 0,    /* The firmware lost an offloaded connection */
+    WAKE_REASON_DATA,               /* Data was received on a TKO socket */
+    WAKE_REASON_LINK_LOSS,          /* The link to the AP is down */
+    WAKE_REASON_OTHER,              /* Anything else, such as ARP or broadcast */
+    WAKE_REASON_MAX
+} wake_reason_t;
+
+/* Called with the sockets, by index in the TCP Keepalive port table, that
+ * received data while the network stack was suspended.
+ */
+typedef void (*wake_data_handler_t)(uint32_t socket_mask);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t wake_dispatcher_init(void);
+void wake_dispatcher_register_data_handler(wake_data_handler_t handler);
+void wake_dispatcher_suspend_begin(void);
+void wake_dispatcher_resume(int32_t status);
+void wake_dispatcher_report(void);
+void wake_dispatcher_get_counts(uint32_t counts[WAKE_REASON_MAX]);
+
+#endif /* WAKE_DISPATCHER_H */
+
+
+/* [] END OF FILE */
+
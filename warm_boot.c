@@ -0,0 +1,549 @@
+/******************************************************************************
+* File Name:   warm_boot.c
+*
+* Description: This file saves the offload configuration and the join state
+*              in a flash row, and restores them after a software or watchdog
+*              reset.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cyhal.h"
+#include "cy_syslib.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header file */
+#include "lwip/ip_addr.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "app_crc.h"
+#include "tcp_keepalive_offload.h"
+#include "offload_registry.h"
+#include "tko_runtime_config.h"
+#include "wifi_fast_rejoin.h"
+#include "warm_boot.h"
+
+#if ENABLE_WARM_BOOT
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define WARM_BOOT_RECORD_MAGIC            (0x544B4F57u) /* "WOKT" */
+#define WARM_BOOT_RAM_MAGIC               (0x4B4F5752u) /* "RWOK" */
+
+/* Resets that keep the RAM and the network configuration: software and watchdog */
+#define WARM_BOOT_RESET_REASONS           (CY_SYSLIB_RESET_SOFT | CY_SYSLIB_RESET_HWWDT |        \
+                                           CY_SYSLIB_RESET_SWWDT0 | CY_SYSLIB_RESET_SWWDT1 |     \
+                                           CY_SYSLIB_RESET_SWWDT2 | CY_SYSLIB_RESET_SWWDT3)
+
+/* The lease of an address that never expires, such as in the IPv6-only build */
+#define WARM_BOOT_LEASE_FOREVER           (UINT32_MAX)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Saved state; the record is rewritten only when it changes */
+typedef struct
+{
+    cy_tko_ol_cfg_t tko_cfg;
+    tko_keepalive_params_t params[MAX_TKO];
+
+    /* Port table as validated by the offload registry */
+    uint32_t valid_ports;
+    ip_addr_t remote_addr[MAX_TKO];
+
+    /* Join state, with the uptime of the boot that saved it until when the address can be reused */
+    bool rejoin_valid;
+    bool lease_forever;
+    wifi_rejoin_state_t rejoin;
+    uint64_t lease_deadline_ms;
+} warm_boot_content_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;
+
+    /* Boot that saved the record, see warm_boot_ram_t */
+    uint32_t boot;
+
+    warm_boot_content_t content;
+
+    /* CRC-32 of the record up to here */
+    uint32_t crc;
+} warm_boot_record_t;
+
+/*
+ * Kept in the RAM across a software or watchdog reset: the count of the boot
+ * and its uptime at the last wake. It tells how long the previous boot ran
+ * after saving the record, short of the time asleep after its last wake.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t boot;
+    uint64_t uptime_ms;
+    uint32_t check;
+} warm_boot_ram_t;
+
+_Static_assert(sizeof(warm_boot_record_t) <= CY_FLASH_SIZEOF_ROW, "Warm boot record does not fit in a flash row");
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/*
+ * Flash row of the record, in the emulated EEPROM region. The row is part of
+ * the programmed image, so programming a new build erases the record.
+ */
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(CY_FLASH_SIZEOF_ROW)
+static const volatile uint8_t warm_boot_flash[CY_FLASH_SIZEOF_ROW] = { 0 };
+
+static CY_NOINIT warm_boot_ram_t warm_boot_ram;
+
+/* Record of the previous boot, and the one being written */
+static warm_boot_record_t warm_boot_record;
+static uint32_t warm_boot_row[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+
+/* Keepalive parameters of each connection restored from the record */
+static tko_keepalive_params_t restored_params[MAX_TKO];
+
+static SemaphoreHandle_t warm_boot_lock = NULL;
+static bool warm_boot = false;
+
+/********************************************************************************
+ * Function Name: warm_boot_uptime_ms
+ ********************************************************************************
+ * Summary:
+ *  Returns the time since the scheduler started, without the wrap of the tick
+ *  count after 49.7 days at a 1 kHz tick. The timeout state of FreeRTOS holds
+ *  the tick count with the number of times it wrapped.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint64_t: Uptime in milliseconds.
+ *
+ *******************************************************************************/
+static uint64_t warm_boot_uptime_ms(void)
+{
+    TimeOut_t now;
+
+    vTaskSetTimeOutState(&now);
+
+    return ((((uint64_t)(uint32_t)now.xOverflowCount) << 32) | now.xTimeOnEntering) * portTICK_PERIOD_MS;
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_ram_check
+ ********************************************************************************
+ * Summary:
+ *  Computes the check word of the RAM state, so that the random content of the
+ *  RAM after a power on is not taken for a previous boot.
+ *
+ * Parameters:
+ *  ram: RAM state.
+ *
+ * Return:
+ *  uint32_t: Check word.
+ *
+ *******************************************************************************/
+static uint32_t warm_boot_ram_check(const warm_boot_ram_t *ram)
+{
+    return ~(ram->magic ^ ram->boot ^ (uint32_t)ram->uptime_ms ^ (uint32_t)(ram->uptime_ms >> 32));
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_record_valid
+ ********************************************************************************
+ * Summary:
+ *  Tells whether a record has the expected magic, version, length and CRC.
+ *
+ * Parameters:
+ *  record: Record to check.
+ *
+ * Return:
+ *  bool: true if the record is valid.
+ *
+ *******************************************************************************/
+static bool warm_boot_record_valid(const warm_boot_record_t *record)
+{
+    return (WARM_BOOT_RECORD_MAGIC == record->magic) &&
+           (WARM_BOOT_RECORD_VERSION == record->version) &&
+           (sizeof(warm_boot_record_t) == record->length) &&
+           (app_crc32(record, offsetof(warm_boot_record_t, crc)) == record->crc);
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_flash_read
+ ********************************************************************************
+ * Summary:
+ *  Copies the record from its flash row.
+ *
+ * Parameters:
+ *  record: Filled in with the content of the flash row.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void warm_boot_flash_read(warm_boot_record_t *record)
+{
+    uint8_t *byte = (uint8_t *)record;
+    size_t index;
+
+    for (index = 0; index < sizeof(*record); index++)
+    {
+        byte[index] = warm_boot_flash[index];
+    }
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_flash_write
+ ********************************************************************************
+ * Summary:
+ *  Erases the flash row of the record and programs it with the given record.
+ *  The CPU is stalled while the row is programmed.
+ *
+ * Parameters:
+ *  record: Record to write.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, a HAL flash error code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t warm_boot_flash_write(const warm_boot_record_t *record)
+{
+    cyhal_flash_t flash;
+    cy_rslt_t result;
+
+    memset(warm_boot_row, 0, sizeof(warm_boot_row));
+    memcpy(warm_boot_row, record, sizeof(*record));
+
+    result = cyhal_flash_init(&flash);
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        result = cyhal_flash_write(&flash, (uint32_t)warm_boot_flash, warm_boot_row);
+        cyhal_flash_free(&flash);
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_restore
+ ********************************************************************************
+ * Summary:
+ *  Checks the reset reason and, after a software or watchdog reset, restores
+ *  the record saved by the previous boot: the validated port table into the
+ *  offload registry, the runtime TCP Keepalive configuration, and the join
+ *  state into the fast rejoin cache. The address of the join state is only
+ *  reused if the previous boot saved the record and its reuse time is not over,
+ *  counting the time that boot ran after saving it. Call it once, before
+ *  offload_registry_init().
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the record was restored, CY_RSLT_TYPE_ERROR
+ *  on a cold boot or if there is no valid record.
+ *
+ *******************************************************************************/
+cy_rslt_t warm_boot_restore(void)
+{
+    warm_boot_content_t *content = &warm_boot_record.content;
+    uint32_t reset_reason = Cy_SysLib_GetResetReason();
+    bool ram_valid = (WARM_BOOT_RAM_MAGIC == warm_boot_ram.magic) &&
+                     (warm_boot_ram_check(&warm_boot_ram) == warm_boot_ram.check);
+    uint32_t previous_boot = warm_boot_ram.boot;
+    uint64_t previous_uptime_ms = warm_boot_ram.uptime_ms;
+
+    Cy_SysLib_ClearResetReason();
+
+    /* Start counting this boot */
+    warm_boot_ram.magic = WARM_BOOT_RAM_MAGIC;
+    warm_boot_ram.boot = ram_valid ? (previous_boot + 1) : 0;
+    warm_boot_ram.uptime_ms = 0;
+    warm_boot_ram.check = warm_boot_ram_check(&warm_boot_ram);
+
+    if (NULL == warm_boot_lock)
+    {
+        warm_boot_lock = xSemaphoreCreateMutex();
+    }
+
+    warm_boot_flash_read(&warm_boot_record);
+
+    if (!warm_boot_record_valid(&warm_boot_record))
+    {
+        memset(&warm_boot_record, 0, sizeof(warm_boot_record));
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    if (0 == (reset_reason & WARM_BOOT_RESET_REASONS))
+    {
+        APP_INFO(("Cold boot, reset reason 0x%"PRIx32"\n", reset_reason));
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    offload_registry_tko_restore(content->valid_ports, content->remote_addr);
+    tcp_socket_runtime_cfg_restore(&content->tko_cfg);
+    memcpy(restored_params, content->params, sizeof(restored_params));
+
+    if (content->rejoin_valid)
+    {
+        if (content->lease_forever)
+        {
+            content->rejoin.lease_left_ms = WARM_BOOT_LEASE_FOREVER;
+        }
+        else if (ram_valid && (previous_boot == warm_boot_record.boot) &&
+                 (content->lease_deadline_ms > previous_uptime_ms + WARM_BOOT_LEASE_MARGIN_MS))
+        {
+            /* No more than the time left when the record was saved, so it fits */
+            content->rejoin.lease_left_ms = (uint32_t)(content->lease_deadline_ms - previous_uptime_ms -
+                                                       WARM_BOOT_LEASE_MARGIN_MS);
+        }
+        else
+        {
+            /* The lease may be over; only the configuration is restored */
+            content->rejoin.lease_left_ms = 0;
+        }
+
+        wifi_fast_rejoin_cache_import(&content->rejoin);
+    }
+
+    warm_boot = true;
+
+    APP_INFO(("Warm boot, reset reason 0x%"PRIx32": restored %"PRIu32" TCP Keepalive ports%s\n",
+              reset_reason, offload_registry_tko_port_count(),
+              (content->rejoin_valid && (0 != content->rejoin.lease_left_ms)) ? " and the join state" : ""));
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_is_warm
+ ********************************************************************************
+ * Summary:
+ *  Tells whether warm_boot_restore() restored the record of the previous boot.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool: true on a warm boot.
+ *
+ *******************************************************************************/
+bool warm_boot_is_warm(void)
+{
+    return warm_boot;
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_apply_overrides
+ ********************************************************************************
+ * Summary:
+ *  Applies the keepalive parameters of each connection restored from the
+ *  record, where they differ from the runtime configuration. Call it once the
+ *  TCP connections are up, as the parameters can only be set on a connected
+ *  socket.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void warm_boot_apply_overrides(void)
+{
+    tko_keepalive_params_t current;
+    int index;
+
+    if (!warm_boot)
+    {
+        return;
+    }
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if ((0 == restored_params[index].interval) ||
+            (CY_RSLT_SUCCESS != tko_get_keepalive_params(index, &current)) ||
+            (0 == memcmp(&current, &restored_params[index], sizeof(current))))
+        {
+            continue;
+        }
+
+        (void)tko_set_keepalive_params(index, &restored_params[index]);
+    }
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_save
+ ********************************************************************************
+ * Summary:
+ *  Saves the runtime TCP Keepalive configuration, the keepalive parameters of
+ *  each connection, the validated port table, and the fast rejoin state in the
+ *  flash row of the record. The row is only written when the content changed,
+ *  or once per boot so that the record tells which boot saved it.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the record is up to date, CY_RSLT_TYPE_ERROR if
+ *  warm_boot_restore() was not called or there is nothing to save yet, a HAL
+ *  flash error code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t warm_boot_save(void)
+{
+    static warm_boot_record_t record;
+    warm_boot_content_t *content = &record.content;
+    const ip_addr_t *remote_addr;
+    uint64_t uptime_ms = warm_boot_uptime_ms();
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    int index;
+
+    /* Nothing to save before the configuration is taken */
+    if ((NULL == warm_boot_lock) || (0 == tko_runtime_cfg.interval))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    warm_boot_heartbeat();
+
+    xSemaphoreTake(warm_boot_lock, portMAX_DELAY);
+
+    memset(&record, 0, sizeof(record));
+    record.magic = WARM_BOOT_RECORD_MAGIC;
+    record.version = WARM_BOOT_RECORD_VERSION;
+    record.length = sizeof(record);
+    record.boot = warm_boot_ram.boot;
+
+    memcpy(&content->tko_cfg, &tko_runtime_cfg, sizeof(content->tko_cfg));
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        remote_addr = offload_registry_tko_remote_addr(index);
+
+        if (NULL != remote_addr)
+        {
+            content->valid_ports |= (1u << index);
+            ip_addr_copy(content->remote_addr[index], *remote_addr);
+        }
+
+        (void)tko_get_keepalive_params(index, &content->params[index]);
+    }
+
+    content->rejoin_valid = wifi_fast_rejoin_cache_export(&content->rejoin);
+
+    if (content->rejoin_valid)
+    {
+        /* Kept as a deadline, so that the content does not change over time */
+        content->lease_forever = (WARM_BOOT_LEASE_FOREVER == content->rejoin.lease_left_ms);
+        content->lease_deadline_ms = content->lease_forever ? 0 : (uptime_ms + content->rejoin.lease_left_ms);
+        content->rejoin.lease_left_ms = 0;
+    }
+
+    record.crc = app_crc32(&record, offsetof(warm_boot_record_t, crc));
+
+    if ((record.boot != warm_boot_record.boot) ||
+        (0 != memcmp(&record.content, &warm_boot_record.content, sizeof(record.content))) ||
+        !warm_boot_record_valid(&warm_boot_record))
+    {
+        result = warm_boot_flash_write(&record);
+
+        if (CY_RSLT_SUCCESS == result)
+        {
+            memcpy(&warm_boot_record, &record, sizeof(warm_boot_record));
+        }
+        else
+        {
+            ERR_INFO(("Failed to save the warm boot record. Error code:%"PRIu32"\n", result));
+        }
+    }
+
+    xSemaphoreGive(warm_boot_lock);
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: warm_boot_heartbeat
+ ********************************************************************************
+ * Summary:
+ *  Records the uptime in the RAM that is kept across a reset, so that the next
+ *  boot knows how long this one ran. Call it after each wake.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void warm_boot_heartbeat(void)
+{
+    uint64_t uptime_ms = warm_boot_uptime_ms();
+    uint32_t saved_interrupt_status = cyhal_system_critical_section_enter();
+
+    warm_boot_ram.uptime_ms = uptime_ms;
+    warm_boot_ram.check = warm_boot_ram_check(&warm_boot_ram);
+
+    cyhal_system_critical_section_exit(saved_interrupt_status);
+}
+
+#endif /* ENABLE_WARM_BOOT */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,441 @@
+/******************************************************************************
+* File Name:   wifi_ap_candidates.c
+*
+* Description: This file keeps a ranked list of the APs of the configured
+*              networks, refreshed by a background scan while the host is
+*              awake anyway, and joins them directly by BSSID when the link
+*              to the last AP cannot be restored.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* Wi-Fi connection manager header file */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "app_platform.h"
+#include "debug_uart.h"
+#include "tcp_keepalive_offload.h"
+#include "wifi_ap_candidates.h"
+
+#if ENABLE_WIFI_AP_CANDIDATES
+
+#if !ENABLE_WIFI_FAST_REJOIN
+#error "ENABLE_WIFI_AP_CANDIDATES is used by the fast rejoin, enable ENABLE_WIFI_FAST_REJOIN"
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Highest 2.4 GHz channel number */
+#define WIFI_MAX_2_4_GHZ_CHANNEL          (14)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Network whose APs are candidates */
+typedef struct
+{
+    const char *ssid;
+    const char *password;
+    cy_wcm_security_t security;
+} wifi_ap_network_t;
+
+/* AP seen by the last scan */
+typedef struct
+{
+    uint8_t network;
+    uint8_t channel;
+    int16_t rssi;
+    bool failed;
+    cy_wcm_mac_t bssid;
+    cy_wcm_wifi_band_t band;
+} wifi_ap_candidate_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const wifi_ap_network_t networks[] =
+{
+    { WIFI_SSID, WIFI_PASSWORD, WIFI_SECURITY_TYPE },
+#ifdef WIFI_AP_CANDIDATE_NETWORKS
+    WIFI_AP_CANDIDATE_NETWORKS
+#endif
+};
+
+#define WIFI_AP_NETWORK_COUNT             ((int)(sizeof(networks) / sizeof(networks[0])))
+
+/* Ranked by signal strength, read and replaced under a critical section */
+static wifi_ap_candidate_t candidates[WIFI_AP_CANDIDATE_MAX];
+static int candidate_count = 0;
+static TickType_t candidates_tick;
+
+/* Filled in by the scan callback, in the WCM worker thread */
+static wifi_ap_candidate_t scan_results[WIFI_AP_CANDIDATE_MAX];
+static int scan_result_count = 0;
+
+static volatile bool scan_running = false;
+static bool scanned = false;
+static TickType_t last_scan_tick;
+static uint32_t scan_count = 0;
+static uint32_t failover_count = 0;
+
+/********************************************************************************
+ * Function Name: wifi_ap_candidates_network
+ ********************************************************************************
+ * Summary:
+ *  Looks up the configured network of an SSID.
+ *
+ * Parameters:
+ *  ssid: SSID seen by the scan.
+ *
+ * Return:
+ *  int: Index of the network in networks[], or -1 if it is not configured.
+ *
+ *******************************************************************************/
+static int wifi_ap_candidates_network(const uint8_t *ssid)
+{
+    int index;
+
+    for (index = 0; index < WIFI_AP_NETWORK_COUNT; index++)
+    {
+        if (0 == strncmp((const char *)ssid, networks[index].ssid, CY_WCM_MAX_SSID_LEN))
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/********************************************************************************
+ * Function Name: wifi_ap_candidates_scan_cb
+ ********************************************************************************
+ * Summary:
+ *  WCM scan callback. Keeps the WIFI_AP_CANDIDATE_MAX strongest APs of the
+ *  configured networks, sorted by signal strength, and replaces the candidate
+ *  list with them when the scan completes.
+ *
+ * Parameters:
+ *  result: AP found, or NULL at the end of the scan.
+ *  user_data: Not used.
+ *  status: CY_WCM_SCAN_INCOMPLETE while results come in, CY_WCM_SCAN_COMPLETE
+ *  at the end of the scan.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_ap_candidates_scan_cb(cy_wcm_scan_result_t *result, void *user_data, cy_wcm_scan_status_t status)
+{
+    wifi_ap_candidate_t entry;
+    int network;
+    int slot;
+
+    (void)user_data;
+
+    if ((CY_WCM_SCAN_INCOMPLETE == status) && (NULL != result) &&
+        ((network = wifi_ap_candidates_network(result->SSID)) >= 0))
+    {
+        /* The same AP can be reported more than once */
+        for (slot = 0; slot < scan_result_count; slot++)
+        {
+            if (0 == memcmp(scan_results[slot].bssid, result->BSSID, sizeof(cy_wcm_mac_t)))
+            {
+                return;
+            }
+        }
+
+        memset(&entry, 0, sizeof(entry));
+        entry.network = (uint8_t)network;
+        entry.channel = result->channel;
+        entry.rssi = result->signal_strength;
+        entry.band = (result->channel > WIFI_MAX_2_4_GHZ_CHANNEL) ? CY_WCM_WIFI_BAND_5GHZ : CY_WCM_WIFI_BAND_2_4GHZ;
+        memcpy(entry.bssid, result->BSSID, sizeof(entry.bssid));
+
+        /* Insertion into the sorted results, dropping the weakest when full */
+        slot = (scan_result_count < WIFI_AP_CANDIDATE_MAX) ? scan_result_count++ : WIFI_AP_CANDIDATE_MAX;
+
+        while ((slot > 0) && (scan_results[slot - 1].rssi < entry.rssi))
+        {
+            if (slot < WIFI_AP_CANDIDATE_MAX)
+            {
+                scan_results[slot] = scan_results[slot - 1];
+            }
+            slot--;
+        }
+
+        if (slot < WIFI_AP_CANDIDATE_MAX)
+        {
+            scan_results[slot] = entry;
+        }
+    }
+    else if (CY_WCM_SCAN_COMPLETE == status)
+    {
+        /* A scan that found none of the networks keeps the previous list */
+        if (0 != scan_result_count)
+        {
+            taskENTER_CRITICAL();
+            memcpy(candidates, scan_results, sizeof(candidates));
+            candidate_count = scan_result_count;
+            candidates_tick = xTaskGetTickCount();
+            taskEXIT_CRITICAL();
+        }
+
+        scan_count++;
+        scan_running = false;
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_ap_candidates_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the candidate list, the scans, and the failovers. Registered as a
+ *  debug UART command.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_ap_candidates_report(void)
+{
+    wifi_ap_candidate_t list[WIFI_AP_CANDIDATE_MAX];
+    const wifi_ap_candidate_t *entry;
+    TickType_t list_tick;
+    int count;
+    int index;
+
+    taskENTER_CRITICAL();
+    memcpy(list, candidates, sizeof(list));
+    count = candidate_count;
+    list_tick = candidates_tick;
+    taskEXIT_CRITICAL();
+
+    APP_INFO(("Rank  BSSID              Channel  RSSI  SSID\n"));
+
+    for (index = 0; index < count; index++)
+    {
+        entry = &list[index];
+        APP_INFO(("%4d  %02X:%02X:%02X:%02X:%02X:%02X %7d %5d  %s%s\n", index + 1,
+                  entry->bssid[0], entry->bssid[1], entry->bssid[2], entry->bssid[3], entry->bssid[4],
+                  entry->bssid[5], entry->channel, entry->rssi, networks[entry->network].ssid,
+                  entry->failed ? " (failed)" : ""));
+    }
+
+    if (0 != count)
+    {
+        APP_INFO(("Scanned %"PRIu32" s ago, ", TICKS_TO_MS(xTaskGetTickCount() - list_tick) / 1000u));
+    }
+
+    APP_INFO(("Scans: %"PRIu32", failovers: %"PRIu32"\n", scan_count, failover_count));
+}
+
+/********************************************************************************
+ * Function Name: wifi_ap_candidates_init
+ ********************************************************************************
+ * Summary:
+ *  Registers the debug UART command that prints the candidate list. The first
+ *  scan is started at the next host wake.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_ap_candidates_init(void)
+{
+    debug_uart_register_command(WIFI_AP_CANDIDATES_REPORT_COMMAND, wifi_ap_candidates_report);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: wifi_ap_candidates_wake
+ ********************************************************************************
+ * Summary:
+ *  Starts a background scan if the last one is WIFI_AP_SCAN_PERIOD_MS old.
+ *  Called by the network idle task each time the host wakes, so the scans add
+ *  no wake of their own. The results are collected by the WCM worker thread
+ *  while the link stays up.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wifi_ap_candidates_wake(void)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    if (scan_running || !cy_wcm_is_connected_to_ap() ||
+        (scanned && (TICKS_TO_MS(now - last_scan_tick) < WIFI_AP_SCAN_PERIOD_MS)))
+    {
+        return;
+    }
+
+    /* A scan refused by the WCM, such as during a join, waits for the next period */
+    scanned = true;
+    last_scan_tick = now;
+    scan_result_count = 0;
+    scan_running = true;
+
+    if (CY_RSLT_SUCCESS != cy_wcm_start_scan(wifi_ap_candidates_scan_cb, NULL, NULL))
+    {
+        scan_running = false;
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_ap_candidates_join
+ ********************************************************************************
+ * Summary:
+ *  Joins the candidates directly by BSSID and band, in the order of the last
+ *  scan, so no full scan is needed. Each candidate is tried once, so the time
+ *  taken is bounded by WIFI_AP_CANDIDATE_MAX joins. A candidate that fails is
+ *  skipped by the next failovers until the next scan. On success, the
+ *  credentials of the network joined are kept in connect_param for the next
+ *  rejoin. The address is obtained by DHCP.
+ *
+ * Parameters:
+ *  skip_bssid: AP already tried by the caller, or NULL.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if a candidate was joined, a WCM error code, or
+ *  CY_RSLT_TYPE_ERROR if there is no candidate left.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_ap_candidates_join(const cy_wcm_mac_t skip_bssid)
+{
+    wifi_ap_candidate_t list[WIFI_AP_CANDIDATE_MAX];
+    const wifi_ap_network_t *network = NULL;
+    cy_rslt_t result = CY_RSLT_TYPE_ERROR;
+    TickType_t start = xTaskGetTickCount();
+    cy_wcm_connect_params_t params;
+    cy_wcm_ip_address_t ip;
+    int count;
+    int index;
+
+    taskENTER_CRITICAL();
+    memcpy(list, candidates, sizeof(list));
+    count = candidate_count;
+    taskEXIT_CRITICAL();
+
+    if ((0 == count) || (CY_RSLT_SUCCESS != wifi_init()))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    for (index = 0; index < count; index++)
+    {
+        if (list[index].failed ||
+            ((NULL != skip_bssid) && (0 == memcmp(list[index].bssid, skip_bssid, sizeof(cy_wcm_mac_t)))))
+        {
+            continue;
+        }
+
+        network = &networks[list[index].network];
+
+        memcpy(&params, &connect_param, sizeof(params));
+        memset(&params.ap_credentials, 0, sizeof(params.ap_credentials));
+        strncpy((char *)params.ap_credentials.SSID, network->ssid, CY_WCM_MAX_SSID_LEN);
+        strncpy((char *)params.ap_credentials.password, network->password, CY_WCM_MAX_PASSPHRASE_LEN);
+        params.ap_credentials.security = network->security;
+        memcpy(params.BSSID, list[index].bssid, sizeof(params.BSSID));
+        params.band = list[index].band;
+
+        result = cy_wcm_connect_ap(&params, &ip);
+
+        if (CY_RSLT_SUCCESS == result)
+        {
+            break;
+        }
+
+        /* Marked in the shared list too, unless a scan replaced it meanwhile */
+        taskENTER_CRITICAL();
+        if ((index < candidate_count) && (0 == memcmp(candidates[index].bssid, list[index].bssid, sizeof(cy_wcm_mac_t))))
+        {
+            candidates[index].failed = true;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    memcpy(&connect_param.ap_credentials, &params.ap_credentials, sizeof(connect_param.ap_credentials));
+    memcpy(&ip_addr, &ip, sizeof(ip_addr));
+    failover_count++;
+
+#if defined(APP_IPV6_ONLY)
+    result = wifi_ipv6_address_wait();
+#endif
+
+    APP_INFO(("Failover to %s, %02X:%02X:%02X:%02X:%02X:%02X on channel %d in %"PRIu32" ms\n",
+              network->ssid, list[index].bssid[0], list[index].bssid[1], list[index].bssid[2],
+              list[index].bssid[3], list[index].bssid[4], list[index].bssid[5], list[index].channel,
+              TICKS_TO_MS(xTaskGetTickCount() - start)));
+
+    return result;
+}
+
+#endif /* ENABLE_WIFI_AP_CANDIDATES */
+
+
+/* [] END OF FILE */
+
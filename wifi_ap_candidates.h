@@ -0,0 +1,71 @@
+/******************************************************************************
+* File Name:   wifi_ap_candidates.h
+*
+* Description: This file contains the declarations of the ranked list of
+*              candidate APs, refreshed by background scans and joined
+*              directly when the fast rejoin to the last AP fails.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef WIFI_AP_CANDIDATES_H
+#define WIFI_AP_CANDIDATES_H
+
+#include <stdbool.h>
+
+#include "cy_result.h"
+
+/* Wi-Fi connection manager header file */
+#include "cy_wcm.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Debug UART command byte that prints the candidate list */
+#define WIFI_AP_CANDIDATES_REPORT_COMMAND        ('c')
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t wifi_ap_candidates_init(void);
+void wifi_ap_candidates_wake(void);
+cy_rslt_t wifi_ap_candidates_join(const cy_wcm_mac_t skip_bssid);
+
+#endif /* WIFI_AP_CANDIDATES_H */
+
+
+/* [] END OF FILE */
+
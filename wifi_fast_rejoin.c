@@ -0,0 +1,998 @@
+/******************************************************************************
+* File Name:   wifi_fast_rejoin.c
+*
+* Description: This file caches the AP BSSID and channel, the DHCP lease, and
+*              the ARP entries of the TCP Keepalive servers, and uses them to
+*              rejoin the AP and re-arm the offloaded connections after a
+*              link loss without a full scan and DHCP exchange.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/* lwIP header file */
+#include "cy_lwip.h"
+#include "lwip/tcpip.h"
+#include "lwip/etharp.h"
+#include "lwip/dhcp.h"
+
+/* Wi-Fi connection manager header file */
+#include "cy_wcm.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "tcp_keepalive_offload.h"
+#include "offload_registry.h"
+#include "retry_scheduler.h"
+#include "wifi_ap_candidates.h"
+#include "wifi_fast_rejoin.h"
+#include "warm_boot.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Highest 2.4 GHz channel number */
+#define WIFI_MAX_2_4_GHZ_CHANNEL          (14)
+
+/* Notification bits of the rejoin task */
+#define REJOIN_EVENT_LINK_LOST            (1u << 0)
+#define REJOIN_EVENT_RECONNECTED          (1u << 1)
+#define REJOIN_EVENT_DHCP_RENEW           (1u << 2)
+#define REJOIN_EVENT_RETRY                (1u << 3)
+
+/* Time the rejoin task waits for DHCP to bind when the reused lease is due */
+#define REJOIN_DHCP_BIND_TIMEOUT_MS       (10000)
+#define REJOIN_DHCP_POLL_MS               (100)
+
+/* Lease time of DHCP that never expires */
+#define REJOIN_DHCP_INFINITE_LEASE        (0xFFFFFFFFu)
+
+/* Longest period of the DHCP renewal timer, longer times are waited in parts */
+#define REJOIN_DHCP_TIMER_MAX_TICKS       (portMAX_DELAY - 1)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    bool valid;
+
+    /* AP the device was last associated to */
+    cy_wcm_mac_t bssid;
+    uint8_t channel;
+    cy_wcm_wifi_band_t band;
+
+    /* Address leased by DHCP, and until when it can be reused without DHCP */
+    cy_wcm_ip_setting_t ip_settings;
+    TickType_t lease_tick;
+    uint32_t lease_reuse_ms;
+
+    wifi_rejoin_arp_entry_t arp[WIFI_REJOIN_ARP_CACHE_SIZE];
+} rejoin_cache_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static rejoin_cache_t rejoin_cache;
+static TaskHandle_t rejoin_task = NULL;
+
+/* ARP entries added as static entries by the last fast rejoin */
+static wifi_rejoin_arp_entry_t primed_arp[WIFI_REJOIN_ARP_CACHE_SIZE];
+
+/* Restarts DHCP when the lease reused by the last fast rejoin is due for renewal */
+static TimerHandle_t dhcp_timer = NULL;
+
+/* Ticks of the renewal time left after the running period of dhcp_timer */
+static uint64_t dhcp_timer_ticks_left = 0;
+
+/* Back-off of the rejoin attempts after a link loss, until one succeeds */
+static const retry_policy_t wifi_rejoin_retry_policy =
+{
+    .initial_jitter_ms = 0,
+    .base_delay_ms     = WIFI_REJOIN_RETRY_BASE_DELAY_MS,
+    .max_delay_ms      = WIFI_REJOIN_RETRY_MAX_DELAY_MS,
+    .max_attempts      = 0,
+    .budget_ms         = 0,
+};
+
+#if !defined(APP_IPV6_ONLY)
+/********************************************************************************
+ * Function Name: rejoin_lease_reuse_ms
+ ********************************************************************************
+ * Summary:
+ *  Returns how long a lease can be reused without DHCP: until its renewal time
+ *  (T1), at most UINT32_MAX - 1 ms, or forever for an infinite lease.
+ *
+ * Parameters:
+ *  dhcp: DHCP client data of the interface, NULL if the address is static.
+ *
+ * Return:
+ *  uint32_t: Reuse time in milliseconds, UINT32_MAX for no limit.
+ *
+ *******************************************************************************/
+static uint32_t rejoin_lease_reuse_ms(const struct dhcp *dhcp)
+{
+    if ((NULL == dhcp) || (REJOIN_DHCP_INFINITE_LEASE == dhcp->offered_t0_lease))
+    {
+        return UINT32_MAX;
+    }
+
+    /* UINT32_MAX stands for no limit, so a long lease saturates below it */
+    return (dhcp->offered_t1_renew < ((UINT32_MAX - 1) / 1000u)) ?
+           (dhcp->offered_t1_renew * 1000u) : (UINT32_MAX - 1);
+}
+#endif
+
+/********************************************************************************
+ * Function Name: rejoin_cache_arp_entry
+ ********************************************************************************
+ * Summary:
+ *  Copies the lwIP ARP table entry of the given address into a cache slot. The
+ *  lwIP core must be locked by the caller.
+ *
+ * Parameters:
+ *  netif: STA network interface.
+ *  ip: Address to look up.
+ *  entry: Cache slot to fill in.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void rejoin_cache_arp_entry(struct netif *netif, const ip4_addr_t *ip, wifi_rejoin_arp_entry_t *entry)
+{
+    struct eth_addr *eth_ret = NULL;
+    const ip4_addr_t *ip_ret = NULL;
+
+    entry->valid = (etharp_find_addr(netif, ip, &eth_ret, &ip_ret) >= 0) && (NULL != eth_ret);
+
+    if (entry->valid)
+    {
+        ip4_addr_copy(entry->ip, *ip);
+        memcpy(&entry->mac, eth_ret, sizeof(entry->mac));
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_cache_update
+ ********************************************************************************
+ * Summary:
+ *  Records the state needed for a fast rejoin: BSSID and channel of the current
+ *  AP, the IPv4 address, netmask and gateway with the DHCP renewal time, and the
+ *  ARP entries of the gateway and of each TCP Keepalive server on the local
+ *  subnet. Call it once the Wi-Fi and the TCP connections are up. The IPv6-only
+ *  build records only the AP, as its address comes from SLAAC.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wifi_fast_rejoin_cache_update(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    cy_wcm_associated_ap_info_t ap_info;
+#if !defined(APP_IPV6_ONLY)
+    const ip_addr_t *server;
+    struct dhcp *dhcp;
+    int index;
+#endif
+
+    memset(&rejoin_cache, 0, sizeof(rejoin_cache));
+
+    if ((NULL == netif) || (CY_RSLT_SUCCESS != cy_wcm_get_associated_ap_info(&ap_info)))
+    {
+        return;
+    }
+
+    memcpy(rejoin_cache.bssid, ap_info.BSSID, sizeof(rejoin_cache.bssid));
+    rejoin_cache.channel = ap_info.channel;
+    rejoin_cache.band = (ap_info.channel > WIFI_MAX_2_4_GHZ_CHANNEL) ?
+                        CY_WCM_WIFI_BAND_5GHZ : CY_WCM_WIFI_BAND_2_4GHZ;
+
+#if defined(APP_IPV6_ONLY)
+    /* The IPv4 settings stay 0.0.0.0, so the rejoin does no DHCPv4 either */
+    rejoin_cache.lease_tick = xTaskGetTickCount();
+    rejoin_cache.lease_reuse_ms = UINT32_MAX;
+    rejoin_cache.valid = true;
+#else
+    LOCK_TCPIP_CORE();
+
+    rejoin_cache.ip_settings.ip_address.version = CY_WCM_IP_VER_V4;
+    rejoin_cache.ip_settings.ip_address.ip.v4 = ip4_addr_get_u32(netif_ip4_addr(netif));
+    rejoin_cache.ip_settings.netmask.version = CY_WCM_IP_VER_V4;
+    rejoin_cache.ip_settings.netmask.ip.v4 = ip4_addr_get_u32(netif_ip4_netmask(netif));
+    rejoin_cache.ip_settings.gateway.version = CY_WCM_IP_VER_V4;
+    rejoin_cache.ip_settings.gateway.ip.v4 = ip4_addr_get_u32(netif_ip4_gw(netif));
+
+    /*
+     * A leased address is only reused until the DHCP renewal time (T1). No
+     * DHCP client runs while it is configured statically, so DHCP is
+     * restarted at T1 after a fast rejoin.
+     */
+    dhcp = netif_dhcp_data(netif);
+    rejoin_cache.lease_tick = xTaskGetTickCount();
+    rejoin_cache.lease_reuse_ms = rejoin_lease_reuse_ms(dhcp);
+
+    rejoin_cache_arp_entry(netif, netif_ip4_gw(netif), &rejoin_cache.arp[0]);
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        server = offload_registry_tko_remote_addr(index);
+
+        if ((NULL != server) && IP_IS_V4(server) &&
+            ip4_addr_netcmp(ip_2_ip4(server), netif_ip4_addr(netif), netif_ip4_netmask(netif)))
+        {
+            rejoin_cache_arp_entry(netif, ip_2_ip4(server), &rejoin_cache.arp[index + 1]);
+        }
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+    rejoin_cache.valid = !ip4_addr_isany_val(*netif_ip4_addr(netif));
+#endif
+
+#if ENABLE_WARM_BOOT
+    (void)warm_boot_save();
+#endif
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_cache_clear
+ ********************************************************************************
+ * Summary:
+ *  Drops the cached state and the static ARP entries added from it, so that
+ *  the next rejoin does a full scan and DHCP exchange.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wifi_fast_rejoin_cache_clear(void)
+{
+    wifi_fast_rejoin_arp_release();
+
+    if (NULL != dhcp_timer)
+    {
+        (void)xTimerStop(dhcp_timer, 0);
+    }
+
+    dhcp_timer_ticks_left = 0;
+    memset(&rejoin_cache, 0, sizeof(rejoin_cache));
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_arp_release
+ ********************************************************************************
+ * Summary:
+ *  Removes the static ARP entries added by the last fast rejoin, and sends an
+ *  ARP request for each of them if the link is up, so that lwIP learns them
+ *  again as dynamic entries that age out. Call it once the link is up and the
+ *  sockets are connected, so that a gateway or server whose MAC address
+ *  changed is not pinned to the old one.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wifi_fast_rejoin_arp_release(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    int index;
+
+    LOCK_TCPIP_CORE();
+
+    for (index = 0; index < WIFI_REJOIN_ARP_CACHE_SIZE; index++)
+    {
+        if (primed_arp[index].valid)
+        {
+            etharp_remove_static_entry(&primed_arp[index].ip);
+
+            if ((NULL != netif) && netif_is_link_up(netif))
+            {
+                (void)etharp_request(netif, &primed_arp[index].ip);
+            }
+
+            primed_arp[index].valid = false;
+        }
+    }
+
+    UNLOCK_TCPIP_CORE();
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_cache_export
+ ********************************************************************************
+ * Summary:
+ *  Copies the cached rejoin state out, with the time the address can still be
+ *  reused without DHCP.
+ *
+ * Parameters:
+ *  state: Filled in with the cached state.
+ *
+ * Return:
+ *  bool: true if the cache is valid, false otherwise.
+ *
+ *******************************************************************************/
+bool wifi_fast_rejoin_cache_export(wifi_rejoin_state_t *state)
+{
+    uint32_t lease_age_ms = (uint32_t)((xTaskGetTickCount() - rejoin_cache.lease_tick) * portTICK_PERIOD_MS);
+
+    if (!rejoin_cache.valid || (lease_age_ms >= rejoin_cache.lease_reuse_ms))
+    {
+        return false;
+    }
+
+    memcpy(state->bssid, rejoin_cache.bssid, sizeof(state->bssid));
+    state->channel = rejoin_cache.channel;
+    state->band = rejoin_cache.band;
+    memcpy(&state->ip_settings, &rejoin_cache.ip_settings, sizeof(state->ip_settings));
+    state->lease_left_ms = (UINT32_MAX == rejoin_cache.lease_reuse_ms) ?
+                           UINT32_MAX : (rejoin_cache.lease_reuse_ms - lease_age_ms);
+    memcpy(state->arp, rejoin_cache.arp, sizeof(state->arp));
+
+    return true;
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_cache_import
+ ********************************************************************************
+ * Summary:
+ *  Replaces the cached rejoin state, such as with the one of the previous boot,
+ *  so that the next wifi_fast_rejoin_join() joins the AP directly.
+ *
+ * Parameters:
+ *  state: Rejoin state to cache.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wifi_fast_rejoin_cache_import(const wifi_rejoin_state_t *state)
+{
+    memset(&rejoin_cache, 0, sizeof(rejoin_cache));
+
+    memcpy(rejoin_cache.bssid, state->bssid, sizeof(rejoin_cache.bssid));
+    rejoin_cache.channel = state->channel;
+    rejoin_cache.band = state->band;
+    memcpy(&rejoin_cache.ip_settings, &state->ip_settings, sizeof(rejoin_cache.ip_settings));
+    rejoin_cache.lease_tick = xTaskGetTickCount();
+    rejoin_cache.lease_reuse_ms = state->lease_left_ms;
+    memcpy(rejoin_cache.arp, state->arp, sizeof(rejoin_cache.arp));
+    rejoin_cache.valid = (0 != state->lease_left_ms);
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_rearm
+ ********************************************************************************
+ * Summary:
+ *  Reconnects only the TCP Keepalive sockets whose connection did not survive
+ *  the link loss. The others are offloaded again at the next network suspend.
+ *  All of them are reconnected if the address of the device changed.
+ *
+ * Parameters:
+ *  all: true to reconnect all the valid sockets.
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if all the sockets are connected, a socket error
+ *  code otherwise.
+ *
+ *******************************************************************************/
+static cy_rslt_t wifi_fast_rejoin_rearm(bool all)
+{
+    uint32_t socket_mask = 0;
+    int index;
+
+    for (index = 0; index < MAX_TKO; index++)
+    {
+        if (offload_registry_tko_port_valid(index) && (all || !tcp_socket_is_established(index)))
+        {
+            socket_mask |= (1u << index);
+        }
+    }
+
+    return (0 != socket_mask) ? tcp_socket_reconnect(socket_mask) : CY_RSLT_SUCCESS;
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_address
+ ********************************************************************************
+ * Summary:
+ *  Returns the IPv4 address of the STA interface.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: Address of the interface, 0 if there is none.
+ *
+ *******************************************************************************/
+static uint32_t wifi_fast_rejoin_address(void)
+{
+#if defined(APP_IPV6_ONLY)
+    return 0;
+#else
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    uint32_t address;
+
+    if (NULL == netif)
+    {
+        return 0;
+    }
+
+    LOCK_TCPIP_CORE();
+    address = ip4_addr_get_u32(netif_ip4_addr(netif));
+    UNLOCK_TCPIP_CORE();
+
+    return address;
+#endif
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_link_up
+ ********************************************************************************
+ * Summary:
+ *  Re-arms the TCP Keepalive sockets once the AP is joined again, by the
+ *  rejoin task or by the WCM on its own, and takes a new snapshot of the
+ *  rejoin state if the cached one is no longer valid.
+ *
+ * Parameters:
+ *  address: IPv4 address of the interface before the link loss, 0 if unknown.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_fast_rejoin_link_up(uint32_t address)
+{
+    uint32_t current = wifi_fast_rejoin_address();
+
+    /* The connections of the old address, such as after a failover to another subnet, are gone */
+    if (CY_RSLT_SUCCESS != wifi_fast_rejoin_rearm((0 != address) && (0 != current) && (address != current)))
+    {
+        ERR_INFO(("One or more TCP socket connections failed after rejoin.\n"));
+    }
+
+    /* The connections are up, the primed ARP entries are learned again from now on */
+    wifi_fast_rejoin_arp_release();
+
+    if (!rejoin_cache.valid)
+    {
+        wifi_fast_rejoin_cache_update();
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_dhcp_start
+ ********************************************************************************
+ * Summary:
+ *  Starts the DHCP client on the STA interface, whose address is configured
+ *  statically by the fast rejoin. The address is kept until DHCP binds.
+ *  Runs in the tcpip_thread.
+ *
+ * Parameters:
+ *  arg: Not used.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_fast_rejoin_dhcp_start(void *arg)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+
+    (void)arg;
+
+    if ((NULL != netif) && (ERR_OK != dhcp_start(netif)))
+    {
+        ERR_INFO(("Failed to restart DHCP after the fast rejoin\n"));
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_dhcp_timer_period
+ ********************************************************************************
+ * Summary:
+ *  Takes the next period of the DHCP renewal timer out of the ticks left until
+ *  the renewal time. A timer period is at most REJOIN_DHCP_TIMER_MAX_TICKS.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  TickType_t: Next period of the timer, at least 1 tick.
+ *
+ *******************************************************************************/
+static TickType_t wifi_fast_rejoin_dhcp_timer_period(void)
+{
+    TickType_t ticks = (dhcp_timer_ticks_left > REJOIN_DHCP_TIMER_MAX_TICKS) ?
+                       REJOIN_DHCP_TIMER_MAX_TICKS : (TickType_t)dhcp_timer_ticks_left;
+
+    dhcp_timer_ticks_left -= ticks;
+
+    return (0 == ticks) ? 1 : ticks;
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_dhcp_timer_cb
+ ********************************************************************************
+ * Summary:
+ *  Timer callback, at the renewal time (T1) of the lease reused by the last
+ *  fast rejoin. Hands the DHCP restart over to the rejoin task, which also
+ *  re-arms the sockets if the address changes, or starts DHCP directly if
+ *  there is no rejoin task, such as after a warm boot join. Before the renewal
+ *  time, restarts the timer for the next part of it.
+ *
+ * Parameters:
+ *  timer: DHCP renewal timer.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_fast_rejoin_dhcp_timer_cb(TimerHandle_t timer)
+{
+    if ((0 != dhcp_timer_ticks_left) &&
+        (pdPASS == xTimerChangePeriod(timer, wifi_fast_rejoin_dhcp_timer_period(), 0)))
+    {
+        return;
+    }
+
+    dhcp_timer_ticks_left = 0;
+
+    if (NULL != rejoin_task)
+    {
+        (void)xTaskNotify(rejoin_task, REJOIN_EVENT_DHCP_RENEW, eSetBits);
+    }
+    else
+    {
+        (void)tcpip_callback(wifi_fast_rejoin_dhcp_start, NULL);
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_dhcp_schedule
+ ********************************************************************************
+ * Summary:
+ *  Schedules the DHCP restart at the end of the reuse time of the cached
+ *  lease, so that the address configured statically by the fast rejoin is not
+ *  kept past its renewal time.
+ *
+ * Parameters:
+ *  lease_left_ms: Time left until the renewal time of the lease, UINT32_MAX
+ *  if the address was not leased by DHCP.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_fast_rejoin_dhcp_schedule(uint32_t lease_left_ms)
+{
+    TickType_t ticks;
+
+    if (UINT32_MAX == lease_left_ms)
+    {
+        return;
+    }
+
+    /* pdMS_TO_TICKS() wraps after about 71 minutes at a 1 kHz tick */
+    dhcp_timer_ticks_left = ((uint64_t)lease_left_ms * configTICK_RATE_HZ) / 1000u;
+    ticks = wifi_fast_rejoin_dhcp_timer_period();
+
+    if (NULL == dhcp_timer)
+    {
+        dhcp_timer = xTimerCreate("DhcpRenew", ticks, pdFALSE, NULL, wifi_fast_rejoin_dhcp_timer_cb);
+    }
+
+    if ((NULL == dhcp_timer) || (pdPASS != xTimerChangePeriod(dhcp_timer, ticks, 0)))
+    {
+        /* Without the timer the address must not be reused: start DHCP now */
+        ERR_INFO(("Failed to schedule the DHCP renewal, restarting DHCP\n"));
+        dhcp_timer_ticks_left = 0;
+        (void)tcpip_callback(wifi_fast_rejoin_dhcp_start, NULL);
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_dhcp_renew
+ ********************************************************************************
+ * Summary:
+ *  Restarts DHCP once the reused lease is due, waits for it to bind, and then
+ *  takes a new snapshot of the rejoin state with the new lease. The sockets
+ *  are reconnected if DHCP assigned another address. Runs in the rejoin task.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_fast_rejoin_dhcp_renew(void)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    uint32_t address = wifi_fast_rejoin_address();
+    uint32_t waited_ms = 0;
+    bool bound = false;
+
+    if ((NULL == netif) || !cy_wcm_is_connected_to_ap())
+    {
+        return;
+    }
+
+    (void)tcpip_callback(wifi_fast_rejoin_dhcp_start, NULL);
+
+    while (!bound && (waited_ms < REJOIN_DHCP_BIND_TIMEOUT_MS))
+    {
+        vTaskDelay(pdMS_TO_TICKS(REJOIN_DHCP_POLL_MS));
+        waited_ms += REJOIN_DHCP_POLL_MS;
+
+        LOCK_TCPIP_CORE();
+        bound = dhcp_supplied_address(netif);
+        UNLOCK_TCPIP_CORE();
+    }
+
+    if (!bound)
+    {
+        ERR_INFO(("DHCP did not bind after the fast rejoin, the lease is renewed in the background\n"));
+        return;
+    }
+
+    /* The snapshot is taken again with the new lease */
+    rejoin_cache.valid = false;
+    wifi_fast_rejoin_link_up(address);
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_join
+ ********************************************************************************
+ * Summary:
+ *  Joins the AP. If the cached state is valid, the AP is joined directly by
+ *  BSSID with the cached address configured statically, so neither a scan nor
+ *  a DHCP exchange is needed, and the cached ARP entries are restored as static
+ *  entries until wifi_fast_rejoin_arp_release() is called. Otherwise, or if this fails, the other candidate APs of the last
+ *  background scan are joined directly, if ENABLE_WIFI_AP_CANDIDATES is
+ *  enabled, and then a full join is done through wifi_connect(). The WCM is
+ *  initialized if needed, so it can also be used for the first join after a
+ *  warm boot.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the AP was joined, a WCM error code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_fast_rejoin_join(void)
+{
+    cy_wcm_connect_params_t params;
+    cy_wcm_ip_address_t ip;
+    cy_rslt_t result = CY_RSLT_TYPE_ERROR;
+    TickType_t start = xTaskGetTickCount();
+    uint32_t lease_age_ms = (uint32_t)((start - rejoin_cache.lease_tick) * portTICK_PERIOD_MS);
+#if ENABLE_WIFI_AP_CANDIDATES
+    cy_wcm_mac_t tried_bssid;
+    bool tried = false;
+#endif
+    int index;
+
+    if (rejoin_cache.valid && (lease_age_ms < rejoin_cache.lease_reuse_ms) &&
+        (CY_RSLT_SUCCESS == wifi_init()))
+    {
+        memcpy(&params, &connect_param, sizeof(params));
+        memcpy(params.BSSID, rejoin_cache.bssid, sizeof(params.BSSID));
+        params.band = rejoin_cache.band;
+        params.static_ip_settings = &rejoin_cache.ip_settings;
+
+#if ENABLE_WIFI_AP_CANDIDATES
+        memcpy(tried_bssid, rejoin_cache.bssid, sizeof(tried_bssid));
+        tried = true;
+#endif
+
+        result = cy_wcm_connect_ap(&params, &ip);
+    }
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        LOCK_TCPIP_CORE();
+
+        for (index = 0; index < WIFI_REJOIN_ARP_CACHE_SIZE; index++)
+        {
+            if (rejoin_cache.arp[index].valid &&
+                (ERR_OK == etharp_add_static_entry(&rejoin_cache.arp[index].ip, &rejoin_cache.arp[index].mac)))
+            {
+                primed_arp[index] = rejoin_cache.arp[index];
+            }
+        }
+
+        UNLOCK_TCPIP_CORE();
+
+        memcpy(&ip_addr, &ip, sizeof(ip_addr));
+
+#if defined(APP_IPV6_ONLY)
+        result = wifi_ipv6_address_wait();
+#endif
+    }
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        APP_INFO(("Fast rejoin to %s on channel %d in %"PRIu32" ms\n", connect_param.ap_credentials.SSID,
+                  rejoin_cache.channel, (uint32_t)((xTaskGetTickCount() - start) * portTICK_PERIOD_MS)));
+
+        /* No DHCP client runs on the static address, so restart it at T1 */
+        wifi_fast_rejoin_dhcp_schedule((UINT32_MAX == rejoin_cache.lease_reuse_ms) ?
+                                       UINT32_MAX : (rejoin_cache.lease_reuse_ms - lease_age_ms));
+    }
+    else
+    {
+        /* Cached state is stale or the AP moved; fall back to scan and DHCP */
+        wifi_fast_rejoin_cache_clear();
+
+#if ENABLE_WIFI_AP_CANDIDATES
+        /* The other APs of the last background scan are joined without a scan */
+        result = wifi_ap_candidates_join(tried ? tried_bssid : NULL);
+
+        if (CY_RSLT_SUCCESS != result)
+#endif
+        {
+            result = wifi_connect();
+        }
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin
+ ********************************************************************************
+ * Summary:
+ *  Rejoins the AP after a link loss through wifi_fast_rejoin_join(), then
+ *  re-arms the TCP Keepalive sockets. The sockets are connected in parallel.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the AP was rejoined, a WCM error code
+ *  otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_fast_rejoin(void)
+{
+    uint32_t address = rejoin_cache.valid ? rejoin_cache.ip_settings.ip_address.ip.v4 : 0;
+    cy_rslt_t result = wifi_fast_rejoin_join();
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        wifi_fast_rejoin_link_up(address);
+    }
+
+    return result;
+}
+
+/********************************************************************************
+ * Function Name: wifi_rejoin_task
+ ********************************************************************************
+ * Summary:
+ *  Waits for the link loss and reconnection notifications of the WCM event
+ *  callback. The rejoin and the reconnection of the WCM are both handled here,
+ *  one at a time: if the WCM has already reconnected on its own by the time a
+ *  notification is handled, only the sockets are re-armed; otherwise the AP is
+ *  rejoined. A failed rejoin is retried after the back-off of
+ *  wifi_rejoin_retry_policy until the link is up again. Blocks without a
+ *  timeout otherwise, so it never wakes the MCU on its own.
+ *
+ * Parameters:
+ *  void *arg: Not used.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_rejoin_task(void *arg)
+{
+    retry_state_t retry;
+    bool retry_pending = false;
+    TickType_t retry_tick = 0;
+    TickType_t timeout;
+    TickType_t now;
+    uint32_t address = 0;
+    uint32_t delay_ms;
+    uint32_t events;
+
+    (void)arg;
+
+    while (true)
+    {
+        now = xTaskGetTickCount();
+        timeout = !retry_pending ? portMAX_DELAY :
+                  (((int32_t)(retry_tick - now) > 0) ? (retry_tick - now) : 0);
+
+        if (pdTRUE != xTaskNotifyWait(0, UINT32_MAX, &events, timeout))
+        {
+            events = 0;
+        }
+
+        if (retry_pending && ((int32_t)(xTaskGetTickCount() - retry_tick) >= 0))
+        {
+            events |= REJOIN_EVENT_RETRY;
+        }
+
+        if ((events & REJOIN_EVENT_DHCP_RENEW) && !(events & (REJOIN_EVENT_LINK_LOST | REJOIN_EVENT_RETRY)))
+        {
+            wifi_fast_rejoin_dhcp_renew();
+            continue;
+        }
+
+        if (events & REJOIN_EVENT_LINK_LOST)
+        {
+            /* The interface may already be down, so use the cached address */
+            address = rejoin_cache.valid ? rejoin_cache.ip_settings.ip_address.ip.v4 : 0;
+            retry_init(&retry, &wifi_rejoin_retry_policy);
+        }
+
+        if (cy_wcm_is_connected_to_ap())
+        {
+            /* The WCM reconnected on its own; joining again would drop the link */
+            retry_pending = false;
+            wifi_fast_rejoin_link_up(address);
+        }
+        else if (events & (REJOIN_EVENT_LINK_LOST | REJOIN_EVENT_RETRY))
+        {
+            retry_pending = false;
+            retry_attempt_begin(&retry);
+
+            if (CY_RSLT_SUCCESS == wifi_fast_rejoin())
+            {
+                continue;
+            }
+
+            if (cy_wcm_is_connected_to_ap())
+            {
+                /* The WCM won the race with the join above */
+                wifi_fast_rejoin_link_up(address);
+            }
+            else if (retry_attempt_record_failure(&retry))
+            {
+                delay_ms = retry_next_delay_ms(&retry);
+                ERR_INFO(("Failed to rejoin Wi-Fi network %s, retrying in %"PRIu32" ms\n",
+                          connect_param.ap_credentials.SSID, delay_ms));
+                retry_tick = xTaskGetTickCount() + pdMS_TO_TICKS(delay_ms);
+                retry_pending = true;
+            }
+            else
+            {
+                ERR_INFO(("Failed to rejoin Wi-Fi network %s\n", connect_param.ap_credentials.SSID));
+            }
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_rejoin_event_cb
+ ********************************************************************************
+ * Summary:
+ *  WCM event callback. Hands a link loss, and a reconnection done by the WCM
+ *  on its own, over to the rejoin task, which handles them one at a time.
+ *
+ * Parameters:
+ *  event: WCM event.
+ *  event_data: Event specific data. Not used.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wifi_rejoin_event_cb(cy_wcm_event_t event, cy_wcm_event_data_t *event_data)
+{
+    (void)event_data;
+
+    if ((CY_WCM_EVENT_DISCONNECTED == event) && (NULL != rejoin_task))
+    {
+        APP_INFO(("Wi-Fi link lost\n"));
+        (void)xTaskNotify(rejoin_task, REJOIN_EVENT_LINK_LOST, eSetBits);
+    }
+    else if ((CY_WCM_EVENT_RECONNECTED == event) && (NULL != rejoin_task))
+    {
+        APP_INFO(("Wi-Fi link reconnected by the WCM\n"));
+        (void)xTaskNotify(rejoin_task, REJOIN_EVENT_RECONNECTED, eSetBits);
+    }
+    else if (CY_WCM_EVENT_IP_CHANGED == event)
+    {
+        /* The cached lease no longer matches the interface */
+        rejoin_cache.valid = false;
+    }
+}
+
+/********************************************************************************
+ * Function Name: wifi_fast_rejoin_init
+ ********************************************************************************
+ * Summary:
+ *  Takes the first snapshot of the rejoin state and starts watching for link
+ *  loss. Call it after wifi_connect() and tcp_socket_connection_start(). A
+ *  state restored by the warm boot is kept, as its address is configured
+ *  statically and has no DHCP lease to snapshot.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS on success, CY_RSLT_TYPE_ERROR if the rejoin task
+ *  cannot be created, a WCM error code otherwise.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_fast_rejoin_init(void)
+{
+    if (!rejoin_cache.valid)
+    {
+        wifi_fast_rejoin_cache_update();
+    }
+
+    if (pdPASS != xTaskCreate(wifi_rejoin_task,
+                              "WiFiRejoin",
+                              WIFI_REJOIN_TASK_STACK_SIZE,
+                              NULL,
+                              WIFI_REJOIN_TASK_PRIORITY,
+                              &rejoin_task))
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    return cy_wcm_register_event_callback(wifi_rejoin_event_cb);
+}
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,116 @@
+/******************************************************************************
+* File Name:   wifi_fast_rejoin.h
+*
+* Description: This file is the public interface of wifi_fast_rejoin.c
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef WIFI_FAST_REJOIN_H
+#define WIFI_FAST_REJOIN_H
+
+#include <stdbool.h>
+
+/* FreeRTOS header file */
+#include <FreeRTOS.h>
+
+#include "cy_result.h"
+
+/* lwIP header files */
+#include "lwip/ip4_addr.h"
+#include "lwip/prot/ethernet.h"
+
+/* Wi-Fi connection manager header file */
+#include "cy_wcm.h"
+
+/* LPA header file */
+#include "cy_OlmInterface.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Stack size and priority of the task that recovers from a link loss */
+#ifndef WIFI_REJOIN_TASK_STACK_SIZE
+#define WIFI_REJOIN_TASK_STACK_SIZE              (1024)
+#endif
+#ifndef WIFI_REJOIN_TASK_PRIORITY
+#define WIFI_REJOIN_TASK_PRIORITY                (3)
+#endif
+
+/* ARP entries cached: the gateway plus one for each TCP Keepalive server */
+#define WIFI_REJOIN_ARP_CACHE_SIZE               (MAX_TKO + 1)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct
+{
+    bool valid;
+    ip4_addr_t ip;
+    struct eth_addr mac;
+} wifi_rejoin_arp_entry_t;
+
+/* Rejoin state kept outside of the fast rejoin module, such as in flash */
+typedef struct
+{
+    cy_wcm_mac_t bssid;
+    uint8_t channel;
+    cy_wcm_wifi_band_t band;
+    cy_wcm_ip_setting_t ip_settings;
+
+    /* How long the address can still be reused without DHCP */
+    uint32_t lease_left_ms;
+
+    wifi_rejoin_arp_entry_t arp[WIFI_REJOIN_ARP_CACHE_SIZE];
+} wifi_rejoin_state_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t wifi_fast_rejoin_init(void);
+void wifi_fast_rejoin_cache_update(void);
+void wifi_fast_rejoin_cache_clear(void);
+void wifi_fast_rejoin_arp_release(void);
+bool wifi_fast_rejoin_cache_export(wifi_rejoin_state_t *state);
+void wifi_fast_rejoin_cache_import(const wifi_rejoin_state_t *state);
+cy_rslt_t wifi_fast_rejoin_join(void);
+cy_rslt_t wifi_fast_rejoin(void);
+
+#endif /* WIFI_FAST_REJOIN_H */
+
+
+/* [] END OF FILE */
+
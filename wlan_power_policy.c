@@ -0,0 +1,326 @@
+/******************************************************************************
+* File Name:   wlan_power_policy.c
+*
+* Description: This file switches the WLAN power save mode and listen
+*              interval between a low latency setting while the host is awake
+*              and a low power setting while the network stack is suspended,
+*              and keeps the time spent in each.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* lwIP header file */
+#include "cy_lwip.h"
+
+/* Wi-Fi Host Driver header file */
+#include "whd_wifi_api.h"
+
+/* User settings related to Wi-Fi and network stack */
+#include "app_config.h"
+
+#include "app_platform.h"
+#include "debug_uart.h"
+#include "wlan_power_policy.h"
+
+#if ENABLE_WLAN_POWER_POLICY
+
+_Static_assert((WLAN_POWER_ACTIVE_SAVE <= WLAN_POWER_SAVE_PM2) && (WLAN_POWER_SUSPEND_SAVE <= WLAN_POWER_SAVE_PM2),
+               "The WLAN power save modes must be WLAN_POWER_SAVE_OFF, WLAN_POWER_SAVE_PM1 or WLAN_POWER_SAVE_PM2");
+_Static_assert((WLAN_POWER_ACTIVE_LISTEN_DTIM >= 1) && (WLAN_POWER_ACTIVE_LISTEN_DTIM <= 255) &&
+               (WLAN_POWER_SUSPEND_LISTEN_DTIM >= 1) && (WLAN_POWER_SUSPEND_LISTEN_DTIM <= 255),
+               "The WLAN listen intervals must be 1 to 255 DTIM periods");
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* WLAN settings of a mode */
+typedef struct
+{
+    const char *name;
+    uint8_t power_save;
+    uint16_t sleep_delay_ms;
+    uint8_t listen_interval_dtim;
+} wlan_power_setting_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const wlan_power_setting_t power_settings[WLAN_POWER_MODE_MAX] =
+{
+    [WLAN_POWER_MODE_ACTIVE] =
+    {
+        "Active", WLAN_POWER_ACTIVE_SAVE, WLAN_POWER_ACTIVE_SLEEP_DELAY_MS, WLAN_POWER_ACTIVE_LISTEN_DTIM
+    },
+    [WLAN_POWER_MODE_SUSPENDED] =
+    {
+        "Suspended", WLAN_POWER_SUSPEND_SAVE, WLAN_POWER_SUSPEND_SLEEP_DELAY_MS, WLAN_POWER_SUSPEND_LISTEN_DTIM
+    }
+};
+
+/* Written only by the network idle task, read under a critical section */
+static wlan_power_mode_t current_mode = WLAN_POWER_MODE_ACTIVE;
+static TickType_t mode_start_tick;
+static uint64_t mode_time_ms[WLAN_POWER_MODE_MAX];
+static uint32_t mode_entries[WLAN_POWER_MODE_MAX];
+static uint32_t apply_failures = 0;
+static bool initialized = false;
+
+/********************************************************************************
+ * Function Name: wlan_power_policy_apply
+ ********************************************************************************
+ * Summary:
+ *  Sets the power save mode and the listen interval of a mode in the WLAN
+ *  firmware.
+ *
+ * Parameters:
+ *  mode: Mode whose settings are applied.
+ *
+ * Return:
+ *  bool: true if the firmware took both settings, false otherwise.
+ *
+ *******************************************************************************/
+static bool wlan_power_policy_apply(wlan_power_mode_t mode)
+{
+    struct netif *netif = cy_lwip_get_interface(CY_LWIP_STA_NW_INTERFACE);
+    const wlan_power_setting_t *setting = &power_settings[mode];
+    whd_interface_t ifp;
+    whd_result_t result;
+
+    if ((NULL == netif) || (NULL == netif->state))
+    {
+        return false;
+    }
+
+    ifp = (whd_interface_t)netif->state;
+
+    switch (setting->power_save)
+    {
+        case WLAN_POWER_SAVE_OFF:
+            result = whd_wifi_disable_powersave(ifp);
+            break;
+
+        case WLAN_POWER_SAVE_PM1:
+            result = whd_wifi_enable_powersave(ifp);
+            break;
+
+        case WLAN_POWER_SAVE_PM2:
+        default:
+            result = whd_wifi_enable_powersave_with_throughput(ifp, setting->sleep_delay_ms);
+            break;
+    }
+
+    if (WHD_SUCCESS == result)
+    {
+        result = whd_wifi_set_listen_interval(ifp, setting->listen_interval_dtim, WHD_LISTEN_INTERVAL_TIME_UNIT_DTIM);
+    }
+
+    return (WHD_SUCCESS == result);
+}
+
+/********************************************************************************
+ * Function Name: wlan_power_policy_enter
+ ********************************************************************************
+ * Summary:
+ *  Applies the settings of a mode, and closes the time spent in the previous
+ *  mode. A mode whose settings the firmware refused is still accounted as
+ *  entered, as the network stack is in that state either way; the next
+ *  transition applies the settings again.
+ *
+ * Parameters:
+ *  mode: Mode to enter.
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wlan_power_policy_enter(wlan_power_mode_t mode)
+{
+    TickType_t now;
+    bool applied;
+
+    if (!initialized)
+    {
+        return;
+    }
+
+    applied = wlan_power_policy_apply(mode);
+    now = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    mode_time_ms[current_mode] += TICKS_TO_MS(now - mode_start_tick);
+    mode_start_tick = now;
+    current_mode = mode;
+    mode_entries[mode]++;
+    apply_failures += applied ? 0 : 1;
+    taskEXIT_CRITICAL();
+}
+
+/********************************************************************************
+ * Function Name: wlan_power_policy_report
+ ********************************************************************************
+ * Summary:
+ *  Prints the settings of each mode, the number of times it was entered, and
+ *  the time spent in it. Registered as a debug UART command.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void wlan_power_policy_report(void)
+{
+    static const char *save_names[] = { "off", "PM1", "PM2" };
+    uint64_t time_ms[WLAN_POWER_MODE_MAX];
+    uint32_t entries[WLAN_POWER_MODE_MAX];
+    const wlan_power_setting_t *setting;
+    wlan_power_mode_t mode;
+    uint32_t failures;
+    TickType_t now;
+    int index;
+
+    taskENTER_CRITICAL();
+    now = xTaskGetTickCount();
+    mode = current_mode;
+    failures = apply_failures;
+
+    for (index = 0; index < WLAN_POWER_MODE_MAX; index++)
+    {
+        time_ms[index] = mode_time_ms[index];
+        entries[index] = mode_entries[index];
+    }
+
+    time_ms[mode] += TICKS_TO_MS(now - mode_start_tick);
+    taskEXIT_CRITICAL();
+
+    APP_INFO(("Mode       Power save  Listen (DTIM)  Entries  Time (s)\n"));
+
+    for (index = 0; index < WLAN_POWER_MODE_MAX; index++)
+    {
+        setting = &power_settings[index];
+        APP_INFO(("%-10s %-10s %14d %8"PRIu32" %9"PRIu32"%s\n", setting->name,
+                  save_names[setting->power_save], setting->listen_interval_dtim, entries[index], (uint32_t)(time_ms[index] / 1000u),
+                  (index == (int)mode) ? " *" : ""));
+    }
+
+    APP_INFO(("Settings refused by the WLAN firmware: %"PRIu32"\n", failures));
+}
+
+/********************************************************************************
+ * Function Name: wlan_power_policy_init
+ ********************************************************************************
+ * Summary:
+ *  Applies the settings of the active mode and starts the time accounting.
+ *  Call it once the AP is joined, as the settings apply to the association.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t: CY_RSLT_SUCCESS if the WLAN firmware took the settings,
+ *  CY_RSLT_TYPE_ERROR otherwise. The policy runs in both cases.
+ *
+ *******************************************************************************/
+cy_rslt_t wlan_power_policy_init(void)
+{
+    bool applied;
+
+    applied = wlan_power_policy_apply(WLAN_POWER_MODE_ACTIVE);
+
+    taskENTER_CRITICAL();
+    current_mode = WLAN_POWER_MODE_ACTIVE;
+    mode_start_tick = xTaskGetTickCount();
+    mode_entries[WLAN_POWER_MODE_ACTIVE]++;
+    apply_failures += applied ? 0 : 1;
+    initialized = true;
+    taskEXIT_CRITICAL();
+
+    debug_uart_register_command(WLAN_POWER_REPORT_COMMAND, wlan_power_policy_report);
+
+    return applied ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
+}
+
+/********************************************************************************
+ * Function Name: wlan_power_policy_suspend_begin
+ ********************************************************************************
+ * Summary:
+ *  Switches to the settings of the suspended mode before the network stack is
+ *  suspended, once all the sockets are offloaded.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wlan_power_policy_suspend_begin(void)
+{
+    wlan_power_policy_enter(WLAN_POWER_MODE_SUSPENDED);
+}
+
+/********************************************************************************
+ * Function Name: wlan_power_policy_resume
+ ********************************************************************************
+ * Summary:
+ *  Switches back to the settings of the active mode once the network stack
+ *  has resumed, before the wake is handled.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void wlan_power_policy_resume(void)
+{
+    wlan_power_policy_enter(WLAN_POWER_MODE_ACTIVE);
+}
+
+#endif /* ENABLE_WLAN_POWER_POLICY */
+
+
+/* [] END OF FILE */
+
@@ -0,0 +1,81 @@
+/******************************************************************************
+* File Name:   wlan_power_policy.h
+*
+* Description: This file contains the declarations of the WLAN power policy,
+*              which sets the power save mode and listen interval of the
+*              radio to match the suspend state of the network stack.
+*
+* Related Document: See README.md
+*
+********************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#ifndef WLAN_POWER_POLICY_H
+#define WLAN_POWER_POLICY_H
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Power save modes of the WLAN firmware, for the WLAN_POWER_* settings */
+#define WLAN_POWER_SAVE_OFF                      (0)
+#define WLAN_POWER_SAVE_PM1                      (1)
+#define WLAN_POWER_SAVE_PM2                      (2)
+
+/* Debug UART command byte that prints the time spent in each mode */
+#define WLAN_POWER_REPORT_COMMAND                ('l')
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum
+{
+    WLAN_POWER_MODE_ACTIVE = 0,     /* The host is awake and the network stack runs */
+    WLAN_POWER_MODE_SUSPENDED,      /* The network stack is suspended and offloaded */
+    WLAN_POWER_MODE_MAX
+} wlan_power_mode_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t wlan_power_policy_init(void);
+void wlan_power_policy_suspend_begin(void);
+void wlan_power_policy_resume(void);
+
+#endif /* WLAN_POWER_POLICY_H */
+
+
+/* [] END OF FILE */
+